@@ -38,8 +38,14 @@
  * ======================================================================== */
 
 #include "InverseCompositional.h"
+#include "WarpSampler.h"
 using namespace windage;
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define IC_SSE2
+	#include <emmintrin.h>
+#endif
+
 bool InverseCompositional::AttatchTemplateImage(IplImage* image)
 {
 	if(this->templateImage == NULL)
@@ -62,35 +68,50 @@ bool InverseCompositional::Initialize()
 	cvSobel(this->templateImage, pGradTx, 1, 0); // Gradient in X direction
 	cvSobel(this->templateImage, pGradTy, 0, 1); // Gradient in Y direction
 
+	int q = this->samplingColumns * this->samplingRows;
+	this->steepestDescent.resize(PARAMETER_COUNT * q);
+	this->templateValue.resize(q);
+	float* sd[PARAMETER_COUNT];
+	for(int i=0; i<PARAMETER_COUNT; i++)
+		sd[i] = &this->steepestDescent[i*q];
+
 	// Compute steepest descent images and Hessian
-	cvSet(H, cvScalar(0)); // Set Hessian with zeroes
+	double H[PARAMETER_COUNT*PARAMETER_COUNT];
+	for(int i=0; i<PARAMETER_COUNT*PARAMETER_COUNT; i++)
+		H[i] = 0.0;
 
 	// Walk through pixels in the template T.
+	int index = 0;
 	for(int y=0; y<this->height; y+=SAMPLING_STEP)
 	{
+		const short* rowTx = &CV_IMAGE_ELEM(pGradTx, short, y, 0);
+		const short* rowTy = &CV_IMAGE_ELEM(pGradTy, short, y, 0);
 		for(int x=0; x<this->width; x+=SAMPLING_STEP)
 		{
 			// Evaluate gradient of T.
-			float Tx = (float)cvGetReal2D(pGradTx, y, x);
-			float Ty = (float)cvGetReal2D(pGradTy, y, x);
+			float Tx = (float)rowTx[x];
+			float Ty = (float)rowTy[x];
 
 			// Calculate steepest descent image's element.
-			float stdesc[4];
+			float stdesc[PARAMETER_COUNT];
 			stdesc[0] = -Tx*y+Ty*x;
 			stdesc[1] = Tx;
 			stdesc[2] = Ty;
 			stdesc[3] = Tx*x+Ty*y;
 
-			cvSet2D(pStDesc, y, x, cvScalar(stdesc[0], stdesc[1], stdesc[2], stdesc[3]));
+			for(int l=0; l<PARAMETER_COUNT; l++)
+				sd[l][index] = stdesc[l];
+			this->templateValue[index] = (float)CV_IMAGE_ELEM(this->templateImage, unsigned char, y, x);
 
 			// Add a term to Hessian.
-			for(int l=0; l<4; l++)
+			for(int l=0; l<PARAMETER_COUNT; l++)
 			{
-				for(int m=0; m<4; m++)
+				for(int m=0; m<PARAMETER_COUNT; m++)
 				{
-					CV_MAT_ELEM((*H), float, l, m) += (stdesc[l] * stdesc[m]);
+					H[l*PARAMETER_COUNT + m] += (double)stdesc[l] * stdesc[m];
 				} 
 			}
+			index++;
 		}	
 	}
 
@@ -98,7 +119,9 @@ bool InverseCompositional::Initialize()
 	cvReleaseImage(&pGradTy);
 
 	// Invert Hessian.
-	double inv_res = cvInvert(H, iH);
+	CvMat hessian = cvMat(PARAMETER_COUNT, PARAMETER_COUNT, CV_64F, H);
+	CvMat inverse = cvMat(PARAMETER_COUNT, PARAMETER_COUNT, CV_64F, this->iH);
+	double inv_res = cvInvert(&hessian, &inverse);
 	if(inv_res==0)
 	{
 		printf("Error: Hessian is singular.\n");
@@ -106,37 +129,11 @@ bool InverseCompositional::Initialize()
 	}
 
 	isInitialize = true;
+	this->InitializePyramid();
 
 	return true;
 }
 
-void InverseCompositional::SetInitialHomography(Matrix3 homography)
-{
-	this->homography = homography;
-
-	for(int y=0; y<3; y++)
-	{
-		for(int x=0; x<3; x++)
-		{
-			CV_MAT_ELEM((*W), float, y, x) = (float)this->homography.m[y][x];
-		}
-	}
-}
-
-Matrix3 InverseCompositional::GetHomography()
-{
-	// update homography
-	for(int y=0; y<3; y++)
-	{
-		for(int x=0; x<3; x++)
-		{
-			this->homography.m[y][x] = (double)CV_MAT_ELEM((*W), float, y, x);
-		}
-	}
-
-	return this->homography;
-}
-
 float InverseCompositional::UpdateHomography(IplImage* image, float* delta)
 {
 	if(isInitialize == false)
@@ -148,53 +145,77 @@ float InverseCompositional::UpdateHomography(IplImage* image, float* delta)
 	if(image->nChannels != 1)
 		return -1.0;
 
-	float error = 0.0;
-//	cvSetIdentity(W);
+	const int q = this->samplingColumns * this->samplingRows;
+	const float* sd0 = &this->steepestDescent[0];
+	const float* sd1 = sd0 + q;
+	const float* sd2 = sd1 + q;
+	const float* sd3 = sd2 + q;
 
-	int ix, iy;
+	double error = 0.0;
 	int pixel_count=0; // Count of processed pixels
-	cvSet(b, cvScalar(0)); // Set b matrix with zeroes
-	windage::Vector3 point, out;
-	point.z = 1.0;
+	double b[PARAMETER_COUNT] = {0.0, 0.0, 0.0, 0.0}; // Vector in the right side of the system of linear equations.
+
+	std::vector<float> warped(this->samplingColumns);
+	std::vector<float> D(this->samplingColumns);
+	std::vector<unsigned char> valid(this->samplingColumns);
 
 	// Walk through pixels in the template T.
-	for(int y=0; y<this->height; y+=SAMPLING_STEP)
+	for(int row=0; row<this->samplingRows; row++)
 	{
-		for(int x=0; x<this->width; x+=SAMPLING_STEP)
+		int y = row*SAMPLING_STEP;
+		int offset = row*this->samplingColumns;
+
+		// get values of the row (bilinear)
+		SampleWarpedRow(image, this->homography, 0, y, SAMPLING_STEP, this->samplingColumns, &warped[0], NULL, NULL, &valid[0]);
+
+		// Calculate image difference D = I(W(x,p))-T(x), zero out of the image.
+		for(int column=0; column<this->samplingColumns; column++)
 		{
-			// get value
-			point.x = x;
-			point.y = y;
-			point.z = 1.0;
-			out = this->homography * point;
-			float ww = 1.0f/(float)out.z;
-			out *= ww;
-			
-			ix = (int)(out.x);
-			iy = (int)(out.y);
-
-			if( 0 < ix && ix < image->width && 0 < iy && iy < image->height)
+			D[column] = 0.0f;
+			if(valid[column])
 			{
 				pixel_count++;
 
-				float value = (float)CV_IMAGE_ELEM(image, unsigned char, iy, ix);
-				CV_IMAGE_ELEM(samplingImage, unsigned char, y, x) = (unsigned char)value;
+				float value = warped[column];
+				CV_IMAGE_ELEM(samplingImage, unsigned char, y, column*SAMPLING_STEP) = (unsigned char)cvRound(value);
 
-				// Calculate image difference D = I(W(x,p))-T(x).
-				float D = value - (float)CV_IMAGE_ELEM(this->templateImage, unsigned char, y, x);
+				D[column] = value - this->templateValue[offset + column];
+				error += fabs(D[column]);
+			}
+		}
 
-				// Update mean error value.
-				error += abs(D);
+		// Add the row terms to b matrix.
+		float rowB[PARAMETER_COUNT] = {0.0f, 0.0f, 0.0f, 0.0f};
+		int column = 0;
+#ifdef IC_SSE2
+		__m128 b0 = _mm_setzero_ps();
+		__m128 b1 = _mm_setzero_ps();
+		__m128 b2 = _mm_setzero_ps();
+		__m128 b3 = _mm_setzero_ps();
+		for(; column+4<=this->samplingColumns; column+=4)
+		{
+			__m128 d = _mm_loadu_ps(&D[column]);
+			b0 = _mm_add_ps(b0, _mm_mul_ps(_mm_loadu_ps(sd0 + offset + column), d));
+			b1 = _mm_add_ps(b1, _mm_mul_ps(_mm_loadu_ps(sd1 + offset + column), d));
+			b2 = _mm_add_ps(b2, _mm_mul_ps(_mm_loadu_ps(sd2 + offset + column), d));
+			b3 = _mm_add_ps(b3, _mm_mul_ps(_mm_loadu_ps(sd3 + offset + column), d));
+		}
 
-				// Add a term to b matrix.
-				CvScalar stdesc = cvGet2D(pStDesc, y, x);
-				for(int i=0; i<4; i++)
-				{
-					float value = CV_MAT_ELEM((*b), float, i, 0);
-					CV_MAT_ELEM((*b), float, i, 0) = value + ((float)stdesc.val[i] * D);
-				} 
-			}
+		// horizontal sum : transpose the 4 accumulators and add the rows
+		_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+		_mm_storeu_ps(rowB, _mm_add_ps(_mm_add_ps(b0, b1), _mm_add_ps(b2, b3)));
+#endif
+		for(; column<this->samplingColumns; column++)
+		{
+			float d = D[column];
+			rowB[0] += sd0[offset + column] * d;
+			rowB[1] += sd1[offset + column] * d;
+			rowB[2] += sd2[offset + column] * d;
+			rowB[3] += sd3[offset + column] * d;
 		}
+
+		for(int i=0; i<PARAMETER_COUNT; i++)
+			b[i] += rowB[i];
 	}
 
 	// Finally, calculate mean_error.
@@ -202,45 +223,41 @@ float InverseCompositional::UpdateHomography(IplImage* image, float* delta)
 		error /= pixel_count;
 
 	// Find parameter increment. 
-	cvGEMM(iH, b, 1, 0, 0, delta_p);
-	float delta_wz = CV_MAT_ELEM(*delta_p, float, 0, 0) * PARAMETER_AMPLIFICATION;
-	float delta_tx = CV_MAT_ELEM(*delta_p, float, 1, 0) * PARAMETER_AMPLIFICATION;
-	float delta_ty = CV_MAT_ELEM(*delta_p, float, 2, 0) * PARAMETER_AMPLIFICATION;
-	float delta_s  = CV_MAT_ELEM(*delta_p, float, 3, 0) * PARAMETER_AMPLIFICATION;
-
-	init_warp(dW, delta_wz, delta_tx, delta_ty, 1.0f+delta_s);
-	// Invert warp.
-	float inv_res = cvInvert(dW, idW);
-	if(inv_res==0)
+	double delta_p[PARAMETER_COUNT];
+	for(int i=0; i<PARAMETER_COUNT; i++)
+	{
+		delta_p[i] = 0.0;
+		for(int j=0; j<PARAMETER_COUNT; j++)
+			delta_p[i] += this->iH[i*PARAMETER_COUNT + j] * b[j];
+		delta_p[i] *= PARAMETER_AMPLIFICATION;
+	}
+	double delta_wz = delta_p[0];
+	double delta_tx = delta_p[1];
+	double delta_ty = delta_p[2];
+	double delta_s  = delta_p[3];
+
+	// Invert warp update dW = [s -wz tx; wz s ty; 0 0 1].
+	double s = 1.0 + delta_s;
+	double determinant = s*s + delta_wz*delta_wz;
+	if(determinant == 0.0)
 	{
 		printf("Error: Warp matrix is singular.\n");
 		return -1.0;
-	} 
+	}
+	double a = s / determinant;
+	double c = delta_wz / determinant;
+	Matrix3 idW(	 a,  c, -( a*delta_tx + c*delta_ty),
+					-c,  a, -(-c*delta_tx + a*delta_ty),
+					0.0, 0.0, 1.0);
 
-	// update homography at W
-	cvGEMM(W, idW, 1, 0, 0, dW);
-	cvCopy(dW, W);
+	// update homography W = W * dW^-1
+	this->homography = this->homography * idW;
 
 	// return delta factor
 	if(delta)
 	{
-		(*delta) = abs(delta_wz) + abs(delta_tx) + abs(delta_ty) + abs(delta_s);
+		(*delta) = (float)(fabs(delta_wz) + fabs(delta_tx) + fabs(delta_ty) + fabs(delta_s));
 	}
 
-	return error;
+	return (float)error;
 }
-
-void InverseCompositional::init_warp(CvMat* W, float wz, float tx, float ty, float s)
-{
-	CV_MAT_ELEM(*W, float, 0, 0) = s;
-	CV_MAT_ELEM(*W, float, 1, 0) = wz;
-	CV_MAT_ELEM(*W, float, 2, 0) = 0;
-
-	CV_MAT_ELEM(*W, float, 0, 1) = -wz;
-	CV_MAT_ELEM(*W, float, 1, 1) = s;
-	CV_MAT_ELEM(*W, float, 2, 1) = 0;
-
-	CV_MAT_ELEM(*W, float, 0, 2) = tx;
-	CV_MAT_ELEM(*W, float, 1, 2) = ty;
-	CV_MAT_ELEM(*W, float, 2, 2) = 1;
-}
\ No newline at end of file
@@ -51,63 +51,50 @@ namespace windage
 	class InverseCompositional : public TemplateMinimization
 	{
 	private:
-		IplImage* pStDesc;	// Steepest descent images.
+		static const int PARAMETER_COUNT = 4;	// rotation (wz), translation (tx, ty), scale (s)
 
-		CvMat* W;	// Current value of warp W(x,p)
-		CvMat* dW;	// Warp update.
-		CvMat* idW;	// Inverse of warp update.
-		CvMat* X;	// Point in coordinate frame of T.
-		CvMat* Z;	// Point in coordinate frame of I.
+		int samplingColumns;
+		int samplingRows;
 
-		CvMat* H;	// Hessian.
-		CvMat* iH;	// Inverse of Hessian.
-		CvMat* b;	// Vector in the right side of the system of linear equations.
-		CvMat* delta_p;	// Parameter update value.
+		std::vector<float> steepestDescent;		///< PARAMETER_COUNT contiguous images of samplingColumns x samplingRows
+		std::vector<float> templateValue;		///< template intensity at the sampling points
+		double iH[PARAMETER_COUNT*PARAMETER_COUNT];	///< inverse of Hessian
 
-		void init_warp(CvMat* W, float wz, float tx, float ty, float s);
+		TemplateMinimization* CreateLevel(int width, int height){return new InverseCompositional(width, height);};
 	public:
 		InverseCompositional(int width=150, int height=150) : TemplateMinimization(width, height)
 		{
 			this->PARAMETER_AMPLIFICATION = 3.0;
 
-			// Create matrices.
-			pStDesc = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 4);
-			
-			W = cvCreateMat(3, 3, CV_32F);
-			dW = cvCreateMat(3, 3, CV_32F);
-			idW = cvCreateMat(3, 3, CV_32F);
-			X = cvCreateMat(3, 1, CV_32F);
-			Z = cvCreateMat(3, 1, CV_32F);
-
-			H = cvCreateMat(4, 4, CV_32F);
-			iH = cvCreateMat(4, 4, CV_32F);
-			b = cvCreateMat(4, 1, CV_32F);
-			delta_p = cvCreateMat(4, 1, CV_32F);
+			// sampling grid : x, y = 0, SAMPLING_STEP, ... < size
+			this->samplingColumns = (this->width + this->SAMPLING_STEP-1)/this->SAMPLING_STEP;
+			this->samplingRows = (this->height + this->SAMPLING_STEP-1)/this->SAMPLING_STEP;
 		}
 		~InverseCompositional()
 		{
-			if(templateImage)	cvReleaseImage(&templateImage);
-			if(samplingImage)	cvReleaseImage(&samplingImage);
-
-			if(pStDesc)	cvReleaseImage(&pStDesc);
-
-			if(W)	cvReleaseMat(&W);
-			if(dW)	cvReleaseMat(&dW);
-			if(idW)	cvReleaseMat(&idW);
-			if(X)	cvReleaseMat(&X);
-			if(Z)	cvReleaseMat(&Z);
-
-			if(H)	cvReleaseMat(&H);
-			if(iH)	cvReleaseMat(&iH);
-			if(b)	cvReleaseMat(&b);
-			if(delta_p) cvReleaseMat(&delta_p);
 		}
 		
-		Matrix3 GetHomography();
-		void SetInitialHomography(Matrix3 homography);
+		inline Matrix3 GetHomography(){return this->homography;};
+		inline void SetInitialHomography(Matrix3 homography){this->homography = homography;};
 
 		bool AttatchTemplateImage(IplImage* image);
+		/**
+		 * @brief
+		 *		precompute the steepest descent images and the inverse of Hessian
+		 * @remark
+		 *		steepest descent images are stored as contiguous float arrays (one array per parameter)
+		 */
 		bool Initialize();
+		/**
+		 * @brief
+		 *		one inverse compositional iteration
+		 * @remark
+		 *		samples the image by bilinear interpolation (WarpSampler.h),
+		 *		accumulates the steepest descent images by the error image with SSE2
+		 *		and composes the inverse of the 4 parameter warp update analytically
+		 * @return
+		 *		mean absolute intensity error of the valid samples (-1 at failure)
+		 */
 		float UpdateHomography(IplImage* image, float* delta = NULL);
 	};
 }
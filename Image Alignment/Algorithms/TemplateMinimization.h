@@ -63,6 +63,117 @@ namespace windage
 
 		bool isInitialize;
 
+		// coarse-to-fine alignment
+		static const int MIN_PYRAMID_SIZE = 16;
+		int pyramidLevel;
+		std::vector<float> convergenceDelta;			///< per-level threshold on the returned delta
+		std::vector<TemplateMinimization*> levels;		///< aligner of each coarse level (levels[0] is level 1)
+		std::vector<IplImage*> imagePyramid;			///< downsampled input image of each coarse level
+
+		/**
+		 * @brief
+		 *		create the same kind of aligner for a coarse level template
+		 */
+		virtual TemplateMinimization* CreateLevel(int width, int height) = 0;
+
+		/**
+		 * @brief
+		 *		homography between the scaled template and image coordinates, S H S^-1 (S = diag(s, s, 1))
+		 */
+		static Matrix3 ScaleHomography(Matrix3 homography, double scale)
+		{
+			homography.m1[2] *= scale;
+			homography.m1[5] *= scale;
+			homography.m1[6] /= scale;
+			homography.m1[7] /= scale;
+			return homography;
+		}
+
+		/**
+		 * @brief
+		 *		iterate one level from the full resolution estimation
+		 * @remark
+		 *		the Jacobians of a coarse level are recomputed at its start homography,
+		 *		estimation is updated to the full resolution result of the level
+		 * @return
+		 *		iteration count (-1 when an update fails)
+		 */
+		int AlignLevel(int level, IplImage* image, int maxIteration, Matrix3* estimation, float* firstError, float* lastError, std::vector<Matrix3>* history)
+		{
+			TemplateMinimization* aligner = level > 0 ? this->levels[level-1] : this;
+			double scale = 1.0/(1 << level);
+
+			aligner->SetInitialHomography(ScaleHomography(*estimation, scale));
+			if(level > 0)
+				aligner->UpdateJacobian();
+
+			int iteration = 0;
+			for(iteration=0; iteration<maxIteration; iteration++)
+			{
+				float delta = 0.0f;
+				float levelError = aligner->UpdateHomography(image, &delta);
+				if(levelError < 0.0f)
+					return -1;
+				if(firstError && iteration == 0)
+					(*firstError) = levelError;
+				(*lastError) = levelError;
+
+				(*estimation) = ScaleHomography(aligner->GetHomography(), 1.0/scale);
+				history->push_back(*estimation);
+				if(delta < this->convergenceDelta[level])
+				{
+					iteration++;
+					break;
+				}
+			}
+			return iteration;
+		}
+
+		void ReleasePyramid()
+		{
+			for(unsigned int i=0; i<levels.size(); i++)
+				delete levels[i];
+			levels.clear();
+			for(unsigned int i=0; i<imagePyramid.size(); i++)
+				cvReleaseImage(&imagePyramid[i]);
+			imagePyramid.clear();
+		}
+
+		/**
+		 * @brief
+		 *		build the template pyramid and initialize the aligner of each coarse level
+		 * @remark
+		 *		called at the end of Initialize of the implementation class
+		 */
+		void InitializePyramid()
+		{
+			ReleasePyramid();
+
+			// the coarse levels start far from the minimum where full steps overshoot the projective terms
+			const float COARSE_AMPLIFICATION = 0.5f;
+
+			IplImage* levelTemplate = this->templateImage;
+			for(int level=1; level<=this->pyramidLevel; level++)
+			{
+				CvSize size = cvSize((levelTemplate->width+1)/2, (levelTemplate->height+1)/2);
+				if(size.width < MIN_PYRAMID_SIZE || size.height < MIN_PYRAMID_SIZE)
+					break;
+
+				IplImage* downTemplate = cvCreateImage(size, IPL_DEPTH_8U, 1);
+				cvPyrDown(levelTemplate, downTemplate);
+
+				TemplateMinimization* aligner = this->CreateLevel(size.width, size.height);
+				aligner->SetParameterAmplification(this->PARAMETER_AMPLIFICATION * COARSE_AMPLIFICATION);
+				aligner->AttatchTemplateImage(downTemplate);
+				aligner->SetInitialHomography(ScaleHomography(this->homography, 1.0/(1 << level)));
+				aligner->Initialize();
+				levels.push_back(aligner);
+
+				cvReleaseImage(&downTemplate);
+				levelTemplate = aligner->GetTemplateImage();
+			}
+		}
+
 	public:
 		TemplateMinimization(int width=150, int height=150)
 		{
@@ -81,9 +192,14 @@ namespace windage
 			cvZero(samplingImage);
 
 			isInitialize = false;
+
+			pyramidLevel = 0;
+			convergenceDelta.resize(1, 0.01f);
 		}
 		virtual ~TemplateMinimization()
 		{
+			ReleasePyramid();
+
 			if(templateImage)	cvReleaseImage(&templateImage);
 			if(samplingImage)	cvReleaseImage(&samplingImage);
 		}
@@ -101,6 +217,107 @@ namespace windage
 		virtual bool AttatchTemplateImage(IplImage* image) = 0;
 		virtual bool Initialize() = 0;
 		virtual float UpdateHomography(IplImage* image, float* delta = NULL) = 0;
+
+		/**
+		 * @brief
+		 *		recompute the warp Jacobians at the current homography (no-op when they do not depend on it)
+		 */
+		virtual void UpdateJacobian(){};
+
+		/**
+		 * @brief
+		 *		set the number of coarse levels (0 : single resolution)
+		 * @remark
+		 *		the template pyramid is built at next Initialize,
+		 *		levels smaller than MIN_PYRAMID_SIZE are skipped
+		 */
+		inline void SetPyramidLevel(int level)
+		{
+			ReleasePyramid();
+			this->pyramidLevel = MAX(level, 0);
+			this->convergenceDelta.resize(this->pyramidLevel + 1, this->convergenceDelta.back());
+		}
+		inline int GetPyramidLevel(){return this->pyramidLevel;};
+
+		/**
+		 * @brief
+		 *		set the early stop threshold on the delta of UpdateHomography (level -1 : all levels)
+		 */
+		inline void SetConvergenceDelta(float delta, int level = -1)
+		{
+			for(int i=0; i<(int)this->convergenceDelta.size(); i++)
+				if(level < 0 || level == i)
+					this->convergenceDelta[i] = delta;
+		}
+		inline float GetConvergenceDelta(int level = 0){return this->convergenceDelta[level];};
+
+		/**
+		 * @brief
+		 *		align the template from the coarsest level to the finest level
+		 * @remark
+		 *		each level iterates until the delta falls under its convergence delta or maxIteration,
+		 *		the estimate of each level is propagated to the next finer level,
+		 *		history (optional) receives the full resolution homography of every iteration
+		 * @warning
+		 *		a coarse level whose error grows is discarded and the next finer level restarts from its start
+		 * @return
+		 *		total iteration count (-1 at failure), error is the last error of the finest level
+		 */
+		int Align(IplImage* image, int maxIteration, float* error = NULL, std::vector<Matrix3>* history = NULL)
+		{
+			if(image == NULL || this->isInitialize == false)
+				return -1;
+
+			// input image pyramid
+			int levelCount = (int)this->levels.size();
+			IplImage* levelImage = image;
+			for(int i=0; i<levelCount; i++)
+			{
+				CvSize size = cvSize((levelImage->width+1)/2, (levelImage->height+1)/2);
+				if(i >= (int)this->imagePyramid.size())
+					this->imagePyramid.push_back(NULL);
+				if(this->imagePyramid[i] == NULL || this->imagePyramid[i]->width != size.width || this->imagePyramid[i]->height != size.height)
+				{
+					if(this->imagePyramid[i]) cvReleaseImage(&this->imagePyramid[i]);
+					this->imagePyramid[i] = cvCreateImage(size, IPL_DEPTH_8U, 1);
+				}
+				cvPyrDown(levelImage, this->imagePyramid[i]);
+				levelImage = this->imagePyramid[i];
+			}
+
+			Matrix3 start = this->GetHomography();
+			int totalIteration = 0;
+			float levelError = 0.0f;
+
+			// coarse levels
+			Matrix3 estimation = start;
+			std::vector<Matrix3> pyramidHistory;
+			for(int level=levelCount; level>0; level--)
+			{
+				Matrix3 levelStart = estimation;
+				float firstError = -1.0f;
+				int iteration = this->AlignLevel(level, this->imagePyramid[level-1], maxIteration, &estimation, &firstError, &levelError, &pyramidHistory);
+				totalIteration += iteration;
+
+				// a failing or diverging coarse level must not spoil the finer ones
+				if(iteration <= 0 || levelError > firstError)
+					estimation = levelStart;
+			}
+
+			// finest level from the pyramid estimate
+			float pyramidError = 0.0f;
+			int iteration = this->AlignLevel(0, image, maxIteration, &estimation, NULL, &pyramidError, &pyramidHistory);
+			if(iteration < 0)
+				return -1;
+			totalIteration += iteration;
+
+			this->SetInitialHomography(estimation);
+			if(history)
+				history->insert(history->end(), pyramidHistory.begin(), pyramidHistory.end());
+			if(error)
+				(*error) = pyramidError;
+			return totalIteration;
+		}
 	};
 }
 
@@ -0,0 +1,218 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek
+ *   Woontack Woo
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#ifndef _WARP_SAMPLER_H_
+#define _WARP_SAMPLER_H_
+
+#include <cv.h>
+
+#include "wMatrix.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define WARP_SAMPLER_SSE2
+	#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+	#define WARP_ALIGN16 __declspec(align(16))
+#else
+	#define WARP_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+namespace windage
+{
+	/**
+	 * @brief
+	 *		analytic jacobian of the homography warp w(x) with respect to h = (h11 ... h32), h33 fixed
+	 * @remark
+	 *		u = (h11 x + h12 y + h13) / d, v = (h21 x + h22 y + h23) / d, d = h31 x + h32 y + h33
+	 */
+	inline void GetHomographyJacobian(const Matrix3& homography, double x, double y, Vector2* jacobian)
+	{
+		const double* h = homography.m1;
+		double id = 1.0 / (h[6]*x + h[7]*y + h[8]);
+		double u = (h[0]*x + h[1]*y + h[2]) * id;
+		double v = (h[3]*x + h[4]*y + h[5]) * id;
+
+		jacobian[0] = Vector2(x*id, 0.0);
+		jacobian[1] = Vector2(y*id, 0.0);
+		jacobian[2] = Vector2(id, 0.0);
+		jacobian[3] = Vector2(0.0, x*id);
+		jacobian[4] = Vector2(0.0, y*id);
+		jacobian[5] = Vector2(0.0, id);
+		jacobian[6] = Vector2(-u*x*id, -v*x*id);
+		jacobian[7] = Vector2(-u*y*id, -v*y*id);
+	}
+
+	/**
+	 * @brief
+	 *		bilinear sampling of the image at w(x) for the template row (x0 + i*step, y), i < count
+	 * @remark
+	 *		produces the warped intensity and its image gradient (derivative of the bilinear patch) in one pass,
+	 *		gradientX / gradientY can be NULL, samples out of the image are marked as invalid
+	 * @return
+	 *		valid sample count
+	 */
+	inline int SampleWarpedRow(IplImage* image, const Matrix3& homography, int x0, int y, int step, int count,
+							   float* value, float* gradientX, float* gradientY, unsigned char* valid)
+	{
+		const double* h = homography.m1;
+		const int width = image->width;
+		const int height = image->height;
+		const int widthStep = image->widthStep;
+		const unsigned char* data = (const unsigned char*)image->imageData;
+
+		// numerators and denominator are linear along the row
+		double nu0 = h[0]*x0 + h[1]*y + h[2];
+		double nv0 = h[3]*x0 + h[4]*y + h[5];
+		double d0  = h[6]*x0 + h[7]*y + h[8];
+		double dnu = h[0]*step;
+		double dnv = h[3]*step;
+		double dd  = h[6]*step;
+
+		int validCount = 0;
+		int i = 0;
+#ifdef WARP_SAMPLER_SSE2
+		const __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maxX = _mm_set1_ps((float)(width - 1));
+		const __m128 maxY = _mm_set1_ps((float)(height - 1));
+		for(; i+4<=count; i+=4)
+		{
+			__m128 k = _mm_add_ps(_mm_set1_ps((float)i), index);
+			__m128 nu = _mm_add_ps(_mm_set1_ps((float)nu0), _mm_mul_ps(k, _mm_set1_ps((float)dnu)));
+			__m128 nv = _mm_add_ps(_mm_set1_ps((float)nv0), _mm_mul_ps(k, _mm_set1_ps((float)dnv)));
+			__m128 d  = _mm_add_ps(_mm_set1_ps((float)d0), _mm_mul_ps(k, _mm_set1_ps((float)dd)));
+			__m128 u = _mm_div_ps(nu, d);
+			__m128 v = _mm_div_ps(nv, d);
+
+			// inside [0, size-1) for the 2x2 neighbourhood
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmplt_ps(u, maxX)),
+									   _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmplt_ps(v, maxY)));
+			int mask = _mm_movemask_ps(inside);
+			u = _mm_and_ps(u, inside);
+			v = _mm_and_ps(v, inside);
+
+			__m128i iu = _mm_cvttps_epi32(u);
+			__m128i iv = _mm_cvttps_epi32(v);
+			__m128 fu = _mm_sub_ps(u, _mm_cvtepi32_ps(iu));
+			__m128 fv = _mm_sub_ps(v, _mm_cvtepi32_ps(iv));
+
+			WARP_ALIGN16 int ou[4];
+			WARP_ALIGN16 int ov[4];
+			WARP_ALIGN16 float p00[4];
+			WARP_ALIGN16 float p10[4];
+			WARP_ALIGN16 float p01[4];
+			WARP_ALIGN16 float p11[4];
+			_mm_store_si128((__m128i*)ou, iu);
+			_mm_store_si128((__m128i*)ov, iv);
+			for(int j=0; j<4; j++)
+			{
+				const unsigned char* pixel = data + ov[j]*widthStep + ou[j];
+				p00[j] = pixel[0];
+				p10[j] = pixel[1];
+				p01[j] = pixel[widthStep];
+				p11[j] = pixel[widthStep + 1];
+			}
+
+			__m128 I00 = _mm_load_ps(p00);
+			__m128 I10 = _mm_load_ps(p10);
+			__m128 I01 = _mm_load_ps(p01);
+			__m128 I11 = _mm_load_ps(p11);
+			__m128 top = _mm_add_ps(I00, _mm_mul_ps(fu, _mm_sub_ps(I10, I00)));
+			__m128 bottom = _mm_add_ps(I01, _mm_mul_ps(fu, _mm_sub_ps(I11, I01)));
+			__m128 result = _mm_and_ps(_mm_add_ps(top, _mm_mul_ps(fv, _mm_sub_ps(bottom, top))), inside);
+			_mm_storeu_ps(value + i, result);
+
+			if(gradientX)
+			{
+				__m128 gx = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, fv), _mm_sub_ps(I10, I00)), _mm_mul_ps(fv, _mm_sub_ps(I11, I01)));
+				_mm_storeu_ps(gradientX + i, _mm_and_ps(gx, inside));
+			}
+			if(gradientY)
+			{
+				_mm_storeu_ps(gradientY + i, _mm_and_ps(_mm_sub_ps(bottom, top), inside));
+			}
+
+			for(int j=0; j<4; j++)
+			{
+				valid[i+j] = (unsigned char)((mask >> j) & 1);
+				validCount += valid[i+j];
+			}
+		}
+#endif
+		for(; i<count; i++)
+		{
+			double d = d0 + dd*i;
+			float u = (float)((nu0 + dnu*i) / d);
+			float v = (float)((nv0 + dnv*i) / d);
+			if(!(u >= 0.0f && u < width-1 && v >= 0.0f && v < height-1))
+			{
+				value[i] = 0.0f;
+				if(gradientX) gradientX[i] = 0.0f;
+				if(gradientY) gradientY[i] = 0.0f;
+				valid[i] = 0;
+				continue;
+			}
+
+			int iu = (int)u;
+			int iv = (int)v;
+			float fu = u - iu;
+			float fv = v - iv;
+			const unsigned char* pixel = data + iv*widthStep + iu;
+			float I00 = pixel[0];
+			float I10 = pixel[1];
+			float I01 = pixel[widthStep];
+			float I11 = pixel[widthStep + 1];
+
+			float top = I00 + fu*(I10 - I00);
+			float bottom = I01 + fu*(I11 - I01);
+			value[i] = top + fv*(bottom - top);
+			if(gradientX) gradientX[i] = (1.0f - fv)*(I10 - I00) + fv*(I11 - I01);
+			if(gradientY) gradientY[i] = bottom - top;
+			valid[i] = 1;
+			validCount++;
+		}
+
+		return validCount;
+	}
+}
+
+#endif
@@ -38,10 +38,76 @@
  * ======================================================================== */
 
 #include "homographyESM.h"
+#include "WarpSampler.h"
 using namespace windage;
 
 #include <omp.h>
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define ESM_SSE2
+	#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+	#define ESM_ALIGN16 __declspec(align(16))
+#else
+	#define ESM_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+static const int ESM_PARAMETER_COUNT = 8;
+
+/**
+ * @brief
+ *		solve A x = b for symmetric positive definite 8x8 A by Cholesky decomposition (A = L L^T)
+ * @remark
+ *		windageLib/src/Algorithms/MultiTemplateESM.cpp has the same solver (the two trees do not share sources), keep them identical
+ */
+static bool SolveCholesky8(const double* A, const double* b, double* x)
+{
+	const int n = ESM_PARAMETER_COUNT;
+	double L[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+
+	for(int j=0; j<n; j++)
+	{
+		double sum = A[j*n + j];
+		for(int k=0; k<j; k++)
+			sum -= L[j*n + k] * L[j*n + k];
+		if(sum <= 0.0)
+			return false;
+		L[j*n + j] = sqrt(sum);
+
+		double inverse = 1.0 / L[j*n + j];
+		for(int i=j+1; i<n; i++)
+		{
+			double value = A[i*n + j];
+			for(int k=0; k<j; k++)
+				value -= L[i*n + k] * L[j*n + k];
+			L[i*n + j] = value * inverse;
+		}
+	}
+
+	// L y = b
+	double y[ESM_PARAMETER_COUNT];
+	for(int i=0; i<n; i++)
+	{
+		double value = b[i];
+		for(int k=0; k<i; k++)
+			value -= L[i*n + k] * y[k];
+		y[i] = value / L[i*n + i];
+	}
+
+	// L^T x = y
+	for(int i=n-1; i>=0; i--)
+	{
+		double value = y[i];
+		for(int k=i+1; k<n; k++)
+			value -= L[k*n + i] * x[k];
+		x[i] = value / L[i*n + i];
+	}
+
+	return true;
+}
+
 bool HomographyESM::AttatchTemplateImage(IplImage* image)
 {
 	if(this->templateImage == NULL)
@@ -59,8 +125,6 @@ bool HomographyESM::Initialize()
 {
 	dI.clear();
 	dI.resize(q);
-	dwI.clear();
-	dwI.resize(q);
 	dwx.clear();
 	dwx.resize(q);
 	for(int i=0; i<q; i++)
@@ -68,14 +132,8 @@ bool HomographyESM::Initialize()
 
 	se.clear();
 	se.resize(q);
-	sxc.clear();
-	sxc.resize(q);
 
 	// initialze d(I(p))/d(p) & d(w(x))/d(x)
-	Vector3 point1, point2, out1, out2;
-	point1.z = 1.0;
-	point2.z = 1.0;
-
 	int index = 0;
 	for(int y=DELTA; y<templateImage->height-DELTA; y+= SAMPLING_STEP)
 	{
@@ -101,37 +159,30 @@ bool HomographyESM::Initialize()
 			dI[index] = tempdI;
 
 			// dw(x) / dx (2xp jacobian matrix)
-			point1.x = x;
-			point1.y = y;
-			point1.z = 1.0;
-
-			// TODO! replace homography derivation
-			for(int i=0; i<this->p; i++)
-			{
-				windage::Matrix3 tempHomography1 = this->homography;
-				windage::Matrix3 tempHomography2 = this->homography;
-
-				tempHomography1.m1[i] -= HOMOGRAPHY_DELTA;
-				tempHomography2.m1[i] += HOMOGRAPHY_DELTA;
-
-				out1 = tempHomography1 * point1;
-				out2 = tempHomography2 * point1;
-				out1 /= out1.z;
-				out2 /= out2.z;
-				out1 = (out2 - out1)/(2*HOMOGRAPHY_DELTA);
-
-				windage::Vector2 temp(out1.x, out1.y);
-				dwx[index][i] = temp;
-			}
+			GetHomographyJacobian(this->homography, x, y, &dwx[index][0]);
 
 			index++;
 		}
 	}
 
 	isInitialize = true;
+	this->InitializePyramid();
 	return true;
 }
 
+void HomographyESM::UpdateJacobian()
+{
+	int index = 0;
+	for(int y=DELTA; y<templateImage->height-DELTA; y+= SAMPLING_STEP)
+	{
+		for(int x=DELTA; x<templateImage->width-DELTA; x+= SAMPLING_STEP)
+		{
+			GetHomographyJacobian(this->homography, x, y, &dwx[index][0]);
+			index++;
+		}
+	}
+}
+
 float HomographyESM::UpdateHomography(IplImage* image, float* delta)
 {
 	if(isInitialize == false)
@@ -143,86 +194,123 @@ float HomographyESM::UpdateHomography(IplImage* image, float* delta)
 	if(image->nChannels != 1)
 		return -1.0;
 
-	// update homography
-	int index = 0;
-//	#pragma omp parallel for 
-	for(int y=DELTA; y<templateImage->height-DELTA; y+= SAMPLING_STEP)
+	// normal equation (J^T J) dx = J^T e, J = (J(e) + J(xc)) * dw(x)/dx
+	double JtJ[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+	double Jte[ESM_PARAMETER_COUNT];
+	double errorSum = 0.0;
+	int validCount = 0;
+	for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+		JtJ[i] = 0.0;
+	for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+		Jte[i] = 0.0;
+
+	#pragma omp parallel
 	{
-		Vector3 point, out;
-		int ix, iy;
-		Vector2 tempdwI;
-		unsigned char I1 = 0;
-		unsigned char I2 = 0;
-		unsigned char value = 0;
-
-		for(int x=DELTA; x<templateImage->width-DELTA; x+= SAMPLING_STEP)
+		double localJtJ[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+		double localJte[ESM_PARAMETER_COUNT];
+		double localError = 0.0;
+		int localCount = 0;
+		for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+			localJtJ[i] = 0.0;
+		for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+			localJte[i] = 0.0;
+
+		std::vector<float> warped(this->samplingColumns);
+		std::vector<float> gradientX(this->samplingColumns);
+		std::vector<float> gradientY(this->samplingColumns);
+		std::vector<unsigned char> valid(this->samplingColumns);
+
+		#pragma omp for schedule(static)
+		for(int row=0; row<this->samplingRows; row++)
 		{
-//			int index = ((y-DELTA)/SAMPLING_STEP) * ((templateImage->width-DELTA-1)/SAMPLING_STEP) + ((x-DELTA)/SAMPLING_STEP);
-
-			point.x = x;
-			point.y = y;
-			point.z = 1.0;
-			out = this->homography * point;
-			float ww = 1.0f/(float)out.z;
-			out *= ww;
-
-			ix = (int)(out.x);
-			iy = (int)(out.y);
-			ww = 1.0f/DELTA;
-
-			// sxc
-			if( 0 < ix && ix+DELTA < image->width && 0 < iy && iy+DELTA < image->height)
+			// row sums are accumulated in float and flushed to double per row
+			ESM_ALIGN16 float rowJtJ[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+			ESM_ALIGN16 float rowJte[ESM_PARAMETER_COUNT];
+			ESM_ALIGN16 float J[ESM_PARAMETER_COUNT];
+			for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+				rowJtJ[i] = 0.0f;
+			for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+				rowJte[i] = 0.0f;
+
+			// warped intensity and gradient of the row (bilinear)
+			int y = DELTA + row*SAMPLING_STEP;
+			SampleWarpedRow(image, this->homography, DELTA, y, SAMPLING_STEP, this->samplingColumns, &warped[0], &gradientX[0], &gradientY[0], &valid[0]);
+
+			for(int column=0; column<this->samplingColumns; column++)
 			{
-				value = CV_IMAGE_ELEM(image, unsigned char, iy, ix);
-				I1 = CV_IMAGE_ELEM(image, unsigned char, iy, ix+DELTA);
-				I2 = CV_IMAGE_ELEM(image, unsigned char, iy+DELTA, ix);
+				int x = DELTA + column*SAMPLING_STEP;
+				int index = row*this->samplingColumns + column;
+
+				// for debuging
+				CV_IMAGE_ELEM(samplingImage, unsigned char, y, x) = (unsigned char)cvRound(warped[column]);
+				if(!valid[column])
+					continue;
+
+				// Jsum = J(e) + J(xc)
+				float gx = (float)dI[index].x + gradientX[column];
+				float gy = (float)dI[index].y + gradientY[column];
+				const Vector2* dw = &dwx[index][0];
+				for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+					J[i] = (float)(gx*dw[i].x + gy*dw[i].y);
+
+				// delta_s
+				float e = warped[column] - se[index];
+				localError += fabs(e);
+				localCount++;
+
+#ifdef ESM_SSE2
+				__m128 j0 = _mm_load_ps(J);
+				__m128 j1 = _mm_load_ps(J + 4);
+				__m128 ee = _mm_set1_ps(e);
+				_mm_store_ps(rowJte, _mm_add_ps(_mm_load_ps(rowJte), _mm_mul_ps(j0, ee)));
+				_mm_store_ps(rowJte + 4, _mm_add_ps(_mm_load_ps(rowJte + 4), _mm_mul_ps(j1, ee)));
+				for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+				{
+					__m128 ji = _mm_set1_ps(J[i]);
+					float* h = rowJtJ + i*ESM_PARAMETER_COUNT;
+					_mm_store_ps(h, _mm_add_ps(_mm_load_ps(h), _mm_mul_ps(j0, ji)));
+					_mm_store_ps(h + 4, _mm_add_ps(_mm_load_ps(h + 4), _mm_mul_ps(j1, ji)));
+				}
+#else
+				for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+				{
+					rowJte[i] += J[i] * e;
+					for(int j=0; j<ESM_PARAMETER_COUNT; j++)
+						rowJtJ[i*ESM_PARAMETER_COUNT + j] += J[i] * J[j];
+				}
+#endif
 			}
-			sxc[index] = (float)value;
-			tempdwI.x = (float)(I1 - value)*ww;
-			tempdwI.y = (float)(I2 - value)*ww;
-
-			// for debuging
-			CV_IMAGE_ELEM(samplingImage, unsigned char, y, x) = value;
 
-			// Jsum = J(e) + J(xc)
-			windage::Vector2 tempJ = (dI[index] + tempdwI);
-			for(int i=0; i<this->p; i++)
-			{
-				CV_MAT_ELEM((*JacobianSum), float, index, i) = (float)(tempJ * dwx[index][i]);
-			}
+			for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+				localJtJ[i] += rowJtJ[i];
+			for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+				localJte[i] += rowJte[i];
+		}
 
-			index++;
+		#pragma omp critical
+		{
+			for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+				JtJ[i] += localJtJ[i];
+			for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+				Jte[i] += localJte[i];
+			errorSum += localError;
+			validCount += localCount;
 		}
 	}
 
-	// delta_s
-	float error = 0.0;
-	for(int i=0; i<this->q; i++)
-	{
-		float value = (sxc[i] - se[i]);
-		CV_MAT_ELEM((*dS), float, i, 0) = value;
-		error += abs(value);
-	}
-	error /= this->q ;
-
-	// pseudo-invers
-//*
-	cvTranspose(JacobianSum, JacobianSumT);
-	cvMatMul(JacobianSumT, JacobianSum, Jacobian);
-	cvMatMul(JacobianSumT, dS, JacobianTdS);
-
-	double inv_res = cvInvert(Jacobian, JacobianInvers, CV_CHOLESKY);
-	cvMatMul(JacobianInvers, JacobianTdS, dx);
-//*/
-/*
-	cvInvert(JacobianSum, JacobianSumT, cv::DECOMP_SVD);
-	cvMatMul(JacobianSumT, dS, JacobianTdS);
-//*/
+	if(validCount < ESM_PARAMETER_COUNT)
+		return -1.0;
+	float error = (float)(errorSum / validCount);
+
+	double dx[ESM_PARAMETER_COUNT];
+	if(!SolveCholesky8(JtJ, Jte, dx))
+		return -1.0;
+
 	// update homography
 	float tempDelta = 0.0;
 	for(int i=0; i<this->p; i++)
 	{
-		float value = -2.0f * CV_MAT_ELEM((*dx), float, 0, i) * PARAMETER_AMPLIFICATION;
+		float value = -2.0f * (float)dx[i] * PARAMETER_AMPLIFICATION;
 		this->homography.m1[i] += value;
 
 		tempDelta += abs(value);
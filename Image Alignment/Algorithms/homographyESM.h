@@ -51,60 +51,33 @@ namespace windage
 	class HomographyESM : public TemplateMinimization
 	{
 	private:
-		float HOMOGRAPHY_DELTA;
 		static const int HOMOGRAPHY_COUNT = 9;
 
 		int q;
 		int p;
+		int samplingColumns;
+		int samplingRows;
 
 		std::vector<Vector2> dI;
-		std::vector<Vector2> dwI;
 		std::vector<std::vector<Vector2>> dwx;
 
 		std::vector<float> se;
-		std::vector<float> sxc;
 
-		CvMat* JacobianSum;
-		CvMat* JacobianSumT;
-		CvMat* Jacobian;
-		CvMat* JacobianInvers;
-		CvMat* dS;
-		CvMat* JacobianTdS;
-		CvMat* dx;
+		TemplateMinimization* CreateLevel(int width, int height){return new HomographyESM(width, height);};
 
 	public:
 		HomographyESM(int width=150, int height=150) : TemplateMinimization(width, height)
 		{
 			this->PARAMETER_AMPLIFICATION = 1.0;
-			this->HOMOGRAPHY_DELTA = 1.0e-3f;
 
-			this->q = ((this->width-this->DELTA*2)/this->SAMPLING_STEP) * ((this->height-this->DELTA*2)/this->SAMPLING_STEP);
+			// sampling grid : x, y = DELTA, DELTA + SAMPLING_STEP, ... < size - DELTA
+			this->samplingColumns = (this->width-this->DELTA*2 + this->SAMPLING_STEP-1)/this->SAMPLING_STEP;
+			this->samplingRows = (this->height-this->DELTA*2 + this->SAMPLING_STEP-1)/this->SAMPLING_STEP;
+			this->q = this->samplingColumns * this->samplingRows;
 			this->p = HOMOGRAPHY_COUNT - 1;
-
-			JacobianSum		= cvCreateMat(q, p, CV_32F);
-			JacobianSumT	= cvCreateMat(p, q, CV_32F);
-			Jacobian		= cvCreateMat(p, p, CV_32F);
-			JacobianInvers	= cvCreateMat(p, p, CV_32F);
-			dS				= cvCreateMat(q, 1, CV_32F);
-			JacobianTdS		= cvCreateMat(p, 1, CV_32F);
-			dx				= cvCreateMat(p, 1, CV_32F);
-
-			cvZero(JacobianSum);
-			cvZero(JacobianSumT);
-			cvZero(Jacobian);
 		}
 		~HomographyESM()
 		{
-			if(templateImage)	cvReleaseImage(&templateImage);
-			if(samplingImage)	cvReleaseImage(&samplingImage);
-
-			if(JacobianSum)		cvReleaseMat(&JacobianSum);
-			if(JacobianSumT)	cvReleaseMat(&JacobianSumT);
-			if(Jacobian)		cvReleaseMat(&Jacobian);
-			if(JacobianInvers)	cvReleaseMat(&JacobianInvers);
-			if(dS)				cvReleaseMat(&dS);
-			if(JacobianTdS)		cvReleaseMat(&JacobianTdS);
-			if(dx)				cvReleaseMat(&dx);
 		}
 
 		inline Matrix3 GetHomography(){return this->homography;};
@@ -112,7 +85,27 @@ namespace windage
 		
 		bool AttatchTemplateImage(IplImage* image);
 		bool Initialize();
+		/**
+		 * @brief
+		 *		one ESM iteration
+		 * @remark
+		 *		samples the image by bilinear interpolation (WarpSampler.h),
+		 *		accumulates 8x8 J^T J and 8x1 J^T e per sampling row in parallel
+		 *		and solves the normal equation by 8x8 Cholesky decomposition,
+		 *		the samples warped out of the image are excluded
+		 * @return
+		 *		mean absolute intensity error of the valid samples (-1 at failure)
+		 */
 		float UpdateHomography(IplImage* image, float* delta = NULL);
+
+		/**
+		 * @brief
+		 *		recompute d(w(x))/d(x) at the current homography
+		 * @remark
+		 *		Initialize builds it at the initial homography,
+		 *		Align refreshes the coarse levels before iterating them
+		 */
+		void UpdateJacobian();
 	};
 }
 
@@ -59,6 +59,7 @@ const int TEMPLATE_WIDTH = 100;
 const int TEMPLATE_HEIGHT = 100;
 const double HOMOGRAPHY_DELTA = 0.01;
 const int MAX_ITERATION = 50;
+const int PYRAMID_LEVEL = 2;
 
 void DrawResult(IplImage* image, windage::Matrix3 homography, CvScalar color = CV_RGB(255, 0, 0), int thickness = 1)
 {
@@ -117,6 +118,8 @@ void  main()
 	windage::HomographyESM* tracker = new windage::HomographyESM(TEMPLATE_WIDTH, TEMPLATE_HEIGHT);
 #endif
 	tracker->SetInitialHomography(e);
+	tracker->SetPyramidLevel(PYRAMID_LEVEL);
+	tracker->SetConvergenceDelta((float)HOMOGRAPHY_DELTA);
 
 	// homography update stack
 	std::vector<windage::Matrix3> homographyList;
@@ -139,18 +142,9 @@ void  main()
 		int64 startTime = cvGetTickCount();
 		
 		float error = 0.0;
-		float delta = 1.0;
-		int iter = 0;
 		homographyList.clear();
-		for(iter=0; iter<MAX_ITERATION; iter++)
-		{
-			error = tracker->UpdateHomography(grayImage, &delta);
-			homography = tracker->GetHomography();
-			homographyList.push_back(homography);
-
-//			if(delta < HOMOGRAPHY_DELTA)
-//				break;
-		}
+		int iter = tracker->Align(grayImage, MAX_ITERATION, &error, &homographyList);
+		homography = tracker->GetHomography();
 		int64 endTime = cvGetTickCount();
 		samplingImage = tracker->GetSamplingImage();
 
@@ -199,6 +193,8 @@ void  main()
 			tracker = new windage::HomographyESM(TEMPLATE_WIDTH, TEMPLATE_HEIGHT);
 #endif
 			tracker->SetInitialHomography(e);
+			tracker->SetPyramidLevel(PYRAMID_LEVEL);
+			tracker->SetConvergenceDelta((float)HOMOGRAPHY_DELTA);
 			break;
 		case 'q':
 		case 'Q':
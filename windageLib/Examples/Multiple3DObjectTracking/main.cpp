@@ -234,9 +234,17 @@ void main()
 		case 'F':
 			flip = !flip;
 			break;
+		case 't':
+		case 'T':
+			if(windage::Profiler::IsTracing())
+				windage::Profiler::StopTrace();
+			else
+				windage::Profiler::StartTrace("trace.json");
+			break;
 		}		
 	}
 
+	windage::Profiler::StopTrace();
 	if(writer) cvReleaseVideoWriter(&writer);
 //	cvReleaseCapture(&capture);
 	capture->stop();
@@ -84,6 +84,7 @@ void main()
 	windage::Algorithms::HomographyEstimator* estimator;
 	windage::Algorithms::OutlierChecker* checker;
 	windage::Algorithms::HomographyRefiner* refiner;
+	windage::Algorithms::MultiTemplateESM* aligner;
 
 	calibration = new windage::Calibration();
 	detector = new windage::Algorithms::WSURFdetector();
@@ -91,6 +92,7 @@ void main()
 	estimator = new windage::Algorithms::ProSACestimator();
 	checker = new windage::Algorithms::OutlierChecker();
 	refiner = new windage::Algorithms::LMmethod();
+	aligner = new windage::Algorithms::MultiTemplateESM();
 
 	calibration->Initialize(INTRINSIC[0], INTRINSIC[1], INTRINSIC[2], INTRINSIC[3], INTRINSIC[4], INTRINSIC[5], INTRINSIC[6], INTRINSIC[7]);
 	detector->SetThreshold(50.0);
@@ -98,6 +100,7 @@ void main()
 	estimator->SetReprojectionError(REPROJECTION_ERROR);
 	checker->SetReprojectionError(REPROJECTION_ERROR * 3);
 	refiner->SetMaxIteration(10);
+	aligner->SetMaxIteration(10);
 
 	tracking.AttatchCalibration(calibration);
 	tracking.AttatchDetetor(detector);
@@ -105,6 +108,7 @@ void main()
 	tracking.AttatchEstimator(estimator);
 	tracking.AttatchChecker(checker);
 	tracking.AttatchRefiner(refiner);
+	tracking.AttatchAligner(aligner);
 	
 	tracking.Initialize(WIDTH, HEIGHT, (double)WIDTH, (double)HEIGHT);
 	tracking.SetFilter(false);
@@ -90,6 +90,7 @@ void main()
 	reconstructor->SetConfidence(RANSAC_COEFFICIENT);
 	reconstructor->SetMaxIteration(RANSAC_ITERATION);
 	reconstructor->SetReprojectionError(RANSAC_REPROJECTION_ERROR);
+	reconstructor->SetVerbose(true);
 
 	reconstructor->AttatchCalibration(initialCalibration);
 
@@ -204,7 +205,7 @@ void main()
 				for(int i=0; i<imageCount; i++)
 				{
 					sprintf_s(message, IMAGE_FILE_NAME_TEMPLATE, path, i);
-					cvSaveImage(message, reconstructionImages[i]);
+					cvSaveImage(message, reconstructionImages[reconstructor->GetImageOrder(i)]);
 
 					exportor.PushCalibration(reconstructor->GetCameraParameter(i));
 					exportor.PushImageFile(message);
@@ -235,6 +236,9 @@ void main()
 				imageCount++;
 				if(imageCount >= 2)
 				{
+					// register the new image against the image that shares the most matches
+					if(imageCount >= 3)
+						reconstructor->CalculateMatchingMatrix();
 					reconstructor->CalculateStep(imageCount);
 
 					int startIndex = MAX(0, imageCount - BUNDLEADSUTMENT_COUNT);
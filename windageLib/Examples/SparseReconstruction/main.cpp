@@ -50,6 +50,7 @@
 
 const char* RECONSTRUCTION_PATH_TEMPLATE = "data/reconstruction-%s";
 const char* RECONSTRUCTION_FILENAME = "%s/reconstruction";
+const char* RECONSTRUCTION_BINARY_FILENAME = "%s/reconstruction.wrb";
 const char* IMAGE_FILE_NAME_TEMPLATE = "%s/image%03d.png";
 
 const int WIDTH = 640;
@@ -216,6 +217,10 @@ void main()
 					exportor.PushImageFile(message);
 				}
 				exportor.DoExport();
+
+				sprintf_s(message, RECONSTRUCTION_BINARY_FILENAME, path);
+				exportor.DoExportBinary(message);
+
 				delete reconstructionLogger;
 				reconstructionLogger = NULL;
 			}
@@ -0,0 +1,237 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#ifndef _BENCHMARK_INPUT_H_
+#define _BENCHMARK_INPUT_H_
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include <cv.h>
+#include <highgui.h>
+
+#include "Structures/Matrix.h"
+#include "Structures/Calibration.h"
+#include "Structures/FeaturePoint.h"
+#include "Algorithms/WSURFdetector.h"
+#include "Algorithms/FLANNtree.h"
+
+/**
+ * fixed input pair of the benchmarks
+ * synthetic : seeded random texture and its perspective view (ground truth homography and pose)
+ * recorded : reference and scene image files (e.g. Test/testReference.png, Test/testImage1.png)
+ */
+class BenchmarkInput
+{
+public:
+	std::string name;
+	IplImage* referenceImage;				///< gray
+	IplImage* sceneImage;					///< gray
+	windage::Calibration* calibration;
+	bool groundTruth;
+	windage::Matrix3 homography;			///< reference pixel to scene pixel (ground truth)
+
+	std::vector<windage::FeaturePoint> referenceKeypoints;
+	std::vector<windage::FeaturePoint> sceneKeypoints;
+
+	/** matched pairs : reference in homogeneous image coordinate, reference in object plane (z = 0) and scene */
+	std::vector<windage::FeaturePoint> referencePoints;
+	std::vector<windage::FeaturePoint> referencePlanePoints;
+	std::vector<windage::FeaturePoint> scenePoints;
+
+	BenchmarkInput()
+	{
+		referenceImage = NULL;
+		sceneImage = NULL;
+		calibration = new windage::Calibration();
+		groundTruth = false;
+	}
+	~BenchmarkInput()
+	{
+		if(referenceImage) cvReleaseImage(&referenceImage);
+		if(sceneImage) cvReleaseImage(&sceneImage);
+		if(calibration) delete calibration;
+		calibration = NULL;
+	}
+
+	bool CreateSynthetic(int width, int height, unsigned int seed)
+	{
+		char tempName[100];
+		sprintf_s(tempName, "synthetic%dx%d_%u", width, height, seed);
+		this->name = tempName;
+
+		CvRNG rng = cvRNG(seed);
+		this->referenceImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+		this->sceneImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+
+		// random texture
+		cvSet(this->referenceImage, cvScalar(128));
+		for(int i=0; i<width*height/1000; i++)
+		{
+			CvPoint center = cvPoint(cvRandInt(&rng) % width, cvRandInt(&rng) % height);
+			int size = 3 + cvRandInt(&rng) % 30;
+			CvScalar color = cvScalar(cvRandInt(&rng) % 256);
+			switch(cvRandInt(&rng) % 3)
+			{
+			case 0:
+				cvCircle(this->referenceImage, center, size, color, CV_FILLED);
+				break;
+			case 1:
+				cvRectangle(this->referenceImage, center, cvPoint(center.x + size, center.y + size*2/3), color, CV_FILLED);
+				break;
+			case 2:
+				cvLine(this->referenceImage, center, cvPoint(center.x + size*2, center.y - size), color, 2);
+				break;
+			}
+		}
+		cvSmooth(this->referenceImage, this->referenceImage, CV_GAUSSIAN, 3);
+
+		// camera looks at the reference plane (1 pixel = 1 unit) with 20 degree tilt and 10 degree roll
+		double f = (double)width;
+		double cx = width/2.0;
+		double cy = height/2.0;
+		this->calibration->Initialize(f, f, cx, cy, 0, 0, 0, 0);
+
+		double tilt = 20.0 * CV_PI / 180.0;
+		double roll = 10.0 * CV_PI / 180.0;
+		windage::Matrix3 rotationX(1.0, 0.0, 0.0, 0.0, cos(tilt), -sin(tilt), 0.0, sin(tilt), cos(tilt));
+		windage::Matrix3 rotationZ(cos(roll), -sin(roll), 0.0, sin(roll), cos(roll), 0.0, 0.0, 0.0, 1.0);
+		windage::Matrix3 R = rotationX * rotationZ;
+		windage::Vector3 center = R * windage::Vector3(cx, cy, 0.0);
+		windage::Vector3 t = windage::Vector3(15.0 - center.x, -10.0 - center.y, 1.1*f - center.z);
+
+		double extrinsic[16];
+		for(int y=0; y<3; y++)
+		{
+			for(int x=0; x<3; x++)
+				extrinsic[y*4+x] = R.m[y][x];
+		}
+		extrinsic[3] = t.x; extrinsic[7] = t.y; extrinsic[11] = t.z;
+		extrinsic[12] = extrinsic[13] = extrinsic[14] = 0.0; extrinsic[15] = 1.0;
+		this->calibration->SetExtrinsicMatrix(extrinsic);
+
+		// H = K [r1 r2 t]
+		windage::Matrix3 K(f, 0.0, cx, 0.0, f, cy, 0.0, 0.0, 1.0);
+		windage::Matrix3 Rt(R.m[0][0], R.m[0][1], t.x, R.m[1][0], R.m[1][1], t.y, R.m[2][0], R.m[2][1], t.z);
+		this->homography = K * Rt;
+		double scale = this->homography.m[2][2];
+		for(int i=0; i<9; i++)
+			this->homography.m1[i] /= scale;
+		this->groundTruth = true;
+
+		CvMat* warp = cvCreateMat(3, 3, CV_64F);
+		for(int y=0; y<3; y++)
+			for(int x=0; x<3; x++)
+				cvmSet(warp, y, x, this->homography.m[y][x]);
+		cvWarpPerspective(this->referenceImage, this->sceneImage, warp, CV_INTER_LINEAR+CV_WARP_FILL_OUTLIERS, cvScalarAll(0));
+		cvReleaseMat(&warp);
+
+		// sensor noise
+		IplImage* noise = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 1);
+		IplImage* scene32F = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 1);
+		cvRandArr(&rng, noise, CV_RAND_NORMAL, cvScalar(0.0), cvScalar(2.0));
+		cvConvert(this->sceneImage, scene32F);
+		cvAdd(scene32F, noise, scene32F);
+		cvConvert(scene32F, this->sceneImage);
+		cvReleaseImage(&noise);
+		cvReleaseImage(&scene32F);
+
+		return this->ExtractCorrespondences();
+	}
+
+	bool LoadRecorded(std::string name, std::string referenceFilename, std::string sceneFilename)
+	{
+		this->name = name;
+		this->groundTruth = false;
+
+		IplImage* reference = cvLoadImage(referenceFilename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+		IplImage* scene = cvLoadImage(sceneFilename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+		if(reference == NULL || scene == NULL)
+		{
+			if(reference) cvReleaseImage(&reference);
+			if(scene) cvReleaseImage(&scene);
+			return false;
+		}
+		this->referenceImage = reference;
+		this->sceneImage = scene;
+
+		double f = (double)scene->width;
+		this->calibration->Initialize(f, f, scene->width/2.0, scene->height/2.0, 0, 0, 0, 0);
+
+		return this->ExtractCorrespondences();
+	}
+
+	/** keypoints by default WSURF detector and matching by FLANN tree (same as the test programs) */
+	bool ExtractCorrespondences()
+	{
+		windage::Algorithms::WSURFdetector detector;
+		detector.DoExtractKeypointsDescriptor(this->referenceImage);
+		this->referenceKeypoints = *detector.GetKeypoints();
+		detector.DoExtractKeypointsDescriptor(this->sceneImage);
+		this->sceneKeypoints = *detector.GetKeypoints();
+
+		windage::Algorithms::FLANNtree searchTree;
+		searchTree.Training(&this->referenceKeypoints);
+		for(unsigned int i=0; i<this->sceneKeypoints.size(); i++)
+		{
+			double distance = 1.0e10;
+			int index = searchTree.Matching(this->sceneKeypoints[i], &distance);
+			if(index >= 0)
+			{
+				windage::FeaturePoint ref = this->referenceKeypoints[index];
+				windage::FeaturePoint sce = this->sceneKeypoints[i];
+				ref.SetDistance(distance);
+				sce.SetDistance(distance);
+
+				this->referencePoints.push_back(ref);
+				this->scenePoints.push_back(sce);
+
+				windage::Vector3 point = ref.GetPoint();
+				point.z = 0.0;
+				ref.SetPoint(point);
+				this->referencePlanePoints.push_back(ref);
+			}
+		}
+
+		return this->scenePoints.size() >= 10;
+	}
+};
+
+#endif
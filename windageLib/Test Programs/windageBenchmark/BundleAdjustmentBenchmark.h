@@ -0,0 +1,204 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include "windageBenchmark.h"
+#include "Reconstruction/BundleWrapper.h"
+#include "Reconstruction/SparseBundleAdjuster.h"
+
+/**
+ * bundle adjustment of the seeded synthetic scene (points in front of the cameras moving along x)
+ * the perturbed points and poses are restored before every operation, the first camera is fixed
+ */
+class BundleAdjustmentBenchmark : public windageBenchmark
+{
+private:
+	bool sparseAdjuster;		///< SparseBundleAdjuster or BundleWrapper (sba)
+	int cameraCount;
+	int pointCount;
+	unsigned int seed;
+
+	CvMat* intrinsic;
+	CvMat* initialPoint3D;
+	CvMat** initialRT;
+	CvMat* point3D;
+	CvMat** RT;
+	windage::Reconstruction::BundleObservations observations;
+
+public:
+	BundleAdjustmentBenchmark(bool sparseAdjuster, int cameraCount, int pointCount, unsigned int seed, const std::string inputName)
+		: windageBenchmark(sparseAdjuster ? "SparseBundleAdjuster" : "BundleWrapper", "BundleAdjustment", inputName, "observations")
+	{
+		this->sparseAdjuster = sparseAdjuster;
+		this->cameraCount = cameraCount;
+		this->pointCount = pointCount;
+		this->seed = seed;
+
+		intrinsic = NULL;
+		initialPoint3D = NULL;
+		initialRT = NULL;
+		point3D = NULL;
+		RT = NULL;
+	}
+	~BundleAdjustmentBenchmark()
+	{
+		std::string message;
+		this->Terminate(&message);
+	}
+
+	bool Initialize(std::string* message)
+	{
+		const double FOCAL_LENGTH = 500.0;
+		const double NOISE = 0.5;		///< pixel
+		CvRNG rng = cvRNG(seed);
+
+		intrinsic = cvCreateMat(3, 3, CV_64F);
+		cvZero(intrinsic);
+		cvmSet(intrinsic, 0, 0, FOCAL_LENGTH);
+		cvmSet(intrinsic, 1, 1, FOCAL_LENGTH);
+		cvmSet(intrinsic, 0, 2, 320.0);
+		cvmSet(intrinsic, 1, 2, 240.0);
+		cvmSet(intrinsic, 2, 2, 1.0);
+
+		// cameras : translation along x with small yaw
+		initialRT = new CvMat*[cameraCount];
+		RT = new CvMat*[cameraCount];
+		std::vector<CvMat*> trueRT(cameraCount);
+		for(int i=0; i<cameraCount; i++)
+		{
+			double yaw = 0.02 * (i - cameraCount/2);
+			double tx = 0.3 * (i - cameraCount/2);
+			trueRT[i] = cvCreateMat(3, 4, CV_64F);
+			cvZero(trueRT[i]);
+			cvmSet(trueRT[i], 0, 0, cos(yaw));	cvmSet(trueRT[i], 0, 2, sin(yaw));
+			cvmSet(trueRT[i], 1, 1, 1.0);
+			cvmSet(trueRT[i], 2, 0, -sin(yaw));	cvmSet(trueRT[i], 2, 2, cos(yaw));
+			cvmSet(trueRT[i], 0, 3, -tx);
+
+			// perturbed initial pose (translation only, the first camera is fixed)
+			initialRT[i] = cvCloneMat(trueRT[i]);
+			if(i > 0)
+			{
+				for(int y=0; y<3; y++)
+					cvmSet(initialRT[i], y, 3, cvmGet(initialRT[i], y, 3) + 0.01 * cvRandReal(&rng) - 0.005);
+			}
+			RT[i] = cvCloneMat(initialRT[i]);
+		}
+
+		// points : uniform in front of the cameras, observed by every camera
+		initialPoint3D = cvCreateMat(4, pointCount, CV_64F);
+		observations.Clear();
+		observations.Reserve(pointCount, pointCount*cameraCount);
+		for(int j=0; j<pointCount; j++)
+		{
+			double X = 4.0 * cvRandReal(&rng) - 2.0;
+			double Y = 3.0 * cvRandReal(&rng) - 1.5;
+			double Z = 4.0 + 4.0 * cvRandReal(&rng);
+
+			for(int i=0; i<cameraCount; i++)
+			{
+				double x = cvmGet(trueRT[i], 0, 0)*X + cvmGet(trueRT[i], 0, 1)*Y + cvmGet(trueRT[i], 0, 2)*Z + cvmGet(trueRT[i], 0, 3);
+				double y = cvmGet(trueRT[i], 1, 0)*X + cvmGet(trueRT[i], 1, 1)*Y + cvmGet(trueRT[i], 1, 2)*Z + cvmGet(trueRT[i], 1, 3);
+				double z = cvmGet(trueRT[i], 2, 0)*X + cvmGet(trueRT[i], 2, 1)*Y + cvmGet(trueRT[i], 2, 2)*Z + cvmGet(trueRT[i], 2, 3);
+				double u = FOCAL_LENGTH * x / z + 320.0 + NOISE * (2.0 * cvRandReal(&rng) - 1.0);
+				double v = FOCAL_LENGTH * y / z + 240.0 + NOISE * (2.0 * cvRandReal(&rng) - 1.0);
+				observations.AddObservation(i, u, v);
+			}
+			observations.EndPoint();
+
+			cvmSet(initialPoint3D, 0, j, X + 0.05 * cvRandReal(&rng) - 0.025);
+			cvmSet(initialPoint3D, 1, j, Y + 0.05 * cvRandReal(&rng) - 0.025);
+			cvmSet(initialPoint3D, 2, j, Z + 0.05 * cvRandReal(&rng) - 0.025);
+			cvmSet(initialPoint3D, 3, j, 1.0);
+		}
+		point3D = cvCloneMat(initialPoint3D);
+
+		for(int i=0; i<cameraCount; i++)
+			cvReleaseMat(&trueRT[i]);
+
+		return true;
+	}
+
+	void Prepare()
+	{
+		cvCopy(initialPoint3D, point3D);
+		for(int i=0; i<cameraCount; i++)
+			cvCopy(initialRT[i], RT[i]);
+	}
+
+	int Operate()
+	{
+		bool result = false;
+		if(sparseAdjuster)
+		{
+			windage::Reconstruction::SparseBundleAdjuster adjuster;
+			adjuster.SetParameters(intrinsic, point3D, &observations, RT, cameraCount, pointCount);
+			result = adjuster.Run();
+		}
+		else
+		{
+			windage::Reconstruction::BundleWrapper bundler;
+			bundler.SetParameters(intrinsic, point3D, &observations, RT, cameraCount, pointCount);
+			result = bundler.Run();
+		}
+
+		if(result == false)
+			return -1;
+		return observations.GetObservationCount();
+	}
+
+	bool Terminate(std::string* message)
+	{
+		if(RT)
+		{
+			for(int i=0; i<cameraCount; i++)
+			{
+				cvReleaseMat(&RT[i]);
+				cvReleaseMat(&initialRT[i]);
+			}
+			delete[] RT;
+			delete[] initialRT;
+		}
+		RT = NULL;
+		initialRT = NULL;
+		if(point3D) cvReleaseMat(&point3D);
+		if(initialPoint3D) cvReleaseMat(&initialPoint3D);
+		if(intrinsic) cvReleaseMat(&intrinsic);
+		return true;
+	}
+};
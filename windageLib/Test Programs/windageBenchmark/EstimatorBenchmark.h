@@ -0,0 +1,157 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include "windageBenchmark.h"
+#include "BenchmarkInput.h"
+#include "Algorithms/PoseEstimator.h"
+#include "Algorithms/HomographyEstimator.h"
+
+/**
+ * homography estimation from the matched pairs of the input
+ * (the estimator is deleted by the benchmark)
+ */
+class HomographyEstimatorBenchmark : public windageBenchmark
+{
+private:
+	windage::Algorithms::HomographyEstimator* estimator;
+	BenchmarkInput* input;
+
+	std::vector<windage::FeaturePoint> referencePoints;
+	std::vector<windage::FeaturePoint> scenePoints;
+
+public:
+	HomographyEstimatorBenchmark(windage::Algorithms::HomographyEstimator* estimator, BenchmarkInput* input) : windageBenchmark(estimator->GetFunctionName(), "HomographyEstimator", input->name, "correspondences")
+	{
+		this->estimator = estimator;
+		this->input = input;
+	}
+	~HomographyEstimatorBenchmark()
+	{
+		if(estimator) delete estimator;
+		estimator = NULL;
+	}
+
+	bool Initialize(std::string* message)
+	{
+		if(input->scenePoints.size() < 10)
+		{
+			(*message) = "not enough correspondences";
+			return false;
+		}
+		estimator->AttatchReferencePoint(&this->referencePoints);
+		estimator->AttatchScenePoint(&this->scenePoints);
+		return true;
+	}
+
+	void Prepare()
+	{
+		// outlier flags are updated by the estimator
+		this->referencePoints = input->referencePoints;
+		this->scenePoints = input->scenePoints;
+	}
+
+	int Operate()
+	{
+		if(estimator->Calculate() == false)
+			return -1;
+		return (int)this->scenePoints.size();
+	}
+
+	bool Terminate(std::string* message)
+	{
+		return true;
+	}
+};
+
+/**
+ * camera pose estimation from the matched pairs of the input (reference on the plane z = 0)
+ * (the estimator is deleted by the benchmark)
+ */
+class PoseEstimatorBenchmark : public windageBenchmark
+{
+private:
+	windage::Algorithms::PoseEstimator* estimator;
+	BenchmarkInput* input;
+
+	std::vector<windage::FeaturePoint> referencePoints;
+	std::vector<windage::FeaturePoint> scenePoints;
+
+public:
+	PoseEstimatorBenchmark(windage::Algorithms::PoseEstimator* estimator, BenchmarkInput* input) : windageBenchmark(estimator->GetFunctionName(), "PoseEstimator", input->name, "correspondences")
+	{
+		this->estimator = estimator;
+		this->input = input;
+	}
+	~PoseEstimatorBenchmark()
+	{
+		if(estimator) delete estimator;
+		estimator = NULL;
+	}
+
+	bool Initialize(std::string* message)
+	{
+		if(input->scenePoints.size() < 10)
+		{
+			(*message) = "not enough correspondences";
+			return false;
+		}
+		estimator->AttatchCameraParameter(input->calibration);
+		estimator->AttatchReferencePoint(&this->referencePoints);
+		estimator->AttatchScenePoint(&this->scenePoints);
+		return true;
+	}
+
+	void Prepare()
+	{
+		this->referencePoints = input->referencePlanePoints;
+		this->scenePoints = input->scenePoints;
+	}
+
+	int Operate()
+	{
+		if(estimator->Calculate() == false)
+			return -1;
+		return (int)this->scenePoints.size();
+	}
+
+	bool Terminate(std::string* message)
+	{
+		return true;
+	}
+};
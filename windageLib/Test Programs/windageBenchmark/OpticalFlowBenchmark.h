@@ -0,0 +1,100 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include "windageBenchmark.h"
+#include "BenchmarkInput.h"
+#include "Algorithms/OpticalFlow.h"
+
+/**
+ * pyramidal Lucas-Kanade tracking of the reference keypoints from the reference image to the scene image
+ */
+class OpticalFlowBenchmark : public windageBenchmark
+{
+private:
+	windage::Algorithms::OpticalFlow* tracker;
+	BenchmarkInput* input;
+
+	std::vector<windage::FeaturePoint> trackedPoints;
+
+public:
+	OpticalFlowBenchmark(BenchmarkInput* input) : windageBenchmark("OpticalFlow", "OpticalFlow", input->name, "features")
+	{
+		this->tracker = NULL;
+		this->input = input;
+	}
+	~OpticalFlowBenchmark()
+	{
+		if(tracker) delete tracker;
+		tracker = NULL;
+	}
+
+	bool Initialize(std::string* message)
+	{
+		if(input->referenceKeypoints.size() == 0)
+		{
+			(*message) = "no keypoints";
+			return false;
+		}
+		if(input->referenceImage->width != input->sceneImage->width || input->referenceImage->height != input->sceneImage->height)
+		{
+			(*message) = "different image size";
+			return false;
+		}
+
+		tracker = new windage::Algorithms::OpticalFlow(50);
+		tracker->Initialize(input->sceneImage->width, input->sceneImage->height, cvSize(15, 15), 3);
+		return true;
+	}
+
+	void Prepare()
+	{
+		this->trackedPoints.clear();
+	}
+
+	int Operate()
+	{
+		tracker->TrackFeatures(input->referenceImage, input->sceneImage, &input->referenceKeypoints, &this->trackedPoints);
+		return (int)input->referenceKeypoints.size();
+	}
+
+	bool Terminate(std::string* message)
+	{
+		return true;
+	}
+};
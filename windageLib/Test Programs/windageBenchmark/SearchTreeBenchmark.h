@@ -0,0 +1,91 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include "windageBenchmark.h"
+#include "BenchmarkInput.h"
+#include "Algorithms/SearchTree.h"
+
+/**
+ * nearest neighbour matching of every scene keypoint (the tree is trained once at initialize)
+ * (the search tree is deleted by the benchmark)
+ */
+class SearchTreeBenchmark : public windageBenchmark
+{
+private:
+	windage::Algorithms::SearchTree* searchTree;
+	BenchmarkInput* input;
+
+public:
+	SearchTreeBenchmark(windage::Algorithms::SearchTree* searchTree, BenchmarkInput* input) : windageBenchmark(searchTree->GetFunctionName(), "SearchTree", input->name, "queries")
+	{
+		this->searchTree = searchTree;
+		this->input = input;
+	}
+	~SearchTreeBenchmark()
+	{
+		if(searchTree) delete searchTree;
+		searchTree = NULL;
+	}
+
+	bool Initialize(std::string* message)
+	{
+		if(input->referenceKeypoints.size() == 0 || input->sceneKeypoints.size() == 0)
+		{
+			(*message) = "no keypoints";
+			return false;
+		}
+		return searchTree->Training(&input->referenceKeypoints);
+	}
+
+	int Operate()
+	{
+		int n = (int)input->sceneKeypoints.size();
+		for(int i=0; i<n; i++)
+		{
+			double distance = 0.0;
+			searchTree->Matching(input->sceneKeypoints[i], &distance);
+		}
+		return n;
+	}
+
+	bool Terminate(std::string* message)
+	{
+		return true;
+	}
+};
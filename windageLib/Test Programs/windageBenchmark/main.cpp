@@ -0,0 +1,241 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <cv.h>
+
+#include "windageBenchmark.h"
+#include "BenchmarkInput.h"
+
+#include "FeatureDetectorBenchmark.h"
+#include "SearchTreeBenchmark.h"
+#include "EstimatorBenchmark.h"
+#include "OpticalFlowBenchmark.h"
+#include "BundleAdjustmentBenchmark.h"
+
+#include "Algorithms/WSURFdetector.h"
+#include "Algorithms/WSURFMultidetector.h"
+#include "Algorithms/SURFdetector.h"
+#include "Algorithms/OpenSURFdetector.h"
+#include "Algorithms/SIFTdetector.h"
+
+#include "Algorithms/KDtree.h"
+#include "Algorithms/Spilltree.h"
+#include "Algorithms/FLANNtree.h"
+#include "Algorithms/KDforest.h"
+
+#include "Algorithms/RANSACestimator.h"
+#include "Algorithms/ProSACestimator.h"
+#include "Algorithms/LMedSestimator.h"
+#include "Algorithms/EPnPRANSACestimator.h"
+#include "Algorithms/OpenCVRANSACestimator.h"
+
+/**
+ * headless benchmark of the detectors, search trees, estimators, optical flow and bundle adjustment
+ *
+ * usage : windageBenchmark [-json result.json] [-iterations 20] [-warmup 3] [-seed 0] [-filter name]
+ *                          [-input name reference.png scene.png] [-nosynthetic]
+ *
+ * the synthetic inputs are generated from the seed and the recorded inputs are Test/testReference.png
+ * and Test/testImage1.png (same as windageTest) when they exist, so the results can be diffed across commits
+ */
+
+class RecordedInput
+{
+public:
+	std::string name;
+	std::string referenceFilename;
+	std::string sceneFilename;
+};
+
+void PrintUsage()
+{
+	printf("usage : windageBenchmark [-json result.json] [-iterations n] [-warmup n] [-seed n] [-filter name]\n");
+	printf("                         [-input name reference.png scene.png] [-nosynthetic]\n");
+}
+
+void main(int argc, char** argv)
+{
+	// before the first OpenCV allocation
+	AllocationCounter::Install();
+
+	std::string jsonFilename = "";
+	std::string filter = "";
+	int iterations = 20;
+	int warmup = 3;
+	unsigned int seed = 0;
+	bool synthetic = true;
+	std::vector<RecordedInput> recordedInputs;
+
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-json") == 0 && i+1 < argc)
+			jsonFilename = argv[++i];
+		else if(strcmp(argv[i], "-iterations") == 0 && i+1 < argc)
+			iterations = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-warmup") == 0 && i+1 < argc)
+			warmup = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i], "-filter") == 0 && i+1 < argc)
+			filter = argv[++i];
+		else if(strcmp(argv[i], "-input") == 0 && i+3 < argc)
+		{
+			RecordedInput input;
+			input.name = argv[++i];
+			input.referenceFilename = argv[++i];
+			input.sceneFilename = argv[++i];
+			recordedInputs.push_back(input);
+		}
+		else if(strcmp(argv[i], "-nosynthetic") == 0)
+			synthetic = false;
+		else
+		{
+			PrintUsage();
+			return;
+		}
+	}
+	if(iterations < 1) iterations = 1;
+	if(warmup < 0) warmup = 0;
+
+	if(recordedInputs.size() == 0)
+	{
+		RecordedInput input;
+		input.name = "testImage";
+		input.referenceFilename = "Test/testReference.png";
+		input.sceneFilename = "Test/testImage1.png";
+		recordedInputs.push_back(input);
+	}
+
+	// inputs
+	std::vector<BenchmarkInput*> inputs;
+	if(synthetic)
+	{
+		BenchmarkInput* input = new BenchmarkInput();
+		if(input->CreateSynthetic(640, 480, seed))
+			inputs.push_back(input);
+		else
+			delete input;
+	}
+	for(unsigned int i=0; i<recordedInputs.size(); i++)
+	{
+		BenchmarkInput* input = new BenchmarkInput();
+		if(input->LoadRecorded(recordedInputs[i].name, recordedInputs[i].referenceFilename, recordedInputs[i].sceneFilename))
+			inputs.push_back(input);
+		else
+		{
+			printf("skip input %s (%s, %s)\n", recordedInputs[i].name.c_str(), recordedInputs[i].referenceFilename.c_str(), recordedInputs[i].sceneFilename.c_str());
+			delete input;
+		}
+	}
+
+	// benchmarks
+	std::vector<windageBenchmark*> benchmarks;
+	for(unsigned int i=0; i<inputs.size(); i++)
+	{
+		BenchmarkInput* input = inputs[i];
+		int width = input->sceneImage->width;
+		int height = input->sceneImage->height;
+
+		benchmarks.push_back(new FeatureDetectorBenchmark(new windage::Algorithms::WSURFdetector(), input));
+		benchmarks.push_back(new FeatureDetectorBenchmark(new windage::Algorithms::WSURFMultidetector(width, height), input));
+		benchmarks.push_back(new FeatureDetectorBenchmark(new windage::Algorithms::SURFdetector(), input));
+		benchmarks.push_back(new FeatureDetectorBenchmark(new windage::Algorithms::OpenSURFdetector(), input));
+		benchmarks.push_back(new FeatureDetectorBenchmark(new windage::Algorithms::SIFTdetector(), input));
+
+		benchmarks.push_back(new SearchTreeBenchmark(new windage::Algorithms::KDtree(), input));
+		benchmarks.push_back(new SearchTreeBenchmark(new windage::Algorithms::Spilltree(), input));
+		benchmarks.push_back(new SearchTreeBenchmark(new windage::Algorithms::FLANNtree(), input));
+		windage::Algorithms::KDforest* forest = new windage::Algorithms::KDforest();
+		forest->SetSeed(seed);
+		benchmarks.push_back(new SearchTreeBenchmark(forest, input));
+
+		// the randomized estimators sample from their own generator, not from srand
+		windage::Algorithms::ProSACestimator* prosac = new windage::Algorithms::ProSACestimator();
+		windage::Algorithms::EPnPRANSACestimator* epnp = new windage::Algorithms::EPnPRANSACestimator();
+		windage::Algorithms::OpenCVRANSACestimator* opencvRansac = new windage::Algorithms::OpenCVRANSACestimator();
+		prosac->SetSeed(seed);
+		epnp->SetSeed(seed);
+		opencvRansac->SetSeed(seed);
+
+		benchmarks.push_back(new HomographyEstimatorBenchmark(new windage::Algorithms::RANSACestimator(), input));
+		benchmarks.push_back(new HomographyEstimatorBenchmark(prosac, input));
+		benchmarks.push_back(new HomographyEstimatorBenchmark(new windage::Algorithms::LMedSestimator(), input));
+		benchmarks.push_back(new PoseEstimatorBenchmark(epnp, input));
+		benchmarks.push_back(new PoseEstimatorBenchmark(opencvRansac, input));
+
+		benchmarks.push_back(new OpticalFlowBenchmark(input));
+	}
+	{
+		char tempName[100];
+		sprintf_s(tempName, "synthetic5x300_%u", seed);
+		benchmarks.push_back(new BundleAdjustmentBenchmark(false, 5, 300, seed, tempName));
+		benchmarks.push_back(new BundleAdjustmentBenchmark(true, 5, 300, seed, tempName));
+	}
+
+	// run
+	std::vector<BenchmarkResult> results;
+	for(unsigned int i=0; i<benchmarks.size(); i++)
+	{
+		if(filter.size() > 0 && benchmarks[i]->GetName().find(filter) == std::string::npos && benchmarks[i]->GetClass().find(filter) == std::string::npos)
+			continue;
+
+		BenchmarkResult result = benchmarks[i]->Do(warmup, iterations, seed);
+		PrintBenchmarkResult(result);
+		results.push_back(result);
+	}
+
+	if(jsonFilename.size() > 0)
+	{
+		if(WriteBenchmarkJSON(jsonFilename.c_str(), results, warmup, iterations, seed))
+			printf("write %s\n", jsonFilename.c_str());
+		else
+			printf("cannot write %s\n", jsonFilename.c_str());
+	}
+
+	for(unsigned int i=0; i<benchmarks.size(); i++)
+		delete benchmarks[i];
+	for(unsigned int i=0; i<inputs.size(); i++)
+		delete inputs[i];
+}
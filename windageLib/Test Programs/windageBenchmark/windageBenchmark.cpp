@@ -0,0 +1,260 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <windows.h>
+#include <malloc.h>
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
+
+#include "windageBenchmark.h"
+#include "Utilities/Utils.h"
+
+namespace BenchmarkAllocation
+{
+	volatile LONG cvAllocationCount = 0;
+	volatile LONG heapAllocationCount = 0;
+	bool installed = false;
+
+	const size_t CV_ALIGNMENT = 32;		///< same as the default cvAlloc
+
+	void* CV_CDECL CountingAlloc(size_t size, void* userdata)
+	{
+		InterlockedIncrement(&cvAllocationCount);
+		return _aligned_malloc(size, CV_ALIGNMENT);
+	}
+	int CV_CDECL CountingFree(void* pptr, void* userdata)
+	{
+		_aligned_free(pptr);
+		return CV_StsOk;
+	}
+
+#ifdef _DEBUG
+	_CRT_ALLOC_HOOK previousHook = NULL;
+	int __cdecl CountingHook(int allocType, void* userData, size_t size, int blockType, long requestNumber, const unsigned char* filename, int lineNumber)
+	{
+		if(allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC)
+			InterlockedIncrement(&heapAllocationCount);
+		if(previousHook)
+			return previousHook(allocType, userData, size, blockType, requestNumber, filename, lineNumber);
+		return TRUE;
+	}
+#endif
+}
+
+void AllocationCounter::Install()
+{
+	if(BenchmarkAllocation::installed)
+		return;
+
+	// the memory manager is replaced before any OpenCV allocation is alive
+	cvSetMemoryManager(BenchmarkAllocation::CountingAlloc, BenchmarkAllocation::CountingFree, NULL);
+#ifdef _DEBUG
+	BenchmarkAllocation::previousHook = _CrtSetAllocHook(BenchmarkAllocation::CountingHook);
+#endif
+	BenchmarkAllocation::installed = true;
+}
+
+bool AllocationCounter::IsHeapCountAvailable()
+{
+#ifdef _DEBUG
+	return BenchmarkAllocation::installed;
+#else
+	return false;
+#endif
+}
+
+long AllocationCounter::GetCvAllocationCount()
+{
+	return (long)BenchmarkAllocation::cvAllocationCount;
+}
+
+long AllocationCounter::GetHeapAllocationCount()
+{
+	if(!IsHeapCountAvailable())
+		return -1;
+	return (long)BenchmarkAllocation::heapAllocationCount;
+}
+
+BenchmarkResult windageBenchmark::Do(int warmup, int iterations, unsigned int seed)
+{
+	BenchmarkResult result;
+	result.benchmarkName = this->benchmarkName;
+	result.benchmarkClass = this->benchmarkClass;
+	result.inputName = this->inputName;
+	result.itemName = this->itemName;
+
+	if(this->Initialize(&result.message) == false)
+	{
+		this->Terminate(&result.message);
+		return result;
+	}
+
+	srand(seed);
+	bool success = true;
+	for(int i=0; i<warmup && success; i++)
+	{
+		this->Prepare();
+		if(this->Operate() < 0)
+			success = false;
+	}
+
+	double tickToNanosecond = 1000.0 / cvGetTickFrequency();
+	std::vector<double> times;
+	times.reserve(iterations);
+	double items = 0.0;
+	long cvAllocations = 0;
+	long heapAllocations = 0;
+
+	for(int i=0; i<iterations && success; i++)
+	{
+		this->Prepare();
+
+		long cvCount = AllocationCounter::GetCvAllocationCount();
+		long heapCount = AllocationCounter::GetHeapAllocationCount();
+		int64 startTick = cvGetTickCount();
+		int count = this->Operate();
+		int64 endTick = cvGetTickCount();
+		heapAllocations += AllocationCounter::GetHeapAllocationCount() - heapCount;
+		cvAllocations += AllocationCounter::GetCvAllocationCount() - cvCount;
+
+		if(count < 0)
+		{
+			success = false;
+			break;
+		}
+		times.push_back((double)(endTick - startTick) * tickToNanosecond);
+		items += (double)count;
+	}
+
+	if(success && times.size() > 0)
+	{
+		int n = (int)times.size();
+		double sum = 0.0;
+		for(int i=0; i<n; i++)
+			sum += times[i];
+		std::sort(times.begin(), times.end());
+
+		result.success = true;
+		result.iterations = n;
+		result.nsPerOp = (n % 2) ? times[n/2] : (times[n/2-1] + times[n/2]) / 2.0;
+		result.nsPerOpMean = sum / n;
+		result.nsPerOpMin = times[0];
+		result.nsPerOpMax = times[n-1];
+		result.itemsPerOp = items / n;
+		result.itemsPerSecond = result.nsPerOp > 0.0 ? result.itemsPerOp * 1.0e9 / result.nsPerOp : 0.0;
+		result.cvAllocationsPerOp = (double)cvAllocations / n;
+		result.heapAllocationsPerOp = AllocationCounter::IsHeapCountAvailable() ? (double)heapAllocations / n : -1.0;
+	}
+	else if(result.message.empty())
+	{
+		result.message = "operation failed";
+	}
+
+	this->Terminate(&result.message);
+	return result;
+}
+
+void PrintBenchmarkResult(const BenchmarkResult& result)
+{
+	if(result.success == false)
+	{
+		printf("%-24s %-28s FAIL (%s)\n", result.benchmarkName.c_str(), result.inputName.c_str(), result.message.c_str());
+		return;
+	}
+
+	printf("%-24s %-28s %14.0f ns/op %12.1f %s/s %10.1f cvAlloc/op", result.benchmarkName.c_str(), result.inputName.c_str(),
+		result.nsPerOp, result.itemsPerSecond, result.itemName.c_str(), result.cvAllocationsPerOp);
+	if(result.heapAllocationsPerOp >= 0.0)
+		printf(" %10.1f alloc/op", result.heapAllocationsPerOp);
+	printf("\n");
+}
+
+bool WriteBenchmarkJSON(const char* filename, const std::vector<BenchmarkResult>& results, int warmup, int iterations, unsigned int seed)
+{
+	FILE* output = fopen(filename, "wb");
+	if(output == NULL)
+		return false;
+
+#ifdef _DEBUG
+	const char* configuration = "Debug";
+#else
+	const char* configuration = "Release";
+#endif
+
+	fprintf(output, "{\n");
+	fprintf(output, "\t\"configuration\": \"%s\",\n", configuration);
+	fprintf(output, "\t\"warmup\": %d,\n", warmup);
+	fprintf(output, "\t\"iterations\": %d,\n", iterations);
+	fprintf(output, "\t\"seed\": %u,\n", seed);
+	fprintf(output, "\t\"heapAllocationCount\": %s,\n", AllocationCounter::IsHeapCountAvailable() ? "true" : "false");
+	fprintf(output, "\t\"results\": [");
+	for(unsigned int i=0; i<results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		fprintf(output, "%s\n\t\t{\"name\": ", i > 0 ? "," : "");
+		windage::Utils::WriteJSONString(output, result.benchmarkName.c_str());
+		fprintf(output, ", \"class\": ");
+		windage::Utils::WriteJSONString(output, result.benchmarkClass.c_str());
+		fprintf(output, ", \"input\": ");
+		windage::Utils::WriteJSONString(output, result.inputName.c_str());
+		fprintf(output, ", \"success\": %s", result.success ? "true" : "false");
+		if(result.success)
+		{
+			fprintf(output, ", \"iterations\": %d, \"nsPerOp\": %.1f, \"nsPerOpMean\": %.1f, \"nsPerOpMin\": %.1f, \"nsPerOpMax\": %.1f",
+				result.iterations, result.nsPerOp, result.nsPerOpMean, result.nsPerOpMin, result.nsPerOpMax);
+			fprintf(output, ", \"item\": ");
+			windage::Utils::WriteJSONString(output, result.itemName.c_str());
+			fprintf(output, ", \"itemsPerOp\": %.2f, \"itemsPerSecond\": %.1f, \"cvAllocationsPerOp\": %.2f, \"heapAllocationsPerOp\": %.2f}",
+				result.itemsPerOp, result.itemsPerSecond, result.cvAllocationsPerOp, result.heapAllocationsPerOp);
+		}
+		else
+		{
+			fprintf(output, ", \"message\": ");
+			windage::Utils::WriteJSONString(output, result.message.c_str());
+			fprintf(output, "}");
+		}
+	}
+	fprintf(output, "\n\t]\n}\n");
+	fclose(output);
+
+	return true;
+}
@@ -0,0 +1,139 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#ifndef _WINDAGE_BENCHMARK_H_
+#define _WINDAGE_BENCHMARK_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <cv.h>
+
+/**
+ * timing and allocation result of a benchmark
+ * (nanoseconds per operation, the median is robust to the scheduler noise)
+ */
+class BenchmarkResult
+{
+public:
+	std::string benchmarkName;
+	std::string benchmarkClass;
+	std::string inputName;
+	std::string itemName;
+	std::string message;
+
+	bool success;
+	int iterations;
+	double nsPerOp;					///< median
+	double nsPerOpMean;
+	double nsPerOpMin;
+	double nsPerOpMax;
+	double itemsPerOp;
+	double itemsPerSecond;			///< items per op / median time
+	double cvAllocationsPerOp;		///< cvAlloc calls of all modules
+	double heapAllocationsPerOp;	///< CRT heap allocations of all modules (-1 when not available)
+
+	BenchmarkResult()
+	{
+		success = false;
+		iterations = 0;
+		nsPerOp = nsPerOpMean = nsPerOpMin = nsPerOpMax = 0.0;
+		itemsPerOp = itemsPerSecond = 0.0;
+		cvAllocationsPerOp = 0.0;
+		heapAllocationsPerOp = -1.0;
+	}
+};
+
+class windageBenchmark
+{
+protected:
+	std::string benchmarkName;
+	std::string benchmarkClass;
+	std::string inputName;
+	std::string itemName;
+
+public:
+	windageBenchmark(const std::string benchmarkName, const std::string benchmarkClass, const std::string inputName, const std::string itemName)
+	{
+		this->benchmarkName = benchmarkName;
+		this->benchmarkClass = benchmarkClass;
+		this->inputName = inputName;
+		this->itemName = itemName;
+	}
+	virtual ~windageBenchmark()
+	{
+	}
+
+	inline std::string GetName(){return this->benchmarkName;};
+	inline std::string GetClass(){return this->benchmarkClass;};
+
+	/**
+	 * initialize, warm up and time the operation (srand(seed) before the first operation)
+	 */
+	BenchmarkResult Do(int warmup, int iterations, unsigned int seed);
+
+	virtual bool Initialize(std::string* message) = 0;
+	/** untimed reset before every operation (e.g. restore the adjusted parameters) */
+	virtual void Prepare(){};
+	/** timed operation, returns the number of processed items (negative is failure) */
+	virtual int Operate() = 0;
+	virtual bool Terminate(std::string* message) = 0;
+};
+
+/**
+ * counts the allocations of every module during the timed operations
+ * cvAlloc is hooked by cvSetMemoryManager (shared cxcore),
+ * CRT heap is hooked by _CrtSetAllocHook only with the debug CRT (_DEBUG)
+ */
+class AllocationCounter
+{
+public:
+	/** to be called before the first OpenCV allocation (the memory manager is never restored) */
+	static void Install();
+	static bool IsHeapCountAvailable();
+
+	static long GetCvAllocationCount();
+	static long GetHeapAllocationCount();
+};
+
+void PrintBenchmarkResult(const BenchmarkResult& result);
+bool WriteBenchmarkJSON(const char* filename, const std::vector<BenchmarkResult>& results, int warmup, int iterations, unsigned int seed);
+
+#endif
@@ -0,0 +1,483 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <cv.h>
+#include <highgui.h>
+
+#include <windage.h>
+
+/**
+ * headless accuracy and speed regression of the planar object tracking
+ *
+ * usage : windageRegression [-json result.json] [-csv frames.csv] [-reference reference.png]
+ *                           [-frames 120] [-seed 0] [-filter name] [-threshold 5.0]
+ *
+ * every configuration tracks the synthetic sequences (windage::SyntheticSequence) of every scenario,
+ * the pose error against the ground truth and the latency of UpdateCamerapose are scored at every frame
+ */
+
+const int WIDTH = 640;
+const int HEIGHT = 480;
+const double INTRINSIC[] = {640.0, 640.0, 320.0, 240.0, 0, 0, 0, 0};
+
+const double SCALE_FACTOR = 4.0;
+const int SCALE_STEP = 4;
+const double REPROJECTION_ERROR = 2.0;
+const double DETECTOR_THRESHOLD = 30.0;
+const int MIN_MATCHING_COUNT = 10;
+
+/** image degradation of the sequence */
+class Scenario
+{
+public:
+	std::string name;
+	double noise;
+	double blur;
+	double gainRange;
+	double biasRange;
+	int occluderCount;
+	double occluderSize;
+
+	Scenario(std::string name, double noise, double blur, double gainRange, double biasRange, int occluderCount, double occluderSize)
+	{
+		this->name = name;
+		this->noise = noise;
+		this->blur = blur;
+		this->gainRange = gainRange;
+		this->biasRange = biasRange;
+		this->occluderCount = occluderCount;
+		this->occluderSize = occluderSize;
+	}
+};
+
+/** tracker configuration (algorithms are created and released with the framework) */
+class Configuration
+{
+public:
+	std::string name;
+	windage::Frameworks::PlanarObjectTracking* tracking;
+	windage::Calibration* calibration;
+	windage::Algorithms::FeatureDetector* detector;
+	windage::Algorithms::SearchTree* searchtree;
+	windage::Algorithms::OpticalFlow* opticalflow;
+	windage::Algorithms::HomographyEstimator* estimator;
+	windage::Algorithms::OutlierChecker* checker;
+	windage::Algorithms::HomographyRefiner* refiner;
+
+	Configuration(std::string name)
+	{
+		this->name = name;
+		tracking = NULL;
+		calibration = NULL;
+		detector = NULL;
+		searchtree = NULL;
+		opticalflow = NULL;
+		estimator = NULL;
+		checker = NULL;
+		refiner = NULL;
+	}
+	~Configuration()
+	{
+		if(tracking) delete tracking;
+		if(calibration) delete calibration;
+		if(detector) delete detector;
+		if(searchtree) delete searchtree;
+		if(opticalflow) delete opticalflow;
+		if(estimator) delete estimator;
+		if(checker) delete checker;
+		if(refiner) delete refiner;
+	}
+
+	/**
+	 * detection : detection and matching at every frame
+	 * tracking : optical flow tracking and detection at every 6th frame
+	 * refinement : tracking and LM refinement of the homography
+	 */
+	bool Create(IplImage* reference)
+	{
+		bool tracker = (this->name == "tracking" || this->name == "refinement");
+
+		calibration = new windage::Calibration();
+		detector = new windage::Algorithms::WSURFdetector();
+		searchtree = new windage::Algorithms::KDtree();
+		estimator = new windage::Algorithms::RANSACestimator();
+		checker = new windage::Algorithms::OutlierChecker();
+		if(tracker)
+			opticalflow = new windage::Algorithms::OpticalFlow();
+		if(this->name == "refinement")
+			refiner = new windage::Algorithms::LMmethod();
+
+		calibration->Initialize(INTRINSIC[0], INTRINSIC[1], INTRINSIC[2], INTRINSIC[3], INTRINSIC[4], INTRINSIC[5], INTRINSIC[6], INTRINSIC[7]);
+		detector->SetThreshold(DETECTOR_THRESHOLD);
+		searchtree->SetRatio(0.7);
+		estimator->SetReprojectionError(REPROJECTION_ERROR);
+		checker->SetReprojectionError(REPROJECTION_ERROR * 3);
+		if(opticalflow)
+			opticalflow->Initialize(WIDTH, HEIGHT, cvSize(15, 15), 3);
+		if(refiner)
+			refiner->SetMaxIteration(10);
+
+		tracking = new windage::Frameworks::PlanarObjectTracking();
+		tracking->AttatchCalibration(calibration);
+		tracking->AttatchDetetor(detector);
+		tracking->AttatchMatcher(searchtree);
+		tracking->AttatchEstimator(estimator);
+		tracking->AttatchChecker(checker);
+		if(opticalflow)
+			tracking->AttatchTracker(opticalflow);
+		if(refiner)
+			tracking->AttatchRefiner(refiner);
+
+		tracking->SetDitectionRatio(tracker ? 5 : 0);
+		if(tracking->Initialize(WIDTH, HEIGHT, (double)WIDTH, (double)HEIGHT, false) == false)
+			return false;
+		if(tracking->AttatchReferenceImage(reference) == false)
+			return false;
+		return tracking->TrainingReference(SCALE_FACTOR, SCALE_STEP);
+	}
+};
+
+class RegressionResult
+{
+public:
+	std::string configurationName;
+	std::string scenarioName;
+
+	int frames;
+	double trackedRatio;			///< frames with the estimated pose
+	double successRatio;			///< frames under the reprojection error threshold
+
+	double rotationError;			///< median of the tracked frames (degree)
+	double translationError;		///< median of the tracked frames (object unit)
+	double reprojectionError;		///< median of the tracked frames (pixel)
+	double reprojectionErrorMean;
+
+	double latency;					///< median (ms)
+	double latencyMean;
+	double latency95;
+	double latencyMax;
+
+	RegressionResult()
+	{
+		frames = 0;
+		trackedRatio = successRatio = 0.0;
+		rotationError = translationError = reprojectionError = reprojectionErrorMean = -1.0;
+		latency = latencyMean = latency95 = latencyMax = 0.0;
+	}
+};
+
+double GetMean(const std::vector<double>& values)
+{
+	if(values.size() == 0)
+		return -1.0;
+
+	double sum = 0.0;
+	for(unsigned int i=0; i<values.size(); i++)
+		sum += values[i];
+	return sum / (double)values.size();
+}
+
+/** seeded random texture, when the reference image is not found */
+IplImage* CreateReferenceTexture(int width, int height, unsigned int seed)
+{
+	CvRNG rng = cvRNG(seed);
+	IplImage* reference = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+	cvSet(reference, cvScalar(128));
+	for(int i=0; i<width*height/500; i++)
+	{
+		CvPoint center = cvPoint(cvRandInt(&rng) % width, cvRandInt(&rng) % height);
+		int size = 3 + cvRandInt(&rng) % 20;
+		CvScalar color = cvScalar(cvRandInt(&rng) % 256);
+		switch(cvRandInt(&rng) % 3)
+		{
+		case 0:
+			cvCircle(reference, center, size, color, CV_FILLED);
+			break;
+		case 1:
+			cvRectangle(reference, center, cvPoint(center.x + size, center.y + size*2/3), color, CV_FILLED);
+			break;
+		case 2:
+			cvLine(reference, center, cvPoint(center.x + size*2, center.y - size), color, 2);
+			break;
+		}
+	}
+	cvSmooth(reference, reference, CV_GAUSSIAN, 3);
+	return reference;
+}
+
+RegressionResult RunRegression(Configuration* configuration, Scenario& scenario, IplImage* reference, int frames, unsigned int seed, double threshold, FILE* csv)
+{
+	RegressionResult result;
+	result.configurationName = configuration->name;
+	result.scenarioName = scenario.name;
+
+	windage::SyntheticSequence sequence;
+	sequence.AttatchCalibration(configuration->calibration);
+	sequence.AttatchReferenceImage(reference);
+	sequence.SetSeed(seed);
+	sequence.SetFrameCount(frames);
+	sequence.SetNoise(scenario.noise);
+	sequence.SetBlur(scenario.blur);
+	sequence.SetLighting(scenario.gainRange, scenario.biasRange);
+	sequence.SetOcclusion(scenario.occluderCount, scenario.occluderSize);
+	if(sequence.Initialize(WIDTH, HEIGHT, (double)WIDTH, (double)HEIGHT) == false)
+		return result;
+
+	std::vector<double> latencies;
+	std::vector<double> rotationErrors;
+	std::vector<double> translationErrors;
+	std::vector<double> reprojectionErrors;
+	int successCount = 0;
+
+	while(sequence.Next())
+	{
+		int64 startTick = cvGetTickCount();
+		configuration->tracking->UpdateCamerapose(sequence.GetFrame());
+		double latency = (double)(cvGetTickCount() - startTick) / (cvGetTickFrequency() * 1000.0);
+		latencies.push_back(latency);
+
+		bool tracked = configuration->tracking->GetMatchingCount() > MIN_MATCHING_COUNT;
+		double rotationError = -1.0;
+		double translationError = -1.0;
+		double reprojectionError = -1.0;
+		if(tracked)
+		{
+			rotationError = sequence.CalculateRotationError(configuration->calibration);
+			translationError = sequence.CalculateTranslationError(configuration->calibration);
+			reprojectionError = sequence.CalculateReprojectionError(configuration->calibration);
+
+			rotationErrors.push_back(rotationError);
+			translationErrors.push_back(translationError);
+			reprojectionErrors.push_back(reprojectionError);
+			if(reprojectionError < threshold)
+				successCount++;
+		}
+
+		if(csv)
+		{
+			fprintf(csv, "%s,%s,%d,%.3f,%d,%d,%.4f,%.4f,%.4f\n", configuration->name.c_str(), scenario.name.c_str(), sequence.GetIndex(),
+				latency, tracked ? 1 : 0, configuration->tracking->GetMatchingCount(), rotationError, translationError, reprojectionError);
+		}
+	}
+
+	result.frames = (int)latencies.size();
+	if(result.frames > 0)
+	{
+		result.trackedRatio = (double)reprojectionErrors.size() / (double)result.frames;
+		result.successRatio = (double)successCount / (double)result.frames;
+	}
+	result.rotationError = windage::Utils::GetPercentile(rotationErrors, 0.5);
+	result.translationError = windage::Utils::GetPercentile(translationErrors, 0.5);
+	result.reprojectionError = windage::Utils::GetPercentile(reprojectionErrors, 0.5);
+	result.reprojectionErrorMean = GetMean(reprojectionErrors);
+	result.latency = windage::Utils::GetPercentile(latencies, 0.5);
+	result.latencyMean = GetMean(latencies);
+	result.latency95 = windage::Utils::GetPercentile(latencies, 0.95);
+	result.latencyMax = windage::Utils::GetPercentile(latencies, 1.0);
+
+	return result;
+}
+
+void PrintRegressionResult(const RegressionResult& result)
+{
+	printf("%-12s %-10s tracked %5.1f%% success %5.1f%% | rotation %7.3f deg translation %8.3f reprojection %7.3f px | latency %7.3f ms (mean %7.3f, 95%% %7.3f, max %7.3f)\n",
+		result.configurationName.c_str(), result.scenarioName.c_str(), result.trackedRatio * 100.0, result.successRatio * 100.0,
+		result.rotationError, result.translationError, result.reprojectionError,
+		result.latency, result.latencyMean, result.latency95, result.latencyMax);
+}
+
+bool WriteRegressionJSON(const char* filename, const std::vector<RegressionResult>& results, std::string referenceName, int frames, unsigned int seed, double threshold)
+{
+	FILE* output = fopen(filename, "wb");
+	if(output == NULL)
+		return false;
+
+#ifdef _DEBUG
+	const char* configuration = "Debug";
+#else
+	const char* configuration = "Release";
+#endif
+
+	fprintf(output, "{\n");
+	fprintf(output, "\t\"configuration\": \"%s\",\n", configuration);
+	fprintf(output, "\t\"reference\": ");
+	windage::Utils::WriteJSONString(output, referenceName.c_str());
+	fprintf(output, ",\n");
+	fprintf(output, "\t\"frames\": %d,\n", frames);
+	fprintf(output, "\t\"seed\": %u,\n", seed);
+	fprintf(output, "\t\"threshold\": %.3f,\n", threshold);
+	fprintf(output, "\t\"results\": [");
+	for(unsigned int i=0; i<results.size(); i++)
+	{
+		const RegressionResult& result = results[i];
+		fprintf(output, "%s\n\t\t{\"name\": ", i > 0 ? "," : "");
+		windage::Utils::WriteJSONString(output, result.configurationName.c_str());
+		fprintf(output, ", \"scenario\": ");
+		windage::Utils::WriteJSONString(output, result.scenarioName.c_str());
+		fprintf(output, ", \"frames\": %d, \"trackedRatio\": %.4f, \"successRatio\": %.4f",
+			result.frames, result.trackedRatio, result.successRatio);
+		fprintf(output, ", \"rotationError\": %.4f, \"translationError\": %.4f, \"reprojectionError\": %.4f, \"reprojectionErrorMean\": %.4f",
+			result.rotationError, result.translationError, result.reprojectionError, result.reprojectionErrorMean);
+		fprintf(output, ", \"latencyMs\": %.4f, \"latencyMeanMs\": %.4f, \"latency95Ms\": %.4f, \"latencyMaxMs\": %.4f}",
+			result.latency, result.latencyMean, result.latency95, result.latencyMax);
+	}
+	fprintf(output, "\n\t]\n}\n");
+	fclose(output);
+
+	return true;
+}
+
+void PrintUsage()
+{
+	printf("usage : windageRegression [-json result.json] [-csv frames.csv] [-reference reference.png]\n");
+	printf("                          [-frames n] [-seed n] [-filter name] [-threshold pixel]\n");
+}
+
+void main(int argc, char** argv)
+{
+	std::string jsonFilename = "";
+	std::string csvFilename = "";
+	std::string referenceFilename = "Test/testReference.png";
+	std::string filter = "";
+	int frames = 120;
+	unsigned int seed = 0;
+	double threshold = 5.0;
+
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-json") == 0 && i+1 < argc)
+			jsonFilename = argv[++i];
+		else if(strcmp(argv[i], "-csv") == 0 && i+1 < argc)
+			csvFilename = argv[++i];
+		else if(strcmp(argv[i], "-reference") == 0 && i+1 < argc)
+			referenceFilename = argv[++i];
+		else if(strcmp(argv[i], "-frames") == 0 && i+1 < argc)
+			frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i], "-filter") == 0 && i+1 < argc)
+			filter = argv[++i];
+		else if(strcmp(argv[i], "-threshold") == 0 && i+1 < argc)
+			threshold = atof(argv[++i]);
+		else
+		{
+			PrintUsage();
+			return;
+		}
+	}
+	if(frames < 1) frames = 1;
+
+	// reference (640x480 object of the frameworks)
+	std::string referenceName = referenceFilename;
+	IplImage* reference = cvLoadImage(referenceFilename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+	if(reference == NULL)
+	{
+		char tempName[100];
+		sprintf_s(tempName, "texture320x240_%u", seed);
+		referenceName = tempName;
+		reference = CreateReferenceTexture(320, 240, seed);
+		printf("cannot load %s, use %s\n", referenceFilename.c_str(), referenceName.c_str());
+	}
+
+	std::vector<Scenario> scenarios;
+	scenarios.push_back(Scenario("clean", 2.0, 0.0, 0.0, 0.0, 0, 0.0));
+	scenarios.push_back(Scenario("noise", 8.0, 0.0, 0.0, 0.0, 0, 0.0));
+	scenarios.push_back(Scenario("blur", 2.0, 1.5, 0.0, 0.0, 0, 0.0));
+	scenarios.push_back(Scenario("lighting", 2.0, 0.0, 0.4, 40.0, 0, 0.0));
+	scenarios.push_back(Scenario("occlusion", 2.0, 0.0, 0.0, 0.0, 3, 0.25));
+	scenarios.push_back(Scenario("all", 6.0, 1.0, 0.3, 30.0, 2, 0.2));
+
+	std::vector<std::string> configurationNames;
+	configurationNames.push_back("detection");
+	configurationNames.push_back("tracking");
+	configurationNames.push_back("refinement");
+
+	FILE* csv = NULL;
+	if(csvFilename.size() > 0)
+	{
+		csv = fopen(csvFilename.c_str(), "wb");
+		if(csv)
+			fprintf(csv, "configuration,scenario,frame,latencyMs,tracked,matching,rotationError,translationError,reprojectionError\n");
+	}
+
+	std::vector<RegressionResult> results;
+	for(unsigned int i=0; i<configurationNames.size(); i++)
+	{
+		for(unsigned int j=0; j<scenarios.size(); j++)
+		{
+			if(filter.size() > 0 && configurationNames[i].find(filter) == std::string::npos && scenarios[j].name.find(filter) == std::string::npos)
+				continue;
+
+			// new tracker for every sequence, so the tracked points are not shared
+			Configuration* configuration = new Configuration(configurationNames[i]);
+			if(configuration->Create(reference))
+			{
+				RegressionResult result = RunRegression(configuration, scenarios[j], reference, frames, seed, threshold, csv);
+				PrintRegressionResult(result);
+				results.push_back(result);
+			}
+			else
+			{
+				printf("%-12s %-10s cannot create the tracker\n", configurationNames[i].c_str(), scenarios[j].name.c_str());
+			}
+			delete configuration;
+		}
+	}
+
+	if(csv)
+		fclose(csv);
+
+	if(jsonFilename.size() > 0)
+	{
+		if(WriteRegressionJSON(jsonFilename.c_str(), results, referenceName, frames, seed, threshold))
+			printf("write %s\n", jsonFilename.c_str());
+		else
+			printf("cannot write %s\n", jsonFilename.c_str());
+	}
+
+	cvReleaseImage(&reference);
+}
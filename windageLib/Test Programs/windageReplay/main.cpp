@@ -0,0 +1,344 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <cv.h>
+#include <highgui.h>
+
+#include <windage.h>
+
+/**
+ * deterministic offline replay of the tracking frameworks
+ *
+ * usage : windageReplay -sequence sequence/%04d.png|video.avi [-start 0] [-frames n] [-seed 0]
+ *                       [-framework planar|thread] [-reference reference.png] [-features descriptor%03d.txt count]
+ *                       [-intrinsic fx fy cx cy] [-detection n] [-gpu] [-output replay.txt] [-trace trace.json]
+ *
+ * every stochastic component is seeded by the seed (srand for the FLANN trees) and the threaded framework
+ * runs the detection synchronously at the detection step, so the same sequence and seed give the same poses.
+ * the poses of every frame are written to the output and summarized as a checksum to compare the runs
+ */
+
+const double SCALE_FACTOR = 4.0;
+const int SCALE_STEP = 4;
+const double REPROJECTION_ERROR = 2.0;
+const double DETECTOR_THRESHOLD = 30.0;
+
+/** FNV-1a hash of the replay output */
+class ReplayChecksum
+{
+private:
+	unsigned int hash;
+public:
+	ReplayChecksum(){hash = 2166136261u;};
+	inline unsigned int GetValue(){return this->hash;};
+	void Update(const char* text)
+	{
+		for(int i=0; text[i] != '\0'; i++)
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= 16777619u;
+		}
+	}
+};
+
+void WriteFrame(FILE* output, ReplayChecksum* checksum, int frame, int objectID, int matchingCount, windage::Calibration* calibration)
+{
+	char message[1000];
+	int length = sprintf_s(message, "%d %d %d", frame, objectID, matchingCount);
+	CvMat* extrinsic = calibration->GetExtrinsicMatrix();
+	for(int y=0; y<3; y++)
+	{
+		for(int x=0; x<4; x++)
+			length += sprintf_s(message + length, sizeof(message) - length, " %.9e", CV_MAT_ELEM((*extrinsic), double, y, x));
+	}
+	sprintf_s(message + length, sizeof(message) - length, "\n");
+
+	checksum->Update(message);
+	if(output)
+		fprintf(output, "%s", message);
+}
+
+void PrintUsage()
+{
+	printf("usage : windageReplay -sequence sequence/%%04d.png|video.avi [-start n] [-frames n] [-seed n]\n");
+	printf("                      [-framework planar|thread] [-reference reference.png] [-features descriptor%%03d.txt count]\n");
+	printf("                      [-intrinsic fx fy cx cy] [-detection n] [-gpu] [-output replay.txt] [-trace trace.json]\n");
+}
+
+void main(int argc, char** argv)
+{
+	std::string sequenceFilename = "";
+	std::string framework = "planar";
+	std::string referenceFilename = "Test/testReference.png";
+	std::string featureFilename = "data/PlanarImage/descriptor%03d.txt";
+	std::string outputFilename = "";
+	std::string traceFilename = "";
+	int featureCount = 1;
+	int startIndex = 0;
+	int frames = 0;
+	int detectionRatio = 5;
+	unsigned int seed = 0;
+	bool useGPU = false;
+	double intrinsic[4] = {0.0, 0.0, 0.0, 0.0};
+
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-sequence") == 0 && i+1 < argc)
+			sequenceFilename = argv[++i];
+		else if(strcmp(argv[i], "-start") == 0 && i+1 < argc)
+			startIndex = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-frames") == 0 && i+1 < argc)
+			frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-seed") == 0 && i+1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if(strcmp(argv[i], "-framework") == 0 && i+1 < argc)
+			framework = argv[++i];
+		else if(strcmp(argv[i], "-reference") == 0 && i+1 < argc)
+			referenceFilename = argv[++i];
+		else if(strcmp(argv[i], "-features") == 0 && i+2 < argc)
+		{
+			featureFilename = argv[++i];
+			featureCount = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-intrinsic") == 0 && i+4 < argc)
+		{
+			for(int j=0; j<4; j++)
+				intrinsic[j] = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-detection") == 0 && i+1 < argc)
+			detectionRatio = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-gpu") == 0)
+			useGPU = true;
+		else if(strcmp(argv[i], "-output") == 0 && i+1 < argc)
+			outputFilename = argv[++i];
+		else if(strcmp(argv[i], "-trace") == 0 && i+1 < argc)
+			traceFilename = argv[++i];
+		else
+		{
+			PrintUsage();
+			return;
+		}
+	}
+	if(sequenceFilename.size() == 0 || (framework != "planar" && framework != "thread") ||
+		windage::ImageSequence::IsNumberedPattern(featureFilename.c_str()) == false)
+	{
+		PrintUsage();
+		return;
+	}
+
+	// the FLANN trees and the other rand() users
+	srand(seed);
+
+	windage::ImageSequence sequence;
+	sequence.SetFrameCount(frames);
+	if(sequence.Open(sequenceFilename.c_str(), startIndex) == false || sequence.Next() == false)
+	{
+		printf("cannot open %s\n", sequenceFilename.c_str());
+		return;
+	}
+	int width = sequence.GetGrayImage()->width;
+	int height = sequence.GetGrayImage()->height;
+
+	windage::Calibration* calibration = new windage::Calibration();
+	if(intrinsic[0] > 0.0)
+		calibration->Initialize(intrinsic[0], intrinsic[1], intrinsic[2], intrinsic[3]);
+	else
+		calibration->Initialize((double)width, (double)width, width/2.0, height/2.0);
+
+	// planar : single thread framework (ProSAC and KD-forest are seeded)
+	windage::Frameworks::PlanarObjectTracking* planarTracking = NULL;
+	windage::Algorithms::FeatureDetector* detector = NULL;
+	windage::Algorithms::KDforest* searchtree = NULL;
+	windage::Algorithms::ProSACestimator* prosacEstimator = NULL;
+	windage::Algorithms::LMmethod* refiner = NULL;
+
+	// thread : threaded framework with the synchronous detection
+	windage::Frameworks::MultiplePlanarObjectThreadTracking* threadTracking = NULL;
+	windage::Algorithms::RANSACestimator* ransacEstimator = NULL;
+
+	windage::Algorithms::OpticalFlow* opticalflow = new windage::Algorithms::OpticalFlow();
+	windage::Algorithms::OutlierChecker* checker = new windage::Algorithms::OutlierChecker();
+	opticalflow->Initialize(width, height, cvSize(15, 15), 3);
+	checker->SetReprojectionError(REPROJECTION_ERROR * 3);
+
+	bool trained = false;
+	if(framework == "planar")
+	{
+		IplImage* reference = cvLoadImage(referenceFilename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+		if(reference == NULL)
+		{
+			printf("cannot load %s\n", referenceFilename.c_str());
+			return;
+		}
+
+		detector = new windage::Algorithms::WSURFdetector();
+		searchtree = new windage::Algorithms::KDforest();
+		prosacEstimator = new windage::Algorithms::ProSACestimator();
+		refiner = new windage::Algorithms::LMmethod();
+
+		detector->SetThreshold(DETECTOR_THRESHOLD);
+		searchtree->SetRatio(0.7);
+		searchtree->SetSeed(seed);
+		prosacEstimator->SetReprojectionError(REPROJECTION_ERROR);
+		prosacEstimator->SetSeed(seed);
+		refiner->SetMaxIteration(10);
+
+		planarTracking = new windage::Frameworks::PlanarObjectTracking();
+		planarTracking->AttatchCalibration(calibration);
+		planarTracking->AttatchDetetor(detector);
+		planarTracking->AttatchMatcher(searchtree);
+		planarTracking->AttatchTracker(opticalflow);
+		planarTracking->AttatchEstimator(prosacEstimator);
+		planarTracking->AttatchChecker(checker);
+		planarTracking->AttatchRefiner(refiner);
+		planarTracking->SetDitectionRatio(detectionRatio);
+
+		planarTracking->Initialize(width, height, (double)width, (double)height);
+		planarTracking->AttatchReferenceImage(reference);
+		trained = planarTracking->TrainingReference(SCALE_FACTOR, SCALE_STEP);
+		cvReleaseImage(&reference);
+	}
+	else
+	{
+		ransacEstimator = new windage::Algorithms::RANSACestimator();
+		ransacEstimator->SetReprojectionError(REPROJECTION_ERROR);
+		ransacEstimator->SetSeed(seed);
+
+		threadTracking = new windage::Frameworks::MultiplePlanarObjectThreadTracking();
+		threadTracking->AttatchCalibration(calibration);
+		threadTracking->AttatchTracker(opticalflow);
+		threadTracking->AttatchEstimator(ransacEstimator);
+		threadTracking->AttatchChecker(checker);
+		threadTracking->SetGPUDetection(useGPU);
+		threadTracking->SetSynchronousDetection(true);
+		threadTracking->SetSeed(seed);
+
+		threadTracking->Initialize(width, height, (double)width, (double)height);
+		threadTracking->SetFilter(false);
+		threadTracking->SetDitectionRatio(detectionRatio);
+
+		std::vector<windage::FeaturePoint> featurePoints;
+		windage::FeatureLoader loader;
+		loader.AttatchFeaturePoints(&featurePoints);
+		for(int i=0; i<featureCount; i++)
+		{
+			char filename[windage::ImageSequence::MAX_FILENAME_LENGTH];
+			sprintf_s(filename, featureFilename.c_str(), i);
+
+			featurePoints.clear();
+			if(loader.DoLoad(filename) && threadTracking->TrainingReference(&featurePoints))
+				trained = true;
+			else
+				printf("cannot load %s\n", filename);
+		}
+	}
+
+	if(trained == false)
+	{
+		printf("cannot train the reference\n");
+		return;
+	}
+
+	FILE* output = NULL;
+	if(outputFilename.size() > 0)
+		output = fopen(outputFilename.c_str(), "wb");
+	if(traceFilename.size() > 0)
+		windage::Profiler::StartTrace(traceFilename.c_str());
+
+	ReplayChecksum checksum;
+	std::vector<double> latencies;
+	do
+	{
+		IplImage* grayImage = sequence.GetGrayImage();
+
+		int64 startTick = cvGetTickCount();
+		if(planarTracking)
+			planarTracking->UpdateCamerapose(grayImage);
+		else
+			threadTracking->UpdateCamerapose(grayImage);
+		latencies.push_back((double)(cvGetTickCount() - startTick) / (cvGetTickFrequency() * 1000.0));
+
+		if(planarTracking)
+		{
+			WriteFrame(output, &checksum, sequence.GetIndex(), 0, planarTracking->GetMatchingCount(), calibration);
+		}
+		else
+		{
+			for(int i=0; i<threadTracking->GetObjectCount(); i++)
+				WriteFrame(output, &checksum, sequence.GetIndex(), i, threadTracking->GetMatchingCount(i), threadTracking->GetCameraParameter(i));
+		}
+	}
+	while(sequence.Next());
+
+	if(traceFilename.size() > 0)
+		windage::Profiler::StopTrace();
+	if(output)
+		fclose(output);
+
+	double latencyMean = 0.0;
+	for(unsigned int i=0; i<latencies.size(); i++)
+		latencyMean += latencies[i];
+	latencyMean /= (double)latencies.size();
+
+	printf("framework %s, seed %u, frames %d\n", framework.c_str(), seed, (int)latencies.size());
+	printf("checksum %08x\n", checksum.GetValue());
+	printf("latency median %.3f ms, mean %.3f ms, 95%% %.3f ms, max %.3f ms\n", windage::Utils::GetPercentile(latencies, 0.5), latencyMean,
+		windage::Utils::GetPercentile(latencies, 0.95), windage::Utils::GetPercentile(latencies, 1.0));
+
+	windage::Logger logger(&std::cout);
+	windage::Profiler::Dump(&logger);
+
+	if(planarTracking) delete planarTracking;
+	if(threadTracking) delete threadTracking;
+	if(detector) delete detector;
+	if(searchtree) delete searchtree;
+	if(prosacEstimator) delete prosacEstimator;
+	if(ransacEstimator) delete ransacEstimator;
+	if(refiner) delete refiner;
+	delete opticalflow;
+	delete checker;
+	delete calibration;
+}
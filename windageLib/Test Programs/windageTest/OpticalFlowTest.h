@@ -42,6 +42,7 @@
 
 #include "windageTest.h"
 #include "Algorithms/WSURFdetector.h"
+#include "Algorithms/WSURFMultidetector.h"
 #include "Algorithms/OpticalFlow.h"
 #include "Utilities/Utils.h"
 
@@ -160,6 +161,38 @@ public:
 		windage::Algorithms::OpticalFlow tracker;
 		tracker.Initialize(imageSize.width, imageSize.height);
 
+		// shared pyramid of WSURFMultidetector gives the same tracking result
+		windage::Algorithms::WSURFMultidetector multiDetector(imageSize.width, imageSize.height);
+		multiDetector.UpdatePyramid(grayImage1);
+		if(multiDetector.GetPreviousPyramid() != NULL)
+			test = false;
+		multiDetector.UpdatePyramid(grayImage2);
+		if(multiDetector.GetPreviousPyramid() == NULL)
+			test = false;
+
+		std::vector<windage::FeaturePoint> sharedPrevPoints = *detector->GetKeypoints();
+		std::vector<windage::FeaturePoint> ownPrevPoints = *detector->GetKeypoints();
+		std::vector<windage::FeaturePoint> sharedPoints;
+		std::vector<windage::FeaturePoint> ownPoints;
+
+		tracker.AttatchPyramid(multiDetector.GetPreviousPyramid(), multiDetector.GetPyramid());
+		tracker.TrackFeatures(grayImage1, grayImage2, &sharedPrevPoints, &sharedPoints);
+		tracker.AttatchPyramid(NULL, NULL);
+		tracker.TrackFeatures(grayImage1, grayImage2, &ownPrevPoints, &ownPoints);
+
+		double maxDifference = 0.0;
+		if(sharedPoints.size() != ownPoints.size())
+			test = false;
+		for(unsigned int i=0; i<sharedPoints.size() && i<ownPoints.size(); i++)
+		{
+			if(sharedPoints[i].IsOutlier() != ownPoints[i].IsOutlier())
+				test = false;
+			else if(ownPoints[i].IsOutlier() == false)
+				maxDifference = MAX(maxDifference, (sharedPoints[i].GetPoint() - ownPoints[i].GetPoint()).getLength());
+		}
+		if(maxDifference > 0.01)
+			test = false;
+
 		IplImage* color[2];
 		color[0] = inputImage1;
 		color[1] = inputImage2;
@@ -197,7 +230,7 @@ public:
 			cvWaitKey(100);
 		}
 		
-		sprintf_s(tempMessage, "");
+		sprintf_s(tempMessage, "shared pyramid difference : %.4lf", maxDifference);
 		(*message) = std::string(tempMessage);
 		return test;
 	}
@@ -0,0 +1,293 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <cv.h>
+#include <highgui.h>
+
+#include "windageTest.h"
+#include "Reconstruction/SparseBundleAdjuster.h"
+
+class SparseBundleAdjusterTest : public windageTest
+{
+private:
+	static const int CAMERA_COUNT = 5;
+	static const int POINT_COUNT = 100;
+
+	CvMat* intrinsic;
+	CvMat* groundTruthPoints;
+	CvMat* groundTruthRT[CAMERA_COUNT];
+	windage::Reconstruction::BundleObservations observations;
+
+	CvMat* points;
+	CvMat* RT[CAMERA_COUNT];
+
+	/** copy the ground truth and perturb the points and the extrinsics of the variable cameras */
+	void Perturb(int fixedCameraCount, double pointNoise, double translationNoise)
+	{
+		CvRNG rng = cvRNG(7);
+		for(int p=0; p<POINT_COUNT; p++)
+		{
+			for(int i=0; i<3; i++)
+				cvmSet(points, i, p, cvmGet(groundTruthPoints, i, p) + pointNoise * (2.0 * cvRandReal(&rng) - 1.0));
+			cvmSet(points, 3, p, 1.0);
+		}
+		for(int c=0; c<CAMERA_COUNT; c++)
+		{
+			cvCopy(groundTruthRT[c], RT[c]);
+			if(c < fixedCameraCount)
+				continue;
+			for(int i=0; i<3; i++)
+				cvmSet(RT[c], i, 3, cvmGet(RT[c], i, 3) + translationNoise * (2.0 * cvRandReal(&rng) - 1.0));
+		}
+	}
+
+	double CalculatePointError()
+	{
+		double maxError = 0.0;
+		for(int p=0; p<POINT_COUNT; p++)
+		{
+			double error = 0.0;
+			for(int i=0; i<3; i++)
+			{
+				double d = cvmGet(points, i, p) / cvmGet(points, 3, p) - cvmGet(groundTruthPoints, i, p);
+				error += d*d;
+			}
+			maxError = MAX(maxError, sqrt(error));
+		}
+		return maxError;
+	}
+
+	int CountBehindCamera()
+	{
+		int count = 0;
+		for(int p=0; p<POINT_COUNT; p++)
+		{
+			for(int c=0; c<CAMERA_COUNT; c++)
+			{
+				double z = cvmGet(RT[c], 2, 3);
+				for(int i=0; i<3; i++)
+					z += cvmGet(RT[c], 2, i) * cvmGet(points, i, p) / cvmGet(points, 3, p);
+				if(z <= 0.0)
+					count++;
+			}
+		}
+		return count;
+	}
+
+public:
+	SparseBundleAdjusterTest() : windageTest("SparseBundleAdjuster Test", "SparseBundleAdjuster")
+	{
+		intrinsic = NULL;
+		groundTruthPoints = NULL;
+		points = NULL;
+		for(int c=0; c<CAMERA_COUNT; c++)
+		{
+			groundTruthRT[c] = NULL;
+			RT[c] = NULL;
+		}
+
+		this->Do();
+	}
+	~SparseBundleAdjusterTest()
+	{
+		std::string message;
+		this->Terminate(&message);
+	}
+
+	bool Initialize(std::string* message)
+	{
+		// synthetic scene : cameras on an arc looking at the points in a cube around the origin
+		const double DISTANCE = 6.0;
+		const double fx = 500.0, fy = 500.0, cx = 320.0, cy = 240.0;
+
+		intrinsic = cvCreateMat(3, 3, CV_64FC1);
+		cvSetIdentity(intrinsic);
+		cvmSet(intrinsic, 0, 0, fx);
+		cvmSet(intrinsic, 1, 1, fy);
+		cvmSet(intrinsic, 0, 2, cx);
+		cvmSet(intrinsic, 1, 2, cy);
+
+		for(int c=0; c<CAMERA_COUNT; c++)
+		{
+			double angle = 0.15 * (c - CAMERA_COUNT/2);
+			double Rc[9] = {	cos(angle),		0.0,	sin(angle),
+								0.0,			1.0,	0.0,
+								-sin(angle),	0.0,	cos(angle)	};
+			double C[3] = {DISTANCE * sin(angle), 0.0, -DISTANCE * cos(angle)};
+
+			groundTruthRT[c] = cvCreateMat(3, 4, CV_64FC1);
+			RT[c] = cvCreateMat(3, 4, CV_64FC1);
+			for(int i=0; i<3; i++)
+			{
+				double t = 0.0;
+				for(int j=0; j<3; j++)
+				{
+					cvmSet(groundTruthRT[c], i, j, Rc[i*3+j]);
+					t -= Rc[i*3+j] * C[j];
+				}
+				cvmSet(groundTruthRT[c], i, 3, t);
+			}
+		}
+
+		CvRNG rng = cvRNG(1);
+		groundTruthPoints = cvCreateMat(4, POINT_COUNT, CV_64FC1);
+		points = cvCreateMat(4, POINT_COUNT, CV_64FC1);
+		observations.Clear();
+		for(int p=0; p<POINT_COUNT; p++)
+		{
+			double X[3];
+			for(int i=0; i<3; i++)
+			{
+				X[i] = 2.0 * cvRandReal(&rng) - 1.0;
+				cvmSet(groundTruthPoints, i, p, X[i]);
+			}
+			cvmSet(groundTruthPoints, 3, p, 1.0);
+
+			for(int c=0; c<CAMERA_COUNT; c++)
+			{
+				double x[3];
+				for(int i=0; i<3; i++)
+					x[i] = cvmGet(groundTruthRT[c], i, 0)*X[0] + cvmGet(groundTruthRT[c], i, 1)*X[1] + cvmGet(groundTruthRT[c], i, 2)*X[2] + cvmGet(groundTruthRT[c], i, 3);
+				observations.AddObservation(c, fx * x[0] / x[2] + cx, fy * x[1] / x[2] + cy);
+			}
+			observations.EndPoint();
+		}
+
+		return true;
+	}
+
+	bool TestMemoryRelease(std::string* message)
+	{
+		// checek the memory leak
+		const int size = 10;
+		char memoryAddress1[size];
+		char memoryAddress2[size];
+
+		void* p1 = 0;
+		void* p2 = 0;
+		int compair = 0;
+
+		windage::Reconstruction::SparseBundleAdjuster* adjuster1 = new windage::Reconstruction::SparseBundleAdjuster();
+		p1 = (void*)adjuster1;
+		this->Perturb(2, 0.01, 0.0);
+		adjuster1->SetParameters(intrinsic, points, &observations, RT, CAMERA_COUNT, POINT_COUNT);
+		adjuster1->SetMaxIteration(3);
+		adjuster1->Run();
+		delete adjuster1;
+
+		windage::Reconstruction::SparseBundleAdjuster* adjuster2 = new windage::Reconstruction::SparseBundleAdjuster();
+		p2 = (void*)adjuster2;
+		this->Perturb(2, 0.01, 0.0);
+		adjuster2->SetParameters(intrinsic, points, &observations, RT, CAMERA_COUNT, POINT_COUNT);
+		adjuster2->SetMaxIteration(3);
+		adjuster2->Run();
+		delete adjuster2;
+
+		sprintf_s(memoryAddress1, "%08X", p1);
+		sprintf_s(memoryAddress2, "%08X", p2);
+		compair += strcmp(memoryAddress1, memoryAddress2);
+
+		(*message) = std::string(memoryAddress1) + std::string(",") + std::string(memoryAddress2);
+		if(compair == 0)
+		{
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	bool TestAlgorithm(std::string* message)
+	{
+		bool test = true;
+		char tempMessage[100];
+
+		// the first two cameras are fixed, so the gauge (including the scale) is fixed at the ground truth
+		const int solvers[2] = {windage::Reconstruction::SparseBundleAdjuster::SOLVER_CHOLESKY, windage::Reconstruction::SparseBundleAdjuster::SOLVER_PCG};
+		double maxPointError = 0.0;
+		double maxFinalError = 0.0;
+		for(int s=0; s<2; s++)
+		{
+			this->Perturb(2, 0.05, 0.05);
+
+			windage::Reconstruction::SparseBundleAdjuster adjuster;
+			adjuster.SetParameters(intrinsic, points, &observations, RT, CAMERA_COUNT, POINT_COUNT);
+			adjuster.SetFixedCameraCount(2);
+			adjuster.SetLinearSolver(solvers[s]);
+			adjuster.SetLossFunction(windage::Reconstruction::SparseBundleAdjuster::LOSS_HUBER, 2.0);
+			adjuster.SetMaxIteration(50);
+			adjuster.Run();
+
+			if(adjuster.GetFinalCost() > adjuster.GetInitialCost())
+				test = false;
+			if(this->CountBehindCamera() > 0)
+				test = false;
+
+			maxPointError = MAX(maxPointError, this->CalculatePointError());
+			maxFinalError = MAX(maxFinalError, adjuster.GetFinalError());
+		}
+
+		// noise-free observations : the ground truth is recovered
+		if(maxFinalError > 1.0e-3)
+			test = false;
+		if(maxPointError > 1.0e-4)
+			test = false;
+
+		sprintf_s(tempMessage, "error %g px, point error %g", maxFinalError, maxPointError);
+		(*message) = std::string(tempMessage);
+		return test;
+	}
+
+	bool Terminate(std::string* message)
+	{
+		// remove data and reset the parameters
+		if(intrinsic) cvReleaseMat(&intrinsic);
+		if(groundTruthPoints) cvReleaseMat(&groundTruthPoints);
+		if(points) cvReleaseMat(&points);
+		for(int c=0; c<CAMERA_COUNT; c++)
+		{
+			if(groundTruthRT[c]) cvReleaseMat(&groundTruthRT[c]);
+			if(RT[c]) cvReleaseMat(&RT[c]);
+		}
+		observations.Clear();
+
+		return true;
+	}
+};
@@ -42,6 +42,9 @@
 
 #include "windageTest.h"
 #include "Algorithms/WSURFMultidetector.h"
+#include "Algorithms/FLANNtree.h"
+#include "Algorithms/RANSACestimator.h"
+#include "Frameworks/PlanarObjectTracking.h"
 #include "Utilities/Utils.h"
 
 class WSURFMultidetectorTest : public windageTest
@@ -134,8 +137,44 @@ public:
 			cvShowImage("Windage SURF Multi detector", resultImage);
 			cvWaitKey(1);
 		}
+
+		// the image of other size than the frame is detected without the pyramid
+		IplImage* halfImage = cvCreateImage(cvSize(imageSize.width/2, imageSize.height/2), IPL_DEPTH_8U, 1);
+		cvResize(grayImage, halfImage);
+		wSurfDetector.SetThreshold(45.0);
+		wSurfDetector.DoExtractKeypointsDescriptor(halfImage);
+		std::vector<windage::FeaturePoint>* halfKeypoints = wSurfDetector.GetKeypoints();
+		int halfCount = (int)halfKeypoints->size();
+		for(unsigned int i=0; i<halfKeypoints->size(); i++)
+		{
+			windage::Vector3 point = (*halfKeypoints)[i].GetPoint();
+			if(point.x < 0.0 || point.x > halfImage->width || point.y < 0.0 || point.y > halfImage->height)
+				test = false;
+		}
+		if(halfCount == 0)
+			test = false;
+		cvReleaseImage(&halfImage);
+
+		// training the reference resized to the half of the frame size
+		windage::Calibration calibration;
+		calibration.Initialize(1200, 1200, imageSize.width/2, imageSize.height/2, 0, 0, 0, 0);
+		windage::Algorithms::FLANNtree matcher;
+		windage::Algorithms::RANSACestimator estimator;
+
+		windage::Frameworks::PlanarObjectTracking tracking;
+		tracking.AttatchCalibration(&calibration);
+		tracking.AttatchDetetor(&wSurfDetector);
+		tracking.AttatchMatcher(&matcher);
+		tracking.AttatchEstimator(&estimator);
+		tracking.Initialize(imageSize.width, imageSize.height, imageSize.width, imageSize.height, false);
+		tracking.AttatchReferenceImage(grayImage);
+		tracking.TrainingReference(2.0, 1);
+		int trainedCount = (int)tracking.GetReferenceRep()->size();
+		if(trainedCount == 0)
+			test = false;
 		
-		sprintf_s(tempMessage, "");(*message) = std::string(tempMessage);
+		sprintf_s(tempMessage, "half size keypoints : %d, trained : %d", halfCount, trainedCount);
+		(*message) = std::string(tempMessage);
 		return test;
 	}
 
@@ -49,6 +49,165 @@ class WSURFdetectorTest : public windageTest
 private:
 	IplImage* grayImage;
 
+	struct HaarBox
+	{
+		int p0, p1, p2, p3;
+		float w;
+	};
+
+	static void ResizeHaarPattern(const int src[][5], HaarBox* dst, int n, int size, int widthStep)
+	{
+		float ratio = (float)size / 9.0f;
+		for(int k=0; k<n; k++)
+		{
+			int dx1 = cvRound(ratio * src[k][0]);
+			int dy1 = cvRound(ratio * src[k][1]);
+			int dx2 = cvRound(ratio * src[k][2]);
+			int dy2 = cvRound(ratio * src[k][3]);
+			dst[k].p0 = dy1 * widthStep + dx1;
+			dst[k].p1 = dy2 * widthStep + dx1;
+			dst[k].p2 = dy1 * widthStep + dx2;
+			dst[k].p3 = dy2 * widthStep + dx2;
+			dst[k].w = src[k][4] / ((float)(dx2 - dx1) * (dy2 - dy1));
+		}
+	}
+
+	static float HaarPattern(const int* origin, const HaarBox* f, int n)
+	{
+		double d = 0;
+		for(int k=0; k<n; k++)
+			d += (origin[f[k].p0] + origin[f[k].p3] - origin[f[k].p1] - origin[f[k].p2]) * f[k].w;
+		return (float)d;
+	}
+
+	/**
+	 * scalar fast-hessian detector (one sample at a time, no tiling) as the reference of KEYPOINT_HESSIAN,
+	 * keypoints are filtered with the same border as WSURFdetector
+	 */
+	static void ReferenceFastHessian(IplImage* grayImage, double threshold, int octaves, int octaveLayers, std::vector<CvSURFPoint>* points)
+	{
+		const int dx_s[3][5] = { {0, 2, 3, 7, 1}, {3, 2, 6, 7, -2}, {6, 2, 9, 7, 1} };
+		const int dy_s[3][5] = { {2, 0, 7, 3, 1}, {2, 3, 7, 6, -2}, {2, 6, 7, 9, 1} };
+		const int dxy_s[4][5] = { {1, 1, 4, 4, 1}, {5, 1, 8, 4, -1}, {1, 5, 4, 8, -1}, {5, 5, 8, 8, 1} };
+		HaarBox Dx[3], Dy[3], Dxy[4];
+
+		CvMat* sum = cvCreateMat(grayImage->height+1, grayImage->width+1, CV_32SC1);
+		cvIntegral(grayImage, sum);
+
+		int layerCount = octaveLayers + 2;
+		std::vector<CvMat*> dets(layerCount);
+		std::vector<CvMat*> traces(layerCount);
+		std::vector<int> sizes(layerCount);
+		for(int layer=0; layer<layerCount; layer++)
+		{
+			dets[layer] = cvCreateMat(sum->rows-1, sum->cols-1, CV_32FC1);
+			traces[layer] = cvCreateMat(sum->rows-1, sum->cols-1, CV_32FC1);
+		}
+
+		for(int octave=0, sampleStep=1; octave<octaves; octave++, sampleStep*=2)
+		{
+			int rows = (sum->rows-1) / sampleStep;
+			int cols = (sum->cols-1) / sampleStep;
+
+			// determinant and trace of the hessian
+			for(int layer=0; layer<layerCount; layer++)
+			{
+				int size = sizes[layer] = (9 + 6*layer) << octave;
+				ResizeHaarPattern(dx_s, Dx, 3, size, sum->cols);
+				ResizeHaarPattern(dy_s, Dy, 3, size, sum->cols);
+				ResizeHaarPattern(dxy_s, Dxy, 4, size, sum->cols);
+
+				int margin = (size/2) / sampleStep;
+				for(int sum_i=0, i=margin; sum_i<=(sum->rows-1)-size; sum_i+=sampleStep, i++)
+				{
+					const int* s_ptr = sum->data.i + sum_i * sum->cols;
+					float* det_ptr = dets[layer]->data.fl + i * dets[layer]->cols + margin;
+					float* trace_ptr = traces[layer]->data.fl + i * traces[layer]->cols + margin;
+					for(int sum_j=0; sum_j<=(sum->cols-1)-size; sum_j+=sampleStep, s_ptr+=sampleStep)
+					{
+						double dx = HaarPattern(s_ptr, Dx, 3);
+						double dy = HaarPattern(s_ptr, Dy, 3);
+						double dxy = HaarPattern(s_ptr, Dxy, 4);
+						*det_ptr++ = (float)(dx*dy - 0.81*dxy*dxy);
+						*trace_ptr++ = (float)(dx + dy);
+					}
+				}
+			}
+
+			// 3x3x3 maxima of the determinant
+			for(int layer=1; layer<=octaveLayers; layer++)
+			{
+				int size = sizes[layer];
+				int margin = (sizes[layer+1]/2) / sampleStep + 1;
+				int c = dets[layer]->cols;
+				for(int i=margin; i<rows-margin; i++)
+				{
+					for(int j=margin; j<cols-margin; j++)
+					{
+						const float* det2 = dets[layer]->data.fl + i*c + j;
+						float val0 = det2[0];
+						if(val0 <= threshold)
+							continue;
+
+						float N9[3][9];
+						bool maximum = true;
+						for(int l=0; l<3; l++)
+						{
+							const float* det = dets[layer-1+l]->data.fl + i*c + j;
+							for(int k=0; k<9; k++)
+							{
+								N9[l][k] = det[(k/3 - 1)*c + (k%3 - 1)];
+								if(!(l == 1 && k == 4) && val0 <= N9[l][k])
+									maximum = false;
+							}
+						}
+						if(!maximum)
+							continue;
+
+						int sum_i = sampleStep * (i - (size/2)/sampleStep);
+						int sum_j = sampleStep * (j - (size/2)/sampleStep);
+						CvSURFPoint point = cvSURFPoint(cvPoint2D32f(sum_j + (double)(size-1)/2, sum_i + (double)(size-1)/2),
+														CV_SIGN(traces[layer]->data.fl[i*c + j]), size, 0, val0);
+
+						// interpolate the maxima in the 3x3x3 neighbourhood
+						float A[9], x[3], b[3];
+						CvMat _A = cvMat(3, 3, CV_32F, A);
+						CvMat _x = cvMat(3, 1, CV_32F, x);
+						CvMat _b = cvMat(3, 1, CV_32F, b);
+						b[0] = -(N9[1][5]-N9[1][3])/2;
+						b[1] = -(N9[1][7]-N9[1][1])/2;
+						b[2] = -(N9[2][4]-N9[0][4])/2;
+						A[0] = N9[1][3]-2*N9[1][4]+N9[1][5];
+						A[1] = A[3] = (N9[1][8]-N9[1][6]-N9[1][2]+N9[1][0])/4;
+						A[2] = A[6] = (N9[2][5]-N9[2][3]-N9[0][5]+N9[0][3])/4;
+						A[4] = N9[1][1]-2*N9[1][4]+N9[1][7];
+						A[5] = A[7] = (N9[2][7]-N9[2][1]-N9[0][7]+N9[0][1])/4;
+						A[8] = N9[0][4]-2*N9[1][4]+N9[2][4];
+						if(!cvSolve(&_A, &_b, &_x))
+							continue;
+
+						int ds = sizes[layer] - sizes[layer-1];
+						point.pt.x += x[0] * sampleStep;
+						point.pt.y += x[1] * sampleStep;
+						point.size = cvRound(point.size + x[2] * ds);
+
+						int px = cvRound(point.pt.x);
+						int py = cvRound(point.pt.y);
+						if(point.size >= 1 && px >= 3 && py >= 3 && px < grayImage->width-3 && py < grayImage->height-3)
+							points->push_back(point);
+					}
+				}
+			}
+		}
+
+		for(int layer=0; layer<layerCount; layer++)
+		{
+			cvReleaseMat(&dets[layer]);
+			cvReleaseMat(&traces[layer]);
+		}
+		cvReleaseMat(&sum);
+	}
+
 public:
 	WSURFdetectorTest() : windageTest("Windage SURFdetector Test", "WindageSURFdetector")
 	{
@@ -131,8 +290,76 @@ public:
 			cvShowImage("Windage SURF detector", resultImage);
 			cvWaitKey(1);
 		}
+
+		// adaptive threshold with grid bucketing
+		const int TARGET_COUNT = 300;
+		wSurfDetector.SetThreshold(150.0);
+		wSurfDetector.SetTargetCount(TARGET_COUNT);
+		wSurfDetector.SetGridBucketing(8, 6, 10);
+		for(int i=0; i<30; i++)
+		{
+			cvCopyImage(testImage, resultImage);
+
+			wSurfDetector.DoExtractKeypointsDescriptor(grayImage);
+			wSurfDetector.DrawKeypoints(resultImage, CV_RGB(0, 255, 0));
+
+			sprintf_s(tempMessage, "Adaptive threshold : %.2lf (%d corners)", wSurfDetector.GetThreshold(), wSurfDetector.GetDetectedCount());
+			windage::Utils::DrawTextToImage(resultImage, cvPoint(10, 20), 0.7, tempMessage);
+
+			cvShowImage("Windage SURF detector", resultImage);
+			cvWaitKey(1);
+		}
+		if(wSurfDetector.GetKeypointsCount() > 8*6*10)
+			test = false;
+		if(abs(wSurfDetector.GetDetectedCount() - TARGET_COUNT) > TARGET_COUNT/2)
+			test = false;
+
+		// tiled fast-hessian detector against the scalar reference detector
+		const double HESSIAN_THRESHOLD = 500.0;
+		windage::Algorithms::WSURFdetector tiledDetector(HESSIAN_THRESHOLD);
+		tiledDetector.SetKeypointDetector(windage::Algorithms::WSURFdetector::KEYPOINT_HESSIAN);
+		tiledDetector.DoExtractKeypointsDescriptor(grayImage);
+
+		std::vector<CvSURFPoint> referencePoints;
+		ReferenceFastHessian(grayImage, HESSIAN_THRESHOLD, 3, 4, &referencePoints);
+
+		std::vector<windage::FeaturePoint>* tiledPoints = tiledDetector.GetKeypoints();
+		int matchedCount = 0;
+		for(unsigned int i=0; i<tiledPoints->size(); i++)
+		{
+			for(unsigned int j=0; j<referencePoints.size(); j++)
+			{
+				windage::Vector3 referencePoint(referencePoints[j].pt.x, referencePoints[j].pt.y, 1.0);
+				if((*tiledPoints)[i].GetSize() == referencePoints[j].size &&
+					((*tiledPoints)[i].GetPoint() - referencePoint).getLength() < 0.5)
+				{
+					matchedCount++;
+					break;
+				}
+			}
+		}
+		int referenceCount = (int)referencePoints.size();
+		if(referenceCount == 0)
+			test = false;
+		if(abs((int)tiledPoints->size() - referenceCount) > referenceCount/50 + 2)
+			test = false;
+		if(matchedCount < referenceCount - referenceCount/50 - 2)
+			test = false;
+
+		// the adaptive hessian threshold is clamped to the hessian range, not to the FAST range
+		tiledDetector.SetTargetCount((int)tiledPoints->size());
+		tiledDetector.DoExtractKeypointsDescriptor(grayImage);
+		if(fabs(tiledDetector.GetThreshold() - HESSIAN_THRESHOLD) > HESSIAN_THRESHOLD * 0.5)
+			test = false;
+
+		cvCopyImage(testImage, resultImage);
+		for(unsigned int i=0; i<referencePoints.size(); i++)
+			cvCircle(resultImage, cvPointFrom32f(referencePoints[i].pt), referencePoints[i].size/2, CV_RGB(0, 0, 255));
+		tiledDetector.DrawKeypoints(resultImage, CV_RGB(255, 0, 0));
+		cvShowImage("Windage SURF detector", resultImage);
+		cvWaitKey(1);
 		
-		sprintf_s(tempMessage, "");(*message) = std::string(tempMessage);
+		sprintf_s(tempMessage, "fast-hessian %d/%d matched", matchedCount, referenceCount);(*message) = std::string(tempMessage);
 		return test;
 	}
 
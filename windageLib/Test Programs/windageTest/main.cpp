@@ -47,6 +47,7 @@
 #include "SURFdetectorTest.h"
 #include "OpenSURFdetectorTest.h"
 #include "SIFTdetectorTest.h"
+#include "SIFTCPUdetectorTest.h"
 #include "SIFTGPUdetectorTest.h"
 #include "WSURFdetectorTest.h"
 #include "WSURFMultidetectorTest.h"
@@ -73,6 +74,7 @@
 #include "MultiplePlanarObjectTrackingTest.h"
 
 #include "StereoReconstructionTest.h"
+#include "SparseBundleAdjusterTest.h"
 
 
 void main()
@@ -87,6 +89,7 @@ void main()
 	OpenSURFdetectorTest testOpenSURFdetector;
 /*
 	SIFTdetectorTest testSIFTdetector;
+	SIFTCPUdetectorTest testSIFTCPUdetector;
 	SIFTGPUdetectorTest testSIFTGPUdetector;
 	WSURFdetectorTest testWSURFdetector;
 	WSURFMultidetectorTest testWSURFMultidetector;
@@ -112,6 +115,7 @@ void main()
 	MultiplePlanarObjectTrackingTest testMultiplePlanarObjectTracking;
 
 	StereoReconstructionTest testStereoReconstruction;
+	SparseBundleAdjusterTest testSparseBundleAdjuster;
 */
 	cvNamedWindow("stop");
 	cvWaitKey(10*1000);
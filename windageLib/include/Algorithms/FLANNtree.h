@@ -121,6 +121,17 @@ namespace windage
 			 */
 			bool Training(std::vector<windage::FeaturePoint>* pointList);
 
+			/**
+			 * @fn	TrainingDescriptors
+			 * @brief
+			 *		generate FLANN index over the descriptor array without copy
+			 * @warning
+			 *		descriptors must be alive until next training or destruction
+			 * @return
+			 *		success or failure
+			 */
+			bool TrainingDescriptors(const float* descriptors, int count, int dimension);
+
 			/**
 			 * @fn	Matching
 			 * @brief
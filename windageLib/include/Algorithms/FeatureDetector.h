@@ -116,6 +116,21 @@ namespace windage
 			inline void SetThreshold(double threshold){if(threshold > 0)this->threshold = threshold;};
 			inline double GetThreshold(){return this->threshold;};
 
+			/**
+			 * @fn	UpdatePyramid
+			 * @brief
+			 *		build the image pyramid of the input frame to share it with the feature tracking
+			 * @remark
+			 *		the detectors which build an image pyramid override it (e.g. WSURFMultidetector)
+			 *		the next DoExtractKeypointsDescriptor of the same image reuses the pyramid
+			 * @return
+			 *		false if the detector does not have an image pyramid
+			 */
+			virtual bool UpdatePyramid(IplImage* grayImage){return false;};
+			virtual int GetPyramidLevel(){return 0;};
+			virtual IplImage* GetPyramid(){return NULL;};
+			virtual IplImage* GetPreviousPyramid(){return NULL;};
+
 			/**
 			 * @fn	DrawKeypoint
 			 * @brief
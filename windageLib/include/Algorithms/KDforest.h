@@ -89,6 +89,7 @@ namespace windage
 			std::vector<std::vector<int>> descriptorIndex;
 			std::vector<CvFeatureTree*> spilltree;	///< openCV tree search interface pointer
 			int eMax;					///< limitation of iteration count
+			CvRNG rng;					///< random number generator of the overlap (seeded from the clock unless SetSeed)
 
 		public:
 			virtual char* GetFunctionName(){return "KDforest";};
@@ -111,6 +112,7 @@ namespace windage
 				}
 
 				this->eMax = eMax;
+				this->rng = cvRNG(cvGetTickCount());
 			}
 			~KDforest()
 			{
@@ -125,6 +127,7 @@ namespace windage
 
 			inline void SetEMax(int emax){this->eMax = emax;};
 			inline int GetEMax(){return this->eMax;};
+			inline void SetSeed(int64 seed){this->rng = cvRNG(seed);};
 
 			/**
 			 * @fn	Training
@@ -0,0 +1,211 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	MultiTemplateESM.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	It is batch homography refinement class for multiple planar templates using ESM (Efficient Second-order Minimization)
+ */
+
+#ifndef _MULTI_TEMPLATE_ESM_H_
+#define _MULTI_TEMPLATE_ESM_H_
+
+#include <vector>
+
+#include <cv.h>
+#include "base.h"
+
+#include "Structures/Matrix.h"
+
+namespace windage
+{
+	namespace Algorithms
+	{
+		/**
+		 * @defgroup Algorithms Algorithm classes
+		 * @brief
+		 *		algorithm classes
+		 * @addtogroup Algorithms
+		 * @{
+		 */
+
+		/**
+		 * @brief	class for dense homography refinement of multiple templates in one frame
+		 * @remark
+		 *		the sampling data of all templates are kept in one contiguous arena,
+		 *		the gradient images of the input frame are computed once and shared by every template
+		 *		and the templates are aligned in parallel (one template per thread)
+		 * @author	Woonhyuk Baek
+		 */
+		class DLLEXPORT MultiTemplateESM
+		{
+		protected:
+			static const int PARAMETER_COUNT = 8;
+			static const int SAMPLE_CHANNEL = 5;	///< x, y, intensity, gradient x, gradient y
+
+			/**
+			 * @brief	per template block in the arena
+			 */
+			struct TemplateBlock
+			{
+				int offset;					///< first float of the block in the arena
+				int count;					///< the number of sampling points
+				int width;					///< template width
+				int height;					///< template height
+				double centerX;				///< sampling coordinates are normalized as (x - centerX) / scale
+				double centerY;
+				double scale;
+
+				windage::Matrix3 homography;///< template pixel to input image
+				bool active;				///< aligned at next Calculate
+				bool aligned;				///< result of last Calculate
+				int iteration;				///< iteration count of last Calculate
+				double error;				///< mean absolute intensity error of last Calculate
+			};
+
+			int samplingStep;				///< template sampling step (pixel)
+			int maxIteration;				///< maximum iteration per template
+			double convergenceDelta;		///< stop when the template corners move less than it (pixel)
+			double minValidRatio;			///< template fails when less sampling points are inside of the image
+
+			std::vector<float> arena;		///< sampling data of all templates (SoA block per template)
+			std::vector<TemplateBlock> templates;
+			int maxSampleCount;				///< the largest block to size the per thread buffer
+
+			IplImage* frame;				///< input frame (32F)
+			IplImage* gradientX;			///< shared x-derivative of the input frame (32F)
+			IplImage* gradientY;			///< shared y-derivative of the input frame (32F)
+
+			/**
+			 * @fn	AlignTemplate
+			 * @brief
+			 *		run ESM iterations of one template on the shared frame data
+			 * @remark
+			 *		buffer is the per thread working memory sized by Calculate
+			 */
+			bool AlignTemplate(TemplateBlock* block, float* buffer);
+
+		public:
+			virtual char* GetFunctionName(){return "MultiTemplateESM";};
+			MultiTemplateESM()
+			{
+				samplingStep = 2;
+				maxIteration = 10;
+				convergenceDelta = 0.05;
+				minValidRatio = 0.5;
+				maxSampleCount = 0;
+
+				frame = NULL;
+				gradientX = NULL;
+				gradientY = NULL;
+			}
+			virtual ~MultiTemplateESM()
+			{
+				if(frame) cvReleaseImage(&frame);
+				if(gradientX) cvReleaseImage(&gradientX);
+				if(gradientY) cvReleaseImage(&gradientY);
+				frame = NULL;
+				gradientX = NULL;
+				gradientY = NULL;
+			}
+
+			inline void SetSamplingStep(int step){if(step < 1) step = 1; this->samplingStep = step;};
+			inline int GetSamplingStep(){return this->samplingStep;};
+			inline void SetMaxIteration(int iteration){this->maxIteration = iteration;};
+			inline int GetMaxIteration(){return this->maxIteration;};
+			inline void SetConvergenceDelta(double delta){this->convergenceDelta = delta;};
+			inline double GetConvergenceDelta(){return this->convergenceDelta;};
+
+			inline int GetTemplateCount(){return (int)this->templates.size();};
+			inline void SetActive(int templateID, bool active){this->templates[templateID].active = active;};
+			inline bool IsActive(int templateID){return this->templates[templateID].active;};
+			inline bool IsAligned(int templateID){return this->templates[templateID].aligned;};
+			inline int GetIteration(int templateID){return this->templates[templateID].iteration;};
+			inline double GetError(int templateID){return this->templates[templateID].error;};
+
+			/**
+			 * @fn	SetHomography
+			 * @brief
+			 *		set initial homography (template pixel to input image) and activate the template
+			 */
+			void SetHomography(int templateID, windage::Matrix3 homography);
+			inline windage::Matrix3 GetHomography(int templateID){return this->templates[templateID].homography;};
+
+			/**
+			 * @fn	AttatchTemplateImage
+			 * @brief
+			 *		sample the template image into the arena
+			 * @remark
+			 *		the image is copied so it can be released after calling this method
+			 * @warning
+			 *		template image is always gray image (1-channel)
+			 * @return
+			 *		template ID or -1 at failure
+			 */
+			int AttatchTemplateImage(IplImage* grayImage);
+
+			/**
+			 * @fn	ClearTemplates
+			 * @brief
+			 *		remove all templates
+			 */
+			void ClearTemplates();
+
+			/**
+			 * @fn	Calculate
+			 * @brief
+			 *		refine the homographies of all active templates on the input frame
+			 * @remark
+			 *		a template keeps its initial homography when the intensity error is not reduced
+			 *		or too many sampling points are warped out of the image,
+			 *		the illumination change is compensated by gain and bias at each iteration
+			 * @warning
+			 *		input image is always gray image (1-channel)
+			 * @return
+			 *		success or failure
+			 */
+			bool Calculate(IplImage* grayImage);
+		};
+		/** @} */ // addtogroup Algorithms
+	}
+}
+#endif // _MULTI_TEMPLATE_ESM_H_
\ No newline at end of file
@@ -56,6 +56,9 @@
 #include "Structures/Vector.h"
 #include "Algorithms/FeatureDetector.h"
 
+class Ipoint;
+class FastHessian;
+
 namespace windage
 {
 	namespace Algorithms
@@ -83,15 +86,22 @@ namespace windage
 		class DLLEXPORT OpenSURFdetector : public FeatureDetector
 		{
 		private:
+			std::vector<Ipoint>* ipts;		///< OpenSURF interest points of the last frame
+			FastHessian* fastHessian;		///< kept between frames to reuse the response layers
+
+			void Release();
 
 		public:
 			virtual char* GetFunctionName(){return "OpenSURFdetector";};
 			OpenSURFdetector(double threshold = 0.0004f) : FeatureDetector()
 			{
 				this->threshold = threshold;
+				this->ipts = NULL;
+				this->fastHessian = NULL;
 			}
 			~OpenSURFdetector()
 			{
+				this->Release();
 			}
 
 			/**
@@ -100,6 +100,9 @@ namespace windage
 			IplImage* pyramid1;
 			IplImage* pyramid2;
 
+			IplImage* attatchedPyramid1;			///< pre-built pyramid of previous image (attatched from out-side)
+			IplImage* attatchedPyramid2;			///< pre-built pyramid of current image (attatched from out-side)
+
 			void Release();
 
 		public:
@@ -109,6 +112,8 @@ namespace windage
 				terminationCriteria = cvTermCriteria( CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, eMax, .3);
 				pyramid1 = NULL;
 				pyramid2 = NULL;
+				attatchedPyramid1 = NULL;
+				attatchedPyramid2 = NULL;
 			}
 			~OpticalFlow()
 			{
@@ -145,6 +150,40 @@ namespace windage
 							int pyramidLevel=3					///< opticalflow pyramid level
 							);
 
+			/**
+			 * @fn	AttatchPyramid
+			 * @brief
+			 *		attatch pre-built image pyramids to skip the pyramid construction in TrackFeatures
+			 * @remark
+			 *		the pyramid buffers are built by BuildPyramid (e.g. shared from WSURFMultidetector)
+			 *		NULL means the pyramid is built inside TrackFeatures as usual
+			 * @warning
+			 *		the pyramids have to be built from the same images passed to TrackFeatures
+			 *		with the level at least the pyramid level of this class
+			 *		pyramid buffers are not create in-side at this class so do not release this pointer
+			 */
+			inline void AttatchPyramid(IplImage* prevPyramid, IplImage* currPyramid){this->attatchedPyramid1 = prevPyramid; this->attatchedPyramid2 = currPyramid;};
+
+			/**
+			 * @fn	BuildPyramid
+			 * @brief
+			 *		build Gaussian pyramid by successive decimation (cvPyrDown)
+			 * @remark
+			 *		the levels 1..pyramidLevel are packed into pyramidBuffer with the same layout of cvCalcOpticalFlowPyrLK
+			 *		so the buffer can be passed as ready pyramid (CV_LKFLOW_PYR_A_READY / CV_LKFLOW_PYR_B_READY)
+			 *		if levelHeaders is not NULL, levelHeaders[i-1] is initialized as image header of level i
+			 * @warning
+			 *		pyramidBuffer is 8-bit 1-channel image that is at least the size of grayImage
+			 * @return
+			 *		success or failure
+			 */
+			static bool BuildPyramid(
+							IplImage* grayImage,				///< input image (level 0)
+							IplImage* pyramidBuffer,			///< output pyramid buffer
+							int pyramidLevel,					///< pyramid level
+							IplImage* levelHeaders = NULL		///< output level image headers (pyramidLevel elements)
+							);
+
 			/**
 			 * @fn	TrackFeatures
 			 * @brief
@@ -86,6 +86,7 @@ namespace windage
 		protected:
 			windage::Calibration* cameraParameter;	///< camera calibration parameter to attatch reference pointer at out-side
 			double reprojectionError;				///< threshold to determin outlier or not
+			CvRNG rng;								///< random number generator of the sampling (seeded from the clock unless SetSeed)
 
 			/** the nubmer of referencePoints and the number of scenePoints is to be same */
 			std::vector<windage::FeaturePoint>* referencePoints;	///< reference feature pointers to attatch pointer at out-side
@@ -97,6 +98,7 @@ namespace windage
 			{
 				cameraParameter = NULL;
 				reprojectionError = 2.0;
+				rng = cvRNG(cvGetTickCount());
 
 				this->referencePoints = NULL;
 				this->scenePoints = NULL;
@@ -143,6 +145,16 @@ namespace windage
 			inline void SetReprojectionError(double error){this->reprojectionError = error;};
 			inline double GetReprojectionError(){return this->reprojectionError;};
 
+			/**
+			 * @fn	SetSeed
+			 * @brief
+			 *		seed the random sampling of the robust estimation
+			 * @remark
+			 *		the generator is not re-seeded at every calculation,
+			 *		so the same seed and the same input sequence give the same result
+			 */
+			inline void SetSeed(int64 seed){this->rng = cvRNG(seed);};
+
 
 			windage::Vector3 ConvertWorldToImage(windage::Vector3 point = windage::Vector3(0.0, 0.0, 0.0))
 			{
@@ -0,0 +1,88 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	wsift.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.04
+ * @brief	multithreaded windage SIFT on the CPU
+ */
+
+#ifndef _W_SIFT_H_
+#define _W_SIFT_H_
+
+#include <vector>
+
+#include <cv.h>
+#include "Algorithms/SIFT/sift.h"
+
+/** feature layout of the windage SIFT, same as the SiftGPU keypoint and descriptor pair */
+struct wSIFTFeature
+{
+	float x;				///< x position at input image
+	float y;				///< y position at input image
+	float scale;			///< feature scale at input image
+	float orientation;		///< canonical orientation [-PI, PI)
+	float descriptor[SIFT_DESCR_WIDTH * SIFT_DESCR_WIDTH * SIFT_DESCR_HIST_BINS];	///< unit length descriptor (same as SiftGPU)
+};
+
+/** scale space buffers kept between frames, re-created only when the input size is changed */
+struct wSIFTPyramid
+{
+	int width;						///< input image width
+	int height;						///< input image height
+	int octaves;					///< number of octaves
+	int intervals;					///< sampled intervals per octave
+	bool doubleImage;				///< double the input image before construct the pyramid
+	IplImage* input;				///< 32-bit input image ([0, 1] range)
+	IplImage* buffer;				///< scratch image for the separable gaussian (size of the base level)
+	std::vector<IplImage*> gauss;	///< octaves x (intervals + 3) gaussian images
+	std::vector<IplImage*> dog;		///< octaves x (intervals + 2) difference of gaussian images
+};
+
+wSIFTPyramid* wCreateSIFTPyramid( int width, int height, int intervals = SIFT_INTVLS, bool doubleImage = true );
+void wReleaseSIFTPyramid( wSIFTPyramid** pyramid );
+
+void wGaussianBlur( const IplImage* src, IplImage* dst, IplImage* buffer, double sigma );
+int wExtractSIFT( const IplImage* grayImage, wSIFTPyramid* pyramid, std::vector<wSIFTFeature>* features,
+				  double contrastThreshold, double sigma = SIFT_SIGMA, int curvatureThreshold = SIFT_CURV_THR );
+
+#endif
@@ -0,0 +1,136 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	SIFTCPUdetector.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.04
+ * @brief	It is multithreaded SIFT feature detection & description class using CPU
+ */
+
+#ifndef _SIFT_CPU_DETECTOR_H_
+#define _SIFT_CPU_DETECTOR_H_
+
+#include <vector>
+
+#include <cv.h>
+#include "base.h"
+
+#include "Structures/Vector.h"
+#include "Algorithms/FeatureDetector.h"
+
+struct wSIFTPyramid;
+struct wSIFTFeature;
+
+namespace windage
+{
+	namespace Algorithms
+	{
+		/**
+		 * @defgroup Algorithms Algorithm classes
+		 * @brief
+		 *		algorithm classes
+		 * @addtogroup Algorithms
+		 * @{
+		 */
+
+		/**
+		 * @defgroup AlgorithmsFeatureDetector Feature Detector
+		 * @brief
+				feature detector algorithm classes
+		 * @addtogroup AlgorithmsFeatureDetector
+		 * @{
+		 */
+
+		/**
+		 * @brief	Class for SIFT CPU feature detector
+		 * @remark
+		 *		the output layout is same as SIFTGPUdetector (unit length descriptor, size is feature scale)
+		 *		so it can be replaced where an OpenGL context is not available
+		 * @author	Woonhyuk Baek
+		 */
+		class DLLEXPORT SIFTCPUdetector : public FeatureDetector
+		{
+		private:
+			int numberOfIntervals;					///< sampled intervals per octave
+			bool doubleImage;						///< double the input image before construct the scale space
+			wSIFTPyramid* pyramid;					///< scale space buffers, re-created when the input size is changed
+			std::vector<wSIFTFeature>* features;	///< detected features buffer
+
+			void Release();
+
+		public:
+			virtual char* GetFunctionName(){return "SIFTCPUdetector";};
+			SIFTCPUdetector(int numberOfIntervals = 3, bool doubleImage = true) : FeatureDetector()
+			{
+				this->numberOfIntervals = numberOfIntervals;
+				this->doubleImage = doubleImage;
+
+				/** same as the default dog threshold of SiftGPU */
+				this->threshold = 0.02 / numberOfIntervals;
+
+				pyramid = NULL;
+				features = NULL;
+			}
+			~SIFTCPUdetector()
+			{
+				this->Release();
+			}
+
+			/**
+			 * @fn	DoExtractKeypointsDescriptor
+			 * @brief
+			 *		implemantation of SIFT feature extraction & description
+			 * @remark
+			 *		the result is depend on threshold (member valuable) that is contrast threshold of difference of gaussian
+			 *		scale space construction, orientation assignment and description are computed in parallel
+			 * @warning
+			 *		input image is always gray image (1-channel)
+			 * @return
+			 *		success or failure
+			 */
+			bool DoExtractKeypointsDescriptor(IplImage* grayImage);
+		};
+		/** @} */ // addtogroup AlgorithmsFeatureDetector
+		/** @} */ // addtogroup Algorithms
+	}
+}
+#endif // _SIFT_CPU_DETECTOR_H_
@@ -114,6 +114,36 @@ namespace windage
 								  std::vector<windage::FeaturePoint>* pointList	///< feature point list to generate tree
 								  ) = 0;
 
+			/**
+			 * @fn	TrainingDescriptors
+			 * @brief
+			 *		generate descriptor tree from row-major float descriptor array (count x dimension)
+			 * @remark
+			 *		default implementation copies into feature point list and calls Training,
+			 *		implementation class can override to use the array in place (e.g. memory-mapped feature file)
+			 * @warning
+			 *		in-place implementation refers to the array until next training or destruction
+			 * @return
+			 *		success or failure
+			 */
+			virtual bool TrainingDescriptors(
+											 const float* descriptors,	///< descriptor array
+											 int count,					///< descriptor count
+											 int dimension				///< descriptor dimension
+											 )
+			{
+				if(descriptors == NULL || count <= 0 || dimension <= 0)
+					return false;
+
+				std::vector<windage::FeaturePoint> pointList(count);
+				for(int i=0; i<count; i++)
+				{
+					pointList[i].DESCRIPTOR_DIMENSION = dimension;
+					pointList[i].descriptor.assign(descriptors + i*dimension, descriptors + (i+1)*dimension);
+				}
+				return this->Training(&pointList);
+			}
+
 			/**
 			 * @fn	Matching
 			 * @brief
@@ -56,6 +56,7 @@
 #include "Structures/Vector.h"
 #include "Algorithms/FeatureDetector.h"
 #include "Algorithms/WSURFdetector.h"
+#include "Algorithms/OpticalFlow.h"
 
 namespace windage
 {
@@ -94,10 +95,26 @@ namespace windage
 			std::vector<double> yScale;
 
 			std::vector<IplImage*> resizeImage;
+			std::vector<int> resizeSource;					///< pyramid level that each scale image is resized from (0 : input image)
+			std::vector<windage::Algorithms::WSURFdetector*> detectors;	///< reused single scale detector of each scale image
+
+			int pyramidLevel;								///< decimation pyramid level
+			int pyramidIndex;								///< current pyramid buffer (double buffered)
+			int pyramidCount;								///< number of consecutive frames of UpdatePyramid (the previous pyramid is valid from 2)
+			IplImage* preparedImage;						///< input image of UpdatePyramid which is not detected yet
+			IplImage* pyramidBuffer[2];						///< decimation pyramid of current/previous frame (cvCalcOpticalFlowPyrLK layout)
+			std::vector<IplImage> pyramidHeaders[2];		///< level image headers pointing into pyramid buffer
+
+			/**
+			 * @fn	SelectResizeSource
+			 * @brief
+			 *		select the smallest pyramid level which is not smaller than each scale image
+			 */
+			void SelectResizeSource();
 
 		public:
 			virtual char* GetFunctionName(){return "WSURFMultidetector";};
-			WSURFMultidetector(int width, int height, double scaleFactor = 2.0, int scaleStep = 4, double threshold = 45.0) : FeatureDetector()
+			WSURFMultidetector(int width, int height, double scaleFactor = 2.0, int scaleStep = 4, double threshold = 45.0, int pyramidLevel = 3) : FeatureDetector()
 			{
 				this->width = width;
 				this->height = height;
@@ -116,24 +133,97 @@ namespace windage
 						this->xScale.push_back((double)width / (dx * x));
 						this->yScale.push_back((double)height / (dy * y));
 						this->resizeImage.push_back(cvCreateImage(cvSize(cvRound(dx * x), cvRound(dy * y)), IPL_DEPTH_8U, 1));
+						this->detectors.push_back(new windage::Algorithms::WSURFdetector(threshold));
 					}
 				}
+
+				if(pyramidLevel < 1) pyramidLevel = 1;
+				this->pyramidLevel = pyramidLevel;
+				this->pyramidIndex = 0;
+				this->pyramidCount = 0;
+				this->preparedImage = NULL;
+				for(int i=0; i<2; i++)
+				{
+					this->pyramidBuffer[i] = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+					this->pyramidHeaders[i].resize(pyramidLevel);
+				}
+				this->SelectResizeSource();
 			}
 			~WSURFMultidetector()
 			{
 				for(unsigned int i=0; i<this->resizeImage.size(); i++)
 				{
 					cvReleaseImage(&this->resizeImage[i]);
+					delete this->detectors[i];
 				}
 				this->resizeImage.clear();
+				this->detectors.clear();
+
+				for(int i=0; i<2; i++)
+				{
+					cvReleaseImage(&this->pyramidBuffer[i]);
+				}
 			}
 
+			inline int GetPyramidLevel(){return this->pyramidLevel;};
+
+			/**
+			 * @fn	SetKeypointDetector
+			 * @brief
+			 *		select the keypoint detector of every scale (WSURFdetector::KeypointDetector)
+			 */
+			inline void SetKeypointDetector(int detector, int octaves = 3, int octaveLayers = 4)
+			{
+				for(unsigned int i=0; i<this->detectors.size(); i++)
+					this->detectors[i]->SetKeypointDetector(detector, octaves, octaveLayers);
+			};
+
+			/**
+			 * @fn	UpdatePyramid
+			 * @brief
+			 *		build the decimation pyramid of the input frame
+			 * @remark
+			 *		it is built once per frame and can be attatched to OpticalFlow (AttatchPyramid)
+			 *		instead of building the pyramid again at the feature tracking,
+			 *		the next DoExtractKeypointsDescriptor of the same image reuses it
+			 * @return
+			 *		false when the image is not the configured size (width x height)
+			 */
+			bool UpdatePyramid(IplImage* grayImage);
+
+			/**
+			 * @fn	GetPyramid
+			 * @brief
+			 *		decimation pyramid of the last input image
+			 */
+			inline IplImage* GetPyramid(){return this->pyramidBuffer[this->pyramidIndex];};
+
+			/**
+			 * @fn	GetPreviousPyramid
+			 * @brief
+			 *		decimation pyramid of the previous frame of UpdatePyramid
+			 * @remark
+			 *		NULL until two consecutive frames are updated,
+			 *		the detection of an image without UpdatePyramid (e.g. reference image) breaks the sequence
+			 */
+			inline IplImage* GetPreviousPyramid(){return this->pyramidCount > 1 ? this->pyramidBuffer[1 - this->pyramidIndex] : NULL;};
+
+			/**
+			 * @fn	GetPyramidImage
+			 * @brief
+			 *		image header of the pyramid level (1 <= level <= pyramid level) of the last input image
+			 */
+			inline IplImage* GetPyramidImage(int level){return &this->pyramidHeaders[this->pyramidIndex][level-1];};
+
 			/**
 			 * @fn	DoExtractKeypointsDescriptor
 			 * @brief
 			 *		implemantation of windage SURF feature extraction & description
 			 * @remark
-			 *		the result is depend on threshold (member valuable)
+			 *		the result is depend on threshold (member valuable),
+			 *		the image of the configured size is resized from the decimation pyramid,
+			 *		the other sizes are resized from the input image without the pyramid,
+			 *		keypoints are at the input image coordinate
 			 * @warning
 			 *		input image is always gray image (1-channel)
 			 * @return
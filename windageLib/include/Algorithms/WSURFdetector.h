@@ -82,8 +82,39 @@ namespace windage
 		 */
 		class DLLEXPORT WSURFdetector : public FeatureDetector
 		{
+		public:
+			/** keypoint detector before the descriptor extraction */
+			enum KeypointDetector
+			{
+				KEYPOINT_FAST = 0,				///< FAST corner
+				KEYPOINT_HESSIAN				///< tiled fast-hessian detector
+			};
+
 		private:
 			int FAST_INDEX;
+			int keypointDetector;		///< keypoint detector
+			int hessianOctaves;			///< octave count of the fast-hessian detector
+			int hessianOctaveLayers;	///< layer count per octave of the fast-hessian detector
+
+			int targetCount;			///< desired keypoint count per frame (0 : fixed threshold)
+			double minThreshold;		///< lower bound of the adaptive FAST threshold
+			double maxThreshold;		///< upper bound of the adaptive FAST threshold
+			double hessianMinThreshold;	///< lower bound of the adaptive hessian threshold
+			double hessianMaxThreshold;	///< upper bound of the adaptive hessian threshold
+			double adaptiveGain;		///< proportional gain of the threshold controller
+
+			int gridCols;				///< bucketing grid columns (0 : no bucketing)
+			int gridRows;				///< bucketing grid rows (0 : no bucketing)
+			int maxCellCount;			///< the strongest corners kept per grid cell
+
+			int detectedCount;			///< FAST corner count before bucketing at last frame
+
+			/**
+			 * @fn	UpdateThreshold
+			 * @brief
+			 *		closed-loop update of the threshold toward the target keypoint count (bounds of the selected detector)
+			 */
+			void UpdateThreshold(int cornerCount);
 
 		public:
 			virtual char* GetFunctionName(){return "WSURFdetector";};
@@ -91,6 +122,23 @@ namespace windage
 			{
 				FAST_INDEX = 10;
 				this->threshold = threshold;
+
+				keypointDetector = KEYPOINT_FAST;
+				hessianOctaves = 3;
+				hessianOctaveLayers = 4;
+
+				targetCount = 0;
+				minThreshold = 5.0;
+				maxThreshold = 150.0;
+				hessianMinThreshold = 50.0;
+				hessianMaxThreshold = 5000.0;
+				adaptiveGain = 0.5;
+
+				gridCols = 0;
+				gridRows = 0;
+				maxCellCount = 0;
+
+				detectedCount = 0;
 			}
 			~WSURFdetector()
 			{
@@ -103,6 +151,90 @@ namespace windage
 				FAST_INDEX = n;
 			}
 
+			/**
+			 * @fn	SetKeypointDetector
+			 * @brief
+			 *		select the keypoint detector (FAST corner or fast-hessian)
+			 * @remark
+			 *		the threshold is the hessian threshold at the fast-hessian detector (same as SURFdetector)
+			 *		and the hessian response is the score of the grid bucketing
+			 */
+			inline void SetKeypointDetector(int detector, int octaves = 3, int octaveLayers = 4)
+			{
+				if(detector < KEYPOINT_FAST || detector > KEYPOINT_HESSIAN) detector = KEYPOINT_FAST;
+				if(octaves < 1) octaves = 1;
+				if(octaveLayers < 1) octaveLayers = 1;
+				this->keypointDetector = detector;
+				this->hessianOctaves = octaves;
+				this->hessianOctaveLayers = octaveLayers;
+			};
+			inline int GetKeypointDetector(){return this->keypointDetector;};
+
+			/**
+			 * @fn	SetTargetCount
+			 * @brief
+			 *		enable the adaptive threshold controller
+			 * @remark
+			 *		after each frame the threshold moves toward the value which gives targetCount corners,
+			 *		clamped to the range of the selected keypoint detector. targetCount 0 disables the controller
+			 */
+			inline void SetTargetCount(int targetCount)
+			{
+				if(targetCount < 0) targetCount = 0;
+				this->targetCount = targetCount;
+			};
+			inline int GetTargetCount(){return this->targetCount;};
+
+			/**
+			 * @fn	SetThresholdRange
+			 * @brief
+			 *		bounds of the adaptive threshold of a keypoint detector
+			 * @remark
+			 *		FAST and hessian thresholds are on different scales (default [5, 150] and [50, 5000])
+			 */
+			inline void SetThresholdRange(int detector, double minThreshold, double maxThreshold)
+			{
+				if(minThreshold < 1.0) minThreshold = 1.0;
+				if(maxThreshold < minThreshold) maxThreshold = minThreshold;
+				if(detector == KEYPOINT_FAST)
+				{
+					this->minThreshold = minThreshold;
+					this->maxThreshold = maxThreshold;
+				}
+				else
+				{
+					this->hessianMinThreshold = minThreshold;
+					this->hessianMaxThreshold = maxThreshold;
+				}
+			};
+			inline void SetAdaptiveGain(double gain){if(gain > 0.0 && gain <= 1.0) this->adaptiveGain = gain;};
+			inline double GetAdaptiveGain(){return this->adaptiveGain;};
+
+			/**
+			 * @fn	SetGridBucketing
+			 * @brief
+			 *		keep only the strongest maxCellCount corners in each cell of a cols x rows grid
+			 * @remark
+			 *		corners stay spread over the image and the keypoint count is bounded by cols*rows*maxCellCount.
+			 *		cols or rows 0 disables the bucketing
+			 */
+			inline void SetGridBucketing(int cols, int rows, int maxCellCount)
+			{
+				if(cols < 0) cols = 0;
+				if(rows < 0) rows = 0;
+				if(maxCellCount < 1) maxCellCount = 1;
+				this->gridCols = cols;
+				this->gridRows = rows;
+				this->maxCellCount = maxCellCount;
+			};
+
+			/**
+			 * @fn	GetDetectedCount
+			 * @brief
+			 *		detected keypoint count of the last frame before grid bucketing (the controller input)
+			 */
+			inline int GetDetectedCount(){return this->detectedCount;};
+
 			/**
 			 * @fn	DoExtractKeypointsDescriptor
 			 * @brief
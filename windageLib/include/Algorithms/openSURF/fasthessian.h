@@ -72,7 +72,7 @@ class FastHessian {
     int isExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b);    
     
     //! Interpolation functions - adapted from Lowe's SIFT implementation
-    void interpolateExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b);
+    void interpolateExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b, std::vector<Ipoint> &found);
     void interpolateStep(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b,
                           double* xi, double* xr, double* xc );
     CvMat* deriv3D(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b);
@@ -88,6 +88,7 @@ class FastHessian {
     std::vector<Ipoint> &ipts;
 
     //! Response stack of determinant of hessian values
+    //! (pooled between frames, reallocated only when the image size or parameters change)
     std::vector<ResponseLayer *> responseMap;
 
     //! Number of Octaves
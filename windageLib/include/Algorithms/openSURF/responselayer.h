@@ -43,6 +43,12 @@ public:
     if (laplacian) delete [] laplacian;
   }
 
+  //! True if the layer storage can be reused for the given geometry
+  inline bool isSameLayout(int width, int height, int step, int filter)
+  {
+    return this->width == width && this->height == height && this->step == step && this->filter == filter;
+  }
+
   inline unsigned char getLaplacian(unsigned int row, unsigned int column)
   {
     return laplacian[row * width + column];
@@ -62,6 +62,7 @@ static void wResizeHaarPattern( const int src[][5], CvSurfHF* dst, int n, int ol
 int wInterpolateKeypoint( float N9[3][9], int dx, int dy, int ds, CvSURFPoint *point );
 
 static CvSeq* wFastHessianDetector( const CvMat* sum, const CvMat* mask_sum, CvMemStorage* storage, const CvSURFParams* params );
+CvSeq* wFastHessianKeypoints( const CvArr* _img, const CvArr* _mask, CvMemStorage* storage, CvSURFParams params );
 void getGaussianKernel( CvMat* kernel, int n, double sigma, int ktype );
 void wExtractSURF( const CvArr* _img, const CvArr* _mask,
 							CvSeq** _keypoints, CvSeq** _descriptors,
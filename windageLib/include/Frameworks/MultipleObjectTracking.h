@@ -123,6 +123,12 @@ namespace windage
 			
 			bool initialize;										///< checked initialized
 			bool trained;											///< checked trained
+			bool useGPUdetector;									///< detection thread uses SIFTGPUdetector (true) or SIFTCPUdetector (false)
+			bool synchronousDetection;								///< detection runs at the detection step of UpdateCamerapose instead of the detection thread (replay)
+			windage::Algorithms::FeatureDetector* synchronousDetector;	///< detector of the synchronous detection
+			windage::Algorithms::OpticalFlow* synchronousTracker;		///< tracker of the synchronous detection
+			bool seeded;											///< estimators of the objects are seeded by the seed
+			int64 seed;
 
 		public:
 			std::vector<std::vector<windage::FeaturePoint>> refMatchedKeypoints;	///< matched point at reference image
@@ -148,6 +154,12 @@ namespace windage
 
 				initialize = false;
 				trained = false;
+				useGPUdetector = true;
+				synchronousDetection = false;
+				synchronousDetector = NULL;
+				synchronousTracker = NULL;
+				seeded = false;
+				seed = 0;
 
 				update = false;
 				processThread = true;
@@ -164,6 +176,11 @@ namespace windage
 				if(prevImage) cvReleaseImage(&prevImage);
 				prevImage = NULL;
 
+				if(synchronousDetector) delete synchronousDetector;
+				synchronousDetector = NULL;
+				if(synchronousTracker) delete synchronousTracker;
+				synchronousTracker = NULL;
+
 				for(unsigned int i=0; i<this->estimatorList.size(); i++)
 					if(estimatorList[i]) delete estimatorList[i];
 				this->estimatorList.clear();
@@ -176,6 +193,30 @@ namespace windage
 			inline void SetSize(int width, int height){this->width = width; this->height = height;};
 			inline CvSize GetSize(){return cvSize(this->width, this->height);};
 			inline void SetDitectionRatio(int ratio){if(ratio<1) ratio=1; this->detectionRatio=ratio; this->step=ratio+1;};
+			inline void SetGPUDetection(bool use){this->useGPUdetector = use;};
+			inline bool IsGPUDetection(){return this->useGPUdetector;};
+
+			/**
+			 * @fn	SetSynchronousDetection
+			 * @brief
+			 *		run the detection in the calling thread at the detection step of UpdateCamerapose
+			 * @remark
+			 *		the detection thread hands over the matched points at racy times,
+			 *		the synchronous detection gives the same result at every run of the same frames (offline replay)
+			 * @warning
+			 *		It will be called before initialization
+			 */
+			inline void SetSynchronousDetection(bool use){this->synchronousDetection = use;};
+			inline bool IsSynchronousDetection(){return this->synchronousDetection;};
+
+			/**
+			 * @fn	SetSeed
+			 * @brief
+			 *		seed the pose estimators of the objects (seed + objectID)
+			 * @warning
+			 *		It will be called before training the references
+			 */
+			inline void SetSeed(int64 seed){this->seed = seed; this->seeded = true;};
 			inline int GetObjectCount(){return this->objectCount;};
 			inline int GetMatchingCount(int i){return (int)this->refMatchedKeypoints[i].size();};
 
@@ -67,6 +67,7 @@
 #include "Algorithms/HomographyEstimator.h"
 #include "Algorithms/OutlierChecker.h"
 #include "Algorithms/HomographyRefiner.h"
+#include "Algorithms/MultiTemplateESM.h"
 #include "Algorithms/KalmanFilter.h"
 
 /** pre-selected search tree algorithm whenever can change other search tree algorithm  */
@@ -93,6 +94,7 @@ namespace windage
 		{
 		protected:
 			static const int MIN_FEATURE_POINTS_COUNT = 10;			///< threshold to determin whether tracked or not
+			static const int ALIGNER_TEMPLATE_SIZE = 160;			///< the longer side of the reference image for dense alignment
 
 			windage::Calibration* initialCamearParameter;			///< It is required elements that camera calibration parameter to attatch reference pointer at out-side
 			windage::Algorithms::FeatureDetector* detector;			///< It is required elements that feature detection algorithm to attatch reference pointer at out-side
@@ -101,6 +103,8 @@ namespace windage
 
 			windage::Algorithms::OutlierChecker* checker;			///< It is optional elements that outlier checker algorithm to attatch reference pointer at out-side
 			windage::Algorithms::HomographyRefiner* refiner;		///< It is optional elements that homography refinement algorithm to attatch reference pointer at out-side
+			windage::Algorithms::MultiTemplateESM* aligner;			///< It is optional elements that dense template alignment algorithm to attatch reference pointer at out-side
+			std::vector<windage::Matrix3> templateToObject;			///< aligner template pixel to reference object coordinate
 
 			std::vector<windage::Calibration*> cameraParameter;		///< the number of camera pose is dynamic that is the result camera pose of recodnized and tracked object
 			std::vector<SearchTreeT*> searchTree;					///< the number of matching algorithm is dynamic that is training of the reference image
@@ -141,6 +145,7 @@ namespace windage
 				estimator = NULL;
 				checker = NULL;
 				refiner = NULL;
+				aligner = NULL;
 
 				useFilter = false;
 				filterStep = 10;
@@ -252,6 +257,20 @@ namespace windage
 			 */
 			inline void AttatchRefiner(windage::Algorithms::HomographyRefiner* refiner){this->refiner = refiner;};
 
+			/**
+			 * @fn	AttatchAligner
+			 * @brief
+			 *		attatch dense template alignment algorithm to member pointer from out-side
+			 * @remark
+			 *		the homographies of all tracked objects are refined together after the homography refinement,
+			 *		the reference images are attatched to the aligner as templates at TrainingReference
+			 * @warning
+			 *		It is optional elements
+			 *		It will be attatched before calling TrainingReference
+			 *		dense template alignment algorithm is not create in-side at this class so do not release this pointer
+			 */
+			inline void AttatchAligner(windage::Algorithms::MultiTemplateESM* aligner){this->aligner = aligner;};
+
 			inline windage::Calibration* GetCameraParameter(int objectID){return this->cameraParameter[objectID];};
 			inline windage::Algorithms::FeatureDetector* GetDetector(){return this->detector;};
 			inline windage::Algorithms::SearchTree* GetMatcher(int objectID){return this->searchTree[objectID];};
@@ -259,6 +278,7 @@ namespace windage
 			inline windage::Algorithms::HomographyEstimator* GetEstimator(){return this->estimator;};
 			inline windage::Algorithms::OutlierChecker* GetChecker(){return this->checker;};
 			inline windage::Algorithms::HomographyRefiner* GetRefiner(){return this->refiner;};
+			inline windage::Algorithms::MultiTemplateESM* GetAligner(){return this->aligner;};
 
 			/**
 			 * @fn	Initialize
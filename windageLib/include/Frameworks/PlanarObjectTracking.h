@@ -66,6 +66,7 @@
 #include "Algorithms/HomographyEstimator.h"
 #include "Algorithms/OutlierChecker.h"
 #include "Algorithms/HomographyRefiner.h"
+#include "Algorithms/MultiTemplateESM.h"
 #include "Algorithms/KalmanFilter.h"
 
 #include "Utilities/Logger.h"
@@ -90,6 +91,7 @@ namespace windage
 		{
 		protected:
 			static const int MIN_FEATURE_POINTS_COUNT = 9;			///< threshold to determin whether tracked or not
+			static const int ALIGNER_TEMPLATE_SIZE = 160;			///< the longer side of the reference image for dense alignment
 
 			windage::Calibration* cameraParameter;					///< It is required elements that camera calibration parameter to attatch reference pointer at out-side
 			windage::Algorithms::FeatureDetector* detector;			///< It is required elements that feature detection algorithm to attatch reference pointer at out-side
@@ -99,7 +101,9 @@ namespace windage
 			windage::Algorithms::OpticalFlow* tracker;				///< It is optional elements that feature tracking algorithm to attatch reference pointer at out-side
 			windage::Algorithms::OutlierChecker* checker;			///< It is optional elements that outlier checker algorithm to attatch reference pointer at out-side
 			windage::Algorithms::HomographyRefiner* refiner;		///< It is optional elements that homography refinement algorithm to attatch reference pointer at out-side
+			windage::Algorithms::MultiTemplateESM* aligner;			///< It is optional elements that dense template alignment algorithm to attatch reference pointer at out-side
 			windage::Algorithms::KalmanFilter* filter;				///< It is optional elements that kalman filter algorithm to attatch reference pointer at out-side
+			windage::Matrix3 templateToObject;						///< aligner template pixel to reference object coordinate
 			int filterStep;
 
 			IplImage* prevImage;									///< gray image for feature tracking
@@ -138,6 +142,7 @@ namespace windage
 				tracker = NULL;
 				checker = NULL;
 				refiner = NULL;
+				aligner = NULL;
 				filter = NULL;
 
 				filterStep = 10;
@@ -258,6 +263,20 @@ namespace windage
 			 */
 			inline void AttatchRefiner(windage::Algorithms::HomographyRefiner* refiner){this->refiner = refiner;};
 
+			/**
+			 * @fn	AttatchAligner
+			 * @brief
+			 *		attatch dense template alignment algorithm to member pointer from out-side
+			 * @remark
+			 *		the homography is refined by the reference image after the homography refinement,
+			 *		the reference image is attatched to the aligner as template at TrainingReference
+			 * @warning
+			 *		It is optional elements
+			 *		It will be attatched before calling TrainingReference
+			 *		dense template alignment algorithm is not create in-side at this class so do not release this pointer
+			 */
+			inline void AttatchAligner(windage::Algorithms::MultiTemplateESM* aligner){this->aligner = aligner;};
+
 			/**
 			 * @fn	AttatchRefiner
 			 * @brief
@@ -277,6 +296,7 @@ namespace windage
 			inline windage::Algorithms::HomographyEstimator* GetEstimator(){return this->estimator;};
 			inline windage::Algorithms::OutlierChecker* GetChecker(){return this->checker;};
 			inline windage::Algorithms::HomographyRefiner* GetRefiner(){return this->refiner;};
+			inline windage::Algorithms::MultiTemplateESM* GetAligner(){return this->aligner;};
 
 			/**
 			 * @fn	Initialize
@@ -108,6 +108,10 @@ namespace windage
 
 			bool initialize;										///< checked initialized
 			bool trained;											///< checked trained
+			bool useGPUdetector;									///< detection thread uses SIFTGPUdetector (true) or SIFTCPUdetector (false)
+			bool synchronousDetection;								///< detection runs at the detection step of UpdateCamerapose instead of the detection thread (replay)
+			windage::Algorithms::FeatureDetector* synchronousDetector;	///< detector of the synchronous detection
+			windage::Algorithms::OpticalFlow* synchronousTracker;		///< tracker of the synchronous detection
 
 		public:
 			std::vector<windage::FeaturePoint> referenceRepository;	///< reference keypoint repository
@@ -134,6 +138,10 @@ namespace windage
 
 				initialize = false;
 				trained = false;
+				useGPUdetector = true;
+				synchronousDetection = false;
+				synchronousDetector = NULL;
+				synchronousTracker = NULL;
 
 				update = false;
 				processThread = true;
@@ -146,12 +154,32 @@ namespace windage
 				if(prevImage) cvReleaseImage(&prevImage);
 				prevImage = NULL;
 
+				if(synchronousDetector) delete synchronousDetector;
+				synchronousDetector = NULL;
+				if(synchronousTracker) delete synchronousTracker;
+				synchronousTracker = NULL;
+
 				this->referenceRepository.clear();
 			}
 
 			inline void SetSize(int width, int height){this->width = width; this->height = height;};
 			inline CvSize GetSize(){return cvSize(this->width, this->height);};
 			inline void SetDitectionRatio(int ratio){this->detectionRatio=ratio; this->step=ratio+1;};
+			inline void SetGPUDetection(bool use){this->useGPUdetector = use;};
+			inline bool IsGPUDetection(){return this->useGPUdetector;};
+
+			/**
+			 * @fn	SetSynchronousDetection
+			 * @brief
+			 *		run the detection in the calling thread at the detection step of UpdateCamerapose
+			 * @remark
+			 *		the detection thread hands over the matched points at racy times,
+			 *		the synchronous detection gives the same result at every run of the same frames (offline replay)
+			 * @warning
+			 *		It will be called before initialization
+			 */
+			inline void SetSynchronousDetection(bool use){this->synchronousDetection = use;};
+			inline bool IsSynchronousDetection(){return this->synchronousDetection;};
 			inline void SetFilterSetp(int step){this->filterStep = step;};
 			inline int GetMatchingCount(){return (int)this->refMatchedKeypoints.size();};
 
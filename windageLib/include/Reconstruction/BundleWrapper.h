@@ -49,6 +49,8 @@
 #ifndef _BUNDLE_WRAPPER_H_
 #define _BUNDLE_WRAPPER_H_
 
+#include <vector>
+
 #include "base.h"
 
 #include <cv.h>
@@ -68,6 +70,53 @@ namespace windage
 
 		const double SBA_MAX_REPROJ_ERROR = 4.0; // max motion only reprojection error
 
+		/**
+		 * @brief	compressed per-point observation list for bundle adjustment (CSR : point -> (camera, x, y))
+		 * @remark
+		 *		the observations of a point are kept in ascending camera order that is the measurement order of sba,
+		 *		so the image points are passed to sba without copy
+		 * @author	Woonhyuk Baek
+		 */
+		class DLLEXPORT BundleObservations
+		{
+		public:
+			std::vector<int> pointOffset;		///< observations of point i are [pointOffset[i], pointOffset[i+1])
+			std::vector<int> cameraIndex;		///< camera index of each observation
+			std::vector<double> imagePoints;	///< image point (x, y) of each observation
+
+		public:
+			BundleObservations()
+			{
+				this->Clear();
+			}
+			~BundleObservations()
+			{
+			}
+
+			inline void Clear(){pointOffset.assign(1, 0); cameraIndex.clear(); imagePoints.clear();};
+			inline void Reserve(int pointCount, int observationCount){pointOffset.reserve(pointCount+1); cameraIndex.reserve(observationCount); imagePoints.reserve(observationCount*2);};
+			inline int GetPointCount(){return (int)pointOffset.size() - 1;};
+			inline int GetObservationCount(){return (int)cameraIndex.size();};
+
+			/**
+			 * @fn	AddObservation
+			 * @brief
+			 *		append the observation to the current point
+			 * @warning
+			 *		the current point is closed by EndPoint
+			 */
+			inline void AddObservation(int camera, double x, double y){cameraIndex.push_back(camera); imagePoints.push_back(x); imagePoints.push_back(y);};
+
+			/**
+			 * @fn	EndPoint
+			 * @brief
+			 *		close the observations of the current point
+			 * @remark
+			 *		the observations are sorted by camera index and the last one is kept when a camera is duplicated
+			 */
+			void EndPoint();
+		};
+
 		/**
 		 * @brief	bundle adjustment class using SBA Algorithm
 		 * @author	Woonhyuk Baek
@@ -79,8 +128,9 @@ namespace windage
 			int m_nImage; /** # of images */
 
 			CvMat  *m_pt3D;
-			CvMat **m_pt2D;
 			CvMat **m_RT;
+			BundleObservations* m_observations;		///< observation list attatched at out-side
+			BundleObservations m_denseObservations;	///< observation list converted from the dense image points
 
 			double m_intrinsicsba[5];
 			double m_opts[SBA_OPTSSZ], m_info[SBA_INFOSZ], phi;
@@ -88,6 +138,7 @@ namespace windage
 			int m_pnp;
 			int m_mnp; 
 			int m_itmax;
+			bool m_parallel;	///< evaluate the projections and jacobians with the per-camera blocks in parallel
 
 		public:
 			BundleWrapper(void);
@@ -96,10 +147,23 @@ namespace windage
 			/**
 			 * Set required parameters 
 			*/
+			void SetParameters(CvMat *intrinsic, CvMat *pt3D, BundleObservations* observations, CvMat **RT, int nImage, int nPTs);
+
+			/**
+			 * Set required parameters with the dense image points (3 x nPTs per image, negative coordinate is not visible)
+			 * @remark the dense image points are converted to the compressed observation list
+			*/
 			void SetParameters(CvMat *intrinsic, CvMat *pt3D, CvMat **pt2D, CvMat **RT, int nImage, int nPTs);
 			
 			bool Run();
 
+			/**
+			 * Set parallel evaluation mode of the projection and jacobian callbacks (default is true)
+			 * @remark the observations (rows of sba_crsm) are partitioned across the threads and each thread writes its own measurements only
+			*/
+			inline void SetParallelEvaluation(bool parallel){this->m_parallel = parallel;};
+			inline bool IsParallelEvaluation(){return this->m_parallel;};
+
 			void Matrix2Quaternion(CvMat *mat, double *q);
 			void Quaternion2Matrix(double *q, CvMat *mat);
 			void quat2vec(double *inp, int nin, double *outp, int nout);
@@ -114,6 +178,12 @@ namespace windage
 			static void calcImgProjJacS(double a[5],double v[3],double t[3],double M[3], double jacmS[2][3]);
 			static void calcImgProjJacRTS(double a[5],double v[3],double t[3],double M[3], double jacmRT[2][6],double jacmS[2][3]);
 			static void calcImgProjJacRT(double a[5],double v[3],double t[3],double M[3], double jacmRT[2][6]);
+
+			/** camera block size of the batched kernels : R (9), dR/dv (27), t (3) */
+			static const int CAMERA_BLOCK_SIZE = 39;
+			static void calcCameraBlock(double v[3], double t[3], double block[CAMERA_BLOCK_SIZE]);
+			static void calcImgProjBatch(double a[5], double *blocks, double M[3], int *cameras, int *measurements, int count, double *hx);
+			static void calcImgProjJacRTSBatch(double a[5], double *blocks, double M[3], int *cameras, int *measurements, int count, double *jac);
 		};
 		/** @} */ // addtogroup Reconstruction
 	}
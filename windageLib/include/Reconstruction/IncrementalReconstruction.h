@@ -69,6 +69,19 @@ namespace windage
 {
 	namespace Reconstruction
 	{
+		class BundleObservations;
+		class SparseBundleAdjuster;
+		struct BundleTask;
+
+		/**
+		 * @brief	reconstruction point observed by an image feature
+		 */
+		struct TrackReference
+		{
+			int pointID;		///< reconstruction point index
+			int featureID;		///< feature index at the image feature list
+		};
+
 		/**
 		 * @defgroup Reconstruction Reconstruction classes
 		 * @brief
@@ -96,9 +109,23 @@ namespace windage
 
 			windage::Algorithms::SearchTree* searchtree;
 			windage::Algorithms::PoseEstimator* estimator;
+			windage::Reconstruction::SparseBundleAdjuster* bundleAdjuster;	///< native bundle adjuster (sba is used when it is NULL)
+			bool asynchronousBundle;			///< CalculateStep runs the windowed bundle adjustment at the background
+			BundleTask* bundleTask;				///< running background window
 
 			std::vector<windage::ReconstructionPoint> reconstructionPoints;
 			std::vector<std::vector<windage::FeaturePoint>> featurePointsList;
+			std::vector<std::vector<TrackReference>> imageTracks;	///< inverted index : image -> tracked (point, feature)
+			bool compactObservation;	///< reconstruction points keep only the feature references (no feature copy)
+
+			std::vector<int> matchingMatrix;	///< match count of the image pairs (attatchedCount x attatchedCount, 0 : pruned pair)
+			std::vector<int> imageOrder;		///< attatched order of the arranged images
+			int vocabularySize;					///< word count of the bag of words prefilter
+			int candidateCount;					///< matched image count per image after prefilter (0 : all pairs)
+			std::vector<windage::FeaturePoint> vocabulary;				///< words of the bag of words prefilter (sampled at the first CalculateMatchingMatrix)
+			std::vector<std::vector<double>> wordHistograms;			///< word count of each image
+			std::vector<windage::Algorithms::SearchTree*> imageMatchers;	///< features of each image trained once for CalculateMatchingMatrix (NULL : not trained)
+			bool verbose;						///< print the seed pair and the best matching image
 
 			
 
@@ -106,8 +133,16 @@ namespace windage
 			bool Matching(std::vector<windage::FeaturePoint>* feature1, std::vector<windage::FeaturePoint>* feature2,
 						  std::vector<windage::FeaturePoint>* matchedPoint1, std::vector<windage::FeaturePoint>* matchedPoint2);
 			int MatchingCount(std::vector<windage::FeaturePoint>* feature1, std::vector<windage::FeaturePoint>* feature2);
+			bool Matching(int image, std::vector<windage::FeaturePoint>* feature2,
+						  std::vector<windage::FeaturePoint>* matchedPoint1, std::vector<windage::FeaturePoint>* matchedPoint2);
+			void AddTrack(int image, int featureID, int pointID);
+			void AddObservation(windage::ReconstructionPoint* point, int image, windage::FeaturePoint& feature);
 			bool StereoReconstruction(int index1 = 0, int index2 = 1);
 			bool IncrementReconstruction();
+
+			BundleTask* CreateBundleTask(int startIndex, int n);
+			void MergeBundleTask(BundleTask* task);
+			void ReleaseBundleTask(BundleTask* task);
 		public:
 			IncrementalReconstruction()
 			{
@@ -119,22 +154,42 @@ namespace windage
 				caculatedCount = 0;
 				initialCameraParameter = NULL;
 				searchtree = NULL;
+				compactObservation = false;
+				vocabularySize = 256;
+				candidateCount = 10;
+				verbose = false;
 				estimator = NULL;
+				bundleAdjuster = NULL;
+				asynchronousBundle = false;
+				bundleTask = NULL;
 			}
 			~IncrementalReconstruction()
 			{
+				this->MergeBundleAdjustment(true);
 				for(unsigned int i=0; i<cameraParameters.size(); i++)
 					delete cameraParameters[i];
 				cameraParameters.clear();
+				for(unsigned int i=0; i<imageMatchers.size(); i++)
+					delete imageMatchers[i];
+				imageMatchers.clear();
 			}
 
 			inline void SetReprojectionError(double error){this->reprojectionError = error;};
 			inline void SetMaxIteration(int iteration){this->maxIteration = iteration;};
 			inline void SetConfidence(double confidence){this->confidence = confidence;};
+			inline void SetCompactObservation(bool compact){this->compactObservation = compact;};
+			inline bool IsCompactObservation(){return this->compactObservation;};
+			inline void SetVocabularySize(int size){this->vocabularySize = size;};
+			inline void SetMatchingCandidateCount(int count){this->candidateCount = count;};
+			inline void SetVerbose(bool verbose){this->verbose = verbose;};
+			inline bool IsVerbose(){return this->verbose;};
+			inline void SetAsynchronousBundleAdjustment(bool asynchronous){this->asynchronousBundle = asynchronous;};
+			inline bool IsAsynchronousBundleAdjustment(){return this->asynchronousBundle;};
 
 			inline void AttatchCalibration(windage::Calibration* calibration){this->initialCameraParameter = calibration;};
 			inline void AttatchSearchTree(windage::Algorithms::SearchTree* matcher){this->searchtree = matcher;};
 			inline void AttatchEstimator(windage::Algorithms::PoseEstimator* estimator){this->estimator = estimator;};
+			inline void AttatchBundleAdjuster(windage::Reconstruction::SparseBundleAdjuster* bundleAdjuster){this->bundleAdjuster = bundleAdjuster;};
 
 			inline int GetCameraParameterCount(){return (int)this->cameraParameters.size();};
 			inline windage::Calibration* GetCameraParameter(int i){return cameraParameters[i];};
@@ -142,15 +197,87 @@ namespace windage
 			inline std::vector<windage::ReconstructionPoint>* GetReconstructedPoint(){return &reconstructionPoints;};
 
 			double CheckReprojectionError(CvMat **RT, CvMat *pt3D, CvMat **pt2D, int n);
+			double CheckReprojectionError(CvMat **RT, CvMat *pt3D, BundleObservations* observations, int n);
 			static const int BUNDLE_STEP = 5;
 			bool BundleAdjustment();
 			bool BundleAdjustment(int startIndex, int n);
+
+			/**
+			 * @fn	BundleAdjustmentAsync
+			 * @brief
+			 *		start the windowed bundle adjustment on a worker thread with a snapshot of the window cameras and points
+			 * @remark
+			 *		the result is merged back by MergeBundleAdjustment (CalculateStep merges at its start),
+			 *		images registered meanwhile use the un-refined poses and are refined by the next window
+			 * @return
+			 *		false when the previous window is still running or the window has no point
+			 */
+			bool BundleAdjustmentAsync(int startIndex, int n);
+			bool IsBundleAdjustmentRunning();
+
+			/**
+			 * @fn	MergeBundleAdjustment
+			 * @brief
+			 *		merge the background window into the reconstruction
+			 * @return
+			 *		true when a finished window was merged
+			 */
+			bool MergeBundleAdjustment(bool wait = true);
 			
 			void AttatchFeaturePoint(std::vector<windage::FeaturePoint>* featurePoints);
+
+			/**
+			 * @fn	CalculateMatchingMatrix
+			 * @brief
+			 *		count the matches between all attatched image pairs in parallel
+			 * @remark
+			 *		a bag of words similarity keeps the candidateCount most similar images of each image,
+			 *		the other pairs are not matched and counted as 0
+			 * @remark
+			 *		the word counts and the trained features of each image are kept between the calls,
+			 *		so a call after attatching new images only fills the rows and columns of the new images
+			 */
+			bool CalculateMatchingMatrix();
+
+			/**
+			 * @fn	ArrangeImageOrder
+			 * @brief
+			 *		rearrange the attatched images to the registration order (best seed pair first)
+			 * @warning
+			 *		called after CalculateMatchingMatrix and before the reconstruction,
+			 *		camera i corresponds to the attatched image GetImageOrder(i) afterward
+			 */
+			bool ArrangeImageOrder();
+			inline int GetMatchingCount(int i, int j){return this->matchingMatrix[i * this->attatchedCount + j];};
+			inline int GetImageOrder(int i){return this->imageOrder.size() > 0 ? this->imageOrder[i] : i;};
 			bool CalculateStep(int step = -1);
+
+			/**
+			 * @fn	CalculateAll
+			 * @brief
+			 *		reconstruct all attatched images
+			 * @remark
+			 *		the images are arranged by the matching matrix before the seed pair is reconstructed
+			 */
 			bool CalculateAll();
 
 			bool UpdateColor();
+
+			/**
+			 * @fn	UpdateFeatureList
+			 * @brief
+			 *		fill the feature copies of the reconstruction points from the feature references
+			 * @remark
+			 *		used before exporting the compact observations
+			 */
+			bool UpdateFeatureList();
+
+			/**
+			 * @fn	UpdateMeanDescriptor
+			 * @brief
+			 *		calculate the mean descriptor of the observed features at each reconstruction point
+			 */
+			bool UpdateMeanDescriptor();
 			bool ResizeScale(double scale = 1.0);
 		};
 		/** @} */ // addtogroup Reconstruction
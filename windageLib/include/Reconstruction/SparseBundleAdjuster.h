@@ -0,0 +1,217 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	SparseBundleAdjuster.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.04
+ * @brief	native sparse bundle adjustment using Schur complement with robust loss
+ */
+
+#ifndef _SPARSE_BUNDLE_ADJUSTER_H_
+#define _SPARSE_BUNDLE_ADJUSTER_H_
+
+#include <vector>
+
+#include <cv.h>
+#include "base.h"
+
+#include "Reconstruction/BundleWrapper.h"
+
+namespace windage
+{
+	namespace Reconstruction
+	{
+		/**
+		 * @defgroup Reconstruction Reconstruction classes
+		 * @brief
+		 *		Reconstruction classes
+		 * @addtogroup Reconstruction
+		 * @{
+		 */
+
+		/**
+		 * @brief	native sparse bundle adjustment class
+		 * @remark
+		 *		Levenberg-Marquardt with iteratively reweighted robust loss.
+		 *		points are eliminated by Schur complement and the reduced camera system is solved by
+		 *		Cholesky decomposition inside the envelope of the camera graph (cameras sharing points)
+		 *		or by PCG with block-Jacobi preconditioner (implicit reduced system) for large problems.
+		 *		per-point and per-camera block works are computed in parallel.
+		 *		the first fixed cameras are kept constant for the gauge freedom (same as sba)
+		 * @author	Woonhyuk Baek
+		 */
+		class DLLEXPORT SparseBundleAdjuster
+		{
+		public:
+			/** robust loss function of the reprojection error */
+			enum LossFunction
+			{
+				LOSS_SQUARED = 0,
+				LOSS_HUBER,
+				LOSS_CAUCHY
+			};
+			/** linear solver of the reduced camera system */
+			enum LinearSolver
+			{
+				SOLVER_AUTO = 0,	///< cholesky until choleskyCameraLimit, pcg above
+				SOLVER_CHOLESKY,
+				SOLVER_PCG
+			};
+
+		private:
+			static const int BEHIND_CAMERA_ERROR = 1000;	///< reprojection error (pixel) of the observation whose point is behind the camera
+
+			int lossFunction;				///< robust loss function
+			double lossScale;				///< inlier reprojection error scale of the robust loss (pixel)
+			int linearSolver;				///< reduced camera system solver
+			int choleskyCameraLimit;		///< maximum variable cameras for the cholesky solver at SOLVER_AUTO
+			int fixedCameraCount;			///< constant cameras (gauge freedom)
+			int maxIteration;				///< maximum LM iteration
+			int maxPCGIteration;			///< maximum PCG iteration per LM step
+			double pcgTolerance;			///< relative residual tolerance of PCG
+			double functionTolerance;		///< relative cost decrease to stop
+			double costTolerance;			///< absolute cost to stop (exact fit)
+			bool verbose;
+
+			double intrinsic[5];			///< fx, fy, skew, cx, cy
+			CvMat* pt3D;					///< 4 x nPTs homogeneous points attatched at out-side
+			CvMat** RT;						///< 3 x 4 extrinsic per image attatched at out-side
+			BundleObservations* observations;	///< observation list attatched at out-side
+			int cameraCount;
+			int pointCount;
+
+			int iteration;
+			double initialCost;
+			double finalCost;
+			double initialError;
+			double finalError;
+
+			// camera -> observation index (CSC of the observation list)
+			std::vector<int> cameraOffset;
+			std::vector<int> cameraObservation;
+			std::vector<int> observationPoint;
+
+			// linearized system
+			std::vector<double> jacobianCamera;		///< 2 x 6 per observation
+			std::vector<double> jacobianPoint;		///< 2 x 3 per observation
+			std::vector<double> residual;			///< 2 per observation
+			std::vector<double> weight;				///< robust weight per observation
+			std::vector<double> blockW;				///< W = Jc^T w Jp (6 x 3) per observation
+			std::vector<double> blockY;				///< Y = W V^-1 (6 x 3) per observation
+			std::vector<double> blockU;				///< U = sum Jc^T w Jc (6 x 6) per camera
+			std::vector<double> blockV;				///< V = sum Jp^T w Jp (3 x 3) per point
+			std::vector<double> blockVinv;			///< damped V^-1 per point
+			std::vector<double> gradientCamera;		///< -sum Jc^T w r per camera
+			std::vector<double> gradientPoint;		///< -sum Jp^T w r per point
+
+			double RobustWeight(double squaredError);
+			double RobustCost(double squaredError);
+			double EvaluateCost(std::vector<double>& cameras, std::vector<double>& points, double* meanError, int* behindCount);
+			void Linearize(std::vector<double>& cameras, std::vector<double>& points);
+			bool SolveStep(double lambda, int variableOffset, std::vector<double>& deltaCamera, std::vector<double>& deltaPoint);
+			bool SolveCholesky(std::vector<double>& dampedU, std::vector<double>& b, int variableOffset, std::vector<double>& x);
+			bool SolvePCG(std::vector<double>& dampedU, std::vector<double>& b, int variableOffset, std::vector<double>& x);
+
+		public:
+			SparseBundleAdjuster()
+			{
+				lossFunction = LOSS_HUBER;
+				lossScale = 2.0;
+				linearSolver = SOLVER_AUTO;
+				choleskyCameraLimit = 200;
+				fixedCameraCount = 1;
+				maxIteration = 100;
+				maxPCGIteration = 100;
+				pcgTolerance = 1.0e-6;
+				functionTolerance = 1.0e-8;
+				costTolerance = 1.0e-12;
+				verbose = false;
+
+				pt3D = NULL;
+				RT = NULL;
+				observations = NULL;
+				cameraCount = 0;
+				pointCount = 0;
+
+				iteration = 0;
+				initialCost = finalCost = 0.0;
+				initialError = finalError = 0.0;
+			}
+			~SparseBundleAdjuster()
+			{
+			}
+
+			inline void SetLossFunction(int loss, double scale = 2.0){this->lossFunction = loss; if(scale > 0) this->lossScale = scale;};
+			inline void SetLinearSolver(int solver, int choleskyCameraLimit = 200){this->linearSolver = solver; this->choleskyCameraLimit = choleskyCameraLimit;};
+			inline void SetFixedCameraCount(int count){if(count >= 0) this->fixedCameraCount = count;};
+			inline void SetMaxIteration(int iteration){this->maxIteration = iteration;};
+			inline void SetPCGParameters(int maxIteration, double tolerance){this->maxPCGIteration = maxIteration; this->pcgTolerance = tolerance;};
+			inline void SetVerbose(bool verbose){this->verbose = verbose;};
+
+			inline int GetIteration(){return this->iteration;};
+			inline double GetInitialCost(){return this->initialCost;};
+			inline double GetFinalCost(){return this->finalCost;};
+			inline double GetInitialError(){return this->initialError;};
+			inline double GetFinalError(){return this->finalError;};
+
+			/**
+			 * @fn	SetParameters
+			 * @brief
+			 *		set required parameters (same as BundleWrapper)
+			 * @warning
+			 *		the points, extrinsics and observations are not copied, the result is written to pt3D and RT
+			 */
+			void SetParameters(CvMat *intrinsic, CvMat *pt3D, BundleObservations* observations, CvMat **RT, int nImage, int nPTs);
+
+			/**
+			 * @fn	Run
+			 * @brief
+			 *		refine the extrinsics and points
+			 * @return
+			 *		success or failure
+			 */
+			bool Run();
+		};
+		/** @} */ // addtogroup Reconstruction
+	}
+}
+#endif // _SPARSE_BUNDLE_ADJUSTER_H_
@@ -95,6 +95,10 @@ namespace windage
 
 			CvMat *essentialMatrix;									/// temporary essential matrix
 			int inlierCount;
+			bool fivePoints;										///< RANSAC uses the 5-point minimal solver instead of the 8-point
+			CvRNG rng;												///< random number generator of the RANSAC sampling (seeded from the clock unless SetSeed)
+
+			bool ComputeEssentialMatrixRANSAC5Points(double* error);
 
 		public:
 			StereoReconstruction(void)
@@ -104,6 +108,8 @@ namespace windage
 				this->maxIteration = 2000;
 				essentialMatrix = cvCreateMat(3, 3, CV_64F);
 				inlierCount = 0;
+				fivePoints = false;
+				rng = cvRNG(cvGetTickCount());
 			}
 			~StereoReconstruction(void)
 			{
@@ -117,6 +123,9 @@ namespace windage
 			inline void SetMaxIteration(int iteration){this->maxIteration = iteration;};
 			inline void SetConfidence(double confidence){this->confidence = confidence;};
 			inline int GetInlierCount(){return this->inlierCount;};
+			inline void SetFivePointMethod(bool fivePoints){this->fivePoints = fivePoints;};
+			inline bool IsFivePointMethod(){return this->fivePoints;};
+			inline void SetSeed(int64 seed){this->rng = cvRNG(seed);};
 
 			inline void AttatchBaseCameraParameter(windage::Calibration* cameraParameter){this->initialCameraParameter = cameraParameter;};
 			inline void AttatchUpdateCameraParameter(windage::Calibration* cameraParameter){this->localCameraParameter = cameraParameter;};
@@ -136,16 +145,29 @@ namespace windage
 			void CalculateNormalizedPoint();
 
 			bool CalibratedTriangulation(CvMat *matR, CvMat *matT, CvMat *ptL, CvMat *ptR, CvMat *pt3D);
-			bool DecomposeEMatrix(CvMat *EMat);
+			bool DecomposeEMatrix(CvMat *EMat, int testIndex1 = 0, int testIndex2 = 1);
 			int ReconstructAll(CvMat *matE);
 			int CountInliers(double thresh, double *err);
 
 			bool ComputeEssentialMatrix8Points(CvMat *pt1, CvMat *pt2, CvMat *EMat);
 
+			/**
+			 * @fn	ComputeEssentialMatrix5Points
+			 * @brief
+			 *		compute essential matrices of 5 normalized correspondences (Nister's 5-point method)
+			 * @remark
+			 *		each row of EMats (at most 10 x 9) is one solution
+			 * @return
+			 *		solution count
+			 */
+			int ComputeEssentialMatrix5Points(CvMat *pt1, CvMat *pt2, CvMat *EMats);
+
 			/**
 			 * @fn	ComputeEssentialMatrixRANSAC
 			 * @brief
 			 *		compute essential matrix and reconstruction 3D points
+			 * @remark
+			 *		the 5-point mode scores the hypotheses by the sampson distance in parallel and decomposes only the best model
 			 */
 			bool ComputeEssentialMatrixRANSAC(double* error);
 		};
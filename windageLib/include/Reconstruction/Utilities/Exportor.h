@@ -57,6 +57,7 @@
 #include "Structures/Calibration.h"
 #include "Structures/ReconstructionPoint.h"
 #include "Utilities/Logger.h"
+#include "Reconstruction/Utilities/ReconstructionFile.h"
 
 namespace windage
 {
@@ -101,7 +102,23 @@ namespace windage
 			inline void PushCalibration(windage::Calibration* calibration){this->calibrationList.push_back(calibration);};
 			inline void SetReconstructionPoints(std::vector<windage::ReconstructionPoint>* reconstructionPoints){this->reconstructionPoints = reconstructionPoints;};
 			
+			/**
+			 * @fn	DoExport
+			 * @brief
+			 *		export the reconstruction datas as text through the attatched logger
+			 * @remark
+			 *		human readable format for debugging, Loader::DoLoad reads both formats
+			 */
 			bool DoExport();
+
+			/**
+			 * @fn	DoExportBinary
+			 * @brief
+			 *		export the reconstruction datas as binary file (ReconstructionFile.h layout)
+			 * @remark
+			 *		the file can be memory-mapped by MappedReconstruction and loaded by Loader::DoLoad
+			 */
+			bool DoExportBinary(const char* filename);
 		};
 		/** @} */ // addtogroup Reconstruction
 	}
@@ -57,6 +57,7 @@
 #include "Structures/Calibration.h"
 #include "Structures/ReconstructionPoint.h"
 #include "Utilities/Logger.h"
+#include "Reconstruction/Utilities/ReconstructionFile.h"
 
 namespace windage
 {
@@ -81,6 +82,9 @@ namespace windage
 			std::vector<std::string>* filenameList;
 			std::vector<windage::ReconstructionPoint>* reconstructionPoints;
 
+			bool DoLoadText(const char* filename);
+			bool DoLoadBinary(const char* filename);
+
 		public:
 			Loader()
 			{
@@ -96,6 +100,14 @@ namespace windage
 			inline void AttatchFilename(std::vector<std::string>* filename){this->filenameList = filename;};
 			inline void AttatchReconstructionPoints(std::vector<windage::ReconstructionPoint>* reconstructionPoints){this->reconstructionPoints = reconstructionPoints;};
 			
+			/**
+			 * @fn	DoLoad
+			 * @brief
+			 *		load the reconstruction datas from the exported file
+			 * @remark
+			 *		binary file (Exportor::DoExportBinary) is detected by its magic number and
+			 *		read through the memory-mapped view, otherwise the text format is parsed
+			 */
 			bool DoLoad(const char* filename="");
 		};
 		/** @} */ // addtogroup Reconstruction
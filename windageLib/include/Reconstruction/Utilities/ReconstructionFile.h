@@ -0,0 +1,196 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	ReconstructionFile.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	binary layout of reconstruction datas and its memory-mapped reader
+ */
+
+#ifndef _RECONSTRUCTION_FILE_H_
+#define _RECONSTRUCTION_FILE_H_
+
+#include "base.h"
+#include "Structures/ReconstructionPoint.h"
+#include "Utilities/MappedFile.h"
+
+namespace windage
+{
+	namespace Reconstruction
+	{
+		/**
+		 * @defgroup Reconstruction Reconstruction classes
+		 * @brief
+		 *		Reconstruction classes
+		 * @addtogroup Reconstruction
+		 * @{
+		 */
+
+		/**
+		 * @brief
+		 *		binary reconstruction file layout (little endian)
+		 * @remark
+		 *		header, section table and the sections follow in order,
+		 *		every section is aligned at 8 bytes and holds a flat array,
+		 *		per point variable length datas are indexed by (point count + 1) offsets
+		 */
+		static const char RECONSTRUCTION_FILE_MAGIC[8] = {'W', 'D', 'G', 'R', 'E', 'C', 'O', 'N'};
+		static const unsigned int RECONSTRUCTION_FILE_VERSION = 1;
+
+		enum ReconstructionSectionType
+		{
+			RECONSTRUCTION_SECTION_CAMERA = 1,			///< CameraRecord per camera
+			RECONSTRUCTION_SECTION_IMAGE_PATH,			///< (camera count + 1) offsets and null-terminated strings
+			RECONSTRUCTION_SECTION_POINT,				///< double[4] per point
+			RECONSTRUCTION_SECTION_COLOR,				///< double[4] per point
+			RECONSTRUCTION_SECTION_OBJECT_ID,			///< int per point
+			RECONSTRUCTION_SECTION_FEATURE_INDEX,		///< (point count + 1) offsets into the feature section
+			RECONSTRUCTION_SECTION_FEATURE,				///< FeatureRecord per observed feature
+			RECONSTRUCTION_SECTION_DESCRIPTOR,			///< double per descriptor element
+			RECONSTRUCTION_SECTION_REFERENCE_INDEX,		///< (point count + 1) offsets into the reference section
+			RECONSTRUCTION_SECTION_REFERENCE			///< windage::FeatureReference per observation
+		};
+
+		struct ReconstructionFileHeader
+		{
+			char magic[8];						///< RECONSTRUCTION_FILE_MAGIC
+			unsigned int version;				///< RECONSTRUCTION_FILE_VERSION
+			unsigned int sectionCount;			///< number of section table entries
+			unsigned long long fileSize;		///< total file size in bytes
+		};
+
+		struct ReconstructionFileSection
+		{
+			unsigned int type;					///< ReconstructionSectionType
+			unsigned int stride;				///< element size in bytes (0 at variable length)
+			unsigned long long count;			///< element count
+			unsigned long long offset;			///< byte offset from the file beginning
+			unsigned long long size;			///< byte size of the section
+		};
+
+		struct CameraRecord
+		{
+			double intrinsic[9];				///< 3x3 intrinsic matrix (row major)
+			double extrinsic[16];				///< 4x4 extrinsic matrix (row major)
+		};
+
+		struct FeatureRecord
+		{
+			double point[3];					///< feature position
+			double color[4];					///< feature color
+			double dir;							///< feature orientation
+			double distance;					///< feature distance
+			int objectID;						///< object id
+			int size;							///< feature size
+			unsigned long long descriptorOffset;///< element offset into the descriptor section
+			int descriptorDimension;			///< descriptor dimension
+			int reserved;						///< padding
+		};
+
+		/**
+		 * @brief	Class for read-only memory-mapped view of the binary reconstruction file
+		 * @author	Woonhyuk Baek
+		 * @remark
+		 *		returned arrays point directly into the mapped file and are valid until Close
+		 */
+		class DLLEXPORT MappedReconstruction
+		{
+		private:
+			windage::MappedFile file;			///< mapped file
+			const char* data;					///< mapped view
+			unsigned long long dataSize;		///< mapped size
+
+			const ReconstructionFileSection* sections;
+			unsigned int sectionCount;
+
+			const void* GetSection(int type, unsigned long long* count=NULL);
+
+		public:
+			MappedReconstruction()
+			{
+				data = NULL;
+				dataSize = 0;
+				sections = NULL;
+				sectionCount = 0;
+			}
+			~MappedReconstruction()
+			{
+				this->Close();
+			}
+
+			/**
+			 * @fn	IsReconstructionFile
+			 * @brief
+			 *		check the magic number whether the file is binary reconstruction file
+			 */
+			static bool IsReconstructionFile(const char* filename);
+
+			/**
+			 * @fn	Open
+			 * @brief
+			 *		map the file and validate the header and the section table
+			 */
+			bool Open(const char* filename);
+			void Close();
+			inline bool IsOpened(){return this->data != NULL;};
+
+			int GetCameraCount();
+			const windage::Reconstruction::CameraRecord* GetCameras();
+			const char* GetImagePath(int index);
+
+			int GetPointCount();
+			const double* GetPoints();
+			const double* GetColors();
+			const int* GetObjectIDs();
+
+			const unsigned long long* GetFeatureIndex();
+			const windage::Reconstruction::FeatureRecord* GetFeatures();
+			const double* GetDescriptors();
+
+			const unsigned long long* GetReferenceIndex();
+			const windage::FeatureReference* GetReferences();
+		};
+		/** @} */ // addtogroup Reconstruction
+	}
+}
+
+#endif
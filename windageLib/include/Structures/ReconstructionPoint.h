@@ -48,6 +48,7 @@
 #ifndef _RECONSTRUCTION_POINT_H_
 #define _RECONSTRUCTION_POINT_H_
 
+#include <vector>
 #include <cv.h>
 
 #include "base.h"
@@ -64,6 +65,15 @@ namespace windage
 	 * @{
 	 */
 
+	/**
+	 * @brief	observation of reconstruction point refered by the index at per-image feature table
+	 */
+	struct FeatureReference
+	{
+		int imageID;				///< image (camera) index
+		int featureID;				///< feature index at the image feature table
+	};
+
 	/**
 	 * @brief	Class for reconstruction points
 	 * @author	Woonhyuk Baek
@@ -72,7 +82,9 @@ namespace windage
 	{
 	protected:
 		windage::Vector4 point;		///< position of reconstruction point (w-value is 1.0)
-		std::vector<windage::FeaturePoint> featureList;
+		std::vector<windage::FeaturePoint> featureList;			///< copy of the observed features (empty at compact observation)
+		std::vector<windage::FeatureReference> referenceList;	///< observed features refered to per-image feature table
+		std::vector<double> meanDescriptor;						///< mean descriptor of the observed features (optional)
 		CvScalar color;				///< color of reconstruction point
 		int objectID;				///< object id (initialize -1)
 		bool outlier;				///< checked outlier
@@ -97,18 +109,15 @@ namespace windage
 		 * @remark
 		 *		copy all data
 		 */
-		virtual void operator=(ReconstructionPoint oprd)
+		virtual void operator=(const ReconstructionPoint& oprd)
 		{
-			this->point = oprd.GetPoint();
-
-			std::vector<windage::FeaturePoint>* featureList = oprd.GetFeatureList();
-			this->featureList.clear();
-			for(unsigned int i=0; i<featureList->size(); i++)
-				this->featureList.push_back((*featureList)[i]);
-
-			this->color = oprd.GetColor();
-			this->objectID = oprd.GetObjectID();
-			this->outlier = oprd.IsOutlier();
+			this->point = oprd.point;
+			this->featureList = oprd.featureList;
+			this->referenceList = oprd.referenceList;
+			this->meanDescriptor = oprd.meanDescriptor;
+			this->color = oprd.color;
+			this->objectID = oprd.objectID;
+			this->outlier = oprd.outlier;
 		}
 
 		inline void SetPoint(windage::Vector4 point){this->point = point;};
@@ -117,6 +126,18 @@ namespace windage
 		inline std::vector<windage::FeaturePoint>* GetFeatureList(){return &this->featureList;};
 		inline windage::FeaturePoint GetFeature(int i){return this->featureList[i];};
 
+		inline void AddFeatureReference(int imageID, int featureID){windage::FeatureReference reference = {imageID, featureID}; this->referenceList.push_back(reference);};
+		inline std::vector<windage::FeatureReference>* GetReferenceList(){return &this->referenceList;};
+		inline int GetReferenceCount(){return (int)this->referenceList.size();};
+		inline std::vector<double>* GetMeanDescriptor(){return &this->meanDescriptor;};
+
+		/**
+		 * @fn	ReleaseFeatureList
+		 * @brief
+		 *		release the feature copies and keep only the references
+		 */
+		inline void ReleaseFeatureList(){std::vector<windage::FeaturePoint>().swap(this->featureList);};
+
 		inline void SetColor(CvScalar color=CV_RGB(255, 255, 2555)){this->color = color;};
 		inline CvScalar GetColor(){return this->color;};
 		inline void SetObjectID(int id){this->objectID = id;};
@@ -57,6 +57,7 @@
 #include "Structures/Calibration.h"
 #include "Structures/ReconstructionPoint.h"
 #include "Utilities/Logger.h"
+#include "Utilities/FeatureFile.h"
 
 namespace windage
 {
@@ -86,7 +87,21 @@ namespace windage
 		inline void AttatchLogger(windage::Logger* logger){this->logger = logger;};
 		inline void SetFeaturePoints(std::vector<windage::FeaturePoint>* featurePoints){this->featurePoints = featurePoints;};
 		
+		/**
+		 * @fn	DoExport
+		 * @brief
+		 *		export the feature datas as text through the attatched logger
+		 */
 		bool DoExport();
+
+		/**
+		 * @fn	DoExportBinary
+		 * @brief
+		 *		export the feature datas as binary feature file (FeatureFile.h layout)
+		 * @remark
+		 *		quantization stores descriptor elements in [minimum, maximum] as uint8
+		 */
+		bool DoExportBinary(const char* filename, bool quantization=false, double minimum=-1.0, double maximum=1.0);
 	};
 }
 
@@ -0,0 +1,228 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	FeatureFile.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	binary feature file with streaming writer and memory-mapped reader
+ */
+
+#ifndef _FEATURE_FILE_H_
+#define _FEATURE_FILE_H_
+
+#include <stdio.h>
+#include <vector>
+
+#include "base.h"
+#include "Structures/FeaturePoint.h"
+#include "Algorithms/SearchTree.h"
+#include "Utilities/MappedFile.h"
+
+namespace windage
+{
+	/**
+	 * @brief
+	 *		binary feature file layout (little endian)
+	 * @remark
+	 *		header is followed by 8-byte aligned per-field arrays (structure of arrays),
+	 *		descriptors are row-major float or uint8 quantised in [minimum, minimum + 255 * scale]
+	 */
+	static const char FEATURE_FILE_MAGIC[8] = {'W', 'D', 'G', 'F', 'E', 'A', 'T', 'R'};
+	static const unsigned int FEATURE_FILE_VERSION = 1;
+	static const unsigned int FEATURE_FILE_QUANTIZED = 0x01;
+
+	enum FeatureFileArray
+	{
+		FEATURE_ARRAY_POSITION = 0,		///< float[3] per feature
+		FEATURE_ARRAY_SIZE,				///< int per feature
+		FEATURE_ARRAY_DIR,				///< float per feature
+		FEATURE_ARRAY_DISTANCE,			///< float per feature
+		FEATURE_ARRAY_OBJECT_ID,		///< int per feature
+		FEATURE_ARRAY_COLOR,			///< unsigned char[4] per feature
+		FEATURE_ARRAY_DESCRIPTOR,		///< float or unsigned char[dimension] per feature
+		FEATURE_ARRAY_COUNT
+	};
+
+	struct FeatureFileHeader
+	{
+		char magic[8];								///< FEATURE_FILE_MAGIC
+		unsigned int version;						///< FEATURE_FILE_VERSION
+		unsigned int flags;							///< FEATURE_FILE_QUANTIZED
+		unsigned long long count;					///< feature count
+		unsigned int dimension;						///< descriptor dimension
+		unsigned int reserved;						///< padding
+		double quantizationMinimum;					///< descriptor value at 0
+		double quantizationScale;					///< descriptor value step
+		unsigned long long fileSize;				///< total file size in bytes
+		unsigned long long offset[FEATURE_ARRAY_COUNT];	///< byte offset of each array
+	};
+
+	/**
+	 * @brief	Class for writing binary feature file by feature blocks
+	 * @author	Woonhyuk Baek
+	 * @remark
+	 *		total count is fixed at Open, every Write appends a block to each array
+	 */
+	class DLLEXPORT FeatureFileWriter
+	{
+	private:
+		FILE* output;
+		FeatureFileHeader header;
+		unsigned long long written;		///< written feature count
+
+		bool WriteArray(int type, int stride, unsigned long long count, const void* data);
+
+	public:
+		FeatureFileWriter()
+		{
+			output = NULL;
+			written = 0;
+		}
+		~FeatureFileWriter()
+		{
+			this->Close();
+		}
+
+		/**
+		 * @fn	Open
+		 * @brief
+		 *		create the file and reserve all arrays for count features
+		 * @remark
+		 *		quantization maps [minimum, maximum] to uint8 descriptor elements
+		 */
+		bool Open(const char* filename, int count, int dimension, bool quantization=false, double minimum=-1.0, double maximum=1.0);
+
+		/**
+		 * @fn	Write
+		 * @brief
+		 *		append the feature block
+		 * @warning
+		 *		descriptor dimension of the features should be same as the opened dimension
+		 */
+		bool Write(std::vector<windage::FeaturePoint>* featurePoints);
+
+		/**
+		 * @fn	Close
+		 * @brief
+		 *		close the file
+		 * @return
+		 *		whether all reserved features are written
+		 */
+		bool Close();
+	};
+
+	/**
+	 * @brief	Class for read-only memory-mapped view of the binary feature file
+	 * @author	Woonhyuk Baek
+	 * @remark
+	 *		returned arrays point directly into the mapped file and are valid until Close
+	 */
+	class DLLEXPORT MappedFeatureFile
+	{
+	private:
+		windage::MappedFile file;				///< mapped file
+		const windage::FeatureFileHeader* header;
+		std::vector<float> dequantizedDescriptors;	///< training buffer at quantized file
+
+		inline const void* GetArray(int type){return this->header ? this->file.GetData() + this->header->offset[type] : NULL;};
+
+	public:
+		MappedFeatureFile()
+		{
+			header = NULL;
+		}
+		~MappedFeatureFile()
+		{
+			this->Close();
+		}
+
+		static bool IsFeatureFile(const char* filename);
+
+		/**
+		 * @fn	Open
+		 * @brief
+		 *		map the file and validate the header and the array ranges
+		 */
+		bool Open(const char* filename);
+		void Close();
+		inline bool IsOpened(){return this->header != NULL;};
+
+		inline int GetCount(){return this->header ? (int)this->header->count : 0;};
+		inline int GetDimension(){return this->header ? (int)this->header->dimension : 0;};
+		inline bool IsQuantized(){return this->header ? (this->header->flags & FEATURE_FILE_QUANTIZED) != 0 : false;};
+
+		inline const float* GetPositions(){return (const float*)this->GetArray(FEATURE_ARRAY_POSITION);};
+		inline const int* GetSizes(){return (const int*)this->GetArray(FEATURE_ARRAY_SIZE);};
+		inline const float* GetDirs(){return (const float*)this->GetArray(FEATURE_ARRAY_DIR);};
+		inline const float* GetDistances(){return (const float*)this->GetArray(FEATURE_ARRAY_DISTANCE);};
+		inline const int* GetObjectIDs(){return (const int*)this->GetArray(FEATURE_ARRAY_OBJECT_ID);};
+		inline const unsigned char* GetColors(){return (const unsigned char*)this->GetArray(FEATURE_ARRAY_COLOR);};
+
+		/**
+		 * @fn	GetDescriptors
+		 * @brief
+		 *		float descriptor array in place (NULL at quantized file)
+		 */
+		inline const float* GetDescriptors(){return this->IsQuantized() ? NULL : (const float*)this->GetArray(FEATURE_ARRAY_DESCRIPTOR);};
+		inline const unsigned char* GetQuantizedDescriptors(){return this->IsQuantized() ? (const unsigned char*)this->GetArray(FEATURE_ARRAY_DESCRIPTOR) : NULL;};
+
+		/**
+		 * @fn	GetFeature
+		 * @brief
+		 *		restore the feature point at index
+		 */
+		bool GetFeature(int index, windage::FeaturePoint* featurePoint);
+
+		/**
+		 * @fn	Training
+		 * @brief
+		 *		train the search tree with the descriptor array
+		 * @remark
+		 *		float descriptors are passed in place, quantized descriptors are expanded into the internal buffer
+		 * @warning
+		 *		the file should be opened while the trained tree refers to the descriptors
+		 */
+		bool Training(windage::Algorithms::SearchTree* searchTree);
+	};
+}
+
+#endif // _FEATURE_FILE_H_
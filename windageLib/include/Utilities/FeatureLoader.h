@@ -78,6 +78,14 @@ namespace windage
 
 		inline void AttatchFeaturePoints(std::vector<windage::FeaturePoint>* featurePoints){this->featurePoints = featurePoints;};
 		
+		/**
+		 * @fn	DoLoad
+		 * @brief
+		 *		append the feature datas from the exported file
+		 * @remark
+		 *		binary feature file (FeatureExportor::DoExportBinary) is detected by its magic number,
+		 *		use MappedFeatureFile directly to train the search tree without restoring feature points
+		 */
 		bool DoLoad(const char* filename="");
 	};
 }
@@ -0,0 +1,158 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+/**
+ * @file	ImageSequence.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	recorded image sequence or video reader for offline replay
+ */
+
+#ifndef _IMAGE_SEQUENCE_H_
+#define _IMAGE_SEQUENCE_H_
+
+#include <string>
+
+#include <cv.h>
+#include <highgui.h>
+
+#include "base.h"
+
+namespace windage
+{
+	/**
+	 * @defgroup Utilities Utility classes
+	 * @brief
+	 *		Utility classes
+	 * @addtogroup Utilities
+	 * @{
+	 */
+
+	/**
+	 * @brief	Class for reading the recorded frames (numbered image files or video file) in order
+	 * @remark
+	 *		the filename with exactly one integer conversion is the numbered image files (e.g. "sequence/%04d.png"),
+	 *		the others are opened as video file.
+	 *		the frames are always same at every replay, so the frameworks can be compared frame by frame
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT ImageSequence
+	{
+	private:
+		std::string filename;		///< numbered image filename or video filename
+		bool numbered;				///< numbered image files or video file
+		CvCapture* capture;			///< video capture
+
+		int startIndex;				///< number of the first image file
+		int frameCount;				///< maximum number of the frames (0 is until the end)
+		int index;					///< current frame index (-1 before the first frame)
+
+		int width;					///< output size (0 is the size of the recorded frame)
+		int height;					///< output size (0 is the size of the recorded frame)
+		IplImage* colorImage;		///< current frame (3-channel)
+		IplImage* grayImage;		///< current frame (1-channel)
+
+		bool SetFrame(IplImage* frame);
+
+	public:
+		virtual char* GetFunctionName(){return "ImageSequence";};
+		ImageSequence()
+		{
+			numbered = false;
+			capture = NULL;
+
+			startIndex = 0;
+			frameCount = 0;
+			index = -1;
+
+			width = 0;
+			height = 0;
+			colorImage = NULL;
+			grayImage = NULL;
+		}
+		virtual ~ImageSequence()
+		{
+			this->Release();
+		}
+
+		inline void SetSize(int width, int height){this->width = width; this->height = height;};
+		inline void SetFrameCount(int count){this->frameCount = count;};
+		inline int GetFrameCount(){return this->frameCount;};
+		inline int GetIndex(){return this->index;};
+		inline IplImage* GetColorImage(){return this->colorImage;};
+		inline IplImage* GetGrayImage(){return this->grayImage;};
+		inline bool IsNumbered(){return this->numbered;};
+
+		/**
+		 * @fn	IsNumberedPattern
+		 * @brief
+		 *		check that the filename is a safe printf format for one int
+		 * @remark
+		 *		exactly one d, i, u, o, x or X conversion with flags and a width of 2 digits at most ('%%' is allowed),
+		 *		and short enough to be formatted into MAX_FILENAME_LENGTH
+		 */
+		static bool IsNumberedPattern(const char* filename);
+		static const int MAX_FILENAME_LENGTH = 1000;
+
+		/**
+		 * @fn	Open
+		 * @brief
+		 *		open the numbered image files or the video file
+		 * @return
+		 *		the first frame is readable or not (the first frame is read at the first Next)
+		 */
+		bool Open(const char* filename,		///< numbered image filename (printf format) or video filename
+				  int startIndex = 0		///< number of the first image file
+				  );
+		void Release();
+
+		/**
+		 * @fn	Next
+		 * @brief
+		 *		read the next frame to the color and gray image
+		 * @return
+		 *		false after the last frame
+		 */
+		bool Next();
+	};
+	/** @} */ // addtogroup Utilities
+}
+
+#endif // _IMAGE_SEQUENCE_H_
@@ -0,0 +1,102 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	MappedFile.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	read-only memory-mapped file
+ */
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "base.h"
+
+namespace windage
+{
+	/**
+	 * @brief	Class for read-only memory-mapped view of the whole file
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT MappedFile
+	{
+	private:
+		void* file;							///< file handle
+		void* mapping;						///< file mapping handle
+		const char* data;					///< mapped view
+		unsigned long long size;			///< mapped size
+
+	public:
+		MappedFile()
+		{
+			file = NULL;
+			mapping = NULL;
+			data = NULL;
+			size = 0;
+		}
+		~MappedFile()
+		{
+			this->Close();
+		}
+
+		/**
+		 * @fn	Open
+		 * @brief
+		 *		map the whole file as read-only
+		 */
+		bool Open(const char* filename);
+		void Close();
+
+		inline bool IsOpened(){return this->data != NULL;};
+		inline const char* GetData(){return this->data;};
+		inline unsigned long long GetSize(){return this->size;};
+
+		/**
+		 * @fn	HasMagic
+		 * @brief
+		 *		check the first bytes of the file without mapping
+		 */
+		static bool HasMagic(const char* filename, const char* magic, int length);
+	};
+}
+
+#endif // _MAPPED_FILE_H_
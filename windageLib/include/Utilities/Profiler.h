@@ -0,0 +1,307 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+/**
+ * @file	Profiler.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	low-overhead stage profiler with per-thread ring buffers, latency histograms and trace export
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <cv.h>
+
+#include "base.h"
+#include "Utilities/Logger.h"
+
+namespace windage
+{
+	/**
+	 * @defgroup Utilities Utility classes
+	 * @brief
+	 *		Utility classes
+	 * @addtogroup Utilities
+	 * @{
+	 */
+
+	/**
+	 * @brief	Class for latency histogram with logarithmic buckets of linear sub-buckets (HDR-style)
+	 * @remark
+	 *		values are nanoseconds, the relative precision of each bucket is 1 / HALF_SUB_BUCKET_COUNT (about 6%)
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT LatencyHistogram
+	{
+	private:
+		static const int SUB_BUCKET_BITS = 5;
+		static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+		static const int HALF_SUB_BUCKET_COUNT = SUB_BUCKET_COUNT / 2;
+		static const int VALUE_BITS = 40;			///< up to about 18 minutes
+		static const int INDEX_COUNT = (VALUE_BITS - SUB_BUCKET_BITS + 2) * HALF_SUB_BUCKET_COUNT;
+
+		unsigned int counts[INDEX_COUNT];
+		unsigned int count;
+		unsigned long long minimum;
+		unsigned long long maximum;
+		double sum;
+
+		static int GetIndex(unsigned long long value);
+		static unsigned long long GetUpperBound(int index);
+
+	public:
+		LatencyHistogram()
+		{
+			this->Reset();
+		}
+
+		void Reset();
+		void Record(unsigned long long nanoseconds);
+		void Merge(const LatencyHistogram& histogram);
+
+		inline unsigned int GetCount() const {return this->count;};
+		inline unsigned long long GetMin() const {return this->count > 0 ? this->minimum : 0;};
+		inline unsigned long long GetMax() const {return this->maximum;};
+		inline double GetMean() const {return this->count > 0 ? this->sum / this->count : 0.0;};
+
+		/**
+		 * @fn	GetPercentile
+		 * @brief
+		 *		value at the percentile (0 ~ 100)
+		 * @return
+		 *		upper bound of the bucket that reaches the percentile (nanoseconds, not larger than max)
+		 */
+		unsigned long long GetPercentile(double percentile) const;
+	};
+
+	/**
+	 * @brief	Class for stage profiler
+	 * @remark
+	 *		each thread records the stage timing into its own ring buffer without lock (single producer / single consumer),
+	 *		Collect drains every ring buffer into the latency histogram of each stage,
+	 *		Collect is to be called periodically (any thread) so that the ring buffers do not overflow,
+	 *		the ring buffer of a finished thread is reused by a new thread after it is collected,
+	 *		while tracing, the collected records are also written as Chrome trace events (chrome://tracing, Perfetto)
+	 *		by a background flusher thread
+	 * @warning
+	 *		profiling is disabled by default
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT Profiler
+	{
+	public:
+		static const int MAX_STAGE_COUNT = 128;		///< the number of stage names
+		static const int MAX_THREAD_COUNT = 64;		///< the number of ring buffers
+		static const int RING_SIZE = 4096;			///< records per ring buffer (power of 2)
+
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		/**
+		 * @fn	RegisterStage
+		 * @brief
+		 *		register the stage name and return stage ID (same ID for the same name)
+		 * @return
+		 *		stage ID or -1 at failure
+		 */
+		static int RegisterStage(const char* name);
+
+		/**
+		 * @fn	RegisterStage
+		 * @brief
+		 *		register the stage name once into the cached stage ID (-1 : not registered yet)
+		 * @remark
+		 *		thread safe, used by the profile macros instead of a function-local static initializer
+		 * @return
+		 *		stage ID or -1 at failure
+		 */
+		static int RegisterStage(volatile long* stageID, const char* name);
+		static int GetStageCount();
+		static const char* GetStageName(int stageID);
+
+		/**
+		 * @fn	BeginFrame
+		 * @brief
+		 *		increase the frame ID which is attatched to the following records of all threads
+		 * @return
+		 *		new frame ID
+		 */
+		static int BeginFrame();
+		static int GetFrameID();
+
+		/**
+		 * @fn	SetThreadName
+		 * @brief
+		 *		name the calling thread in the trace
+		 */
+		static void SetThreadName(const char* name);
+
+		/**
+		 * @fn	Record
+		 * @brief
+		 *		push a stage timing to the ring buffer of the calling thread
+		 * @remark
+		 *		tick is the value of cvGetTickCount, the record is dropped when the ring buffer is full,
+		 *		frame ID and object ID are trace arguments (-1 is not written)
+		 */
+		static void Record(int stageID, int64 startTick, int64 endTick, int frameID=-1, int objectID=-1);
+
+		/**
+		 * @fn	Collect
+		 * @brief
+		 *		drain the ring buffers of all threads into the histograms
+		 */
+		static void Collect();
+
+		/**
+		 * @fn	Reset
+		 * @brief
+		 *		collect and clear the histograms
+		 */
+		static void Reset();
+
+		static LatencyHistogram GetHistogram(int stageID);
+		static unsigned int GetDroppedCount();
+
+		/**
+		 * @fn	Dump
+		 * @brief
+		 *		collect and log count, mean, p50, p95, p99 and max (milliseconds) of every recorded stage
+		 */
+		static void Dump(windage::Logger* logger);
+
+		/**
+		 * @fn	StartTrace
+		 * @brief
+		 *		enable profiling and write the records to the Chrome trace file (JSON)
+		 * @remark
+		 *		the background thread collects the ring buffers every flushInterval milliseconds
+		 * @return
+		 *		false when the file cannot be opened or the trace is already running
+		 */
+		static bool StartTrace(const char* filename, int flushInterval=100);
+
+		/**
+		 * @fn	StopTrace
+		 * @brief
+		 *		stop the flusher thread, write the remained records and close the trace file
+		 */
+		static void StopTrace();
+		static bool IsTracing();
+	};
+
+	/**
+	 * @brief	Class for scoped stage timer
+	 * @remark
+	 *		records from construction to destruction (or Stop) when the profiler is enabled
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT ProfileScope
+	{
+	private:
+		int stageID;
+		int objectID;
+		int frameID;
+		int64 startTick;
+
+	public:
+		ProfileScope(int stageID, int objectID=-1)
+		{
+			this->stageID = Profiler::IsEnabled() ? stageID : -1;
+			if(this->stageID >= 0)
+			{
+				this->objectID = objectID;
+				this->frameID = Profiler::GetFrameID();
+				this->startTick = cvGetTickCount();
+			}
+		}
+		~ProfileScope()
+		{
+			this->Stop();
+		}
+
+		inline void Stop()
+		{
+			if(this->stageID >= 0)
+				Profiler::Record(this->stageID, this->startTick, cvGetTickCount(), this->frameID, this->objectID);
+			this->stageID = -1;
+		}
+	};
+	/** @} */ // addtogroup Utilities
+}
+
+#define WINDAGE_PROFILE_JOIN2(a, b) a##b
+#define WINDAGE_PROFILE_JOIN(a, b) WINDAGE_PROFILE_JOIN2(a, b)
+
+/**
+ * time the rest of the enclosing block as the stage name
+ * (the stage is registered once at the first pass, same name always gets the same ID,
+ *  the cached ID is a constant-initialized static so that the macro is safe in parallel regions)
+ */
+#define WINDAGE_PROFILE_SCOPE(name) \
+	static volatile long WINDAGE_PROFILE_JOIN(profileStage, __LINE__) = -1; \
+	windage::ProfileScope WINDAGE_PROFILE_JOIN(profileScope, __LINE__)(windage::Profiler::RegisterStage(&WINDAGE_PROFILE_JOIN(profileStage, __LINE__), name))
+
+/**
+ * time the rest of the enclosing block as the stage of the object (object ID is a trace argument)
+ */
+#define WINDAGE_PROFILE_OBJECT_SCOPE(name, objectID) \
+	static volatile long WINDAGE_PROFILE_JOIN(profileStage, __LINE__) = -1; \
+	windage::ProfileScope WINDAGE_PROFILE_JOIN(profileScope, __LINE__)(windage::Profiler::RegisterStage(&WINDAGE_PROFILE_JOIN(profileStage, __LINE__), name), objectID)
+
+/**
+ * start a new frame and time the rest of the enclosing block as the stage
+ */
+#define WINDAGE_PROFILE_FRAME(name) \
+	windage::Profiler::BeginFrame(); \
+	WINDAGE_PROFILE_SCOPE(name)
+
+/**
+ * enter the critical section and time the wait as the stage (lock contention)
+ */
+#define WINDAGE_PROFILE_LOCK(name, criticalSection) \
+	{ \
+		WINDAGE_PROFILE_SCOPE(name); \
+		EnterCriticalSection(criticalSection); \
+	}
+
+#endif // _PROFILER_H_
\ No newline at end of file
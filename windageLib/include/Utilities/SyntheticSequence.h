@@ -0,0 +1,272 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+/**
+ * @file	SyntheticSequence.h
+ * @author	Woonhyuk Baek
+ * @version 2.0
+ * @date	2010.03.01
+ * @brief	synthetic image sequence of a planar reference with ground truth camera pose
+ */
+
+#ifndef _SYNTHETIC_SEQUENCE_H_
+#define _SYNTHETIC_SEQUENCE_H_
+
+#include <cv.h>
+
+#include "base.h"
+#include "Structures/Vector.h"
+#include "Structures/Matrix.h"
+#include "Structures/Calibration.h"
+
+namespace windage
+{
+	/**
+	 * @defgroup Utilities Utility classes
+	 * @brief
+	 *		Utility classes
+	 * @addtogroup Utilities
+	 * @{
+	 */
+
+	/**
+	 * @brief	Class for rendering the reference image under known camera poses (ground truth sequence)
+	 * @remark
+	 *		the reference plane is same as the object coordinate of the frameworks
+	 *		(realWidth x realHeight, centered at the origin, y-up, z = 0)
+	 *		the camera looks around the reference with sinusoidal tilt, pan, roll, translation and distance and seeded jitter,
+	 *		then noise, blur, lighting and occlusion are applied to the rendered frame.
+	 *		every frame is a function of the seed and the frame index only, so the sequence is reproducible
+	 * @author	Woonhyuk Baek
+	 */
+	class DLLEXPORT SyntheticSequence
+	{
+	private:
+		windage::Calibration* cameraParameter;	///< attatched camera parameter (intrinsic only)
+		windage::Calibration* groundTruth;		///< intrinsic and ground truth extrinsic of the current frame
+		windage::Matrix3 homography;			///< reference image pixel to frame pixel (ground truth)
+
+		IplImage* referenceImage;				///< attatched reference image
+		IplImage* referenceMask;				///< coverage of the reference image
+		IplImage* backgroundImage;				///< seeded random texture behind the reference plane
+		IplImage* warpImage;					///< warped reference image
+		IplImage* maskImage;					///< warped coverage
+		IplImage* floatImage;					///< buffer for the sensor noise
+		IplImage* noiseImage;					///< buffer for the sensor noise
+		IplImage* frameImage;					///< rendered frame (gray image)
+
+		int width;								///< frame width
+		int height;								///< frame height
+		double realWidth;						///< reference object width
+		double realHeight;						///< reference object height
+
+		unsigned int seed;						///< seed of the jitter, texture, occlusion and noise
+		int frameCount;							///< number of frames (a period of the motion)
+		int index;								///< current frame index (-1 before the first frame)
+
+		double distance;						///< distance between the camera and the reference plane (0 is fit to the frame)
+		double rotationRange;					///< amplitude of tilt, pan and roll (degree)
+		double translationRange;				///< amplitude of the look-at point (ratio of the reference size)
+		double distanceRange;					///< amplitude of the distance (ratio of the distance)
+		double jitter;							///< standard deviation of the rotation jitter (degree)
+
+		double noise;							///< standard deviation of the gaussian sensor noise (gray level)
+		double blur;							///< standard deviation of the gaussian blur (pixel, 0 is off)
+		double gainRange;						///< amplitude of the lighting gain (ratio)
+		double biasRange;						///< amplitude of the lighting bias (gray level)
+		int occluderCount;						///< number of the occluding rectangles
+		double occluderSize;					///< size of the occluding rectangle (ratio of the projected reference)
+
+		bool initialize;						///< checked initialized
+
+		void Release();
+		void RenderBackground();
+		void CalculatePose(int index, CvRNG* rng, double* extrinsic);
+
+	public:
+		virtual char* GetFunctionName(){return "SyntheticSequence";};
+		SyntheticSequence()
+		{
+			cameraParameter = NULL;
+			groundTruth = new windage::Calibration();
+
+			referenceImage = NULL;
+			referenceMask = NULL;
+			backgroundImage = NULL;
+			warpImage = NULL;
+			maskImage = NULL;
+			floatImage = NULL;
+			noiseImage = NULL;
+			frameImage = NULL;
+
+			width = 640;
+			height = 480;
+			realWidth = 640.0;
+			realHeight = 480.0;
+
+			seed = 0;
+			frameCount = 300;
+			index = -1;
+
+			distance = 0.0;
+			rotationRange = 20.0;
+			translationRange = 0.1;
+			distanceRange = 0.2;
+			jitter = 0.5;
+
+			noise = 2.0;
+			blur = 0.0;
+			gainRange = 0.0;
+			biasRange = 0.0;
+			occluderCount = 0;
+			occluderSize = 0.2;
+
+			initialize = false;
+		}
+		virtual ~SyntheticSequence()
+		{
+			this->Release();
+			if(referenceImage) cvReleaseImage(&referenceImage);
+			referenceImage = NULL;
+			if(groundTruth) delete groundTruth;
+			groundTruth = NULL;
+		}
+
+		inline void SetSeed(unsigned int seed){this->seed = seed;};
+		inline unsigned int GetSeed(){return this->seed;};
+		inline void SetFrameCount(int count){this->frameCount = count;};
+		inline int GetFrameCount(){return this->frameCount;};
+		inline int GetIndex(){return this->index;};
+		inline CvSize GetSize(){return cvSize(this->width, this->height);};
+
+		/**
+		 * @fn	SetMotion
+		 * @brief
+		 *		set the camera motion of the sequence
+		 * @remark
+		 *		tilt, pan and roll are sinusoidal of the different frequencies within the rotation range in a period (frame count),
+		 *		the look-at point and the distance are also sinusoidal and the rotation jitter is added at every frame
+		 */
+		inline void SetMotion(double distance, double rotationRange, double translationRange=0.1, double distanceRange=0.2, double jitter=0.5)
+		{
+			this->distance = distance;
+			this->rotationRange = rotationRange;
+			this->translationRange = translationRange;
+			this->distanceRange = distanceRange;
+			this->jitter = jitter;
+		};
+		inline void SetNoise(double sigma){this->noise = sigma;};
+		inline void SetBlur(double sigma){this->blur = sigma;};
+		inline void SetLighting(double gainRange, double biasRange){this->gainRange = gainRange; this->biasRange = biasRange;};
+		inline void SetOcclusion(int count, double size){this->occluderCount = count; this->occluderSize = size;};
+
+		inline IplImage* GetFrame(){return this->frameImage;};
+		inline IplImage* GetReferenceImage(){return this->referenceImage;};
+		inline windage::Matrix3 GetHomography(){return this->homography;};
+		inline windage::Calibration* GetGroundTruth(){return this->groundTruth;};
+
+		/**
+		 * @fn	AttatchCalibration
+		 * @brief
+		 *		attatch camera parameter to member pointer from out-side
+		 * @remark
+		 *		only the intrinsic parameter is used to render, the ground truth extrinsic is at GetGroundTruth
+		 * @warning
+		 *		It is required elements
+		 *		camera parameter is not create in-side at this class so do not release this pointer
+		 */
+		inline void AttatchCalibration(windage::Calibration* calibration){this->cameraParameter = calibration;};
+
+		/**
+		 * @fn	AttatchReferenceImage
+		 * @brief
+		 *		attatch reference image
+		 * @warning
+		 *		reference image is always gray image (1-channel)
+		 */
+		bool AttatchReferenceImage(IplImage* grayImage);
+
+		/**
+		 * @fn	Initialize
+		 * @brief
+		 *		initialize the frame buffers and render the background texture
+		 * @warning
+		 *		It will be called after attatched the camera parameter and the reference image
+		 */
+		bool Initialize(int width,					///< frame width
+						int height,					///< frame height
+						double realWidth=640.0,		///< refenrece object width
+						double realHeight=480.0		///< reference object height
+						);
+
+		/**
+		 * @fn	Generate
+		 * @brief
+		 *		render the frame of the index and update the ground truth
+		 */
+		bool Generate(int index);
+
+		/**
+		 * @fn	Next
+		 * @brief
+		 *		render the next frame for streaming the sequence to the frameworks
+		 * @return
+		 *		false after the last frame
+		 */
+		bool Next();
+		inline void Reset(){this->index = -1;};
+
+		/**
+		 * @defgroup ground truth error
+		 * @brief
+		 *		error of the estimated camera parameter against the ground truth of the current frame
+		 * @{
+		 */
+		/** angle of the relative rotation (degree) */
+		double CalculateRotationError(windage::Calibration* estimated);
+		/** distance between the camera positions (object unit) */
+		double CalculateTranslationError(windage::Calibration* estimated);
+		/** mean distance between the projected corners of the reference (pixel) */
+		double CalculateReprojectionError(windage::Calibration* estimated);
+		/** @} */
+	};
+	/** @} */ // addtogroup Utilities
+}
+
+#endif // _SYNTHETIC_SEQUENCE_H_
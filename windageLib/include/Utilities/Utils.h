@@ -48,6 +48,8 @@
 #ifndef _UTILS_H_
 #define _UTILS_H_
 
+#include <stdio.h>
+#include <vector>
 #include <cv.h>
 
 #include "base.h"
@@ -77,6 +79,24 @@ namespace windage
 		 *		draw text to image
 		 */
 		static void DrawTextToImage(IplImage* colorImage, CvPoint position, double scale, char* message);
+
+		/**
+		 * @fn	WriteJSONString
+		 * @brief
+		 *		write the text as a quoted JSON string
+		 * @remark
+		 *		quotation marks and backslashes are escaped, control characters are written as \uXXXX
+		 */
+		static void WriteJSONString(FILE* file, const char* text);
+
+		/**
+		 * @fn	GetPercentile
+		 * @brief
+		 *		nearest rank value at the ratio (0 ~ 1) of the sorted copy of the values
+		 * @return
+		 *		-1 when the values are empty
+		 */
+		static double GetPercentile(std::vector<double> values, double ratio);
 	};
 	/** @} */ // addtogroup Utilities
 }
@@ -65,6 +65,7 @@
 #include "Algorithms/OpenSURFdetector.h"
 #include "Algorithms/SURFdetector.h"
 #include "Algorithms/SIFTdetector.h"
+#include "Algorithms/SIFTCPUdetector.h"
 #include "Algorithms/SIFTGPUdetector.h"
 #include "Algorithms/WSURFdetector.h"
 #include "Algorithms/WSURFMultidetector.h"
@@ -94,6 +95,7 @@
 #include "Algorithms/LMmethod.h"
 #include "Algorithms/PoseRefiner.h"
 #include "Algorithms/PoseLMmethod.h"
+#include "Algorithms/MultiTemplateESM.h"
 
 #include "Algorithms/OutlierChecker.h"
 
@@ -105,6 +107,11 @@
 // Utilities
 #include "Utilities/Utils.h"
 #include "Utilities/Logger.h"
+#include "Utilities/Profiler.h"
+#include "Utilities/ImageSequence.h"
+#include "Utilities/SyntheticSequence.h"
+#include "Utilities/MappedFile.h"
+#include "Utilities/FeatureFile.h"
 #include "Utilities/FeatureExportor.h"
 #include "Utilities/FeatureLoader.h"
 
@@ -131,4 +138,5 @@
 // Reconstruction : utilities
 #include "Reconstruction/Utilities/Exportor.h"
 #include "Reconstruction/Utilities/Loader.h"
+#include "Reconstruction/Utilities/ReconstructionFile.h"
 #include "Reconstruction/Utilities/ConvertCoordination.h"
\ No newline at end of file
@@ -60,7 +60,6 @@ bool EPnPRANSACestimator::Calculate()
 	double cy = this->cameraParameter->GetParameters()[3];
 
 	int idx[SAMPLE_SIZE];
-	CvRNG rng = cvRNG(cvGetTickCount());
 	int pre_inliers = 0;
 
 	windage::Calibration tempCalibration;
@@ -84,7 +83,7 @@ bool EPnPRANSACestimator::Calculate()
 			bool found = true;
 			while(found)
 			{
-				tempIndex = cvRandInt(&rng) % n;
+				tempIndex = cvRandInt(&this->rng) % n;
 				found = false;
 				for(int j=0; j<i; j++)
 				{
@@ -70,6 +70,21 @@ bool FLANNtree::Training(std::vector<windage::FeaturePoint>* pointList)
 	return true;
 }
 
+bool FLANNtree::TrainingDescriptors(const float* descriptors, int count, int dimension)
+{
+	if(descriptors == NULL || count <= 0 || dimension <= 0)
+		return false;
+
+	if(this->descriptorStorage) cvReleaseMat(&this->descriptorStorage);
+
+	// refer to the external array in place
+	flannStorage = cv::Mat(count, dimension, CV_32F, (void*)descriptors);
+	if(this->flannIndex) delete flannIndex;
+	this->flannIndex = new cv::flann::Index(flannStorage, cv::flann::KDTreeIndexParams(2));
+
+	return true;
+}
+
 int FLANNtree::Matching(windage::FeaturePoint point, double* difference)
 {
 	int index = -1;
@@ -73,12 +73,11 @@ bool KDforest::Training(std::vector<windage::FeaturePoint>* pointList)
 		}
 	}
 
-	CvRNG rng = cvRNG(cvGetTickCount());
 	for(int i=0; i<overlabCount; i++)
 	{
 		for(int index=0; index<this->treeNumber; index++)
 		{
-			int randIndex = cvRandInt(&rng) % count;
+			int randIndex = cvRandInt(&this->rng) % count;
 			int y = stepCount + i;
 			this->descriptorIndex[index][y] = randIndex;
 			for(int x=0; x<dimension; x++)
@@ -0,0 +1,433 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <math.h>
+#include <omp.h>
+
+#include "Algorithms/MultiTemplateESM.h"
+using namespace windage;
+using namespace windage::Algorithms;
+
+static const int ESM_PARAMETER_COUNT = 8;
+static const int BUFFER_CHANNEL = 6;	// warped intensity, gradient x, gradient y, u, v, 1/w
+
+/**
+ * @brief
+ *		solve A x = b for symmetric positive definite 8x8 A by Cholesky decomposition (A = L L^T)
+ * @remark
+ *		copy of the solver in Image Alignment/Algorithms/homographyESM.cpp (the two trees do not share sources), keep them identical
+ */
+static bool SolveCholesky8(const double* A, const double* b, double* x)
+{
+	const int n = ESM_PARAMETER_COUNT;
+	double L[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+
+	for(int j=0; j<n; j++)
+	{
+		double sum = A[j*n + j];
+		for(int k=0; k<j; k++)
+			sum -= L[j*n + k] * L[j*n + k];
+		if(sum <= 0.0)
+			return false;
+		L[j*n + j] = sqrt(sum);
+
+		double inverse = 1.0 / L[j*n + j];
+		for(int i=j+1; i<n; i++)
+		{
+			double value = A[i*n + j];
+			for(int k=0; k<j; k++)
+				value -= L[i*n + k] * L[j*n + k];
+			L[i*n + j] = value * inverse;
+		}
+	}
+
+	// L y = b
+	double y[ESM_PARAMETER_COUNT];
+	for(int i=0; i<n; i++)
+	{
+		double value = b[i];
+		for(int k=0; k<i; k++)
+			value -= L[i*n + k] * y[k];
+		y[i] = value / L[i*n + i];
+	}
+
+	// L^T x = y
+	for(int i=n-1; i>=0; i--)
+	{
+		double value = y[i];
+		for(int k=i+1; k<n; k++)
+			value -= L[k*n + i] * x[k];
+		x[i] = value / L[i*n + i];
+	}
+
+	return true;
+}
+
+void MultiTemplateESM::SetHomography(int templateID, windage::Matrix3 homography)
+{
+	if(homography.m1[8] != 0.0)
+	{
+		double inverse = 1.0 / homography.m1[8];
+		for(int i=0; i<9; i++)
+			homography.m1[i] *= inverse;
+	}
+
+	this->templates[templateID].homography = homography;
+	this->templates[templateID].active = true;
+}
+
+int MultiTemplateESM::AttatchTemplateImage(IplImage* grayImage)
+{
+	if(grayImage == NULL)
+		return -1;
+	if(grayImage->nChannels != 1 || grayImage->depth != IPL_DEPTH_8U)
+		return -1;
+	if(grayImage->width < 3 || grayImage->height < 3)
+		return -1;
+
+	int columns = (grayImage->width-2 + this->samplingStep-1) / this->samplingStep;
+	int rows = (grayImage->height-2 + this->samplingStep-1) / this->samplingStep;
+
+	TemplateBlock block;
+	block.offset = (int)this->arena.size();
+	block.count = columns * rows;
+	block.width = grayImage->width;
+	block.height = grayImage->height;
+	block.centerX = (grayImage->width-1) / 2.0;
+	block.centerY = (grayImage->height-1) / 2.0;
+	block.scale = (grayImage->width > grayImage->height ? grayImage->width : grayImage->height) / 2.0;
+	block.homography = windage::Matrix3(1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0);
+	block.active = false;
+	block.aligned = false;
+	block.iteration = 0;
+	block.error = 0.0;
+
+	// SoA block : x[count], y[count], intensity[count], gradient x[count], gradient y[count]
+	this->arena.resize(block.offset + SAMPLE_CHANNEL*block.count);
+	float* sampleX = &this->arena[block.offset];
+	float* sampleY = sampleX + block.count;
+	float* intensity = sampleY + block.count;
+	float* gradX = intensity + block.count;
+	float* gradY = gradX + block.count;
+
+	int index = 0;
+	for(int y=1; y<grayImage->height-1; y+=this->samplingStep)
+	{
+		for(int x=1; x<grayImage->width-1; x+=this->samplingStep)
+		{
+			// gradients are derivatives by the normalized coordinate
+			sampleX[index] = (float)((x - block.centerX) / block.scale);
+			sampleY[index] = (float)((y - block.centerY) / block.scale);
+			intensity[index] = (float)CV_IMAGE_ELEM(grayImage, unsigned char, y, x);
+			gradX[index] = (float)(((int)CV_IMAGE_ELEM(grayImage, unsigned char, y, x+1) - (int)CV_IMAGE_ELEM(grayImage, unsigned char, y, x-1)) * 0.5 * block.scale);
+			gradY[index] = (float)(((int)CV_IMAGE_ELEM(grayImage, unsigned char, y+1, x) - (int)CV_IMAGE_ELEM(grayImage, unsigned char, y-1, x)) * 0.5 * block.scale);
+			index++;
+		}
+	}
+
+	if(block.count > this->maxSampleCount)
+		this->maxSampleCount = block.count;
+
+	this->templates.push_back(block);
+	return (int)this->templates.size() - 1;
+}
+
+void MultiTemplateESM::ClearTemplates()
+{
+	this->arena.clear();
+	this->templates.clear();
+	this->maxSampleCount = 0;
+}
+
+bool MultiTemplateESM::Calculate(IplImage* grayImage)
+{
+	if(grayImage == NULL)
+		return false;
+	if(grayImage->nChannels != 1)
+		return false;
+
+	// shared frame data : intensity and central difference gradients
+	if(this->frame == NULL || this->frame->width != grayImage->width || this->frame->height != grayImage->height)
+	{
+		if(this->frame) cvReleaseImage(&this->frame);
+		if(this->gradientX) cvReleaseImage(&this->gradientX);
+		if(this->gradientY) cvReleaseImage(&this->gradientY);
+		this->frame = cvCreateImage(cvGetSize(grayImage), IPL_DEPTH_32F, 1);
+		this->gradientX = cvCreateImage(cvGetSize(grayImage), IPL_DEPTH_32F, 1);
+		this->gradientY = cvCreateImage(cvGetSize(grayImage), IPL_DEPTH_32F, 1);
+	}
+	cvConvert(grayImage, this->frame);
+	cvSobel(this->frame, this->gradientX, 1, 0, 1);
+	cvSobel(this->frame, this->gradientY, 0, 1, 1);
+	cvConvertScale(this->gradientX, this->gradientX, 0.5);
+	cvConvertScale(this->gradientY, this->gradientY, 0.5);
+
+	int templateCount = (int)this->templates.size();
+	int bufferSize = BUFFER_CHANNEL * (this->maxSampleCount > 0 ? this->maxSampleCount : 1);
+
+	#pragma omp parallel
+	{
+		std::vector<float> buffer(bufferSize);
+
+		#pragma omp for schedule(dynamic)
+		for(int i=0; i<templateCount; i++)
+		{
+			TemplateBlock* block = &this->templates[i];
+			block->aligned = false;
+			block->iteration = 0;
+			if(block->active)
+				this->AlignTemplate(block, &buffer[0]);
+		}
+	}
+
+	return true;
+}
+
+bool MultiTemplateESM::AlignTemplate(TemplateBlock* block, float* buffer)
+{
+	const int count = block->count;
+	const float* sampleX = &this->arena[block->offset];
+	const float* sampleY = sampleX + count;
+	const float* intensity = sampleY + count;
+	const float* templateGradX = intensity + count;
+	const float* templateGradY = templateGradX + count;
+
+	float* warped = buffer;
+	float* gradX = warped + count;
+	float* gradY = gradX + count;
+	float* warpedU = gradY + count;
+	float* warpedV = warpedU + count;
+	float* inverseW = warpedV + count;
+
+	// homography of the normalized sampling coordinate
+	windage::Matrix3 denormalize(block->scale, 0.0, block->centerX, 0.0, block->scale, block->centerY, 0.0, 0.0, 1.0);
+	windage::Matrix3 normalized = block->homography * denormalize;
+	if(normalized.m1[8] == 0.0)
+		return false;
+
+	double g[9];
+	for(int i=0; i<9; i++)
+		g[i] = normalized.m1[i] / normalized.m1[8];
+
+	// template corners to measure the update in pixel
+	double cornerX[4], cornerY[4];
+	cornerX[0] = -block->centerX / block->scale;	cornerY[0] = -block->centerY / block->scale;
+	cornerX[1] = -cornerX[0];						cornerY[1] = cornerY[0];
+	cornerX[2] = -cornerX[0];						cornerY[2] = -cornerY[0];
+	cornerX[3] = cornerX[0];						cornerY[3] = -cornerY[0];
+
+	const double maxU = this->frame->width - 1;
+	const double maxV = this->frame->height - 1;
+	const int widthStep = this->frame->widthStep;
+
+	double best[9];
+	double initialError = -1.0;
+	double bestError = -1.0;
+	bool converged = false;
+	int iteration = 0;
+	while(true)
+	{
+		// warp and sample the shared frame data (bilinear)
+		int validCount = 0;
+		double sumT = 0.0, sumI = 0.0, sumTT = 0.0, sumTI = 0.0;
+		for(int i=0; i<count; i++)
+		{
+			double x = sampleX[i];
+			double y = sampleY[i];
+
+			inverseW[i] = 0.0f;
+			double w = g[6]*x + g[7]*y + g[8];
+			if(w <= 0.0)
+				continue;
+			double invW = 1.0 / w;
+			double u = (g[0]*x + g[1]*y + g[2]) * invW;
+			double v = (g[3]*x + g[4]*y + g[5]) * invW;
+			if(u < 0.0 || v < 0.0 || u >= maxU || v >= maxV)
+				continue;
+
+			int iu = (int)u;
+			int iv = (int)v;
+			float a = (float)(u - iu);
+			float b = (float)(v - iv);
+			float w00 = (1.0f-a)*(1.0f-b), w01 = a*(1.0f-b), w10 = (1.0f-a)*b, w11 = a*b;
+			int offset = iv*widthStep + iu*sizeof(float);
+
+			const float* I0 = (const float*)(this->frame->imageData + offset);
+			const float* I1 = (const float*)(this->frame->imageData + offset + widthStep);
+			const float* X0 = (const float*)(this->gradientX->imageData + offset);
+			const float* X1 = (const float*)(this->gradientX->imageData + offset + widthStep);
+			const float* Y0 = (const float*)(this->gradientY->imageData + offset);
+			const float* Y1 = (const float*)(this->gradientY->imageData + offset + widthStep);
+
+			warped[i] = w00*I0[0] + w01*I0[1] + w10*I1[0] + w11*I1[1];
+			gradX[i] = w00*X0[0] + w01*X0[1] + w10*X1[0] + w11*X1[1];
+			gradY[i] = w00*Y0[0] + w01*Y0[1] + w10*Y1[0] + w11*Y1[1];
+			warpedU[i] = (float)u;
+			warpedV[i] = (float)v;
+			inverseW[i] = (float)invW;
+
+			sumT += intensity[i];
+			sumI += warped[i];
+			sumTT += intensity[i] * intensity[i];
+			sumTI += intensity[i] * warped[i];
+			validCount++;
+		}
+		if(validCount < ESM_PARAMETER_COUNT || validCount < this->minValidRatio * count)
+			break;
+
+		// illumination change : I = gain * T + bias
+		double meanT = sumT / validCount;
+		double meanI = sumI / validCount;
+		double varianceT = sumTT / validCount - meanT*meanT;
+		double covariance = sumTI / validCount - meanT*meanI;
+		if(varianceT < 1e-6 || covariance <= 0.0)
+			break;
+		double gain = covariance / varianceT;
+		double bias = meanI - gain * meanT;
+
+		// normal equation (J^T J) dx = J^T e, J = (J(image) + J(template)) / 2 * dw/dx
+		double JtJ[ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT];
+		double Jte[ESM_PARAMETER_COUNT];
+		double J[ESM_PARAMETER_COUNT];
+		double errorSum = 0.0;
+		for(int i=0; i<ESM_PARAMETER_COUNT*ESM_PARAMETER_COUNT; i++)
+			JtJ[i] = 0.0;
+		for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+			Jte[i] = 0.0;
+
+		for(int i=0; i<count; i++)
+		{
+			if(inverseW[i] == 0.0f)
+				continue;
+
+			double x = sampleX[i];
+			double y = sampleY[i];
+			double u = warpedU[i];
+			double v = warpedV[i];
+			double invW = inverseW[i];
+
+			double e = warped[i] - (gain * intensity[i] + bias);
+			errorSum += fabs(e);
+
+			// template gradient is transfered to the image by the inverse of local warp jacobian
+			double a11 = (g[0] - u*g[6]) * invW;
+			double a12 = (g[1] - u*g[7]) * invW;
+			double a21 = (g[3] - v*g[6]) * invW;
+			double a22 = (g[4] - v*g[7]) * invW;
+			double determinant = a11*a22 - a12*a21;
+			if(fabs(determinant) < 1e-12)
+				continue;
+
+			double tx = gain * templateGradX[i];
+			double ty = gain * templateGradY[i];
+			double ex = 0.5 * (gradX[i] + ( tx*a22 - ty*a21) / determinant);
+			double ey = 0.5 * (gradY[i] + (-tx*a12 + ty*a11) / determinant);
+			double r = -(ex*u + ey*v);
+
+			J[0] = ex*x*invW;	J[1] = ex*y*invW;	J[2] = ex*invW;
+			J[3] = ey*x*invW;	J[4] = ey*y*invW;	J[5] = ey*invW;
+			J[6] = r*x*invW;	J[7] = r*y*invW;
+
+			for(int j=0; j<ESM_PARAMETER_COUNT; j++)
+			{
+				Jte[j] += J[j] * e;
+				for(int k=j; k<ESM_PARAMETER_COUNT; k++)
+					JtJ[j*ESM_PARAMETER_COUNT + k] += J[j] * J[k];
+			}
+		}
+		for(int j=0; j<ESM_PARAMETER_COUNT; j++)
+			for(int k=0; k<j; k++)
+				JtJ[j*ESM_PARAMETER_COUNT + k] = JtJ[k*ESM_PARAMETER_COUNT + j];
+
+		double error = errorSum / validCount;
+		if(initialError < 0.0)
+			initialError = error;
+		if(bestError < 0.0 || error < bestError)
+		{
+			bestError = error;
+			for(int i=0; i<9; i++)
+				best[i] = g[i];
+		}
+
+		if(converged || iteration >= this->maxIteration)
+			break;
+
+		double dx[ESM_PARAMETER_COUNT];
+		if(!SolveCholesky8(JtJ, Jte, dx))
+			break;
+
+		double previous[9];
+		for(int i=0; i<9; i++)
+			previous[i] = g[i];
+		for(int i=0; i<ESM_PARAMETER_COUNT; i++)
+			g[i] -= dx[i];
+		iteration++;
+
+		// the largest motion of the template corners
+		double delta = 0.0;
+		for(int i=0; i<4; i++)
+		{
+			double w1 = previous[6]*cornerX[i] + previous[7]*cornerY[i] + previous[8];
+			double w2 = g[6]*cornerX[i] + g[7]*cornerY[i] + g[8];
+			double du = (g[0]*cornerX[i] + g[1]*cornerY[i] + g[2])/w2 - (previous[0]*cornerX[i] + previous[1]*cornerY[i] + previous[2])/w1;
+			double dv = (g[3]*cornerX[i] + g[4]*cornerY[i] + g[5])/w2 - (previous[3]*cornerX[i] + previous[4]*cornerY[i] + previous[5])/w1;
+			double distance = sqrt(du*du + dv*dv);
+			if(distance > delta)
+				delta = distance;
+		}
+		converged = delta < this->convergenceDelta;
+	}
+
+	block->iteration = iteration;
+	if(initialError < 0.0)
+		return false;
+
+	// keep the initial homography when the error is not reduced
+	block->error = bestError;
+	if(bestError >= initialError)
+		return false;
+
+	windage::Matrix3 result(best[0], best[1], best[2], best[3], best[4], best[5], best[6], best[7], best[8]);
+	windage::Matrix3 normalize(1.0/block->scale, 0.0, -block->centerX/block->scale, 0.0, 1.0/block->scale, -block->centerY/block->scale, 0.0, 0.0, 1.0);
+	block->homography = result * normalize;
+	block->aligned = true;
+
+	return true;
+}
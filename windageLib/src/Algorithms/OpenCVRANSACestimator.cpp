@@ -58,7 +58,6 @@ bool OpenCVRANSACestimator::Calculate()
 	double cy = this->cameraParameter->GetParameters()[3];
 
 	int idx[SAMPLE_SIZE];
-	CvRNG rng = cvRNG(cvGetTickCount());
 	int pre_inliers = 0;
 
 	CvMat* samplingRef = cvCreateMat(SAMPLE_SIZE, 3, CV_64FC1);
@@ -87,7 +86,7 @@ bool OpenCVRANSACestimator::Calculate()
 			bool found = true;
 			while(found)
 			{
-				tempIndex = cvRandInt(&rng) % n;
+				tempIndex = cvRandInt(&this->rng) % n;
 				found = false;
 				for(int j=0; j<i; j++)
 				{
@@ -45,6 +45,14 @@
 using namespace windage;
 using namespace windage::Algorithms;
 
+void OpenSURFdetector::Release()
+{
+	if(this->fastHessian) delete this->fastHessian;
+	this->fastHessian = NULL;
+	if(this->ipts) delete this->ipts;
+	this->ipts = NULL;
+}
+
 bool OpenSURFdetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 {
 	if(grayImage == NULL)
@@ -54,14 +62,29 @@ bool OpenSURFdetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 
 	this->keypoints.clear();
 
-	IpVec ipts;
-	surfDetDes(grayImage, ipts, false, 5, 4, 2, this->threshold);
+	if(this->fastHessian == NULL)
+	{
+		this->ipts = new IpVec();
+		this->fastHessian = new FastHessian(*this->ipts);
+	}
+
+	// same as surfDetDes(grayImage, ipts, false, 5, 4, 2, threshold)
+	// except the fast hessian object (response layers) is reused between frames
+	IplImage* integralImage = Integral(grayImage);
+	this->fastHessian->saveParameters(5, 4, 2, (float)this->threshold);
+	this->fastHessian->setIntImage(integralImage);
+	this->fastHessian->getIpoints();
+
+	Surf descriptor(integralImage, *this->ipts);
+	descriptor.getDescriptors(false);
+
+	cvReleaseImage(&integralImage);
 
 	Ipoint *ipt;
 	windage::OpenSURFpoint point;
-	for(unsigned int i = 0; i < ipts.size(); i++) 
+	for(unsigned int i = 0; i < this->ipts->size(); i++) 
 	{
-		ipt = &ipts.at(i);
+		ipt = &this->ipts->at(i);
 
 		point.SetPoint(windage::Vector3(ipt->x, ipt->y, 1.0));
 		point.SetSize(2.5f * ipt->scale);
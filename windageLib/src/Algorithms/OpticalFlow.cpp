@@ -65,6 +65,45 @@ void OpticalFlow::Initialize(int width, int height, CvSize windowSize, int pyram
 	pyramid2 = cvCreateImage(this->GetImageSize(), IPL_DEPTH_8U, 1);
 }
 
+bool OpticalFlow::BuildPyramid(IplImage* grayImage, IplImage* pyramidBuffer, int pyramidLevel, IplImage* levelHeaders)
+{
+	if(grayImage == NULL || pyramidBuffer == NULL)
+		return false;
+	if(grayImage->nChannels != 1 || grayImage->depth != IPL_DEPTH_8U)
+		return false;
+
+	// same as the pyramid layout of cvCalcOpticalFlowPyrLK :
+	// each level is (size+1)/2 of the upper level, row step aligned to 8 bytes and stored consecutively
+	const int ALIGN = 8;
+	int bufferSize = pyramidBuffer->widthStep * pyramidBuffer->height;
+
+	std::vector<IplImage> localHeaders;
+	if(levelHeaders == NULL)
+	{
+		localHeaders.resize(pyramidLevel);
+		levelHeaders = &localHeaders[0];
+	}
+
+	IplImage* upperImage = grayImage;
+	int offset = 0;
+	for(int i=1; i<=pyramidLevel; i++)
+	{
+		CvSize levelSize = cvSize((upperImage->width + 1) >> 1, (upperImage->height + 1) >> 1);
+		int levelStep = (levelSize.width + ALIGN - 1) & -ALIGN;
+		if(offset + levelStep * levelSize.height > bufferSize)
+			return false;
+
+		cvInitImageHeader(&levelHeaders[i-1], levelSize, IPL_DEPTH_8U, 1);
+		cvSetData(&levelHeaders[i-1], pyramidBuffer->imageData + offset, levelStep);
+		cvPyrDown(upperImage, &levelHeaders[i-1], CV_GAUSSIAN_5x5);
+
+		offset += levelStep * levelSize.height;
+		upperImage = &levelHeaders[i-1];
+	}
+
+	return true;
+}
+
 int OpticalFlow::TrackFeatures(IplImage* prevGrayImage, IplImage* currGrayImage, std::vector<FeaturePoint>* prevPoints, std::vector<FeaturePoint>* currPoints)
 {
 	int pointCount = MIN((int)prevPoints->size(), this->MAX_POINT_COUNT);
@@ -79,7 +118,22 @@ int OpticalFlow::TrackFeatures(IplImage* prevGrayImage, IplImage* currGrayImage,
 		for(int i=0; i<pointCount; i++)
 			this->feature1[i] = cvPoint2D32f((*prevPoints)[i].GetPoint().x, (*prevPoints)[i].GetPoint().y);
 
-		cvCalcOpticalFlowPyrLK(tempPrev, tempCurr, pyramid1, pyramid2, feature1, feature2, pointCount, this->windowSize, this->pyramidLevel, foundFeature, errorFeature, terminationCriteria, 0);
+		// use the attatched pyramids if it was built already
+		int flags = 0;
+		IplImage* prevPyramid = pyramid1;
+		IplImage* currPyramid = pyramid2;
+		if(this->attatchedPyramid1)
+		{
+			prevPyramid = this->attatchedPyramid1;
+			flags |= CV_LKFLOW_PYR_A_READY;
+		}
+		if(this->attatchedPyramid2)
+		{
+			currPyramid = this->attatchedPyramid2;
+			flags |= CV_LKFLOW_PYR_B_READY;
+		}
+
+		cvCalcOpticalFlowPyrLK(tempPrev, tempCurr, prevPyramid, currPyramid, feature1, feature2, pointCount, this->windowSize, this->pyramidLevel, foundFeature, errorFeature, terminationCriteria, flags);
 
 		cvReleaseImage(&tempPrev);
 		cvReleaseImage(&tempCurr);
@@ -69,7 +69,6 @@ bool ProSACestimator::Calculate()
 	CvMat samplingObjectPoints = cvMat(1, 4, CV_64FC2, &(samplingObject[0]));
 	CvMat samplingReferencePoints = cvMat(1, 4, CV_64FC2, &(samplingReference[0]));
 
-	CvRNG rng = cvRNG(cvGetTickCount());
 	int bestCount = 0;
 	int count = (int)this->referencePoints->size();
 
@@ -109,10 +108,10 @@ bool ProSACestimator::Calculate()
 		int index[4] = {-1, -1, -1, -1};
 		for(int j=0; j<4; j++)
 		{
-			int tempIndex = cvRandInt(&rng) % samplingCount;
+			int tempIndex = cvRandInt(&this->rng) % samplingCount;
 			while(index[0] == tempIndex || index[1] == tempIndex || index[2] == tempIndex)
 			{
-				tempIndex = cvRandInt(&rng) % samplingCount;						
+				tempIndex = cvRandInt(&this->rng) % samplingCount;						
 			}
 			index[j] = tempIndex;
 		}
@@ -0,0 +1,735 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "Algorithms/SIFT/wsift.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define W_SIFT_SSE2
+	#include <emmintrin.h>
+#endif
+
+#define W_SIFT_DESCR_LENGTH (SIFT_DESCR_WIDTH * SIFT_DESCR_WIDTH * SIFT_DESCR_HIST_BINS)
+
+/* Row band height of a task for the extrema detection */
+#define W_SIFT_BAND_ROWS 32
+
+/* detection data of a scale space extremum before the orientation assignment */
+struct wSIFTCandidate
+{
+	int octave;
+	int interval;
+	int r;
+	int c;
+	double x;				// position at the input image
+	double y;
+	double scale;			// scale at the input image
+	double scaleOctave;		// scale relative to the octave
+};
+
+/* orientations assigned to a candidate, a feature is generated per orientation */
+struct wSIFTOrientation
+{
+	int count;
+	float orientation[SIFT_ORI_HIST_BINS];
+};
+
+struct wCompareScaleGreater
+{
+	bool operator()( const wSIFTCandidate& a, const wSIFTCandidate& b ) const
+	{
+		return a.scale > b.scale;
+	}
+};
+
+static inline float wPixel( const IplImage* image, int r, int c )
+{
+	return ((const float*)(image->imageData + image->widthStep*r))[c];
+}
+
+static inline IplImage* wGaussLevel( wSIFTPyramid* pyramid, int octave, int interval )
+{
+	return pyramid->gauss[octave*(pyramid->intervals + 3) + interval];
+}
+
+static inline IplImage* wDoGLevel( wSIFTPyramid* pyramid, int octave, int interval )
+{
+	return pyramid->dog[octave*(pyramid->intervals + 2) + interval];
+}
+
+wSIFTPyramid* wCreateSIFTPyramid( int width, int height, int intervals, bool doubleImage )
+{
+	wSIFTPyramid* pyramid = new wSIFTPyramid();
+	pyramid->width = width;
+	pyramid->height = height;
+	pyramid->intervals = intervals;
+	pyramid->doubleImage = doubleImage;
+
+	CvSize size = doubleImage ? cvSize(width*2, height*2) : cvSize(width, height);
+
+	// smallest dimension of top level is ~4 pixels
+	pyramid->octaves = (int)(log( (double)MIN( size.width, size.height ) ) / log(2.0) - 2);
+	if(pyramid->octaves < 1)
+		pyramid->octaves = 1;
+
+	pyramid->input = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 1);
+	pyramid->buffer = cvCreateImage(size, IPL_DEPTH_32F, 1);
+	pyramid->gauss.resize(pyramid->octaves * (intervals + 3));
+	pyramid->dog.resize(pyramid->octaves * (intervals + 2));
+	for(int o=0; o<pyramid->octaves; o++)
+	{
+		for(int i=0; i<intervals+3; i++)
+			pyramid->gauss[o*(intervals+3) + i] = cvCreateImage(size, IPL_DEPTH_32F, 1);
+		for(int i=0; i<intervals+2; i++)
+			pyramid->dog[o*(intervals+2) + i] = cvCreateImage(size, IPL_DEPTH_32F, 1);
+
+		size = cvSize(size.width/2, size.height/2);
+	}
+
+	return pyramid;
+}
+
+void wReleaseSIFTPyramid( wSIFTPyramid** pyramid )
+{
+	if(pyramid == NULL || *pyramid == NULL)
+		return;
+
+	for(unsigned int i=0; i<(*pyramid)->gauss.size(); i++)
+		cvReleaseImage(&(*pyramid)->gauss[i]);
+	for(unsigned int i=0; i<(*pyramid)->dog.size(); i++)
+		cvReleaseImage(&(*pyramid)->dog[i]);
+	cvReleaseImage(&(*pyramid)->input);
+	cvReleaseImage(&(*pyramid)->buffer);
+
+	delete *pyramid;
+	*pyramid = NULL;
+}
+
+/* half of the normalized gaussian kernel, kernel[j] is the weight at +-j */
+static void wGaussianKernel( double sigma, std::vector<float>& kernel )
+{
+	int radius = MAX(1, cvRound(sigma * 4.0));
+	kernel.resize(radius + 1);
+
+	double sum = 0.0;
+	std::vector<double> weight(radius + 1);
+	for( int j = 0; j <= radius; j++ )
+	{
+		weight[j] = exp( -0.5 * j * j / (sigma * sigma) );
+		sum += (j == 0) ? weight[j] : 2.0 * weight[j];
+	}
+	for( int j = 0; j <= radius; j++ )
+		kernel[j] = (float)(weight[j] / sum);
+}
+
+/* one tap of the horizontal pass with the replicated border */
+static inline float wClampedTap( const float* line, int x, int length, const float* kernel, int radius )
+{
+	float sum = kernel[0] * line[x];
+	for( int j = 1; j <= radius; j++ )
+		sum += kernel[j] * (line[MAX(x - j, 0)] + line[MIN(x + j, length - 1)]);
+	return sum;
+}
+
+/*
+ separable gaussian smoothing with the replicated border,
+ rows of each pass are computed in parallel and the inner loops use SSE2 when it is available
+ (buffer is at least as large as src, src and dst can be the same image)
+*/
+void wGaussianBlur( const IplImage* src, IplImage* dst, IplImage* buffer, double sigma )
+{
+	std::vector<float> kernelBuffer;
+	wGaussianKernel( sigma, kernelBuffer );
+	const float* kernel = &kernelBuffer[0];
+	const int radius = (int)kernelBuffer.size() - 1;
+	const int width = src->width;
+	const int height = src->height;
+
+	// horizontal pass (src -> buffer)
+	#pragma omp parallel for schedule(dynamic, 16)
+	for( int y = 0; y < height; y++ )
+	{
+		const float* in = (const float*)(src->imageData + src->widthStep*y);
+		float* out = (float*)(buffer->imageData + buffer->widthStep*y);
+		const int end = width - radius;
+
+		int x = 0;
+		for( ; x < MIN(radius, width); x++ )
+			out[x] = wClampedTap( in, x, width, kernel, radius );
+#ifdef W_SIFT_SSE2
+		for( ; x + 4 <= end; x += 4 )
+		{
+			__m128 sum = _mm_mul_ps( _mm_loadu_ps(in + x), _mm_set1_ps(kernel[0]) );
+			for( int j = 1; j <= radius; j++ )
+			{
+				__m128 pair = _mm_add_ps( _mm_loadu_ps(in + x - j), _mm_loadu_ps(in + x + j) );
+				sum = _mm_add_ps( sum, _mm_mul_ps( pair, _mm_set1_ps(kernel[j]) ) );
+			}
+			_mm_storeu_ps( out + x, sum );
+		}
+#endif
+		for( ; x < end; x++ )
+		{
+			float sum = kernel[0] * in[x];
+			for( int j = 1; j <= radius; j++ )
+				sum += kernel[j] * (in[x - j] + in[x + j]);
+			out[x] = sum;
+		}
+		for( ; x < width; x++ )
+			out[x] = wClampedTap( in, x, width, kernel, radius );
+	}
+
+	// vertical pass (buffer -> dst), accumulate the symmetric row pairs
+	#pragma omp parallel for schedule(dynamic, 16)
+	for( int y = 0; y < height; y++ )
+	{
+		const float* center = (const float*)(buffer->imageData + buffer->widthStep*y);
+		float* out = (float*)(dst->imageData + dst->widthStep*y);
+
+		int x = 0;
+#ifdef W_SIFT_SSE2
+		__m128 k0 = _mm_set1_ps(kernel[0]);
+		for( ; x + 4 <= width; x += 4 )
+			_mm_storeu_ps( out + x, _mm_mul_ps( _mm_loadu_ps(center + x), k0 ) );
+#endif
+		for( ; x < width; x++ )
+			out[x] = kernel[0] * center[x];
+
+		for( int j = 1; j <= radius; j++ )
+		{
+			const float* up = (const float*)(buffer->imageData + buffer->widthStep*MAX(y - j, 0));
+			const float* down = (const float*)(buffer->imageData + buffer->widthStep*MIN(y + j, height - 1));
+
+			x = 0;
+#ifdef W_SIFT_SSE2
+			__m128 kj = _mm_set1_ps(kernel[j]);
+			for( ; x + 4 <= width; x += 4 )
+			{
+				__m128 pair = _mm_add_ps( _mm_loadu_ps(up + x), _mm_loadu_ps(down + x) );
+				_mm_storeu_ps( out + x, _mm_add_ps( _mm_loadu_ps(out + x), _mm_mul_ps( pair, kj ) ) );
+			}
+#endif
+			for( ; x < width; x++ )
+				out[x] += kernel[j] * (up[x] + down[x]);
+		}
+	}
+}
+
+/* nearest neighbor half size downsampling */
+static void wDownsample( const IplImage* src, IplImage* dst )
+{
+	#pragma omp parallel for schedule(dynamic, 16)
+	for( int y = 0; y < dst->height; y++ )
+	{
+		const float* in = (const float*)(src->imageData + src->widthStep*(y*2));
+		float* out = (float*)(dst->imageData + dst->widthStep*y);
+		for( int x = 0; x < dst->width; x++ )
+			out[x] = in[x*2];
+	}
+}
+
+static void wBuildScaleSpace( const IplImage* grayImage, wSIFTPyramid* pyramid, double sigma )
+{
+	const int intervals = pyramid->intervals;
+
+	// base level
+	IplImage* base = wGaussLevel(pyramid, 0, 0);
+	cvConvertScale(grayImage, pyramid->input, 1.0 / 255.0, 0);
+	if(pyramid->doubleImage)
+	{
+		cvResize(pyramid->input, base, CV_INTER_CUBIC);
+		wGaussianBlur(base, base, pyramid->buffer, sqrt( sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA * 4 ));
+	}
+	else
+	{
+		wGaussianBlur(pyramid->input, base, pyramid->buffer, sqrt( sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA ));
+	}
+
+	// \sigma_{total}^2 = \sigma_{i}^2 + \sigma_{i-1}^2
+	std::vector<double> sig(intervals + 3);
+	double k = pow( 2.0, 1.0 / intervals );
+	sig[0] = sigma;
+	for( int i = 1; i < intervals + 3; i++ )
+	{
+		double sigPrev = pow( k, i - 1 ) * sigma;
+		double sigTotal = sigPrev * k;
+		sig[i] = sqrt( sigTotal * sigTotal - sigPrev * sigPrev );
+	}
+
+	// each level depends on the previous one, so the rows of each level are parallelized instead
+	for( int o = 0; o < pyramid->octaves; o++ )
+	{
+		for( int i = 0; i < intervals + 3; i++ )
+		{
+			if( o == 0 && i == 0 )
+				continue;
+			else if( i == 0 )
+				wDownsample( wGaussLevel(pyramid, o-1, intervals), wGaussLevel(pyramid, o, 0) );
+			else
+				wGaussianBlur( wGaussLevel(pyramid, o, i-1), wGaussLevel(pyramid, o, i), pyramid->buffer, sig[i] );
+		}
+	}
+
+	// difference of gaussian levels are independent
+	const int dogCount = pyramid->octaves * (intervals + 2);
+	#pragma omp parallel for schedule(dynamic)
+	for( int n = 0; n < dogCount; n++ )
+	{
+		int o = n / (intervals + 2);
+		int i = n % (intervals + 2);
+		const IplImage* g0 = wGaussLevel(pyramid, o, i);
+		const IplImage* g1 = wGaussLevel(pyramid, o, i+1);
+		IplImage* dog = wDoGLevel(pyramid, o, i);
+
+		for( int y = 0; y < dog->height; y++ )
+		{
+			const float* a = (const float*)(g0->imageData + g0->widthStep*y);
+			const float* b = (const float*)(g1->imageData + g1->widthStep*y);
+			float* out = (float*)(dog->imageData + dog->widthStep*y);
+
+			int x = 0;
+#ifdef W_SIFT_SSE2
+			for( ; x + 4 <= dog->width; x += 4 )
+				_mm_storeu_ps( out + x, _mm_sub_ps( _mm_loadu_ps(b + x), _mm_loadu_ps(a + x) ) );
+#endif
+			for( ; x < dog->width; x++ )
+				out[x] = b[x] - a[x];
+		}
+	}
+}
+
+static bool wIsExtremum( wSIFTPyramid* pyramid, int octave, int interval, int r, int c, float value )
+{
+	for( int i = -1; i <= 1; i++ )
+	{
+		const IplImage* dog = wDoGLevel(pyramid, octave, interval + i);
+		for( int j = -1; j <= 1; j++ )
+		{
+			const float* row = (const float*)(dog->imageData + dog->widthStep*(r + j));
+			if( value > 0 )
+			{
+				if( value < row[c-1] || value < row[c] || value < row[c+1] )
+					return false;
+			}
+			else
+			{
+				if( value > row[c-1] || value > row[c] || value > row[c+1] )
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* solves H * x = -dD of the 3D quadratic fitting, returns false when the hessian is singular */
+static bool wInterpolateStep( wSIFTPyramid* pyramid, int octave, int interval, int r, int c, double x[3], double dD[3] )
+{
+	const IplImage* prev = wDoGLevel(pyramid, octave, interval - 1);
+	const IplImage* curr = wDoGLevel(pyramid, octave, interval);
+	const IplImage* next = wDoGLevel(pyramid, octave, interval + 1);
+
+	double v = wPixel(curr, r, c);
+	dD[0] = ( wPixel(curr, r, c+1) - wPixel(curr, r, c-1) ) / 2.0;
+	dD[1] = ( wPixel(curr, r+1, c) - wPixel(curr, r-1, c) ) / 2.0;
+	dD[2] = ( wPixel(next, r, c) - wPixel(prev, r, c) ) / 2.0;
+
+	double dxx = wPixel(curr, r, c+1) + wPixel(curr, r, c-1) - 2 * v;
+	double dyy = wPixel(curr, r+1, c) + wPixel(curr, r-1, c) - 2 * v;
+	double dss = wPixel(next, r, c) + wPixel(prev, r, c) - 2 * v;
+	double dxy = ( wPixel(curr, r+1, c+1) - wPixel(curr, r+1, c-1) - wPixel(curr, r-1, c+1) + wPixel(curr, r-1, c-1) ) / 4.0;
+	double dxs = ( wPixel(next, r, c+1) - wPixel(next, r, c-1) - wPixel(prev, r, c+1) + wPixel(prev, r, c-1) ) / 4.0;
+	double dys = ( wPixel(next, r+1, c) - wPixel(next, r-1, c) - wPixel(prev, r+1, c) + wPixel(prev, r-1, c) ) / 4.0;
+
+	// inverse of the symmetric 3x3 hessian by cofactors
+	double c00 = dyy*dss - dys*dys;
+	double c01 = dxs*dys - dxy*dss;
+	double c02 = dxy*dys - dxs*dyy;
+	double det = dxx*c00 + dxy*c01 + dxs*c02;
+	if( fabs(det) < DBL_EPSILON )
+		return false;
+
+	double c11 = dxx*dss - dxs*dxs;
+	double c12 = dxy*dxs - dxx*dys;
+	double c22 = dxx*dyy - dxy*dxy;
+
+	x[0] = -( c00*dD[0] + c01*dD[1] + c02*dD[2] ) / det;
+	x[1] = -( c01*dD[0] + c11*dD[1] + c12*dD[2] ) / det;
+	x[2] = -( c02*dD[0] + c12*dD[1] + c22*dD[2] ) / det;
+	return true;
+}
+
+static bool wIsTooEdgeLike( const IplImage* dog, int r, int c, int curvatureThreshold )
+{
+	double d = wPixel(dog, r, c);
+	double dxx = wPixel(dog, r, c+1) + wPixel(dog, r, c-1) - 2 * d;
+	double dyy = wPixel(dog, r+1, c) + wPixel(dog, r-1, c) - 2 * d;
+	double dxy = ( wPixel(dog, r+1, c+1) - wPixel(dog, r+1, c-1) - wPixel(dog, r-1, c+1) + wPixel(dog, r-1, c-1) ) / 4.0;
+	double tr = dxx + dyy;
+	double det = dxx * dyy - dxy * dxy;
+
+	if( det <= 0 )
+		return true;
+	if( tr * tr / det < ( curvatureThreshold + 1.0 )*( curvatureThreshold + 1.0 ) / curvatureThreshold )
+		return false;
+	return true;
+}
+
+static bool wInterpolateExtremum( wSIFTPyramid* pyramid, int octave, int interval, int r, int c,
+								  double contrastThreshold, int curvatureThreshold, double sigma, wSIFTCandidate* candidate )
+{
+	const int intervals = pyramid->intervals;
+	const IplImage* dog = wDoGLevel(pyramid, octave, 0);
+	double x[3] = {0, 0, 0};
+	double dD[3] = {0, 0, 0};
+
+	int step = 0;
+	while( step < SIFT_MAX_INTERP_STEPS )
+	{
+		if( !wInterpolateStep( pyramid, octave, interval, r, c, x, dD ) )
+			return false;
+		if( fabs(x[0]) < 0.5 && fabs(x[1]) < 0.5 && fabs(x[2]) < 0.5 )
+			break;
+
+		c += cvRound( x[0] );
+		r += cvRound( x[1] );
+		interval += cvRound( x[2] );
+		if( interval < 1 || interval > intervals ||
+			c < SIFT_IMG_BORDER || r < SIFT_IMG_BORDER ||
+			c >= dog->width - SIFT_IMG_BORDER || r >= dog->height - SIFT_IMG_BORDER )
+		{
+			return false;
+		}
+		step++;
+	}
+	if( step >= SIFT_MAX_INTERP_STEPS )
+		return false;
+
+	double contrast = wPixel(wDoGLevel(pyramid, octave, interval), r, c) + 0.5 * (dD[0]*x[0] + dD[1]*x[1] + dD[2]*x[2]);
+	if( fabs(contrast) < contrastThreshold )
+		return false;
+	if( wIsTooEdgeLike( wDoGLevel(pyramid, octave, interval), r, c, curvatureThreshold ) )
+		return false;
+
+	double scaleRatio = pyramid->doubleImage ? 0.5 : 1.0;
+	double octaveScale = pow( 2.0, octave );
+	double subInterval = interval + x[2];
+
+	candidate->octave = octave;
+	candidate->interval = interval;
+	candidate->r = r;
+	candidate->c = c;
+	candidate->x = ( c + x[0] ) * octaveScale * scaleRatio;
+	candidate->y = ( r + x[1] ) * octaveScale * scaleRatio;
+	candidate->scaleOctave = sigma * pow( 2.0, subInterval / intervals );
+	candidate->scale = candidate->scaleOctave * octaveScale * scaleRatio;
+	return true;
+}
+
+static inline bool wGradient( const IplImage* image, int r, int c, float* dx, float* dy )
+{
+	if( r <= 0 || r >= image->height - 1 || c <= 0 || c >= image->width - 1 )
+		return false;
+
+	const float* row = (const float*)(image->imageData + image->widthStep*r);
+	*dx = row[c+1] - row[c-1];
+	*dy = wPixel(image, r-1, c) - wPixel(image, r+1, c);
+	return true;
+}
+
+static void wAssignOrientations( const IplImage* image, const wSIFTCandidate& candidate, wSIFTOrientation* result )
+{
+	const int n = SIFT_ORI_HIST_BINS;
+	const double PI2 = CV_PI * 2.0;
+	const int radius = cvRound( SIFT_ORI_RADIUS * candidate.scaleOctave );
+	const double sigma = SIFT_ORI_SIG_FCTR * candidate.scaleOctave;
+	const double expDenom = 2.0 * sigma * sigma;
+
+	double hist[SIFT_ORI_HIST_BINS];
+	for( int i = 0; i < n; i++ )
+		hist[i] = 0.0;
+
+	float dx, dy;
+	for( int i = -radius; i <= radius; i++ )
+	{
+		for( int j = -radius; j <= radius; j++ )
+		{
+			if( wGradient( image, candidate.r + i, candidate.c + j, &dx, &dy ) )
+			{
+				double w = exp( -( i*i + j*j ) / expDenom );
+				int bin = cvRound( n * ( atan2( (double)dy, (double)dx ) + CV_PI ) / PI2 );
+				bin = ( bin < n ) ? bin : 0;
+				hist[bin] += w * sqrt( (double)(dx*dx + dy*dy) );
+			}
+		}
+	}
+
+	for( int pass = 0; pass < SIFT_ORI_SMOOTH_PASSES; pass++ )
+	{
+		double prev = hist[n-1];
+		double h0 = hist[0];
+		for( int i = 0; i < n; i++ )
+		{
+			double tmp = hist[i];
+			hist[i] = 0.25 * prev + 0.5 * hist[i] + 0.25 * ( ( i+1 == n ) ? h0 : hist[i+1] );
+			prev = tmp;
+		}
+	}
+
+	double omax = hist[0];
+	for( int i = 1; i < n; i++ )
+		omax = MAX( omax, hist[i] );
+
+	double threshold = omax * SIFT_ORI_PEAK_RATIO;
+	result->count = 0;
+	for( int i = 0; i < n; i++ )
+	{
+		int l = ( i == 0 ) ? n - 1 : i - 1;
+		int r = ( i + 1 ) % n;
+		if( hist[i] > hist[l] && hist[i] > hist[r] && hist[i] >= threshold )
+		{
+			double bin = i + 0.5 * (hist[l] - hist[r]) / (hist[l] - 2.0*hist[i] + hist[r]);
+			bin = ( bin < 0 ) ? n + bin : ( bin >= n ) ? bin - n : bin;
+			result->orientation[result->count++] = (float)(( PI2 * bin ) / n - CV_PI);
+		}
+	}
+}
+
+/*
+ descriptor histograms are accumulated at a padded (d+2) x (d+2) x (n+2) array on the stack,
+ the padding absorbs the trilinear interpolation spill at the border bins so no allocation and bound check are required
+*/
+static void wComputeDescriptor( const IplImage* image, const wSIFTCandidate& candidate, float orientation, float* descriptor )
+{
+	const int d = SIFT_DESCR_WIDTH;
+	const int n = SIFT_DESCR_HIST_BINS;
+	const int rowStep = (d + 2) * (n + 2);
+	const int colStep = n + 2;
+	const double PI2 = 2.0 * CV_PI;
+
+	float hist[(SIFT_DESCR_WIDTH + 2) * (SIFT_DESCR_WIDTH + 2) * (SIFT_DESCR_HIST_BINS + 2)];
+	memset( hist, 0, sizeof(hist) );
+
+	double cosT = cos( (double)orientation );
+	double sinT = sin( (double)orientation );
+	double binsPerRad = n / PI2;
+	double expDenom = d * d * 0.5;
+	double histWidth = SIFT_DESCR_SCL_FCTR * candidate.scaleOctave;
+	int radius = (int)(histWidth * sqrt(2.0) * ( d + 1.0 ) * 0.5 + 0.5);
+
+	float dx, dy;
+	for( int i = -radius; i <= radius; i++ )
+	{
+		for( int j = -radius; j <= radius; j++ )
+		{
+			double cRot = ( j * cosT - i * sinT ) / histWidth;
+			double rRot = ( j * sinT + i * cosT ) / histWidth;
+			double rbin = rRot + d / 2 - 0.5;
+			double cbin = cRot + d / 2 - 0.5;
+
+			if( rbin > -1.0 && rbin < d && cbin > -1.0 && cbin < d &&
+				wGradient( image, candidate.r + i, candidate.c + j, &dx, &dy ) )
+			{
+				double gradOri = atan2( (double)dy, (double)dx ) - orientation;
+				while( gradOri < 0.0 )
+					gradOri += PI2;
+				while( gradOri >= PI2 )
+					gradOri -= PI2;
+
+				double obin = gradOri * binsPerRad;
+				double mag = sqrt( (double)(dx*dx + dy*dy) ) * exp( -(cRot * cRot + rRot * rRot) / expDenom );
+
+				int r0 = cvFloor( rbin );
+				int c0 = cvFloor( cbin );
+				int o0 = cvFloor( obin );
+				float dr = (float)(rbin - r0);
+				float dc = (float)(cbin - c0);
+				float dor = (float)(obin - o0);
+				float v = (float)mag;
+
+				// r0, c0 in [-1, d-1] are stored at [0, d] of the padded array
+				float* h = hist + (r0 + 1) * rowStep + (c0 + 1) * colStep + o0;
+				float vr1 = v * dr,		vr0 = v - vr1;
+				float vrc11 = vr1 * dc,	vrc10 = vr1 - vrc11;
+				float vrc01 = vr0 * dc,	vrc00 = vr0 - vrc01;
+
+				h[0]							+= vrc00 * (1.0f - dor);
+				h[1]							+= vrc00 * dor;
+				h[colStep]						+= vrc01 * (1.0f - dor);
+				h[colStep + 1]					+= vrc01 * dor;
+				h[rowStep]						+= vrc10 * (1.0f - dor);
+				h[rowStep + 1]					+= vrc10 * dor;
+				h[rowStep + colStep]			+= vrc11 * (1.0f - dor);
+				h[rowStep + colStep + 1]		+= vrc11 * dor;
+			}
+		}
+	}
+
+	// fold the orientation wrap-around and copy the inner bins
+	int k = 0;
+	for( int r = 1; r <= d; r++ )
+	{
+		for( int c = 1; c <= d; c++ )
+		{
+			float* h = hist + r * rowStep + c * colStep;
+			h[0] += h[n];
+			for( int o = 0; o < n; o++ )
+				descriptor[k++] = h[o];
+		}
+	}
+
+	// normalize, clamp large gradient and re-normalize (unit length as SiftGPU)
+	for( int pass = 0; pass < 2; pass++ )
+	{
+		double lengthSq = 0.0;
+		for( int i = 0; i < W_SIFT_DESCR_LENGTH; i++ )
+			lengthSq += descriptor[i] * descriptor[i];
+
+		float lengthInv = (lengthSq > 0.0) ? (float)(1.0 / sqrt( lengthSq )) : 0.0f;
+		for( int i = 0; i < W_SIFT_DESCR_LENGTH; i++ )
+		{
+			descriptor[i] *= lengthInv;
+			if( pass == 0 && descriptor[i] > SIFT_DESCR_MAG_THR )
+				descriptor[i] = (float)SIFT_DESCR_MAG_THR;
+		}
+	}
+}
+
+int wExtractSIFT( const IplImage* grayImage, wSIFTPyramid* pyramid, std::vector<wSIFTFeature>* features,
+				  double contrastThreshold, double sigma, int curvatureThreshold )
+{
+	if( grayImage == NULL || pyramid == NULL || features == NULL )
+		return -1;
+	if( grayImage->nChannels != 1 || grayImage->depth != IPL_DEPTH_8U )
+		return -1;
+	if( grayImage->width != pyramid->width || grayImage->height != pyramid->height )
+		return -1;
+
+	features->clear();
+	wBuildScaleSpace( grayImage, pyramid, sigma );
+
+	// extrema detection, tasks are row bands of each (octave, interval) and merged at the task order
+	const int intervals = pyramid->intervals;
+	const float prelimThreshold = (float)(0.5 * contrastThreshold);
+	std::vector<int> taskOctave, taskInterval, taskRow;
+	for( int o = 0; o < pyramid->octaves; o++ )
+	{
+		int height = wDoGLevel(pyramid, o, 0)->height;
+		for( int i = 1; i <= intervals; i++ )
+		{
+			for( int r = SIFT_IMG_BORDER; r < height - SIFT_IMG_BORDER; r += W_SIFT_BAND_ROWS )
+			{
+				taskOctave.push_back(o);
+				taskInterval.push_back(i);
+				taskRow.push_back(r);
+			}
+		}
+	}
+
+	const int taskCount = (int)taskOctave.size();
+	std::vector<std::vector<wSIFTCandidate> > found(taskCount);
+
+	#pragma omp parallel for schedule(dynamic)
+	for( int t = 0; t < taskCount; t++ )
+	{
+		const int o = taskOctave[t];
+		const int i = taskInterval[t];
+		const IplImage* dog = wDoGLevel(pyramid, o, i);
+		const int rowEnd = MIN( taskRow[t] + W_SIFT_BAND_ROWS, dog->height - SIFT_IMG_BORDER );
+
+		wSIFTCandidate candidate;
+		for( int r = taskRow[t]; r < rowEnd; r++ )
+		{
+			const float* row = (const float*)(dog->imageData + dog->widthStep*r);
+			for( int c = SIFT_IMG_BORDER; c < dog->width - SIFT_IMG_BORDER; c++ )
+			{
+				float value = row[c];
+				if( fabs(value) > prelimThreshold && wIsExtremum( pyramid, o, i, r, c, value ) )
+				{
+					if( wInterpolateExtremum( pyramid, o, i, r, c, contrastThreshold, curvatureThreshold, sigma, &candidate ) )
+						found[t].push_back(candidate);
+				}
+			}
+		}
+	}
+
+	std::vector<wSIFTCandidate> candidates;
+	for( int t = 0; t < taskCount; t++ )
+		candidates.insert( candidates.end(), found[t].begin(), found[t].end() );
+
+	// decreasing scale order (same as the original SIFT implementation)
+	std::stable_sort( candidates.begin(), candidates.end(), wCompareScaleGreater() );
+
+	// orientation assignment
+	const int candidateCount = (int)candidates.size();
+	std::vector<wSIFTOrientation> orientations(candidateCount);
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for( int n = 0; n < candidateCount; n++ )
+	{
+		const IplImage* image = wGaussLevel( pyramid, candidates[n].octave, candidates[n].interval );
+		wAssignOrientations( image, candidates[n], &orientations[n] );
+	}
+
+	std::vector<int> offset(candidateCount + 1, 0);
+	for( int n = 0; n < candidateCount; n++ )
+		offset[n+1] = offset[n] + orientations[n].count;
+	features->resize(offset[candidateCount]);
+
+	// descriptors are written to their own slot of the output
+	#pragma omp parallel for schedule(dynamic, 16)
+	for( int n = 0; n < candidateCount; n++ )
+	{
+		const IplImage* image = wGaussLevel( pyramid, candidates[n].octave, candidates[n].interval );
+		for( int k = 0; k < orientations[n].count; k++ )
+		{
+			wSIFTFeature& feature = (*features)[offset[n] + k];
+			feature.x = (float)candidates[n].x;
+			feature.y = (float)candidates[n].y;
+			feature.scale = (float)candidates[n].scale;
+			feature.orientation = orientations[n].orientation[k];
+			wComputeDescriptor( image, candidates[n], feature.orientation, feature.descriptor );
+		}
+	}
+
+	return (int)features->size();
+}
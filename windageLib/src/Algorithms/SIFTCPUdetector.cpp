@@ -0,0 +1,95 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include "Algorithms/SIFTCPUdetector.h"
+#include "Structures/SIFTpoint.h"
+using namespace windage;
+using namespace windage::Algorithms;
+
+#include "Algorithms/SIFT/wsift.h"
+
+void SIFTCPUdetector::Release()
+{
+	wReleaseSIFTPyramid(&this->pyramid);
+	if(this->features) delete this->features;
+	this->features = NULL;
+}
+
+bool SIFTCPUdetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
+{
+	if(grayImage == NULL)
+		return false;
+	if(grayImage->nChannels != 1)
+		return false;
+
+	this->keypoints.clear();
+
+	if(this->pyramid == NULL || this->pyramid->width != grayImage->width || this->pyramid->height != grayImage->height)
+	{
+		wReleaseSIFTPyramid(&this->pyramid);
+		this->pyramid = wCreateSIFTPyramid(grayImage->width, grayImage->height, this->numberOfIntervals, this->doubleImage);
+	}
+	if(this->features == NULL)
+		this->features = new std::vector<wSIFTFeature>();
+
+	int count = wExtractSIFT(grayImage, this->pyramid, this->features, this->threshold);
+	if(count < 0)
+		return false;
+
+	this->keypoints.reserve(count);
+
+	windage::SIFTpoint point;
+	for(int i=0; i<count; i++)
+	{
+		wSIFTFeature& feature = (*this->features)[i];
+		point.SetPoint(windage::Vector3((double)feature.x, (double)feature.y, 1.0));
+		point.SetSize(cvRound(feature.scale));
+		point.SetDir((double)feature.orientation);
+
+		for(int j=0; j<point.DESCRIPTOR_DIMENSION; j++)
+		{
+			point.descriptor[j] = (double)feature.descriptor[j];
+		}
+
+		this->keypoints.push_back(point);
+	}
+
+	return true;
+}
@@ -51,6 +51,49 @@
 using namespace windage;
 using namespace windage::Algorithms;
 
+void WSURFMultidetector::SelectResizeSource()
+{
+	// the level l of the decimation pyramid is about (1/2^l) of the input image
+	this->resizeSource.resize(this->resizeImage.size());
+	for(unsigned int i=0; i<this->resizeImage.size(); i++)
+	{
+		int source = 0;
+		int width = this->width;
+		int height = this->height;
+		for(int l=1; l<=this->pyramidLevel; l++)
+		{
+			width = (width + 1) >> 1;
+			height = (height + 1) >> 1;
+			if(width < this->resizeImage[i]->width || height < this->resizeImage[i]->height)
+				break;
+			source = l;
+		}
+		this->resizeSource[i] = source;
+	}
+}
+
+bool WSURFMultidetector::UpdatePyramid(IplImage* grayImage)
+{
+	if(grayImage == NULL)
+		return false;
+	if(grayImage->nChannels != 1)
+		return false;
+	if(grayImage->width != this->width || grayImage->height != this->height)
+		return false;
+
+	this->pyramidIndex = 1 - this->pyramidIndex;
+	if(windage::Algorithms::OpticalFlow::BuildPyramid(grayImage, this->pyramidBuffer[this->pyramidIndex], this->pyramidLevel, &this->pyramidHeaders[this->pyramidIndex][0]) == false)
+	{
+		this->pyramidCount = 0;
+		this->preparedImage = NULL;
+		return false;
+	}
+
+	this->pyramidCount++;
+	this->preparedImage = grayImage;
+	return true;
+}
+
 bool WSURFMultidetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 {
 	if(grayImage == NULL)
@@ -60,28 +103,52 @@ bool WSURFMultidetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 
 	this->keypoints.clear();
 
-	windage::Algorithms::WSURFdetector* singleDetector = new windage::Algorithms::WSURFdetector();
-	singleDetector->SetThreshold(this->threshold);
+	// build decimation pyramid once per frame (reuse it if it was built by UpdatePyramid),
+	// the other sizes (e.g. the resized reference images at the training) are resized from the input image
+	bool framed = (grayImage->width == this->width && grayImage->height == this->height);
+	if(framed && this->preparedImage != grayImage)
+	{
+		if(this->UpdatePyramid(grayImage) == false)
+			return false;
+		this->pyramidCount = 0;
+	}
+	this->preparedImage = NULL;
 
-	for(unsigned int i=0; i<this->resizeImage.size(); i++)
+	// each scale is resized from the nearest pyramid level and detected independently
+	int scaleCount = (int)this->resizeImage.size();
+	#pragma omp parallel for schedule(dynamic)
+	for(int i=0; i<scaleCount; i++)
 	{
-		cvResize(grayImage, this->resizeImage[i]);
-		singleDetector->DoExtractKeypointsDescriptor(this->resizeImage[i]);
+		IplImage* source = grayImage;
+		if(framed && this->resizeSource[i] > 0)
+			source = &this->pyramidHeaders[this->pyramidIndex][this->resizeSource[i]-1];
 
-		std::vector<windage::FeaturePoint>* singlePoints = singleDetector->GetKeypoints();
+		if(source->width == this->resizeImage[i]->width && source->height == this->resizeImage[i]->height)
+			cvCopyImage(source, this->resizeImage[i]);
+		else
+			cvResize(source, this->resizeImage[i]);
+
+		this->detectors[i]->SetThreshold(this->threshold);
+		this->detectors[i]->DoExtractKeypointsDescriptor(this->resizeImage[i]);
+	}
+
+	// keypoints are at the input image coordinate
+	double xInputScale = (double)grayImage->width / (double)this->width;
+	double yInputScale = (double)grayImage->height / (double)this->height;
+	for(int i=0; i<scaleCount; i++)
+	{
+		std::vector<windage::FeaturePoint>* singlePoints = this->detectors[i]->GetKeypoints();
 		for(unsigned int j=0; j<singlePoints->size(); j++)
 		{
 			(*singlePoints)[j].SetSize(this->size[i]);
 			windage::Vector3 pt = (*singlePoints)[j].GetPoint();
-			pt.x *= this->xScale[i];
-			pt.y *= this->yScale[i];
+			pt.x *= this->xScale[i] * xInputScale;
+			pt.y *= this->yScale[i] * yInputScale;
 			(*singlePoints)[j].SetPoint(pt);
 
 			this->keypoints.push_back((*singlePoints)[j]);
 		}
 	}
 
-	delete singleDetector;
-
 	return true;
 }
@@ -38,6 +38,7 @@
  * ======================================================================== */
 
 #include <vector>
+#include <algorithm>
 
 #include "Algorithms/WSURFdetector.h"
 #include "Structures/WSURFpoint.h"
@@ -50,6 +51,48 @@
 using namespace windage;
 using namespace windage::Algorithms;
 
+/** maximum relative change of the threshold in a frame (avoid oscillation at scene cut) */
+const double MAX_THRESHOLD_STEP = 0.25;
+
+typedef struct _CornerScore
+{
+	float score;
+	int index;
+}CornerScore;
+
+typedef struct _CompareScoreGreater
+{
+	bool operator()(const CornerScore& a, const CornerScore& b) const
+	{
+		return a.score > b.score;
+	}
+}CompareScoreGreater;
+
+void WSURFdetector::UpdateThreshold(int cornerCount)
+{
+	if(this->targetCount <= 0)
+		return;
+
+	// FAST corner and hessian blob counts fall roughly exponentially with the threshold,
+	// so the controller works on the relative error and relative step
+	double error = (double)(cornerCount - this->targetCount) / (double)this->targetCount;
+	double step = this->adaptiveGain * error;
+	if(step > MAX_THRESHOLD_STEP) step = MAX_THRESHOLD_STEP;
+	if(step < -MAX_THRESHOLD_STEP) step = -MAX_THRESHOLD_STEP;
+
+	double threshold = this->threshold * (1.0 + step);
+	double minThreshold = this->minThreshold;
+	double maxThreshold = this->maxThreshold;
+	if(this->keypointDetector != KEYPOINT_FAST)
+	{
+		minThreshold = this->hessianMinThreshold;
+		maxThreshold = this->hessianMaxThreshold;
+	}
+	if(threshold < minThreshold) threshold = minThreshold;
+	if(threshold > maxThreshold) threshold = maxThreshold;
+	this->threshold = threshold;
+}
+
 bool WSURFdetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 {
 	if(grayImage == NULL)
@@ -59,34 +102,119 @@ bool WSURFdetector::DoExtractKeypointsDescriptor(IplImage* grayImage)
 
 	this->keypoints.clear();
 
-	// Extract FAST corners;
-	int cornerCount = 0;
-	xy* cornerPoints = NULL;
+	// keypoint candidates (position, size and score)
+	std::vector<CvSURFPoint> candidates;
+	bool bucketing = (this->gridCols > 0 && this->gridRows > 0);
 
-	switch(FAST_INDEX)
+	if(this->keypointDetector == KEYPOINT_FAST)
 	{
-	case 9:
-		cornerPoints = fast9_detect_nonmax((const byte*)grayImage->imageData, grayImage->width, grayImage->height, grayImage->widthStep, cvRound(this->threshold), &cornerCount);
-		break;
-	case 10:
-		cornerPoints = fast10_detect_nonmax((const byte*)grayImage->imageData, grayImage->width, grayImage->height, grayImage->widthStep, cvRound(this->threshold), &cornerCount);
-		break;
-	case 11:
-		cornerPoints = fast11_detect_nonmax((const byte*)grayImage->imageData, grayImage->width, grayImage->height, grayImage->widthStep, cvRound(this->threshold), &cornerCount);
-		break;
-	default:
-		cornerPoints = fast12_detect_nonmax((const byte*)grayImage->imageData, grayImage->width, grayImage->height, grayImage->widthStep, cvRound(this->threshold), &cornerCount);
-		break;
+		// Extract FAST corners;
+		int cornerCount = 0;
+		xy* cornerPoints = NULL;
+		int* cornerScores = NULL;
+
+		const byte* imageData = (const byte*)grayImage->imageData;
+		int threshold = cvRound(this->threshold);
+
+		switch(FAST_INDEX)
+		{
+		case 9:
+			cornerPoints = fast9_detect_nonmax(imageData, grayImage->width, grayImage->height, grayImage->widthStep, threshold, &cornerCount);
+			if(bucketing) cornerScores = fast9_score(imageData, grayImage->widthStep, cornerPoints, cornerCount, threshold);
+			break;
+		case 10:
+			cornerPoints = fast10_detect_nonmax(imageData, grayImage->width, grayImage->height, grayImage->widthStep, threshold, &cornerCount);
+			if(bucketing) cornerScores = fast10_score(imageData, grayImage->widthStep, cornerPoints, cornerCount, threshold);
+			break;
+		case 11:
+			cornerPoints = fast11_detect_nonmax(imageData, grayImage->width, grayImage->height, grayImage->widthStep, threshold, &cornerCount);
+			if(bucketing) cornerScores = fast11_score(imageData, grayImage->widthStep, cornerPoints, cornerCount, threshold);
+			break;
+		default:
+			cornerPoints = fast12_detect_nonmax(imageData, grayImage->width, grayImage->height, grayImage->widthStep, threshold, &cornerCount);
+			if(bucketing) cornerScores = fast12_score(imageData, grayImage->widthStep, cornerPoints, cornerCount, threshold);
+			break;
+		}
+
+		candidates.resize(cornerCount);
+		for(int i=0; i<cornerCount; i++)
+		{
+			float score = cornerScores ? (float)cornerScores[i] : 0.0f;
+			candidates[i] = cvSURFPoint(cvPoint2D32f(cornerPoints[i].x, cornerPoints[i].y), 0, 15, 0, score);
+		}
+
+		if(cornerPoints) free(cornerPoints);
+		if(cornerScores) free(cornerScores);
 	}
-	
+	else
+	{
+		// Extract fast-hessian keypoints
+		CvMemStorage* storage = cvCreateMemStorage(0);
+		CvSURFParams params = cvSURFParams(this->threshold, 0);
+		params.nOctaves = this->hessianOctaves;
+		params.nOctaveLayers = this->hessianOctaveLayers;
+
+		CvSeq* hessianPoints = wFastHessianKeypoints(grayImage, NULL, storage, params);
+		for(int i=0; i<hessianPoints->total; i++)
+		{
+			// the orientation of the descriptor is sampled on the FAST circle (radius 3)
+			CvSURFPoint* hessianPoint = (CvSURFPoint*)cvGetSeqElem(hessianPoints, i);
+			int x = cvRound(hessianPoint->pt.x);
+			int y = cvRound(hessianPoint->pt.y);
+			if(x >= 3 && y >= 3 && x < grayImage->width-3 && y < grayImage->height-3)
+				candidates.push_back(*hessianPoint);
+		}
+
+		cvReleaseMemStorage(&storage);
+	}
+
+	int cornerCount = (int)candidates.size();
+	this->detectedCount = cornerCount;
+
+	// grid bucketing : keep the strongest corners of each cell
+	std::vector<int> selected;
+	if(bucketing && cornerCount > 0)
+	{
+		int cellCount = this->gridCols * this->gridRows;
+		std::vector<std::vector<CornerScore>> cells(cellCount);
+		for(int i=0; i<cornerCount; i++)
+		{
+			int cx = MIN((int)candidates[i].pt.x * this->gridCols / grayImage->width, this->gridCols - 1);
+			int cy = MIN((int)candidates[i].pt.y * this->gridRows / grayImage->height, this->gridRows - 1);
+			CornerScore corner;
+			corner.score = candidates[i].hessian;
+			corner.index = i;
+			cells[cy * this->gridCols + cx].push_back(corner);
+		}
+
+		for(int i=0; i<cellCount; i++)
+		{
+			int keep = MIN((int)cells[i].size(), this->maxCellCount);
+			std::partial_sort(cells[i].begin(), cells[i].begin() + keep, cells[i].end(), CompareScoreGreater());
+			for(int j=0; j<keep; j++)
+				selected.push_back(cells[i][j].index);
+		}
+
+		// restore raster order
+		std::sort(selected.begin(), selected.end());
+	}
+	else
+	{
+		selected.resize(cornerCount);
+		for(int i=0; i<cornerCount; i++)
+			selected[i] = i;
+	}
+
 	windage::WSURFpoint point;
-	for(int i=0; i<cornerCount; i++)
+	for(unsigned int i=0; i<selected.size(); i++)
 	{
-		point.SetPoint(windage::Vector3(cornerPoints[i].x, cornerPoints[i].y, 1.0));
-		point.SetSize(15);
+		point.SetPoint(windage::Vector3(candidates[selected[i]].pt.x, candidates[selected[i]].pt.y, 1.0));
+		point.SetSize(candidates[selected[i]].size);
 		this->keypoints.push_back(point);
 	}
-	if(cornerPoints) delete[] cornerPoints;
+
+	// closed-loop threshold control for the next frame
+	this->UpdateThreshold(cornerCount);
 
 	// Generate Descriptor
 //	wExtractSURF(grayImage, NULL, &keypointsSeq, &descriptors, storage, params, 1);
@@ -101,13 +101,21 @@ void FastHessian::getIpoints()
   // Build the response map
   buildResponseMap();
 
-  // Get the response layers
-  ResponseLayer *b, *m, *t;
-  for (int o = 0; o < octaves; ++o) for (int i = 0; i <= 1; ++i)
+  // Each (octave, interval) triple is searched independently and
+  // the features are collected in order after the parallel search
+  int searchCount = octaves * 2;
+  std::vector<std::vector<Ipoint> > found(searchCount);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int k = 0; k < searchCount; ++k)
   {
-    b = responseMap.at(filter_map[o][i]);
-    m = responseMap.at(filter_map[o][i+1]);
-    t = responseMap.at(filter_map[o][i+2]);
+    int o = k / 2;
+    int i = k % 2;
+
+    // Get the response layers
+    ResponseLayer *b = responseMap.at(filter_map[o][i]);
+    ResponseLayer *m = responseMap.at(filter_map[o][i+1]);
+    ResponseLayer *t = responseMap.at(filter_map[o][i+2]);
 
     // loop over middle response layer at density of the most 
     // sparse layer (always top), to find maxima across scale and space
@@ -117,11 +125,14 @@ void FastHessian::getIpoints()
       {
         if (isExtremum(r, c, t, m, b))
         {
-          interpolateExtremum(r, c, t, m, b);
+          interpolateExtremum(r, c, t, m, b, found[k]);
         }
       }
     }
   }
+
+  for (int k = 0; k < searchCount; ++k)
+    ipts.insert(ipts.end(), found[k].begin(), found[k].end());
 }
 
 //-------------------------------------------------------
@@ -136,51 +147,43 @@ void FastHessian::buildResponseMap()
   // Oct4: 51, 99, 147,195
   // Oct5: 99, 195,291,387
 
-  // Deallocate memory and clear any existing response layers
-  for(unsigned int i = 0; i < responseMap.size(); ++i)  
-    delete responseMap[i];
-  responseMap.clear();
+  // Layer geometry (width/height divisor, step multiplier, filter size) of each octave
+  static const int layout[12][3] = {
+    {1, 1, 9}, {1, 1, 15}, {1, 1, 21}, {1, 1, 27},
+    {2, 2, 39}, {2, 2, 51},
+    {4, 4, 75}, {4, 4, 99},
+    {8, 8, 147}, {8, 8, 195},
+    {16, 16, 291}, {16, 16, 387} };
+  int layerCount = (octaves >= 1 ? 4 : 0) + (octaves > 1 ? 2 * (octaves - 1) : 0);
 
   // Get image attributes
   int w = (i_width / init_sample);
   int h = (i_height / init_sample);
   int s = (init_sample);
 
-  // Calculate approximated determinant of hessian values
-  if (octaves >= 1)
+  // Reuse the pooled layers while the geometry is unchanged,
+  // all responses are overwritten below so the storage need not be cleared
+  bool reuse = ((int)responseMap.size() == layerCount);
+  for (int i = 0; reuse && i < layerCount; ++i)
   {
-    responseMap.push_back(new ResponseLayer(w,   h,   s,   9));
-    responseMap.push_back(new ResponseLayer(w,   h,   s,   15));
-    responseMap.push_back(new ResponseLayer(w,   h,   s,   21));
-    responseMap.push_back(new ResponseLayer(w,   h,   s,   27));
-  }
- 
-  if (octaves >= 2)
-  {
-    responseMap.push_back(new ResponseLayer(w/2, h/2, s*2, 39));
-    responseMap.push_back(new ResponseLayer(w/2, h/2, s*2, 51));
+    reuse = responseMap[i]->isSameLayout(w/layout[i][0], h/layout[i][0], s*layout[i][1], layout[i][2]);
   }
 
-  if (octaves >= 3)
+  if (!reuse)
   {
-    responseMap.push_back(new ResponseLayer(w/4, h/4, s*4, 75));
-    responseMap.push_back(new ResponseLayer(w/4, h/4, s*4, 99));
+    // Deallocate memory and clear any existing response layers
+    for(unsigned int i = 0; i < responseMap.size(); ++i)  
+      delete responseMap[i];
+    responseMap.clear();
+
+    // Calculate approximated determinant of hessian values
+    for (int i = 0; i < layerCount; ++i)
+      responseMap.push_back(new ResponseLayer(w/layout[i][0], h/layout[i][0], s*layout[i][1], layout[i][2]));
   }
 
-  if (octaves >= 4)
-  {
-    responseMap.push_back(new ResponseLayer(w/8, h/8, s*8, 147));
-    responseMap.push_back(new ResponseLayer(w/8, h/8, s*8, 195));
-  }
-
-  if (octaves >= 5)
-  {
-    responseMap.push_back(new ResponseLayer(w/16, h/16, s*16, 291));
-    responseMap.push_back(new ResponseLayer(w/16, h/16, s*16, 387));
-  }
-
-  // Extract responses from the image
-  for (unsigned int i = 0; i < responseMap.size(); ++i)
+  // Extract responses from the image, the layers are independent
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < layerCount; ++i)
   {
     buildResponseLayer(responseMap[i]);
   }
@@ -200,6 +203,11 @@ void FastHessian::buildResponseLayer(ResponseLayer *rl)
   float inverse_area = 1.f/(w*w);           // normalisation factor
   float Dxx, Dyy, Dxy;
 
+#ifdef RL_DEBUG
+  // the layer can be reused from the previous frame
+  rl->coords.clear();
+#endif
+
   for(int r, c, ar = 0, index = 0; ar < rl->height; ++ar) 
   {
     for(int ac = 0; ac < rl->width; ++ac, index++) 
@@ -270,7 +278,7 @@ int FastHessian::isExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, Re
 //-------------------------------------------------------
 
 //! Interpolate scale-space extrema to subpixel accuracy to form an image feature.   
-void FastHessian::interpolateExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b)
+void FastHessian::interpolateExtremum(int r, int c, ResponseLayer *t, ResponseLayer *m, ResponseLayer *b, std::vector<Ipoint> &found)
 {
   // get the step distance between filters
   // check the middle filter is mid way between top and bottom
@@ -289,7 +297,7 @@ void FastHessian::interpolateExtremum(int r, int c, ResponseLayer *t, ResponseLa
     ipt.y = static_cast<float>((r + xr) * t->step);
     ipt.scale = static_cast<float>((0.1333f) * (m->filter + xi * filterStep));
     ipt.laplacian = static_cast<int>(m->getLaplacian(r,c,t));
-    ipts.push_back(ipt);
+    found.push_back(ipt);
   }
 }
 
@@ -37,8 +37,15 @@
  ** @author   Woonhyuk Baek
  * ======================================================================== */
 
+#include <vector>
+
 #include "Algorithms/windageSURF/wsurf.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define W_SURF_SSE2
+	#include <emmintrin.h>
+#endif
+
 float wCalcHaarPattern( const int* origin, const CvSurfHF* f, int n )
 {
     double d = 0;
@@ -96,6 +103,122 @@ int wInterpolateKeypoint( float N9[3][9], int dx, int dy, int ds, CvSURFPoint *p
     return solve_ok;
 }
 
+/* Row band height (in samples) of a tile for the hessian computation and the non-maxima suppression */
+const int HESSIAN_BAND_ROWS = 32;
+
+/* Weighted sum of n haar boxes for count samples along a row of the integral image.
+   The samples are step apart; with step 1 the corners of each box are contiguous in the
+   integral image rows, so 4 samples are summed at once */
+static void wCalcHaarPatternRow( const int* origin, const CvSurfHF* f, int n, int step, int count, float* dst )
+{
+    int j = 0;
+#ifdef W_SURF_SSE2
+    if( step == 1 )
+    {
+        for( ; j <= count-4; j += 4 )
+        {
+            const int* ptr = origin + j;
+            __m128 d = _mm_setzero_ps();
+            for( int k = 0; k < n; k++ )
+            {
+                __m128i s0 = _mm_loadu_si128( (const __m128i*)(ptr + f[k].p0) );
+                __m128i s1 = _mm_loadu_si128( (const __m128i*)(ptr + f[k].p1) );
+                __m128i s2 = _mm_loadu_si128( (const __m128i*)(ptr + f[k].p2) );
+                __m128i s3 = _mm_loadu_si128( (const __m128i*)(ptr + f[k].p3) );
+                __m128i box = _mm_sub_epi32( _mm_add_epi32(s0, s3), _mm_add_epi32(s1, s2) );
+                d = _mm_add_ps( d, _mm_mul_ps(_mm_cvtepi32_ps(box), _mm_set1_ps(f[k].w)) );
+            }
+            _mm_storeu_ps( dst + j, d );
+        }
+    }
+#endif
+    for( ; j < count; j++ )
+    {
+        const int* ptr = origin + j*step;
+        float d = 0;
+        for( int k = 0; k < n; k++ )
+            d += (float)(ptr[f[k].p0] + ptr[f[k].p3] - ptr[f[k].p1] - ptr[f[k].p2])*f[k].w;
+        dst[j] = d;
+    }
+}
+
+/* Maximum of the 26 neighbours of det2[0] in the 3x3x3 neighbourhood (c : row stride) */
+static inline float wNeighbourMax( const float* det1, const float* det2, const float* det3, int c )
+{
+    float m = det1[-c-1];
+    const float* layers[3] = { det1, det2, det3 };
+    for( int l = 0; l < 3; l++ )
+    {
+        const float* d = layers[l];
+        for( int r = -c; r <= c; r += c )
+            for( int k = -1; k <= 1; k++ )
+                if( l != 1 || r != 0 || k != 0 )
+                    m = MAX( m, d[r+k] );
+    }
+    return m;
+}
+
+static void wHessianCandidate( const CvMat* sum, const CvMat* mask_sum, const CvSurfHF* Dm,
+    CvMat** dets, CvMat** traces, const int* sizes, int layer, int sampleStep, int i, int j,
+    std::vector<CvSURFPoint>* points )
+{
+    int size = sizes[layer];
+    float val0 = dets[layer]->data.fl[i*dets[layer]->cols + j];
+    float trace = traces[layer]->data.fl[i*traces[layer]->cols + j];
+
+    /* Coordinates for the start of the wavelet in the sum image. There   
+       is some integer division involved, so don't try to simplify this
+       (cancel out sampleStep) without checking the result is the same */
+    int sum_i = sampleStep*(i-(size/2)/sampleStep);
+    int sum_j = sampleStep*(j-(size/2)/sampleStep);
+
+    /* Check the mask - why not just check the mask at the center of the wavelet? */
+    if( mask_sum )
+    {
+        const int* mask_ptr = mask_sum->data.i +  mask_sum->cols*sum_i + sum_j;
+        float mval = wCalcHaarPattern( mask_ptr, Dm, 1 );
+        if( mval < 0.5 )
+            return;
+    }
+
+    /* The 3x3x3 neighbouring samples around the maxima. 
+       The maxima is included at N9[1][4] */
+    int c = dets[layer]->cols;
+    const float *det1 = dets[layer-1]->data.fl + i*c + j;
+    const float *det2 = dets[layer]->data.fl   + i*c + j;
+    const float *det3 = dets[layer+1]->data.fl + i*c + j;
+    float N9[3][9] = { { det1[-c-1], det1[-c], det1[-c+1],          
+                         det1[-1]  , det1[0] , det1[1],
+                         det1[c-1] , det1[c] , det1[c+1]  },
+                       { det2[-c-1], det2[-c], det2[-c+1],       
+                         det2[-1]  , det2[0] , det2[1],
+                         det2[c-1] , det2[c] , det2[c+1 ] },
+                       { det3[-c-1], det3[-c], det3[-c+1],       
+                         det3[-1  ], det3[0] , det3[1],
+                         det3[c-1] , det3[c] , det3[c+1 ] } };
+
+    /* Calculate the wavelet center coordinates for the maxima */
+    double center_i = sum_i + (double)(size-1)/2;
+    double center_j = sum_j + (double)(size-1)/2;
+
+    CvSURFPoint point = cvSURFPoint( cvPoint2D32f(center_j,center_i), 
+                                     CV_SIGN(trace), sizes[layer], 0, val0 );
+   
+    /* Interpolate maxima location within the 3x3x3 neighbourhood  */
+    int ds = sizes[layer]-sizes[layer-1];
+    int interp_ok = wInterpolateKeypoint( N9, sampleStep, sampleStep, ds, &point );
+
+    /* Sometimes the interpolation step gives a negative size etc. */
+    if( interp_ok && point.size >= 1 &&
+        point.pt.x >= 0 && point.pt.x <= (sum->cols-1) &&
+        point.pt.y >= 0 && point.pt.y <= (sum->rows-1) )
+    {    
+        points->push_back( point );
+    }    
+}
+
+/* Tiled fast-hessian detector : the layers of an octave are split into row bands
+   which are computed in parallel, and each band is again split for the non-maxima suppression */
 static CvSeq* wFastHessianDetector( const CvMat* sum, const CvMat* mask_sum,
     CvMemStorage* storage, const CvSURFParams* params )
 {
@@ -122,148 +245,176 @@ static CvSeq* wFastHessianDetector( const CvMat* sum, const CvMat* mask_sum,
     const int dy_s[NY][5] = { {2, 0, 7, 3, 1}, {2, 3, 7, 6, -2}, {2, 6, 7, 9, 1} };
     const int dxy_s[NXY][5] = { {1, 1, 4, 4, 1}, {5, 1, 8, 4, -1}, {1, 5, 4, 8, -1}, {5, 5, 8, 8, 1} };
     const int dm[NM][5] = { {0, 0, 9, 9, 1} };
-    CvSurfHF Dx[NX], Dy[NY], Dxy[NXY], Dm;
 
-    CvMat** dets = (CvMat**)cvStackAlloc((params->nOctaveLayers+2)*sizeof(dets[0]));
-    CvMat** traces = (CvMat**)cvStackAlloc((params->nOctaveLayers+2)*sizeof(traces[0]));
-    int *sizes = (int*)cvStackAlloc((params->nOctaveLayers+2)*sizeof(sizes[0]));
+    int nLayers = params->nOctaveLayers+2;
+    CvMat** dets = (CvMat**)cvStackAlloc(nLayers*sizeof(dets[0]));
+    CvMat** traces = (CvMat**)cvStackAlloc(nLayers*sizeof(traces[0]));
+    int *sizes = (int*)cvStackAlloc(nLayers*sizeof(sizes[0]));
+    CvSurfHF* Dx = (CvSurfHF*)cvStackAlloc(nLayers*NX*sizeof(Dx[0]));
+    CvSurfHF* Dy = (CvSurfHF*)cvStackAlloc(nLayers*NY*sizeof(Dy[0]));
+    CvSurfHF* Dxy = (CvSurfHF*)cvStackAlloc(nLayers*NXY*sizeof(Dxy[0]));
+    CvSurfHF* Dm = (CvSurfHF*)cvStackAlloc(nLayers*NM*sizeof(Dm[0]));
 
-    double dx = 0, dy = 0, dxy = 0;
-    int octave, layer, sampleStep, size, margin;
+    int octave, layer, sampleStep;
     int rows, cols;
-    int i, j, sum_i, sum_j;
-    const int* s_ptr;
-    float *det_ptr, *trace_ptr;
+    float threshold = (float)params->hessianThreshold;
 
     /* Allocate enough space for hessian determinant and trace matrices at the 
        first octave. Clearing these initially or between octaves is not
        required, since all values that are accessed are first calculated */
-    for( layer = 0; layer <= params->nOctaveLayers+1; layer++ )
+    for( layer = 0; layer < nLayers; layer++ )
     {
         dets[layer]   = cvCreateMat( (sum->rows-1)/SAMPLE_STEP0, (sum->cols-1)/SAMPLE_STEP0, CV_32FC1 );
         traces[layer] = cvCreateMat( (sum->rows-1)/SAMPLE_STEP0, (sum->cols-1)/SAMPLE_STEP0, CV_32FC1 );
     }
 
+    std::vector<int> taskLayer;
+    std::vector<int> taskRow;
+    std::vector< std::vector<CvSURFPoint> > found;
+
     for( octave = 0, sampleStep=SAMPLE_STEP0; octave < params->nOctaves; octave++, sampleStep*=2 )
     {
         /* Hessian determinant and trace sample array size in this octave */
         rows = (sum->rows-1)/sampleStep;
         cols = (sum->cols-1)/sampleStep;
 
+        /* Split every layer into row bands */
+        taskLayer.clear();
+        taskRow.clear();
+        for( layer = 0; layer < nLayers; layer++ )
+        {
+            sizes[layer] = (HAAR_SIZE0+HAAR_SIZE_INC*layer)<<octave;
+            wResizeHaarPattern( dx_s, Dx + layer*NX, NX, 9, sizes[layer], sum->cols );
+            wResizeHaarPattern( dy_s, Dy + layer*NY, NY, 9, sizes[layer], sum->cols );
+            wResizeHaarPattern( dxy_s, Dxy + layer*NXY, NXY, 9, sizes[layer], sum->cols );
+            wResizeHaarPattern( dm, Dm + layer*NM, NM, 9, sizes[layer], mask_sum ? mask_sum->cols : sum->cols );
+
+            int sampleRows = (sum->rows-1)-sizes[layer] >= 0 ? ((sum->rows-1)-sizes[layer])/sampleStep + 1 : 0;
+            for( int band = 0; band < sampleRows; band += HESSIAN_BAND_ROWS )
+            {
+                taskLayer.push_back( layer );
+                taskRow.push_back( band );
+            }
+        }
+
         /* Calculate the determinant and trace of the hessian */
-        for( layer = 0; layer <= params->nOctaveLayers+1; layer++ )
+        int taskCount = (int)taskLayer.size();
+        #pragma omp parallel for schedule(dynamic)
+        for( int t = 0; t < taskCount; t++ )
         {
-            sizes[layer] = size = (HAAR_SIZE0+HAAR_SIZE_INC*layer)<<octave;
-            wResizeHaarPattern( dx_s, Dx, NX, 9, size, sum->cols );
-            wResizeHaarPattern( dy_s, Dy, NY, 9, size, sum->cols );
-            wResizeHaarPattern( dxy_s, Dxy, NXY, 9, size, sum->cols );
-            /*printf( "octave=%d layer=%d size=%d rows=%d cols=%d\n", octave, layer, size, rows, cols );*/
-            
-            margin = (size/2)/sampleStep;
-            for( sum_i=0, i=margin; sum_i<=(sum->rows-1)-size; sum_i+=sampleStep, i++ )
+            int layer = taskLayer[t];
+            int size = sizes[layer];
+            int margin = (size/2)/sampleStep;
+            int sampleRows = ((sum->rows-1)-size)/sampleStep + 1;
+            int sampleCols = (sum->cols-1)-size >= 0 ? ((sum->cols-1)-size)/sampleStep + 1 : 0;
+            if( sampleCols <= 0 )
+                continue;
+
+            float* buffer = (float*)cvAlloc( 3*sampleCols*sizeof(float) );
+            float* dx = buffer;
+            float* dy = buffer + sampleCols;
+            float* dxy = buffer + 2*sampleCols;
+
+            int rowEnd = MIN( taskRow[t] + HESSIAN_BAND_ROWS, sampleRows );
+            for( int r = taskRow[t]; r < rowEnd; r++ )
             {
-                s_ptr = sum->data.i + sum_i*sum->cols;
-                det_ptr = dets[layer]->data.fl + i*dets[layer]->cols + margin;
-                trace_ptr = traces[layer]->data.fl + i*traces[layer]->cols + margin;
-                for( sum_j=0, j=margin; sum_j<=(sum->cols-1)-size; sum_j+=sampleStep, j++ )
+                const int* s_ptr = sum->data.i + r*sampleStep*sum->cols;
+                wCalcHaarPatternRow( s_ptr, Dx + layer*NX, NX, sampleStep, sampleCols, dx );
+                wCalcHaarPatternRow( s_ptr, Dy + layer*NY, NY, sampleStep, sampleCols, dy );
+                wCalcHaarPatternRow( s_ptr, Dxy + layer*NXY, NXY, sampleStep, sampleCols, dxy );
+
+                float* det_ptr = dets[layer]->data.fl + (r+margin)*dets[layer]->cols + margin;
+                float* trace_ptr = traces[layer]->data.fl + (r+margin)*traces[layer]->cols + margin;
+                for( int j = 0; j < sampleCols; j++ )
                 {
-                    dx  = wCalcHaarPattern( s_ptr, Dx, 3 );
-                    dy  = wCalcHaarPattern( s_ptr, Dy, 3 );
-                    dxy = wCalcHaarPattern( s_ptr, Dxy, 4 );
-                    s_ptr+=sampleStep;
-                    *det_ptr++ = (float)(dx*dy - 0.81*dxy*dxy);
-                    *trace_ptr++ = (float)(dx + dy);
+                    det_ptr[j] = dx[j]*dy[j] - 0.81f*dxy[j]*dxy[j];
+                    trace_ptr[j] = dx[j] + dy[j];
                 }
             }
+
+            cvFree( &buffer );
         }
 
         /* Find maxima in the determinant of the hessian */
+        taskLayer.clear();
+        taskRow.clear();
         for( layer = 1; layer <= params->nOctaveLayers; layer++ )
         {
-            size = sizes[layer];
-            wResizeHaarPattern( dm, &Dm, NM, 9, size, mask_sum ? mask_sum->cols : sum->cols );
-            
             /* Ignore pixels without a 3x3 neighbourhood in the layer above */
-            margin = (sizes[layer+1]/2)/sampleStep+1; 
-            for( i = margin; i < rows-margin; i++ )
+            int margin = (sizes[layer+1]/2)/sampleStep+1; 
+            for( int band = margin; band < rows-margin; band += HESSIAN_BAND_ROWS )
             {
-                det_ptr = dets[layer]->data.fl + i*dets[layer]->cols;
-                trace_ptr = traces[layer]->data.fl + i*traces[layer]->cols;
-                for( j = margin; j < cols-margin; j++ )
+                taskLayer.push_back( layer );
+                taskRow.push_back( band );
+            }
+        }
+
+        taskCount = (int)taskLayer.size();
+        found.clear();
+        found.resize( taskCount );
+        #pragma omp parallel for schedule(dynamic)
+        for( int t = 0; t < taskCount; t++ )
+        {
+            int layer = taskLayer[t];
+            int margin = (sizes[layer+1]/2)/sampleStep+1;
+            int c = dets[layer]->cols;
+            int rowEnd = MIN( taskRow[t] + HESSIAN_BAND_ROWS, rows-margin );
+            for( int i = taskRow[t]; i < rowEnd; i++ )
+            {
+                const float* det1 = dets[layer-1]->data.fl + i*c;
+                const float* det2 = dets[layer]->data.fl   + i*c;
+                const float* det3 = dets[layer+1]->data.fl + i*c;
+
+                int j = margin;
+#ifdef W_SURF_SSE2
+                /* Non-maxima suppression of 4 samples at once against the maximum of the 26 neighbours */
+                __m128 thresh = _mm_set1_ps( threshold );
+                for( ; j <= cols-margin-4; j += 4 )
                 {
-                    float val0 = det_ptr[j];
-                    if( val0 > params->hessianThreshold )
+                    __m128 val0 = _mm_loadu_ps( det2 + j );
+                    if( _mm_movemask_ps(_mm_cmpgt_ps(val0, thresh)) == 0 )
+                        continue;
+
+                    __m128 m = _mm_loadu_ps( det2 + j - 1 );
+                    m = _mm_max_ps( m, _mm_loadu_ps(det2 + j + 1) );
+                    for( int k = -1; k <= 1; k++ )
                     {
-                        /* Coordinates for the start of the wavelet in the sum image. There   
-                           is some integer division involved, so don't try to simplify this
-                           (cancel out sampleStep) without checking the result is the same */
-                        int sum_i = sampleStep*(i-(size/2)/sampleStep);
-                        int sum_j = sampleStep*(j-(size/2)/sampleStep);
-
-                        /* The 3x3x3 neighbouring samples around the maxima. 
-                           The maxima is included at N9[1][4] */
-                        int c = dets[layer]->cols;
-                        const float *det1 = dets[layer-1]->data.fl + i*c + j;
-                        const float *det2 = dets[layer]->data.fl   + i*c + j;
-                        const float *det3 = dets[layer+1]->data.fl + i*c + j;
-                        float N9[3][9] = { { det1[-c-1], det1[-c], det1[-c+1],          
-                                             det1[-1]  , det1[0] , det1[1],
-                                             det1[c-1] , det1[c] , det1[c+1]  },
-                                           { det2[-c-1], det2[-c], det2[-c+1],       
-                                             det2[-1]  , det2[0] , det2[1],
-                                             det2[c-1] , det2[c] , det2[c+1 ] },
-                                           { det3[-c-1], det3[-c], det3[-c+1],       
-                                             det3[-1  ], det3[0] , det3[1],
-                                             det3[c-1] , det3[c] , det3[c+1 ] } };
-
-                        /* Check the mask - why not just check the mask at the center of the wavelet? */
-                        if( mask_sum )
+                        m = _mm_max_ps( m, _mm_loadu_ps(det2 + j - c + k) );
+                        m = _mm_max_ps( m, _mm_loadu_ps(det2 + j + c + k) );
+                        for( int r = -c; r <= c; r += c )
                         {
-                            const int* mask_ptr = mask_sum->data.i +  mask_sum->cols*sum_i + sum_j;
-                            float mval = wCalcHaarPattern( mask_ptr, &Dm, 1 );
-                            if( mval < 0.5 )
-                                continue;
+                            m = _mm_max_ps( m, _mm_loadu_ps(det1 + j + r + k) );
+                            m = _mm_max_ps( m, _mm_loadu_ps(det3 + j + r + k) );
                         }
+                    }
 
-                        /* Non-maxima suppression. val0 is at N9[1][4]*/
-                        if( val0 > N9[0][0] && val0 > N9[0][1] && val0 > N9[0][2] &&
-                            val0 > N9[0][3] && val0 > N9[0][4] && val0 > N9[0][5] &&
-                            val0 > N9[0][6] && val0 > N9[0][7] && val0 > N9[0][8] &&
-                            val0 > N9[1][0] && val0 > N9[1][1] && val0 > N9[1][2] &&
-                            val0 > N9[1][3]                    && val0 > N9[1][5] &&
-                            val0 > N9[1][6] && val0 > N9[1][7] && val0 > N9[1][8] &&
-                            val0 > N9[2][0] && val0 > N9[2][1] && val0 > N9[2][2] &&
-                            val0 > N9[2][3] && val0 > N9[2][4] && val0 > N9[2][5] &&
-                            val0 > N9[2][6] && val0 > N9[2][7] && val0 > N9[2][8] )
-                        {
-                            /* Calculate the wavelet center coordinates for the maxima */
-                            double center_i = sum_i + (double)(size-1)/2;
-                            double center_j = sum_j + (double)(size-1)/2;
-
-                            CvSURFPoint point = cvSURFPoint( cvPoint2D32f(center_j,center_i), 
-                                                             CV_SIGN(trace_ptr[j]), sizes[layer], 0, val0 );
-                           
-                            /* Interpolate maxima location within the 3x3x3 neighbourhood  */
-                            int ds = sizes[layer]-sizes[layer-1];
-                            int interp_ok = wInterpolateKeypoint( N9, sampleStep, sampleStep, ds, &point );
-
-                            /* Sometimes the interpolation step gives a negative size etc. */
-                            if( interp_ok && point.size >= 1 &&
-                                point.pt.x >= 0 && point.pt.x <= (sum->cols-1) &&
-                                point.pt.y >= 0 && point.pt.y <= (sum->rows-1) )
-                            {    
-                                /*printf( "Keypoint %f %f %d\n", point.pt.x, point.pt.y, point.size );*/
-                                cvSeqPush( points, &point );
-                            }    
-                        }
+                    int maxima = _mm_movemask_ps( _mm_and_ps(_mm_cmpgt_ps(val0, thresh), _mm_cmpgt_ps(val0, m)) );
+                    for( int b = 0; maxima != 0; b++, maxima >>= 1 )
+                    {
+                        if( maxima & 1 )
+                            wHessianCandidate( sum, mask_sum, Dm + layer*NM, dets, traces, sizes, layer, sampleStep, i, j+b, &found[t] );
                     }
                 }
+#endif
+                for( ; j < cols-margin; j++ )
+                {
+                    float val0 = det2[j];
+                    if( val0 > threshold && val0 > wNeighbourMax(det1 + j, det2 + j, det3 + j, c) )
+                        wHessianCandidate( sum, mask_sum, Dm + layer*NM, dets, traces, sizes, layer, sampleStep, i, j, &found[t] );
+                }
             }
         }
+
+        /* Collect in the order of the tasks so the result does not depend on the thread scheduling */
+        for( int t = 0; t < taskCount; t++ )
+        {
+            for( unsigned int k = 0; k < found[t].size(); k++ )
+                cvSeqPush( points, &found[t][k] );
+        }
     }
 
     /* Clean-up */
-    for( layer = 0; layer <= params->nOctaveLayers+1; layer++ )
+    for( layer = 0; layer < nLayers; layer++ )
     {
         cvReleaseMat( &dets[layer] );
         cvReleaseMat( &traces[layer] );
@@ -272,6 +423,32 @@ static CvSeq* wFastHessianDetector( const CvMat* sum, const CvMat* mask_sum,
     return points;
 }
 
+CvSeq* wFastHessianKeypoints( const CvArr* _img, const CvArr* _mask,
+                              CvMemStorage* storage, CvSURFParams params )
+{
+    CvMat imghdr, *img = cvGetMat(_img, &imghdr);
+    CvMat maskhdr, *mask = _mask ? cvGetMat(_mask, &maskhdr) : 0;
+    CvMat *sum = 0, *mask1 = 0, *mask_sum = 0;
+
+    sum = cvCreateMat( img->height+1, img->width+1, CV_32SC1 );
+    cvIntegral( img, sum );
+    if( mask )
+    {
+        mask1 = cvCreateMat( img->height, img->width, CV_8UC1 );
+        mask_sum = cvCreateMat( img->height+1, img->width+1, CV_32SC1 );
+        cvMinS( mask, 1, mask1 );
+        cvIntegral( mask1, mask_sum );
+    }
+
+    CvSeq* keypoints = wFastHessianDetector( sum, mask_sum, storage, &params );
+
+    cvReleaseMat( &sum );
+    if( mask1 ) cvReleaseMat( &mask1 );
+    if( mask_sum ) cvReleaseMat( &mask_sum );
+
+    return keypoints;
+}
+
 /****************************************************************************************\
                                      Gaussian Blur
 \****************************************************************************************/
@@ -395,7 +572,14 @@ void wExtractSURF( const CvArr* _img, const CvArr* _mask,
 	// Compute keypoints only if we are not asked for evaluating the descriptors are some given locations:
 	if (!useProvidedKeyPts)
 	{
-		return;
+		if( mask )
+		{
+			mask1 = cvCreateMat( img->height, img->width, CV_8UC1 );
+			mask_sum = cvCreateMat( img->height+1, img->width+1, CV_32SC1 );
+			cvMinS( mask, 1, mask1 );
+			cvIntegral( mask1, mask_sum );
+		}
+		keypoints = wFastHessianDetector( sum, mask_sum, storage, &params );
 	}
 	else
 	{
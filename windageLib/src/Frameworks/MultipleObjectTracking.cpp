@@ -38,7 +38,9 @@
  * ======================================================================== */
 
 #include "Algorithms/SIFTGPUdetector.h"
+#include "Algorithms/SIFTCPUdetector.h"
 #include "Frameworks/MultipleObjectTracking.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Frameworks;
 
@@ -51,66 +53,91 @@ namespace MultipleOjbectThread
 	CRITICAL_SECTION csKeypointsUpdate;
 	CRITICAL_SECTION csImageUpdate;
 
-	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	// SIFTGPUdetector requires an OpenGL context, SIFTCPUdetector runs on GPU-less nodes
+	windage::Algorithms::FeatureDetector* CreateDetector(windage::Frameworks::MultipleObjectTracking* thisClass)
+	{
+		if(thisClass->IsGPUDetection())
+			return new windage::Algorithms::SIFTGPUdetector();
+		else
+			return new windage::Algorithms::SIFTCPUdetector();
+	}
+
+	windage::Algorithms::OpticalFlow* CreateTracker(windage::Frameworks::MultipleObjectTracking* thisClass)
 	{
-		windage::Frameworks::MultipleObjectTracking* thisClass = (windage::Frameworks::MultipleObjectTracking*)pArg;
-		windage::Algorithms::SIFTGPUdetector* detector = new windage::Algorithms::SIFTGPUdetector();
 		windage::Algorithms::OpticalFlow* tracker = new windage::Algorithms::OpticalFlow(50);
 		tracker->Initialize(thisClass->GetSize().width, thisClass->GetSize().height, cvSize(15, 15), 3);
+		return tracker;
+	}
 
-		cvGetTickCount();
+	/**
+	 * detect and match the features at globalGrayImage and track them to globalCurrentGrayImage
+	 * (detection thread or synchronous detection)
+	 */
+	void DetectFeatures(windage::Frameworks::MultipleObjectTracking* thisClass, windage::Algorithms::FeatureDetector* detector, windage::Algorithms::OpticalFlow* tracker)
+	{
+		int objectID = thisClass->objectID;
+		WINDAGE_PROFILE_OBJECT_SCOPE("MultipleObjectTracking::detection", objectID);
+		std::vector<windage::FeaturePoint> refMatchedKeypoints;
+		std::vector<windage::FeaturePoint> sceMatchedKeypoints;
 
-		while(thisClass->processThread)
+		// detect feature
+		detector->DoExtractKeypointsDescriptor(globalGrayImage);
+		std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+
+		for(unsigned int i=0; i<sceneKeypoints->size(); i++)
 		{
-			if(thisClass->update)
+			int count = 0;
+			int index = thisClass->GetMatcher(objectID)->Matching((*sceneKeypoints)[i]);
+			if(0 <= index && index < (int)thisClass->referenceRepository[objectID].size())
 			{
-				int objectID = thisClass->objectID;
-				std::vector<windage::FeaturePoint> refMatchedKeypoints;
-				std::vector<windage::FeaturePoint> sceMatchedKeypoints;
+				(*sceneKeypoints)[i].SetRepositoryID(index);
 
-				// detect feature
-				detector->DoExtractKeypointsDescriptor(globalGrayImage);
-				std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+				refMatchedKeypoints.push_back(thisClass->referenceRepository[objectID][index]);
+				sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
+			}
+		}
+
+		if(sceMatchedKeypoints.size() > 1)
+		{
+			// track feature
+			std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
+			WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csImageUpdate", &MultipleOjbectThread::csImageUpdate);
+			tracker->TrackFeatures(globalGrayImage, globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
+			LeaveCriticalSection(&csImageUpdate);
 
-				for(unsigned int i=0; i<sceneKeypoints->size(); i++)
+			for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
+			{
+				// if not tracked have point
+				int index = sceneUpdatedKeypoints[i].GetRepositoryID();
+				if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[objectID][index].IsTracked() == false)
 				{
-					int count = 0;
-					int index = thisClass->GetMatcher(objectID)->Matching((*sceneKeypoints)[i]);
-					if(0 <= index && index < (int)thisClass->referenceRepository[objectID].size())
+					WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csKeypointsUpdate", &MultipleOjbectThread::csKeypointsUpdate);
 					{
-						(*sceneKeypoints)[i].SetRepositoryID(index);
+						thisClass->referenceRepository[objectID][index].SetTracked(true);
 
-						refMatchedKeypoints.push_back(thisClass->referenceRepository[objectID][index]);
-						sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
+						thisClass->refMatchedKeypoints[objectID].push_back(thisClass->referenceRepository[objectID][index]);
+						thisClass->sceMatchedKeypoints[objectID].push_back((sceneUpdatedKeypoints)[i]);
 					}
+					LeaveCriticalSection(&csKeypointsUpdate);
 				}
+			}
+		}
+	}
 
-				if(sceMatchedKeypoints.size() > 1)
-				{
-					// track feature
-					std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
-					EnterCriticalSection(&csImageUpdate);
-					tracker->TrackFeatures(globalGrayImage, globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
-					LeaveCriticalSection(&csImageUpdate);
+	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	{
+		windage::Frameworks::MultipleObjectTracking* thisClass = (windage::Frameworks::MultipleObjectTracking*)pArg;
+		windage::Algorithms::FeatureDetector* detector = CreateDetector(thisClass);
+		windage::Algorithms::OpticalFlow* tracker = CreateTracker(thisClass);
 
-					for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
-					{
-						// if not tracked have point
-						int index = sceneUpdatedKeypoints[i].GetRepositoryID();
-						if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[objectID][index].IsTracked() == false)
-						{
-							EnterCriticalSection(&csKeypointsUpdate);
-							{
-								thisClass->referenceRepository[objectID][index].SetTracked(true);
-
-								thisClass->refMatchedKeypoints[objectID].push_back(thisClass->referenceRepository[objectID][index]);
-								thisClass->sceMatchedKeypoints[objectID].push_back((sceneUpdatedKeypoints)[i]);
-							}
-							LeaveCriticalSection(&csKeypointsUpdate);
-						}
-					}
-				}
+		cvGetTickCount();
+		windage::Profiler::SetThreadName("MultipleObjectTracking::detection");
 
+		while(thisClass->processThread)
+		{
+			if(thisClass->update)
+			{
+				DetectFeatures(thisClass, detector, tracker);
 				thisClass->update = false;
 			}
 		}
@@ -153,10 +180,20 @@ bool MultipleObjectTracking::Initialize(int width, int height, bool printInfo)
 		std::cout << std::endl;
 	}
 
-	// create detection thread
+	// create detection thread (or detector of the synchronous detection)
 	InitializeCriticalSection(&MultipleOjbectThread::csKeypointsUpdate);
 	InitializeCriticalSection(&MultipleOjbectThread::csImageUpdate);
-	_beginthreadex(NULL, 0, MultipleOjbectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	if(this->synchronousDetection)
+	{
+		if(this->synchronousDetector) delete this->synchronousDetector;
+		if(this->synchronousTracker) delete this->synchronousTracker;
+		this->synchronousDetector = MultipleOjbectThread::CreateDetector(this);
+		this->synchronousTracker = MultipleOjbectThread::CreateTracker(this);
+	}
+	else
+	{
+		_beginthreadex(NULL, 0, MultipleOjbectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	}
 
 	this->initialize = true;
 	return true;
@@ -196,6 +233,8 @@ bool MultipleObjectTracking::TrainingReference(std::vector<windage::FeaturePoint
 
 	this->estimatorList.resize(this->objectCount+1);
 	this->estimatorList[this->objectCount] = new PoseEstimationT();
+	if(this->seeded)
+		this->estimatorList[this->objectCount]->SetSeed(this->seed + this->objectCount);
 	this->estimatorList[this->objectCount]->SetReprojectionError(this->estimator->GetReprojectionError());
 	this->estimatorList[this->objectCount]->SetConfidence(((PoseEstimationT*)this->estimator)->GetConfidence());
 	this->estimatorList[this->objectCount]->SetMaxIteration(((PoseEstimationT*)this->estimator)->GetMaxIteration());
@@ -212,12 +251,15 @@ bool MultipleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	if(initialize == false || trained == false)
 		return false;
 
+	WINDAGE_PROFILE_FRAME("MultipleObjectTracking::frame");
+
 	// featur tracking routine
 	std::vector<windage::FeaturePoint> sceneKeypoints1;
 	std::vector<windage::FeaturePoint> sceneKeypoints2;
 
-	EnterCriticalSection(&MultipleOjbectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csKeypointsUpdate", &MultipleOjbectThread::csKeypointsUpdate);
 	{
+		WINDAGE_PROFILE_SCOPE("MultipleObjectTracking::tracking");
 		for(unsigned int i=0; i<this->sceMatchedKeypoints.size(); i++)
 		{
 			for(unsigned int j=0; j<this->sceMatchedKeypoints[i].size(); j++)
@@ -256,7 +298,7 @@ bool MultipleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 
 	// feature detection
 	{
-		EnterCriticalSection(&MultipleOjbectThread::csImageUpdate);
+		WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csImageUpdate", &MultipleOjbectThread::csImageUpdate);
 		if(MultipleOjbectThread::globalCurrentGrayImage)	cvCopyImage(grayImage, MultipleOjbectThread::globalCurrentGrayImage);
 		else						MultipleOjbectThread::globalCurrentGrayImage = cvCloneImage(grayImage);
 		LeaveCriticalSection(&MultipleOjbectThread::csImageUpdate);
@@ -270,19 +312,23 @@ bool MultipleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 				if(MultipleOjbectThread::globalGrayImage) cvCopyImage(grayImage, MultipleOjbectThread::globalGrayImage);
 				else				MultipleOjbectThread::globalGrayImage = cvCloneImage(grayImage);
 				this->objectID = objectID;
-				this->update = true;
+				if(this->synchronousDetection)
+					MultipleOjbectThread::DetectFeatures(this, this->synchronousDetector, this->synchronousTracker);
+				else
+					this->update = true;
 			}
 		}
 	}
 
 	// pose estimate
-	EnterCriticalSection(&MultipleOjbectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csKeypointsUpdate", &MultipleOjbectThread::csKeypointsUpdate);
 
 	#pragma omp parallel for
 	for(int i=0; i<this->objectCount; i++)
 	{
 		if((int)refMatchedKeypoints[i].size() > MIN_FEATURE_POINTS_COUNT)
 		{
+			WINDAGE_PROFILE_OBJECT_SCOPE("MultipleObjectTracking::pose", i);
 /*
 			this->estimator->AttatchCameraParameter(this->cameraParameter[i]);
 			this->estimator->AttatchReferencePoint(&(refMatchedKeypoints[i]));
@@ -354,7 +400,7 @@ void MultipleObjectTracking::DrawDebugInfo(IplImage* colorImage, int objectID)
 		b = cvRound((double)255.0);
 	}
 
-	EnterCriticalSection(&MultipleOjbectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultipleObjectTracking::lock csKeypointsUpdate", &MultipleOjbectThread::csKeypointsUpdate);
 	for(unsigned int i=0; i<refMatchedKeypoints[j].size(); i++)
 	{
 		CvPoint imagePoint = cvPoint((int)sceMatchedKeypoints[j][i].GetPoint().x, (int)sceMatchedKeypoints[j][i].GetPoint().y);
@@ -38,7 +38,9 @@
  * ======================================================================== */
 
 #include "Algorithms/SIFTGPUdetector.h"
+#include "Algorithms/SIFTCPUdetector.h"
 #include "Frameworks/MultiplePlanarObjectThreadTracking.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Frameworks;
 
@@ -52,68 +54,93 @@ namespace MultiplePlanarObjectThread
 	CRITICAL_SECTION csKeypointsUpdate;
 	CRITICAL_SECTION csImageUpdate;
 
-	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	// SIFTGPUdetector requires an OpenGL context, SIFTCPUdetector runs on GPU-less nodes
+	windage::Algorithms::FeatureDetector* CreateDetector(windage::Frameworks::MultiplePlanarObjectThreadTracking* thisClass)
+	{
+		if(thisClass->IsGPUDetection())
+			return new windage::Algorithms::SIFTGPUdetector();
+		else
+			return new windage::Algorithms::SIFTCPUdetector();
+	}
+
+	windage::Algorithms::OpticalFlow* CreateTracker(windage::Frameworks::MultiplePlanarObjectThreadTracking* thisClass)
 	{
-		windage::Frameworks::MultiplePlanarObjectThreadTracking* thisClass = (windage::Frameworks::MultiplePlanarObjectThreadTracking*)pArg;
-		windage::Algorithms::SIFTGPUdetector* detector = new windage::Algorithms::SIFTGPUdetector();
 		windage::Algorithms::OpticalFlow* tracker = new windage::Algorithms::OpticalFlow(50);
 		tracker->Initialize(thisClass->GetSize().width, thisClass->GetSize().height, cvSize(15, 15), 3);
+		return tracker;
+	}
 
-		cvGetTickCount();
+	/**
+	 * detect and match the features at globalGrayImage and track them to globalCurrentGrayImage
+	 * (detection thread or synchronous detection)
+	 */
+	void DetectFeatures(windage::Frameworks::MultiplePlanarObjectThreadTracking* thisClass, windage::Algorithms::FeatureDetector* detector, windage::Algorithms::OpticalFlow* tracker)
+	{
+		int objectID = thisClass->objectID;
+		WINDAGE_PROFILE_OBJECT_SCOPE("MultiplePlanarObjectThreadTracking::detection", objectID);
+		std::vector<windage::FeaturePoint> refMatchedKeypoints;
+		std::vector<windage::FeaturePoint> sceMatchedKeypoints;
 
-		while(thisClass->processThread)
+		// detect feature
+		detector->DoExtractKeypointsDescriptor(globalGrayImage);
+		std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+
+		detector->DrawKeypoints(globalGrayImage);
+
+		for(unsigned int i=0; i<sceneKeypoints->size(); i++)
 		{
-			if(thisClass->update)
+			int count = 0;
+			int index = thisClass->GetMatcher(objectID)->Matching((*sceneKeypoints)[i]);
+			if(0 <= index && index < (int)thisClass->referenceRepository[objectID].size())
 			{
-				int objectID = thisClass->objectID;
-				std::vector<windage::FeaturePoint> refMatchedKeypoints;
-				std::vector<windage::FeaturePoint> sceMatchedKeypoints;
+				(*sceneKeypoints)[i].SetRepositoryID(index);
 
-				// detect feature
-				detector->DoExtractKeypointsDescriptor(globalGrayImage);
-				std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+				refMatchedKeypoints.push_back(thisClass->referenceRepository[objectID][index]);
+				sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
+			}
+		}
 
-				detector->DrawKeypoints(globalGrayImage);
+		if(sceMatchedKeypoints.size() > 10)
+		{
+			// track feature
+			std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
+			WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csImageUpdate", &MultiplePlanarObjectThread::csImageUpdate);
+			tracker->TrackFeatures(globalGrayImage, globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
+			LeaveCriticalSection(&csImageUpdate);
 
-				for(unsigned int i=0; i<sceneKeypoints->size(); i++)
+			for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
+			{
+				// if not tracked have point
+				int index = sceneUpdatedKeypoints[i].GetRepositoryID();
+				if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[objectID][index].IsTracked() == false)
 				{
-					int count = 0;
-					int index = thisClass->GetMatcher(objectID)->Matching((*sceneKeypoints)[i]);
-					if(0 <= index && index < (int)thisClass->referenceRepository[objectID].size())
+					WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csKeypointsUpdate", &MultiplePlanarObjectThread::csKeypointsUpdate);
 					{
-						(*sceneKeypoints)[i].SetRepositoryID(index);
+						thisClass->referenceRepository[objectID][index].SetTracked(true);
 
-						refMatchedKeypoints.push_back(thisClass->referenceRepository[objectID][index]);
-						sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
+						thisClass->refMatchedKeypoints[objectID].push_back(thisClass->referenceRepository[objectID][index]);
+						thisClass->sceMatchedKeypoints[objectID].push_back((sceneUpdatedKeypoints)[i]);
 					}
+					LeaveCriticalSection(&csKeypointsUpdate);
 				}
+			}
+		}
+	}
 
-				if(sceMatchedKeypoints.size() > 10)
-				{
-					// track feature
-					std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
-					EnterCriticalSection(&csImageUpdate);
-					tracker->TrackFeatures(globalGrayImage, globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
-					LeaveCriticalSection(&csImageUpdate);
+	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	{
+		windage::Frameworks::MultiplePlanarObjectThreadTracking* thisClass = (windage::Frameworks::MultiplePlanarObjectThreadTracking*)pArg;
+		windage::Algorithms::FeatureDetector* detector = CreateDetector(thisClass);
+		windage::Algorithms::OpticalFlow* tracker = CreateTracker(thisClass);
 
-					for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
-					{
-						// if not tracked have point
-						int index = sceneUpdatedKeypoints[i].GetRepositoryID();
-						if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[objectID][index].IsTracked() == false)
-						{
-							EnterCriticalSection(&csKeypointsUpdate);
-							{
-								thisClass->referenceRepository[objectID][index].SetTracked(true);
-
-								thisClass->refMatchedKeypoints[objectID].push_back(thisClass->referenceRepository[objectID][index]);
-								thisClass->sceMatchedKeypoints[objectID].push_back((sceneUpdatedKeypoints)[i]);
-							}
-							LeaveCriticalSection(&csKeypointsUpdate);
-						}
-					}
-				}
+		cvGetTickCount();
+		windage::Profiler::SetThreadName("MultiplePlanarObjectThreadTracking::detection");
 
+		while(thisClass->processThread)
+		{
+			if(thisClass->update)
+			{
+				DetectFeatures(thisClass, detector, tracker);
 				thisClass->update = false;
 			}
 		}
@@ -160,10 +187,20 @@ bool MultiplePlanarObjectThreadTracking::Initialize(int width, int height, doubl
 		std::cout << std::endl;
 	}
 
-	// create detection thread
+	// create detection thread (or detector of the synchronous detection)
 	InitializeCriticalSection(&MultiplePlanarObjectThread::csKeypointsUpdate);
 	InitializeCriticalSection(&MultiplePlanarObjectThread::csImageUpdate);
-	_beginthreadex(NULL, 0, MultiplePlanarObjectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	if(this->synchronousDetection)
+	{
+		if(this->synchronousDetector) delete this->synchronousDetector;
+		if(this->synchronousTracker) delete this->synchronousTracker;
+		this->synchronousDetector = MultiplePlanarObjectThread::CreateDetector(this);
+		this->synchronousTracker = MultiplePlanarObjectThread::CreateTracker(this);
+	}
+	else
+	{
+		_beginthreadex(NULL, 0, MultiplePlanarObjectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	}
 
 	this->initialize = true;
 	return true;
@@ -202,6 +239,8 @@ bool MultiplePlanarObjectThreadTracking::TrainingReference(std::vector<windage::
 
 	this->estimatorList.resize(this->objectCount+1);
 	this->estimatorList[this->objectCount] = new PoseEstimationT();
+	if(this->seeded)
+		this->estimatorList[this->objectCount]->SetSeed(this->seed + this->objectCount);
 	this->estimatorList[this->objectCount]->SetReprojectionError(this->estimator->GetReprojectionError());
 
 	this->objectCount++;
@@ -216,12 +255,15 @@ bool MultiplePlanarObjectThreadTracking::UpdateCamerapose(IplImage* grayImage)
 	if(initialize == false || trained == false)
 		return false;
 
+	WINDAGE_PROFILE_FRAME("MultiplePlanarObjectThreadTracking::frame");
+
 	// featur tracking routine
 	std::vector<windage::FeaturePoint> sceneKeypoints1;
 	std::vector<windage::FeaturePoint> sceneKeypoints2;
 
-	EnterCriticalSection(&MultiplePlanarObjectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csKeypointsUpdate", &MultiplePlanarObjectThread::csKeypointsUpdate);
 	{
+		WINDAGE_PROFILE_SCOPE("MultiplePlanarObjectThreadTracking::tracking");
 		for(unsigned int i=0; i<this->sceMatchedKeypoints.size(); i++)
 		{
 			for(unsigned int j=0; j<this->sceMatchedKeypoints[i].size(); j++)
@@ -260,7 +302,7 @@ bool MultiplePlanarObjectThreadTracking::UpdateCamerapose(IplImage* grayImage)
 	
 	// feature detection
 	{
-		EnterCriticalSection(&MultiplePlanarObjectThread::csImageUpdate);
+		WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csImageUpdate", &MultiplePlanarObjectThread::csImageUpdate);
 		if(MultiplePlanarObjectThread::globalCurrentGrayImage)	cvCopyImage(grayImage, MultiplePlanarObjectThread::globalCurrentGrayImage);
 		else						MultiplePlanarObjectThread::globalCurrentGrayImage = cvCloneImage(grayImage);
 		LeaveCriticalSection(&MultiplePlanarObjectThread::csImageUpdate);
@@ -274,17 +316,21 @@ bool MultiplePlanarObjectThreadTracking::UpdateCamerapose(IplImage* grayImage)
 				if(MultiplePlanarObjectThread::globalGrayImage) cvCopyImage(grayImage, MultiplePlanarObjectThread::globalGrayImage);
 				else											MultiplePlanarObjectThread::globalGrayImage = cvCloneImage(grayImage);
 				this->objectID = objectID;
-				this->update = true;
+				if(this->synchronousDetection)
+					MultiplePlanarObjectThread::DetectFeatures(this, this->synchronousDetector, this->synchronousTracker);
+				else
+					this->update = true;
 			}
 		}
 	}
 
 	// pose estimate
-	EnterCriticalSection(&MultiplePlanarObjectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csKeypointsUpdate", &MultiplePlanarObjectThread::csKeypointsUpdate);
 	for(int i=0; i<this->objectCount; i++)
 	{
 		if((int)refMatchedKeypoints[i].size() > MIN_FEATURE_POINTS_COUNT)
 		{
+			WINDAGE_PROFILE_OBJECT_SCOPE("MultiplePlanarObjectThreadTracking::pose", i);
 			this->estimator->AttatchReferencePoint(&(refMatchedKeypoints[i]));
 			this->estimator->AttatchScenePoint(&(sceMatchedKeypoints[i]));
 			this->estimator->Calculate();
@@ -402,7 +448,7 @@ void MultiplePlanarObjectThreadTracking::DrawDebugInfo(IplImage* colorImage, int
 		b = cvRound((double)255.0);
 	}
 
-	EnterCriticalSection(&MultiplePlanarObjectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("MultiplePlanarObjectThreadTracking::lock csKeypointsUpdate", &MultiplePlanarObjectThread::csKeypointsUpdate);
 	for(unsigned int i=0; i<refMatchedKeypoints[j].size(); i++)
 	{
 		CvPoint imagePoint = cvPoint((int)sceMatchedKeypoints[j][i].GetPoint().x, (int)sceMatchedKeypoints[j][i].GetPoint().y);
@@ -38,6 +38,7 @@
  * ======================================================================== */
 
 #include "Frameworks/MultiplePlanarObjectTracking.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Frameworks;
 
@@ -169,6 +170,32 @@ bool MultiplePlanarObjectTracking::TrainingReference(double scaleFactor, int sca
 		this->searchTree[i]->Training(&(this->referenceRepository[i]));
 	}
 
+	// dense alignment templates
+	if(this->aligner)
+	{
+		this->aligner->ClearTemplates();
+		this->templateToObject.resize(this->objectCount);
+		for(int i=0; i<objectCount; i++)
+		{
+			double scale = (double)ALIGNER_TEMPLATE_SIZE / (double)MAX(this->referenceImage[i]->width, this->referenceImage[i]->height);
+			if(scale > 1.0) scale = 1.0;
+
+			IplImage* templateImage = cvCreateImage(cvSize(cvRound(this->referenceImage[i]->width*scale), cvRound(this->referenceImage[i]->height*scale)), IPL_DEPTH_8U, 1);
+			cvResize(this->referenceImage[i], templateImage, CV_INTER_AREA);
+			cvSmooth(templateImage, templateImage, CV_GAUSSIAN, 3, 3);
+			this->aligner->AttatchTemplateImage(templateImage);
+
+			// same conversion as the reference keypoints
+			double xScaleFactor = this->realWidth / (double)templateImage->width;
+			double yScaleFactor = this->realHeight / (double)templateImage->height;
+			this->templateToObject[i] = windage::Matrix3(	xScaleFactor, 0.0, -this->realWidth/2.0,
+															0.0, -yScaleFactor, this->realHeight/2.0 + 1.0,
+															0.0, 0.0, 1.0);
+
+			cvReleaseImage(&templateImage);
+		}
+	}
+
 	this->trained = true;
 	return true;
 }
@@ -178,8 +205,11 @@ bool MultiplePlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	if(initialize == false || trained == false)
 		return false;
 
+	WINDAGE_PROFILE_FRAME("MultiplePlanarObjectTracking::frame");
+
 	// featur tracking routine
 	{
+		WINDAGE_PROFILE_SCOPE("MultiplePlanarObjectTracking::tracking");
 		std::vector<windage::FeaturePoint> sceneKeypoints1;
 		std::vector<windage::FeaturePoint> sceneKeypoints2;
 
@@ -191,7 +221,18 @@ bool MultiplePlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 			}
 		}
 
+		// share the image pyramid of the detector with the tracker (it is built once per frame)
+		IplImage* prevPyramid = NULL;
+		IplImage* currPyramid = NULL;
+		if(this->tracker->GetPyramidLevel() <= this->detector->GetPyramidLevel() && this->detector->UpdatePyramid(grayImage))
+		{
+			prevPyramid = this->detector->GetPreviousPyramid();
+			currPyramid = this->detector->GetPyramid();
+		}
+
+		this->tracker->AttatchPyramid(prevPyramid, currPyramid);
 		this->tracker->TrackFeatures(prevImage, grayImage, &sceneKeypoints1, &sceneKeypoints2);
+		this->tracker->AttatchPyramid(NULL, NULL);
 		
 		int iter = 0;
 		for(int i=0; i<this->objectCount; i++)
@@ -225,9 +266,13 @@ bool MultiplePlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 			objectID /= this->detectionRatio;
 			if(objectID < this->objectCount)
 			{
-				this->detector->DoExtractKeypointsDescriptor(grayImage);
+				{
+					WINDAGE_PROFILE_OBJECT_SCOPE("MultiplePlanarObjectTracking::feature", objectID);
+					this->detector->DoExtractKeypointsDescriptor(grayImage);
+				}
 				std::vector<windage::FeaturePoint>* sceneKeypoints = this->detector->GetKeypoints();
 
+				WINDAGE_PROFILE_OBJECT_SCOPE("MultiplePlanarObjectTracking::matching", objectID);
 				for(unsigned int i=0; i<sceneKeypoints->size(); i++)
 				{
 					int index = this->searchTree[objectID]->Matching((*sceneKeypoints)[i]);
@@ -248,10 +293,13 @@ bool MultiplePlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	}
 
 	// pose estimate
+	std::vector<bool> estimated(this->objectCount, false);
+	std::vector<windage::Matrix3> homographies(this->objectCount);
 	for(int i=0; i<this->objectCount; i++)
 	{
 		if((int)refMatchedKeypoints[i].size() > MIN_FEATURE_POINTS_COUNT)
 		{
+			WINDAGE_PROFILE_OBJECT_SCOPE("MultiplePlanarObjectTracking::pose", i);
 			this->estimator->AttatchReferencePoint(&(refMatchedKeypoints[i]));
 			this->estimator->AttatchScenePoint(&(sceMatchedKeypoints[i]));
 			this->estimator->Calculate();
@@ -283,6 +331,36 @@ bool MultiplePlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 				this->refiner->Calculate();
 			}
 
+			homographies[i] = *this->estimator->GetHomography();
+			estimated[i] = true;
+		}
+	}
+
+	// dense refinement of all estimated objects at once
+	if(this->aligner && this->aligner->GetTemplateCount() == this->objectCount)
+	{
+		WINDAGE_PROFILE_SCOPE("MultiplePlanarObjectTracking::align");
+		for(int i=0; i<this->objectCount; i++)
+		{
+			this->aligner->SetActive(i, estimated[i]);
+			if(estimated[i])
+				this->aligner->SetHomography(i, homographies[i] * this->templateToObject[i]);
+		}
+
+		this->aligner->Calculate(grayImage);
+
+		for(int i=0; i<this->objectCount; i++)
+		{
+			if(estimated[i] && this->aligner->IsAligned(i))
+				homographies[i] = this->aligner->GetHomography(i) * this->templateToObject[i].Inverse();
+		}
+	}
+
+	for(int i=0; i<this->objectCount; i++)
+	{
+		if(estimated[i])
+		{
+			(*this->estimator->GetHomography()) = homographies[i];
 			this->estimator->DecomposeHomography((this->cameraParameter[i]));
 
 			// filtering
@@ -38,6 +38,7 @@
  * ======================================================================== */
 
 #include "Frameworks/PlanarObjectTracking.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Frameworks;
 
@@ -146,6 +147,30 @@ bool PlanarObjectTracking::TrainingReference(double scaleFactor, int scaleStep)
 	}
 
 	this->matcher->Training(&this->referenceRepository);
+
+	// dense alignment template
+	if(this->aligner)
+	{
+		double scale = (double)ALIGNER_TEMPLATE_SIZE / (double)MAX(this->referenceImage->width, this->referenceImage->height);
+		if(scale > 1.0) scale = 1.0;
+
+		IplImage* templateImage = cvCreateImage(cvSize(cvRound(this->referenceImage->width*scale), cvRound(this->referenceImage->height*scale)), IPL_DEPTH_8U, 1);
+		cvResize(this->referenceImage, templateImage, CV_INTER_AREA);
+		cvSmooth(templateImage, templateImage, CV_GAUSSIAN, 3, 3);
+
+		this->aligner->ClearTemplates();
+		this->aligner->AttatchTemplateImage(templateImage);
+
+		// same conversion as the reference keypoints
+		double xScaleFactor = this->realWidth / (double)templateImage->width;
+		double yScaleFactor = this->realHeight / (double)templateImage->height;
+		this->templateToObject = windage::Matrix3(	xScaleFactor, 0.0, -this->realWidth/2.0,
+													0.0, -yScaleFactor, this->realHeight/2.0 + 1.0,
+													0.0, 0.0, 1.0);
+
+		cvReleaseImage(&templateImage);
+	}
+
 	this->trained = true;
 	return true;
 }
@@ -155,6 +180,8 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	if(initialize == false || trained == false)
 		return false;
 
+	WINDAGE_PROFILE_FRAME("PlanarObjectTracking::frame");
+
 	if(tracker == NULL)
 		this->SetDitectionRatio(-1);
 	
@@ -165,11 +192,24 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	}
 	else // featur tracking routine
 	{
+		WINDAGE_PROFILE_SCOPE("PlanarObjectTracking::tracking");
+
 		if(this->performance)
 			this->performance->updateTickCount();
 
+		// share the image pyramid of the detector with the tracker (it is built once per frame)
+		IplImage* prevPyramid = NULL;
+		IplImage* currPyramid = NULL;
+		if(this->tracker->GetPyramidLevel() <= this->detector->GetPyramidLevel() && this->detector->UpdatePyramid(grayImage))
+		{
+			prevPyramid = this->detector->GetPreviousPyramid();
+			currPyramid = this->detector->GetPyramid();
+		}
+
 		std::vector<windage::FeaturePoint> sceneKeypoints;
+		this->tracker->AttatchPyramid(prevPyramid, currPyramid);
 		this->tracker->TrackFeatures(prevImage, grayImage, &sceMatchedKeypoints, &sceneKeypoints);
+		this->tracker->AttatchPyramid(NULL, NULL);
 
 		int index = 0;
 		for(unsigned int i=0; i<sceneKeypoints.size(); i++)
@@ -199,7 +239,10 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 		if(this->performance)
 			this->performance->updateTickCount();
 
-		this->detector->DoExtractKeypointsDescriptor(grayImage);
+		{
+			WINDAGE_PROFILE_SCOPE("PlanarObjectTracking::feature");
+			this->detector->DoExtractKeypointsDescriptor(grayImage);
+		}
 
 		if(this->performance)
 			this->performance->log("feature", this->performance->calculateProcessTime());
@@ -209,6 +252,7 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 		if(this->performance)
 			this->performance->updateTickCount();
 
+		WINDAGE_PROFILE_SCOPE("PlanarObjectTracking::matching");
 		for(unsigned int i=0; i<sceneKeypoints->size(); i++)
 		{
 			int count = 0;
@@ -238,6 +282,7 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	int matchedCount = (int)refMatchedKeypoints.size();
 	if(matchedCount > MIN_FEATURE_POINTS_COUNT)
 	{
+		WINDAGE_PROFILE_SCOPE("PlanarObjectTracking::pose");
 
 		// pose estimate
 		this->estimator->AttatchReferencePoint(&refMatchedKeypoints);
@@ -273,6 +318,16 @@ bool PlanarObjectTracking::UpdateCamerapose(IplImage* grayImage)
 			this->refiner->Calculate();
 		}
 
+		// dense refinement
+		if(aligner && this->aligner->GetTemplateCount() > 0)
+		{
+			WINDAGE_PROFILE_SCOPE("PlanarObjectTracking::align");
+			this->aligner->SetHomography(0, (*this->estimator->GetHomography()) * this->templateToObject);
+			this->aligner->Calculate(grayImage);
+			if(this->aligner->IsAligned(0))
+				(*this->estimator->GetHomography()) = this->aligner->GetHomography(0) * this->templateToObject.Inverse();
+		}
+
 		this->estimator->DecomposeHomography(this->cameraParameter);
 
 		// filtering
@@ -38,7 +38,9 @@
  * ======================================================================== */
 
 #include "Algorithms/SIFTGPUdetector.h"
+#include "Algorithms/SIFTCPUdetector.h"
 #include "Frameworks/SingleObjectTracking.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Frameworks;
 
@@ -52,61 +54,86 @@ namespace SingleOjbectThread
 	CRITICAL_SECTION csKeypointsUpdate;
 	CRITICAL_SECTION csImageUpdate;
 
-	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	// SIFTGPUdetector requires an OpenGL context, SIFTCPUdetector runs on GPU-less nodes
+	windage::Algorithms::FeatureDetector* CreateDetector(SingleObjectTracking* thisClass)
+	{
+		if(thisClass->IsGPUDetection())
+			return new windage::Algorithms::SIFTGPUdetector();
+		else
+			return new windage::Algorithms::SIFTCPUdetector();
+	}
+
+	windage::Algorithms::OpticalFlow* CreateTracker(SingleObjectTracking* thisClass)
 	{
-		SingleObjectTracking* thisClass = (SingleObjectTracking*)pArg;
-		windage::Algorithms::SIFTGPUdetector* detector = new windage::Algorithms::SIFTGPUdetector();
 		windage::Algorithms::OpticalFlow* tracker = new windage::Algorithms::OpticalFlow(50);
 		tracker->Initialize(thisClass->GetSize().width, thisClass->GetSize().height, cvSize(15, 15), 3);
+		return tracker;
+	}
 
-		cvGetTickCount();
-
-		while(thisClass->processThread)
+	/**
+	 * detect and match the features at globalGrayImage and track them to globalCurrentGrayImage
+	 * (detection thread or synchronous detection)
+	 */
+	void DetectFeatures(SingleObjectTracking* thisClass, windage::Algorithms::FeatureDetector* detector, windage::Algorithms::OpticalFlow* tracker)
+	{
+		WINDAGE_PROFILE_SCOPE("SingleObjectTracking::detection");
+		// detect feature
+		detector->DoExtractKeypointsDescriptor(SingleOjbectThread::globalGrayImage);
+		std::vector<windage::FeaturePoint> refMatchedKeypoints;
+		std::vector<windage::FeaturePoint> sceMatchedKeypoints;
+		std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+
+		for(unsigned int i=0; i<sceneKeypoints->size(); i++)
 		{
-			if(thisClass->update)
+			int count = 0;
+			int index = thisClass->GetMatcher()->Matching((*sceneKeypoints)[i]);
+			if(0 <= index && index < (int)thisClass->referenceRepository.size())
 			{
-				// detect feature
-				detector->DoExtractKeypointsDescriptor(SingleOjbectThread::globalGrayImage);
-				std::vector<windage::FeaturePoint> refMatchedKeypoints;
-				std::vector<windage::FeaturePoint> sceMatchedKeypoints;
-				std::vector<windage::FeaturePoint>* sceneKeypoints = detector->GetKeypoints();
+				(*sceneKeypoints)[i].SetRepositoryID(index);
 
-				for(unsigned int i=0; i<sceneKeypoints->size(); i++)
-				{
-					int count = 0;
-					int index = thisClass->GetMatcher()->Matching((*sceneKeypoints)[i]);
-					if(0 <= index && index < (int)thisClass->referenceRepository.size())
-					{
-						(*sceneKeypoints)[i].SetRepositoryID(index);
-
-						refMatchedKeypoints.push_back(thisClass->referenceRepository[index]);
-						sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
-					}
-				}
+				refMatchedKeypoints.push_back(thisClass->referenceRepository[index]);
+				sceMatchedKeypoints.push_back((*sceneKeypoints)[i]);
+			}
+		}
 
-				// track feature
-				std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
-				EnterCriticalSection(&SingleOjbectThread::csImageUpdate);
-				tracker->TrackFeatures(SingleOjbectThread::globalGrayImage, SingleOjbectThread::globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
-				LeaveCriticalSection(&SingleOjbectThread::csImageUpdate);
+		// track feature
+		std::vector<windage::FeaturePoint> sceneUpdatedKeypoints;
+		WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csImageUpdate", &SingleOjbectThread::csImageUpdate);
+		tracker->TrackFeatures(SingleOjbectThread::globalGrayImage, SingleOjbectThread::globalCurrentGrayImage, &sceMatchedKeypoints, &sceneUpdatedKeypoints);
+		LeaveCriticalSection(&SingleOjbectThread::csImageUpdate);
 
-				for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
+		for(unsigned int i=0; i<sceneUpdatedKeypoints.size(); i++)
+		{
+			// if not tracked have point
+			int index = sceneUpdatedKeypoints[i].GetRepositoryID();
+			if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[index].IsTracked() == false)
+			{
+				WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csKeypointsUpdate", &SingleOjbectThread::csKeypointsUpdate);
 				{
-					// if not tracked have point
-					int index = sceneUpdatedKeypoints[i].GetRepositoryID();
-					if(sceneUpdatedKeypoints[i].IsOutlier() == false && thisClass->referenceRepository[index].IsTracked() == false)
-					{
-						EnterCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
-						{
-							thisClass->referenceRepository[index].SetTracked(true);
-
-							thisClass->refMatchedKeypoints.push_back(thisClass->referenceRepository[index]);
-							thisClass->sceMatchedKeypoints.push_back((sceneUpdatedKeypoints)[i]);
-						}
-						LeaveCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
-					}
+					thisClass->referenceRepository[index].SetTracked(true);
+
+					thisClass->refMatchedKeypoints.push_back(thisClass->referenceRepository[index]);
+					thisClass->sceMatchedKeypoints.push_back((sceneUpdatedKeypoints)[i]);
 				}
+				LeaveCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
+			}
+		}
+	}
+
+	unsigned int WINAPI FeatureDetectionThread(void* pArg)
+	{
+		SingleObjectTracking* thisClass = (SingleObjectTracking*)pArg;
+		windage::Algorithms::FeatureDetector* detector = CreateDetector(thisClass);
+		windage::Algorithms::OpticalFlow* tracker = CreateTracker(thisClass);
+
+		cvGetTickCount();
+		windage::Profiler::SetThreadName("SingleObjectTracking::detection");
 
+		while(thisClass->processThread)
+		{
+			if(thisClass->update)
+			{
+				DetectFeatures(thisClass, detector, tracker);
 				thisClass->update = false;
 			}
 		}
@@ -151,10 +178,20 @@ bool SingleObjectTracking::Initialize(int width, int height, bool printInfo)
 		std::cout << std::endl;
 	}
 
-	// create detection thread
+	// create detection thread (or detector of the synchronous detection)
 	InitializeCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
 	InitializeCriticalSection(&SingleOjbectThread::csImageUpdate);
-	_beginthreadex(NULL, 0, SingleOjbectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	if(this->synchronousDetection)
+	{
+		if(this->synchronousDetector) delete this->synchronousDetector;
+		if(this->synchronousTracker) delete this->synchronousTracker;
+		this->synchronousDetector = SingleOjbectThread::CreateDetector(this);
+		this->synchronousTracker = SingleOjbectThread::CreateTracker(this);
+	}
+	else
+	{
+		_beginthreadex(NULL, 0, SingleOjbectThread::FeatureDetectionThread, (void*)this, 0, NULL);
+	}
 
 	this->estimator->AttatchCameraParameter(this->cameraParameter);
 	this->initialize = true;
@@ -181,9 +218,12 @@ bool SingleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	if(initialize == false || trained == false)
 		return false;
 
+	WINDAGE_PROFILE_FRAME("SingleObjectTracking::frame");
+
 	// featur tracking routine
-	EnterCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csKeypointsUpdate", &SingleOjbectThread::csKeypointsUpdate);
 	{
+		WINDAGE_PROFILE_SCOPE("SingleObjectTracking::tracking");
 		std::vector<windage::FeaturePoint> sceneKeypoints;
 		this->tracker->TrackFeatures(prevImage, grayImage, &sceMatchedKeypoints, &sceneKeypoints);
 
@@ -206,7 +246,7 @@ bool SingleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 	}
 	LeaveCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
 
-	EnterCriticalSection(&SingleOjbectThread::csImageUpdate);
+	WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csImageUpdate", &SingleOjbectThread::csImageUpdate);
 	if(SingleOjbectThread::globalCurrentGrayImage)	cvCopyImage(grayImage, SingleOjbectThread::globalCurrentGrayImage);
 	else						SingleOjbectThread::globalCurrentGrayImage = cvCloneImage(grayImage);
 	LeaveCriticalSection(&SingleOjbectThread::csImageUpdate);
@@ -217,15 +257,19 @@ bool SingleObjectTracking::UpdateCamerapose(IplImage* grayImage)
 
 		if(SingleOjbectThread::globalGrayImage) cvCopyImage(grayImage, SingleOjbectThread::globalGrayImage);
 		else				SingleOjbectThread::globalGrayImage = cvCloneImage(grayImage);
-		this->update = true;
+		if(this->synchronousDetection)
+			SingleOjbectThread::DetectFeatures(this, this->synchronousDetector, this->synchronousTracker);
+		else
+			this->update = true;
 	}
 
 
 	if((int)refMatchedKeypoints.size() > MIN_FEATURE_POINTS_COUNT)
 	{
-		EnterCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
+		WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csKeypointsUpdate", &SingleOjbectThread::csKeypointsUpdate);
 		{
 			// pose estimate
+			WINDAGE_PROFILE_SCOPE("SingleObjectTracking::pose");
 			this->estimator->AttatchReferencePoint(&refMatchedKeypoints);
 			this->estimator->AttatchScenePoint(&sceMatchedKeypoints);
 			this->estimator->Calculate();
@@ -314,7 +358,7 @@ void SingleObjectTracking::DrawDebugInfo(IplImage* colorImage)
 	int g = 0;
 	int b = 0;
 
-	EnterCriticalSection(&SingleOjbectThread::csKeypointsUpdate);
+	WINDAGE_PROFILE_LOCK("SingleObjectTracking::lock csKeypointsUpdate", &SingleOjbectThread::csKeypointsUpdate);
 	for(unsigned int i=0; i<refMatchedKeypoints.size(); i++)
 	{
 		CvPoint imagePoint = cvPoint((int)sceMatchedKeypoints[i].GetPoint().x, (int)sceMatchedKeypoints[i].GetPoint().y);
@@ -37,6 +37,7 @@
  ** @author   Woonhyuk Baek
  * ======================================================================== */
 #include <stdio.h>
+#include <string.h>
 
 #include "Reconstruction/BundleWrapper.h"
 using namespace windage;
@@ -63,14 +64,66 @@ struct globs_{
 
 	double *ptparams;  /* needed only when bundle adjusting for camera parameters only */
 	double *camparams; /* needed only when bundle adjusting for structure parameters only */
+
+	double *camblocks; /* per camera blocks of the parallel evaluation mode (NULL is the serial evaluation) */
 } globs;
 
+void BundleObservations::EndPoint()
+{
+	int begin = this->pointOffset.back();
+	int end = (int)this->cameraIndex.size();
+
+	// insertion sort by camera index, the observation count of a point is small
+	for(int i=begin+1; i<end; i++)
+	{
+		int camera = this->cameraIndex[i];
+		double x = this->imagePoints[i*2+0];
+		double y = this->imagePoints[i*2+1];
+
+		int j = i - 1;
+		while(j >= begin && this->cameraIndex[j] > camera)
+		{
+			this->cameraIndex[j+1] = this->cameraIndex[j];
+			this->imagePoints[(j+1)*2+0] = this->imagePoints[j*2+0];
+			this->imagePoints[(j+1)*2+1] = this->imagePoints[j*2+1];
+			j--;
+		}
+		this->cameraIndex[j+1] = camera;
+		this->imagePoints[(j+1)*2+0] = x;
+		this->imagePoints[(j+1)*2+1] = y;
+	}
+
+	// remove the duplicated camera (keep the last one)
+	int count = begin;
+	for(int i=begin; i<end; i++)
+	{
+		if(count > begin && this->cameraIndex[count-1] == this->cameraIndex[i])
+			count--;
+
+		this->cameraIndex[count] = this->cameraIndex[i];
+		this->imagePoints[count*2+0] = this->imagePoints[i*2+0];
+		this->imagePoints[count*2+1] = this->imagePoints[i*2+1];
+		count++;
+	}
+	this->cameraIndex.resize(count);
+	this->imagePoints.resize(count*2);
+
+	this->pointOffset.push_back(count);
+}
+
 BundleWrapper::BundleWrapper(void)
 {
 	m_cnp = 6; /** dim. rt */
 	m_pnp = 3; /** dim . point */
 	m_mnp = 2; /** measurement */
 	m_itmax = 100; /** max iteration */
+	m_parallel = true;
+
+	m_pt3D = NULL;
+	m_RT = NULL;
+	m_observations = NULL;
+	m_nPT = 0;
+	m_nImage = 0;
 
 	/* set up globs structure */
 	globs.cnp = m_cnp; 
@@ -82,6 +135,24 @@ BundleWrapper::~BundleWrapper(void)
 }
 
 void BundleWrapper::SetParameters(CvMat *intrinsic, CvMat *pt3D, CvMat **pt2D, CvMat **RT, int nImage, int nPTs)
+{
+	this->m_denseObservations.Clear();
+	for(int p=0; p<nPTs; p++)
+	{
+		for(int i=0; i<nImage; i++)
+		{
+			double x = cvmGet(pt2D[i], 0, p);
+			double y = cvmGet(pt2D[i], 1, p);
+			if(x >= 0 || y >= 0)
+				this->m_denseObservations.AddObservation(i, x, y);
+		}
+		this->m_denseObservations.EndPoint();
+	}
+
+	this->SetParameters(intrinsic, pt3D, &this->m_denseObservations, RT, nImage, nPTs);
+}
+
+void BundleWrapper::SetParameters(CvMat *intrinsic, CvMat *pt3D, BundleObservations* observations, CvMat **RT, int nImage, int nPTs)
 {
 	m_intrinsicsba[0] = intrinsic->data.db[0];
 	m_intrinsicsba[1] = intrinsic->data.db[2];
@@ -91,6 +162,7 @@ void BundleWrapper::SetParameters(CvMat *intrinsic, CvMat *pt3D, CvMat **pt2D, C
 	globs.intrcalib = m_intrinsicsba;
 	globs.ptparams = NULL;
 	globs.camparams = NULL;
+	globs.camblocks = NULL;
 
 	/* call sparse LM routine */
 	m_opts[0]=SBA_INIT_MU; m_opts[1]=SBA_STOP_THRESH; m_opts[2]=SBA_STOP_THRESH;
@@ -99,7 +171,7 @@ void BundleWrapper::SetParameters(CvMat *intrinsic, CvMat *pt3D, CvMat **pt2D, C
 	m_opts[4]=0.0;
 
 	m_pt3D   = pt3D;
-	m_pt2D   = pt2D;
+	m_observations = observations;
 	m_RT     = RT;
 	m_nPT    = nPTs;
 	m_nImage = nImage;
@@ -112,10 +184,16 @@ bool BundleWrapper::Run()
 	int nconstframes = 1;
 	int verbose = 1;
 
+	if(m_observations == NULL || m_observations->GetPointCount() != m_nPT || m_observations->GetObservationCount() == 0)
+		return false;
+
+	/** sba takes the visibility as a byte mask, the measurements are the observation list itself */
 	char *vmask = (char *)malloc(m_nPT * m_nImage * sizeof(char));
 	double *motstruct = (double *)malloc((m_nImage * m_cnp + m_nPT * m_pnp)*sizeof(double));
-	double *imgpts = (double *)malloc(m_nPT * m_nImage * m_mnp * sizeof(double));
+	double *imgpts = &m_observations->imagePoints[0];
 	double *covimgpts = NULL; /** no covariance */
+	if(m_parallel)
+		globs.camblocks = (double *)malloc(m_nImage * CAMERA_BLOCK_SIZE * sizeof(double));
   
 	printf("Euclidean Sparse Bundle Adjustment ... \n");
 
@@ -158,34 +236,15 @@ bool BundleWrapper::Run()
 		pindex += 3;
 	}
 
-	/** 2D points */
-	pindex = 0;
-
-	for(int p=0; p<m_nPT; p++)
-	{
-		for(int i=0; i<m_nImage; i++)
-		{
-			if(cvmGet(m_pt2D[i], 0, p) > 0 && cvmGet(m_pt2D[i], 1, p) > 0)
-			{
-				imgpts[pindex] = cvmGet(m_pt2D[i], 0, p);
-				imgpts[pindex+1] = cvmGet(m_pt2D[i], 1, p);
-				pindex += 2;
-			}
-		}
-	}
-
 	/**
 	 * vmask
 	*/
-	pindex = 0;
+	memset(vmask, 0, m_nPT * m_nImage * sizeof(char));
 	for(int p=0; p<m_nPT; p++)
 	{
-		for(int i=0; i<m_nImage; i++)
+		for(int k=m_observations->pointOffset[p]; k<m_observations->pointOffset[p+1]; k++)
 		{
-			if(cvmGet(m_pt2D[i], 0, p) < 0 && cvmGet(m_pt2D[i], 1, p) < 0) vmask[pindex] = 0;
-			else vmask[pindex] = 1;
-
-			pindex++;
+			vmask[p * m_nImage + m_observations->cameraIndex[k]] = 1;
 		}
 	}
 
@@ -237,7 +296,8 @@ bool BundleWrapper::Run()
 
 	free(vmask);
 	free(motstruct);
-	free(imgpts);
+	if(globs.camblocks) free(globs.camblocks);
+	globs.camblocks = NULL;
 
 	return _ret;
 }
@@ -399,6 +459,21 @@ void BundleWrapper::img_projsRTS_x(double *p, struct sba_crsm *idxij, int *rcidx
 	m=idxij->nc;
 	pa=p; pb=p+m*cnp;
 
+	if(gl->camblocks != NULL){
+		/* parallel evaluation : camera blocks once, then the points (rows of idxij) are partitioned across the threads */
+		int n=idxij->nr;
+		#pragma omp parallel for
+		for(j=0; j<m; ++j)
+			calcCameraBlock(pa+j*cnp, pa+j*cnp+3, gl->camblocks + j*CAMERA_BLOCK_SIZE);
+
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(i=0; i<n; ++i){
+			int begin=idxij->rowptr[i];
+			calcImgProjBatch(Kparms, gl->camblocks, pb + i*pnp, idxij->colidx + begin, idxij->val + begin, idxij->rowptr[i+1] - begin, hx);
+		}
+		return;
+	}
+
 	for(j=0; j<m; ++j){
 		/* j-th camera parameters */
 		pqr=pa+j*cnp;
@@ -441,6 +516,21 @@ void BundleWrapper::img_projsRTS_jac_x(double *p, struct sba_crsm *idxij, int *r
 	pa=p; pb=p+m*cnp;
 	Asz=mnp*cnp; Bsz=mnp*pnp; ABsz=Asz+Bsz;
 
+	if(gl->camblocks != NULL){
+		/* parallel evaluation : same partition as img_projsRTS_x */
+		int n=idxij->nr;
+		#pragma omp parallel for
+		for(j=0; j<m; ++j)
+			calcCameraBlock(pa+j*cnp, pa+j*cnp+3, gl->camblocks + j*CAMERA_BLOCK_SIZE);
+
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(i=0; i<n; ++i){
+			int begin=idxij->rowptr[i];
+			calcImgProjJacRTSBatch(Kparms, gl->camblocks, pb + i*pnp, idxij->colidx + begin, idxij->val + begin, idxij->rowptr[i+1] - begin, jac);
+		}
+		return;
+	}
+
 	for(j=0; j<m; ++j){
 		/* j-th camera parameters */
 		pqr=pa+j*cnp;
@@ -458,6 +548,113 @@ void BundleWrapper::img_projsRTS_jac_x(double *p, struct sba_crsm *idxij, int *r
 		}
 	}
 }
+/* Computes the rotation matrix of the quaternion vector part v (the scalar part is sqrt(1 - |v|^2)),
+ * the derivatives of the rotation matrix with respect to v and copies the translation.
+ * The block is shared by the all observations of the camera at the batched kernels.
+ */
+void BundleWrapper::calcCameraBlock(double v[3], double t[3], double block[CAMERA_BLOCK_SIZE])
+{
+	double x = v[0];
+	double y = v[1];
+	double z = v[2];
+	double w = sqrt(1.0 - x*x - y*y - z*z);
+
+	double *R = block;
+	double *dR = block + 9;
+	double *T = block + 36;
+
+	R[0] = 1.0 - 2.0*(y*y + z*z);	R[1] = 2.0*(x*y - w*z);			R[2] = 2.0*(x*z + w*y);
+	R[3] = 2.0*(x*y + w*z);			R[4] = 1.0 - 2.0*(x*x + z*z);	R[5] = 2.0*(y*z - w*x);
+	R[6] = 2.0*(x*z - w*y);			R[7] = 2.0*(y*z + w*x);			R[8] = 1.0 - 2.0*(x*x + y*y);
+
+	/* dR/dv_k = pR/pv_k + pR/pw * dw/dv_k, dw/dv_k = -v_k / w */
+	double dRw[9] = { 0.0,    -2.0*z,  2.0*y,    2.0*z,  0.0,    -2.0*x,   -2.0*y,  2.0*x,  0.0    };
+	double dRx[9] = { 0.0,     2.0*y,  2.0*z,    2.0*y, -4.0*x,  -2.0*w,    2.0*z,  2.0*w, -4.0*x  };
+	double dRy[9] = {-4.0*y,   2.0*x,  2.0*w,    2.0*x,  0.0,     2.0*z,   -2.0*w,  2.0*z, -4.0*y  };
+	double dRz[9] = {-4.0*z,  -2.0*w,  2.0*x,    2.0*w, -4.0*z,   2.0*y,    2.0*x,  2.0*y,  0.0    };
+
+	double winv = 1.0 / w;
+	for(int k=0; k<9; k++)
+	{
+		dR[k]    = dRx[k] - x*winv*dRw[k];
+		dR[9+k]  = dRy[k] - y*winv*dRw[k];
+		dR[18+k] = dRz[k] - z*winv*dRw[k];
+	}
+
+	T[0] = t[0];
+	T[1] = t[1];
+	T[2] = t[2];
+}
+
+/* Batched projection of a point M to the observed cameras, same model as calcImgProj.
+ * hx_ij is stored at hx + measurements[k]*2 and the camera j is cameras[k].
+ */
+void BundleWrapper::calcImgProjBatch(double a[5], double *blocks, double M[3], int *cameras, int *measurements, int count, double *hx)
+{
+	const double fu = a[0];
+	const double fv = a[0]*a[3];
+
+	for(int k=0; k<count; k++)
+	{
+		const double *R = blocks + cameras[k]*CAMERA_BLOCK_SIZE;
+		const double *T = R + 36;
+
+		double X = R[0]*M[0] + R[1]*M[1] + R[2]*M[2] + T[0];
+		double Y = R[3]*M[0] + R[4]*M[1] + R[5]*M[2] + T[1];
+		double Z = R[6]*M[0] + R[7]*M[1] + R[8]*M[2] + T[2];
+		double iz = 1.0 / Z;
+
+		double *n = hx + measurements[k]*2;
+		n[0] = (fu*X + a[4]*Y)*iz + a[1];
+		n[1] = fv*Y*iz + a[2];
+	}
+}
+
+/* Batched jacobian of the projection of a point M, same as calcImgProjJacRTS.
+ * A_ij (2x6) and B_ij (2x3) are stored at jac + measurements[k]*18.
+ */
+void BundleWrapper::calcImgProjJacRTSBatch(double a[5], double *blocks, double M[3], int *cameras, int *measurements, int count, double *jac)
+{
+	const double fu = a[0];
+	const double fv = a[0]*a[3];
+
+	for(int k=0; k<count; k++)
+	{
+		const double *R = blocks + cameras[k]*CAMERA_BLOCK_SIZE;
+		const double *dR = R + 9;
+		const double *T = R + 36;
+
+		double X = R[0]*M[0] + R[1]*M[1] + R[2]*M[2] + T[0];
+		double Y = R[3]*M[0] + R[4]*M[1] + R[5]*M[2] + T[1];
+		double Z = R[6]*M[0] + R[7]*M[1] + R[8]*M[2] + T[2];
+		double iz = 1.0 / Z;
+
+		/* derivatives of the projection with respect to the camera coordinate */
+		double ju[3] = { fu*iz, a[4]*iz, -(fu*X + a[4]*Y)*iz*iz };
+		double jv[3] = { 0.0, fv*iz, -fv*Y*iz*iz };
+
+		double *pA = jac + measurements[k]*18;
+		double *pB = pA + 12;
+
+		for(int c=0; c<3; c++)
+		{
+			const double *D = dR + c*9;
+			double dX = D[0]*M[0] + D[1]*M[1] + D[2]*M[2];
+			double dY = D[3]*M[0] + D[4]*M[1] + D[5]*M[2];
+			double dZ = D[6]*M[0] + D[7]*M[1] + D[8]*M[2];
+
+			pA[c]     = ju[0]*dX + ju[1]*dY + ju[2]*dZ;
+			pA[6 + c] = jv[0]*dX + jv[1]*dY + jv[2]*dZ;
+
+			pA[3 + c] = ju[c];
+			pA[9 + c] = jv[c];
+
+			pB[c]     = ju[0]*R[c] + ju[1]*R[3+c] + ju[2]*R[6+c];
+			pB[3 + c] = jv[0]*R[c] + jv[1]*R[3+c] + jv[2]*R[6+c];
+		}
+	}
+}
+
 void BundleWrapper::calcImgProj(double a[5],double v[3],double t[3],double M[3],double n[2])
 {
   double t1;
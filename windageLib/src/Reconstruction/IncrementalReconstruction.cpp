@@ -42,10 +42,17 @@ using namespace windage;
 using namespace windage::Reconstruction;
 
 #include <iostream>
+#include <algorithm>
+#include <float.h>
+#include <windows.h>
+#include <process.h>
 
 #include "Algorithms/RANSACestimator.h"
 #include "Algorithms/OutlierChecker.h"
+#include "Algorithms/FLANNtree.h"
 #include "Reconstruction/BundleWrapper.h"
+#include "Reconstruction/SparseBundleAdjuster.h"
+#include "Utilities/Profiler.h"
 
 // Simple linear triangulation method 
 // See "Multiple view geometry" written by R.Hartely
@@ -147,22 +154,63 @@ int IncrementalReconstruction::MatchingCount(std::vector<windage::FeaturePoint>*
 	return count;
 }
 
+bool IncrementalReconstruction::Matching(int image, std::vector<windage::FeaturePoint>* feature2, std::vector<windage::FeaturePoint>* matchedPoint1, std::vector<windage::FeaturePoint>* matchedPoint2)
+{
+	std::vector<windage::FeaturePoint>* feature1 = &this->featurePointsList[image];
+	searchtree->Training(feature1);
+
+	for(unsigned int i=0; i<feature2->size(); i++)
+	{
+		int index = searchtree->Matching((*feature2)[i]);
+		if(index >= 0)
+		{
+			matchedPoint1->push_back((*feature1)[index]);
+			matchedPoint2->push_back((*feature2)[i]);
+			(*matchedPoint1)[matchedPoint1->size()-1].SetRepositoryID(index);
+			(*matchedPoint2)[matchedPoint1->size()-1].SetRepositoryID(i);
+		}
+	}
+	return true;
+}
+
+void IncrementalReconstruction::AddTrack(int image, int featureID, int pointID)
+{
+	this->featurePointsList[image][featureID].SetTracked(true);
+	this->featurePointsList[image][featureID].SetRepositoryID(pointID);
+
+	TrackReference track;
+	track.pointID = pointID;
+	track.featureID = featureID;
+	this->imageTracks[image].push_back(track);
+}
+
+void IncrementalReconstruction::AddObservation(windage::ReconstructionPoint* point, int image, windage::FeaturePoint& feature)
+{
+	// the repository id of the matched feature is its index at the image feature table
+	point->AddFeatureReference(image, feature.GetRepositoryID());
+	if(!this->compactObservation)
+		point->AddFeaturePoint(feature);
+}
+
 bool IncrementalReconstruction::StereoReconstruction(int index1, int index2)
 {
 	if(this->attatchedCount < 2)
 		return false;
 
+	WINDAGE_PROFILE_SCOPE("IncrementalReconstruction::stereo");
+
 	// release before data
 	reconstructionPoints.clear();
+	for(unsigned int i=0; i<this->imageTracks.size(); i++)
+		this->imageTracks[i].clear();
 
 	// matching
-	std::vector<windage::FeaturePoint>* feature1 = &featurePointsList[index1];
 	std::vector<windage::FeaturePoint>* feature2 = &featurePointsList[index2];
 
 	std::vector<windage::FeaturePoint> matchedPoint1;
 	std::vector<windage::FeaturePoint> matchedPoint2;
 
-	this->Matching(feature1, feature2, &matchedPoint1, &matchedPoint2);
+	this->Matching(index1, feature2, &matchedPoint1, &matchedPoint2);
 
 	if(matchedPoint1.size() < 10)
 		return false;
@@ -171,6 +219,7 @@ bool IncrementalReconstruction::StereoReconstruction(int index1, int index2)
 	stereo.SetReprojectionError(this->reprojectionError);
 	stereo.SetConfidence(this->confidence);
 	stereo.SetMaxIteration(this->maxIteration);
+	stereo.SetFivePointMethod(true);
 
 	stereo.AttatchBaseCameraParameter(this->GetCameraParameter(index1));
 	stereo.AttatchUpdateCameraParameter(this->GetCameraParameter(index2));
@@ -195,16 +244,14 @@ bool IncrementalReconstruction::StereoReconstruction(int index1, int index2)
 			
 			// reconstructed point is tracked
 			int index = (int)this->reconstructionPoints.size();
-			this->featurePointsList[index1][matchedPoint1[i].GetRepositoryID()].SetTracked(true);
-			this->featurePointsList[index2][matchedPoint2[i].GetRepositoryID()].SetTracked(true);
-			this->featurePointsList[index1][matchedPoint1[i].GetRepositoryID()].SetRepositoryID(index);
-			this->featurePointsList[index2][matchedPoint2[i].GetRepositoryID()].SetRepositoryID(index);
+			this->AddTrack(index1, matchedPoint1[i].GetRepositoryID(), index);
+			this->AddTrack(index2, matchedPoint2[i].GetRepositoryID(), index);
 
 			reconsturctionPoint.SetObjectID(index1);
 			matchedPoint1[i].SetObjectID(index1);
 			matchedPoint2[i].SetObjectID(index2);
-			reconsturctionPoint.AddFeaturePoint(matchedPoint1[i]);
-			reconsturctionPoint.AddFeaturePoint(matchedPoint2[i]);
+			this->AddObservation(&reconsturctionPoint, index1, matchedPoint1[i]);
+			this->AddObservation(&reconsturctionPoint, index2, matchedPoint2[i]);
 			reconsturctionPoint.SetColor(matchedPoint1[i].GetColor());
 			this->reconstructionPoints.push_back(reconsturctionPoint);
 			count++;
@@ -226,71 +273,61 @@ bool IncrementalReconstruction::IncrementReconstruction()
 	if(this->caculatedCount < 2)
 		return false;
 
-	// find best matching scene
+	WINDAGE_PROFILE_SCOPE("IncrementalReconstruction::increment");
+
+	// find best matching scene (the registered image that shares the most matches at the matching matrix)
 	int index = this->caculatedCount - 1;
-/*
-	int maxCount = 0;
-	for(int k=0; k<this->caculatedCount; k++)
+	if((int)this->matchingMatrix.size() == this->attatchedCount * this->attatchedCount)
 	{
-		std::vector<windage::FeaturePoint> reconstructedFeature;
-		reconstructedFeature.clear();
-		for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
-		{
-			windage::Vector4 point3D = this->reconstructionPoints[i].GetPoint();
-			std::vector<windage::FeaturePoint>* features = this->reconstructionPoints[i].GetFeatureList();
-			for(unsigned int j=0; j<features->size(); j++)
-			{
-				if((*features)[j].GetObjectID() == k)
-				{
-					reconstructedFeature.push_back((*features)[j]);
-					int idx = reconstructedFeature.size() - 1;
-					reconstructedFeature[idx].SetRepositoryID(i);
-					reconstructedFeature[idx].SetPoint(windage::Vector3(point3D.x, point3D.y, point3D.z));
-				}
-			}		
-		}
-
-		if((int)reconstructedFeature.size() > MINIMUM_MATCHING_COUNT)
+		int maxCount = 0;
+		for(int k=0; k<this->caculatedCount; k++)
 		{
-			int matchedCount = this->MatchingCount(&reconstructedFeature, &this->featurePointsList[this->caculatedCount]);
-			if(maxCount < matchedCount)
+			int matchedCount = this->GetMatchingCount(k, this->caculatedCount);
+			if((int)this->imageTracks[k].size() >= MINIMUM_MATCHING_COUNT && maxCount < matchedCount)
 			{
 				maxCount = matchedCount;
 				index = k;
 			}
 		}
+		if(this->verbose)
+		{
+			std::cout << std::endl;
+			std::cout << "best matching image index : " << index  << "(" << maxCount << ")" << std::endl;
+		}
 	}
-	std::cout << std::endl;
-	std::cout << "best matching image index : " << index  << "(" << maxCount << ")" << std::endl;
-//*/
 
 	// matching
-	std::vector<windage::FeaturePoint> feature1;
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
-	{
-		windage::Vector4 point3D = this->reconstructionPoints[i].GetPoint();
-		std::vector<windage::FeaturePoint>* features = this->reconstructionPoints[i].GetFeatureList();
-		for(unsigned int j=0; j<features->size(); j++)
-		{
-			if((*features)[j].GetObjectID() == index)
-			{
-				feature1.push_back((*features)[j]);
-				int idx = feature1.size() - 1;
-				feature1[idx].SetRepositoryID(i);
-				feature1[idx].SetPoint(windage::Vector3(point3D.x, point3D.y, point3D.z));
-			}
-		}		
-	}
 	std::vector<windage::FeaturePoint>* feature2 = &this->featurePointsList[this->caculatedCount];
-	if((int)feature1.size() < MINIMUM_MATCHING_COUNT)
+	if((int)this->imageTracks[index].size() < MINIMUM_MATCHING_COUNT)
 	{
 		this->caculatedCount++;
 		return false;
 	}
 
+	// one matching against all features of the image serves the registration and the triangulation
+	std::vector<windage::FeaturePoint> imageMatchedPoint1;
+	std::vector<windage::FeaturePoint> imageMatchedPoint2;
+	this->Matching(index, feature2, &imageMatchedPoint1, &imageMatchedPoint2);
+
+	// registration uses the matches of the tracked features (image feature -> reconstruction point from the track index)
+	std::vector<int> trackedPoint(this->featurePointsList[index].size(), -1);
+	for(unsigned int i=0; i<this->imageTracks[index].size(); i++)
+		trackedPoint[this->imageTracks[index][i].featureID] = this->imageTracks[index][i].pointID;
+
 	std::vector<windage::FeaturePoint> matchedPoint1;
 	std::vector<windage::FeaturePoint> matchedPoint2;
-	this->Matching(&feature1, feature2, &matchedPoint1, &matchedPoint2);
+	for(unsigned int i=0; i<imageMatchedPoint1.size(); i++)
+	{
+		int pointID = trackedPoint[imageMatchedPoint1[i].GetRepositoryID()];
+		if(pointID < 0)
+			continue;
+
+		windage::Vector4 point3D = this->reconstructionPoints[pointID].GetPoint();
+		matchedPoint1.push_back(imageMatchedPoint1[i]);
+		matchedPoint1[matchedPoint1.size()-1].SetRepositoryID(pointID);
+		matchedPoint1[matchedPoint1.size()-1].SetPoint(windage::Vector3(point3D.x, point3D.y, point3D.z));
+		matchedPoint2.push_back(imageMatchedPoint2[i]);
+	}
 
 	if((int)matchedPoint1.size() < MINIMUM_MATCHING_COUNT)
 	{
@@ -325,10 +362,8 @@ bool IncrementalReconstruction::IncrementReconstruction()
 	}
 
 	// reconstruction points
-	matchedPoint1.clear();
-	matchedPoint2.clear();
-	std::vector<windage::FeaturePoint>* feature = &this->featurePointsList[index];
-	this->Matching(feature, feature2, &matchedPoint1, &matchedPoint2);
+	matchedPoint1 = imageMatchedPoint1;
+	matchedPoint2 = imageMatchedPoint2;
 
 	// outlier rejection
 //*
@@ -437,8 +472,7 @@ bool IncrementalReconstruction::IncrementReconstruction()
 					errorR = sqrt(errorR);
 					if(errorL + errorR < this->reprojectionError * 2.0)
 					{
-						this->featurePointsList[this->caculatedCount][matchedPoint2[i].GetRepositoryID()].SetTracked(true);
-						this->featurePointsList[this->caculatedCount][matchedPoint2[i].GetRepositoryID()].SetRepositoryID(idx);
+						this->AddTrack(this->caculatedCount, matchedPoint2[i].GetRepositoryID(), idx);
 
 						matchedPoint2[i].SetObjectID(this->caculatedCount);
 
@@ -446,24 +480,21 @@ bool IncrementalReconstruction::IncrementReconstruction()
 						windage::Vector4 pt2 = this->reconstructionPoints[idx].GetPoint();
 						double error = pt1.getDistance(pt2);
 
-						this->reconstructionPoints[idx].AddFeaturePoint(matchedPoint2[i]);
+						this->AddObservation(&this->reconstructionPoints[idx], this->caculatedCount, matchedPoint2[i]);
 						addCount++;
 					}
 				}
 				else
 				{
 					int idx = this->reconstructionPoints.size();
-					this->featurePointsList[index][matchedPoint1[i].GetRepositoryID()].SetTracked(true);
-					this->featurePointsList[this->caculatedCount][matchedPoint2[i].GetRepositoryID()].SetTracked(true);
-
-					this->featurePointsList[index][matchedPoint1[i].GetRepositoryID()].SetRepositoryID(idx);
-					this->featurePointsList[this->caculatedCount][matchedPoint2[i].GetRepositoryID()].SetRepositoryID(idx);
+					this->AddTrack(index, matchedPoint1[i].GetRepositoryID(), idx);
+					this->AddTrack(this->caculatedCount, matchedPoint2[i].GetRepositoryID(), idx);
 
 					reconsturctionPoint.SetObjectID(index);
 					matchedPoint1[i].SetObjectID(index);
 					matchedPoint2[i].SetObjectID(this->caculatedCount);
-					reconsturctionPoint.AddFeaturePoint(matchedPoint1[i]);
-					reconsturctionPoint.AddFeaturePoint(matchedPoint2[i]);
+					this->AddObservation(&reconsturctionPoint, index, matchedPoint1[i]);
+					this->AddObservation(&reconsturctionPoint, this->caculatedCount, matchedPoint2[i]);
 
 					this->reconstructionPoints.push_back(reconsturctionPoint);
 					count++;
@@ -517,281 +548,539 @@ double IncrementalReconstruction::CheckReprojectionError(CvMat **RT, CvMat *pt3D
 	return error;
 }
 
-bool IncrementalReconstruction::BundleAdjustment()
+double IncrementalReconstruction::CheckReprojectionError(CvMat **RT, CvMat *pt3D, BundleObservations* observations, int n)
 {
-	int n = this->caculatedCount;
-	BundleWrapper* bundler = new windage::Reconstruction::BundleWrapper();
-	CvMat *pt3D, **pt2D, **RT;
-	
-	int pointcount = (int)this->reconstructionPoints.size();
+	double error = 0.0;
 
-	// set 3d points
-	pt3D = cvCreateMat(4, pointcount, CV_64F);
-	for(unsigned int j=0; j<this->reconstructionPoints.size(); j++)
+	// projection matrix of each camera
+	std::vector<double> projection(n * 12);
+	CvMat* proj = cvCreateMat(3, 4, CV_64F);
+	for(int i=0; i<n; i++)
 	{
-		windage::Vector4 point3D = this->reconstructionPoints[j].GetPoint();
-		point3D /= point3D.w;
-
-		cvmSet(pt3D, 0, j, point3D.x);
-		cvmSet(pt3D, 1, j, point3D.y);
-		cvmSet(pt3D, 2, j, point3D.z);
-		cvmSet(pt3D, 3, j, point3D.w);
+		cvMatMul(this->initialCameraParameter->GetIntrinsicMatrix(), RT[i], proj);
+		for(int k=0; k<12; k++)
+			projection[i*12 + k] = proj->data.db[k];
 	}
+	cvReleaseMat(&proj);
 
-	// set 2d image points
-	pt2D = new CvMat*[n];
-	for(int i=0; i<n; i++)
+	for(int j=0; j<observations->GetPointCount(); j++)
 	{
-		pt2D[i] = cvCreateMat(3, pointcount, CV_64F);
+		double X = cvmGet(pt3D, 0, j);
+		double Y = cvmGet(pt3D, 1, j);
+		double Z = cvmGet(pt3D, 2, j);
+		double W = cvmGet(pt3D, 3, j);
 
-		for(int j=0; j<pointcount; j++)
+		for(int k=observations->pointOffset[j]; k<observations->pointOffset[j+1]; k++)
 		{
-			cvmSet(pt2D[i], 0, j, -1.0);
-			cvmSet(pt2D[i], 1, j, -1.0);
-			cvmSet(pt2D[i], 2, j, 1.0);
+			const double* P = &projection[observations->cameraIndex[k] * 12];
+			double ww = 1.0 / (P[8]*X + P[9]*Y + P[10]*Z + P[11]*W);
+			double x = (P[0]*X + P[1]*Y + P[2]*Z + P[3]*W) * ww - observations->imagePoints[k*2+0];
+			double y = (P[4]*X + P[5]*Y + P[6]*Z + P[7]*W) * ww - observations->imagePoints[k*2+1];
+			error += sqrt(x*x + y*y);
 		}
 	}
 
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+	return error;
+}
+
+bool IncrementalReconstruction::BundleAdjustment()
+{
+	return this->BundleAdjustment(0, this->caculatedCount);
+}
+
+namespace windage
+{
+	namespace Reconstruction
+	{
+		/**
+		 * @brief	snapshot of a bundle adjustment window, refined apart from the reconstruction and merged back
+		 */
+		struct BundleTask
+		{
+			int startIndex;
+			int n;
+			std::vector<int> pointIndex;				///< reconstruction point index of each snapshot point
+			BundleObservations observations;
+			CvMat* intrinsic;
+			CvMat* pt3D;
+			CvMat** RT;
+			SparseBundleAdjuster* bundleAdjuster;		///< native adjuster (sba when NULL)
+
+			double scale;								///< ResizeScale applied after the snapshot : X' = (X - center) * scale
+			double center[3];
+
+			HANDLE thread;
+		};
+	}
+}
+
+static void RunBundleTask(BundleTask* task)
+{
+	int pointcount = (int)task->pointIndex.size();
+	if(task->bundleAdjuster)
+	{
+		task->bundleAdjuster->SetParameters(task->intrinsic, task->pt3D, &task->observations, task->RT, task->n, pointcount);
+		task->bundleAdjuster->Run();
+	}
+	else
+	{
+		BundleWrapper* bundler = new windage::Reconstruction::BundleWrapper();
+		bundler->SetParameters(task->intrinsic, task->pt3D, &task->observations, task->RT, task->n, pointcount);
+		bundler->Run();
+		delete bundler;
+	}
+}
+
+static unsigned int WINAPI BundleAdjustmentThread(void* pArg)
+{
+	RunBundleTask((BundleTask*)pArg);
+	return 0;
+}
+
+BundleTask* IncrementalReconstruction::CreateBundleTask(int startIndex, int n)
+{
+	BundleTask* task = new BundleTask();
+	task->startIndex = startIndex;
+	task->n = n;
+	task->bundleAdjuster = this->bundleAdjuster;
+	task->scale = 1.0;
+	task->center[0] = task->center[1] = task->center[2] = 0.0;
+	task->thread = NULL;
+
+	// select the points observed at the window from the track index
+	std::vector<int> windowPoints;
+	for(int k=startIndex; k<startIndex+n && k<(int)this->imageTracks.size(); k++)
+	{
+		for(unsigned int j=0; j<this->imageTracks[k].size(); j++)
+			windowPoints.push_back(this->imageTracks[k][j].pointID);
+	}
+	std::sort(windowPoints.begin(), windowPoints.end());
+	windowPoints.erase(std::unique(windowPoints.begin(), windowPoints.end()), windowPoints.end());
+
+	// store the observations (camera index is relative to the window)
+	task->observations.Reserve((int)windowPoints.size(), (int)windowPoints.size() * 2);
+	for(unsigned int p=0; p<windowPoints.size(); p++)
 	{
-		std::vector<windage::FeaturePoint>* features = this->reconstructionPoints[i].GetFeatureList();
+		int i = windowPoints[p];
+		std::vector<windage::FeatureReference>* referenceList = this->reconstructionPoints[i].GetReferenceList();
+		bool found = false;
+		for(unsigned int j=0; j<referenceList->size(); j++)
+		{
+			int objectID = (*referenceList)[j].imageID;
+			if(startIndex <= objectID && objectID < startIndex + n)
+			{
+				windage::Vector3 imagePoint = this->featurePointsList[objectID][(*referenceList)[j].featureID].GetPoint();
+				task->observations.AddObservation(objectID - startIndex, imagePoint.x, imagePoint.y);
+				found = true;
+			}
+		}
 
-		for(unsigned int j=0; j<features->size(); j++)
+		if(found)
 		{
-			int idx = (*features)[j].GetObjectID();
-			windage::Vector3 imagePoint = (*features)[j].GetPoint();
-			
-			cvmSet(pt2D[idx], 0, i, imagePoint.x);
-			cvmSet(pt2D[idx], 1, i, imagePoint.y);
-			cvmSet(pt2D[idx], 2, i, imagePoint.z);
+			task->observations.EndPoint();
+			task->pointIndex.push_back(i);
 		}
 	}
 
+	int pointcount = (int)task->pointIndex.size();
+	if(pointcount == 0)
+	{
+		delete task;
+		return NULL;
+	}
+
+	task->intrinsic = cvCloneMat(this->initialCameraParameter->GetIntrinsicMatrix());
+
+	// set 3d points
+	task->pt3D = cvCreateMat(4, pointcount, CV_64F);
+	for(int i=0; i<pointcount; i++)
+	{
+		windage::Vector4 point3D = this->reconstructionPoints[task->pointIndex[i]].GetPoint();
+		point3D /= point3D.w;
+
+		cvmSet(task->pt3D, 0, i, point3D.x);
+		cvmSet(task->pt3D, 1, i, point3D.y);
+		cvmSet(task->pt3D, 2, i, point3D.z);
+		cvmSet(task->pt3D, 3, i, point3D.w);
+	}
+
 	// RT
-	RT = new CvMat*[n];
+	task->RT = new CvMat*[n];
 	for(int i=0; i<n; i++)
 	{
-		RT[i] = cvCreateMat(3, 4, CV_64F);
+		task->RT[i] = cvCreateMat(3, 4, CV_64F);
 
-		CvMat* extrinsic = this->GetCameraParameter(i)->GetExtrinsicMatrix();
+		CvMat* extrinsic = this->GetCameraParameter(startIndex + i)->GetExtrinsicMatrix();
 		for(int y=0; y<3; y++)
 		{
 			for(int x=0; x<3; x++)
 			{
-				CV_MAT_ELEM((*RT[i]), double, y, x) = CV_MAT_ELEM((*extrinsic), double, y, x);
+				CV_MAT_ELEM((*task->RT[i]), double, y, x) = CV_MAT_ELEM((*extrinsic), double, y, x);
 			}
-			CV_MAT_ELEM((*RT[i]), double, y, 3) = CV_MAT_ELEM((*extrinsic), double, y, 3);
+			CV_MAT_ELEM((*task->RT[i]), double, y, 3) = CV_MAT_ELEM((*extrinsic), double, y, 3);
 		}
 	}
 
-	double error1 = this->CheckReprojectionError(RT, pt3D, pt2D, n);
-	bundler->SetParameters(this->initialCameraParameter->GetIntrinsicMatrix(),
-							pt3D, pt2D, RT, n, pointcount);
-	bundler->Run();
-	double error2 = this->CheckReprojectionError(RT, pt3D, pt2D, n);
+	return task;
+}
 
-	// update 3d points
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+void IncrementalReconstruction::MergeBundleTask(BundleTask* task)
+{
+	// update 3d points (points are only appended while the task runs, so the snapshot index stays valid)
+	for(unsigned int i=0; i<task->pointIndex.size(); i++)
 	{
 		windage::Vector4 point3D;
-		point3D.x = cvmGet(pt3D, 0, i);
-		point3D.y = cvmGet(pt3D, 1, i);
-		point3D.z = cvmGet(pt3D, 2, i);
-		point3D.w = cvmGet(pt3D, 3, i);
+		point3D.x = cvmGet(task->pt3D, 0, i);
+		point3D.y = cvmGet(task->pt3D, 1, i);
+		point3D.z = cvmGet(task->pt3D, 2, i);
+		point3D.w = cvmGet(task->pt3D, 3, i);
 		point3D /= point3D.w;
 
-		this->reconstructionPoints[i].SetPoint(point3D);
+		for(int k=0; k<3; k++)
+			point3D.v[k] = (point3D.v[k] - task->center[k]) * task->scale;
+
+		this->reconstructionPoints[task->pointIndex[i]].SetPoint(point3D);
 	}
 
 	// update to calibration 
-	for(int i=0; i<n; i++)
+	for(int i=0; i<task->n; i++)
 	{
-		CvMat* extrinsic = this->GetCameraParameter(i)->GetExtrinsicMatrix();
+		CvMat* extrinsic = this->GetCameraParameter(task->startIndex + i)->GetExtrinsicMatrix();
 		for(int y=0; y<3; y++)
 		{
 			for(int x=0; x<3; x++)
 			{
-				CV_MAT_ELEM((*extrinsic), double, y, x) = CV_MAT_ELEM((*RT[i]), double, y, x);
+				CV_MAT_ELEM((*extrinsic), double, y, x) = CV_MAT_ELEM((*task->RT[i]), double, y, x);
 			}
-			CV_MAT_ELEM((*extrinsic), double, y, 3) = CV_MAT_ELEM((*RT[i]), double, y, 3);
+			CV_MAT_ELEM((*extrinsic), double, y, 3) = CV_MAT_ELEM((*task->RT[i]), double, y, 3);
+		}
+
+		if(task->scale != 1.0 || task->center[0] != 0.0 || task->center[1] != 0.0 || task->center[2] != 0.0)
+		{
+			CvScalar position = this->GetCameraParameter(task->startIndex + i)->GetCameraPosition();
+			for(int k=0; k<3; k++)
+				position.val[k] = (position.val[k] - task->center[k]) * task->scale;
+			this->GetCameraParameter(task->startIndex + i)->SetCameraPosition(position);
 		}
 	}
-	
-	// release storage
-	cvReleaseMat(&pt3D);
-	for(int i=0; i<n; i++)
+}
+
+void IncrementalReconstruction::ReleaseBundleTask(BundleTask* task)
+{
+	if(task->thread)
+		CloseHandle(task->thread);
+
+	cvReleaseMat(&task->intrinsic);
+	cvReleaseMat(&task->pt3D);
+	for(int i=0; i<task->n; i++)
 	{
-		cvReleaseMat(&pt2D[i]);
-		cvReleaseMat(&RT[i]);
+		cvReleaseMat(&task->RT[i]);
 	}
-	delete [] pt2D;
-	delete [] RT;
-	delete bundler;
+	delete [] task->RT;
+	delete task;
+}
+
+bool IncrementalReconstruction::IsBundleAdjustmentRunning()
+{
+	if(this->bundleTask == NULL)
+		return false;
+	return WaitForSingleObject(this->bundleTask->thread, 0) != WAIT_OBJECT_0;
+}
 
+bool IncrementalReconstruction::MergeBundleAdjustment(bool wait)
+{
+	if(this->bundleTask == NULL)
+		return false;
+
+	if(WaitForSingleObject(this->bundleTask->thread, wait ? INFINITE : 0) != WAIT_OBJECT_0)
+		return false;
+
+	this->MergeBundleTask(this->bundleTask);
+	this->ReleaseBundleTask(this->bundleTask);
+	this->bundleTask = NULL;
 	return true;
 }
 
 bool IncrementalReconstruction::BundleAdjustment(int startIndex, int n)
 {
-	BundleWrapper* bundler = new windage::Reconstruction::BundleWrapper();
-	CvMat *pt3D, **pt2D, **RT;
-	
-	int pointcount = 0;
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+	// the attatched adjuster is shared with the worker
+	this->MergeBundleAdjustment(true);
+
+	BundleTask* task = this->CreateBundleTask(startIndex, n);
+	if(task == NULL)
+		return false;
+
+	RunBundleTask(task);
+	this->MergeBundleTask(task);
+	this->ReleaseBundleTask(task);
+
+	return true;
+}
+
+bool IncrementalReconstruction::BundleAdjustmentAsync(int startIndex, int n)
+{
+	// a previous window still running is not stopped; this window is skipped and the next one covers it
+	this->MergeBundleAdjustment(false);
+	if(this->bundleTask != NULL)
+		return false;
+
+	BundleTask* task = this->CreateBundleTask(startIndex, n);
+	if(task == NULL)
+		return false;
+
+	task->thread = (HANDLE)_beginthreadex(NULL, 0, BundleAdjustmentThread, (void*)task, 0, NULL);
+	if(task->thread == NULL)
 	{
-		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
-		bool found = false;
-		for(unsigned int j=0; j<featureList->size() && found==false; j++)
+		RunBundleTask(task);
+		this->MergeBundleTask(task);
+		this->ReleaseBundleTask(task);
+		return true;
+	}
+
+	this->bundleTask = task;
+	return true;
+}
+
+bool IncrementalReconstruction::CalculateMatchingMatrix()
+{
+	int imageCount = this->attatchedCount;
+	if(imageCount < 2)
+		return false;
+
+	WINDAGE_PROFILE_SCOPE("IncrementalReconstruction::matchingMatrix");
+
+	// images already in the matrix keep their counts, only the pairs with the new images are matched
+	int matchedCount = 0;
+	while(matchedCount * matchedCount < (int)this->matchingMatrix.size())
+		matchedCount++;
+	if(matchedCount * matchedCount != (int)this->matchingMatrix.size() || matchedCount > imageCount)
+		matchedCount = 0;
+	if(matchedCount == imageCount)
+		return true;
+
+	// vocabulary : words sampled at regular stride over the features of the images at the first call
+	if(this->vocabulary.size() == 0)
+	{
+		int totalCount = 0;
+		for(int i=0; i<imageCount; i++)
+			totalCount += (int)this->featurePointsList[i].size();
+		if(totalCount == 0)
+			return false;
+
+		int wordCount = MIN(this->vocabularySize, totalCount);
+		long long sample = 0;
+		for(int i=0; i<imageCount && (int)this->vocabulary.size() < wordCount; i++)
 		{
-			int objectID = (*featureList)[j].GetObjectID();
-			if(startIndex <= objectID && objectID < startIndex + n)
+			for(unsigned int j=0; j<this->featurePointsList[i].size() && (int)this->vocabulary.size() < wordCount; j++, sample++)
 			{
-				pointcount++;
-				found = true;
+				if((sample * wordCount) % totalCount < wordCount)
+					this->vocabulary.push_back(this->featurePointsList[i][j]);
 			}
 		}
 	}
+	int wordCount = (int)this->vocabulary.size();
+	int dimension = this->vocabulary[0].DESCRIPTOR_DIMENSION;
 
-	// set 3d points
-	pt3D = cvCreateMat(4, pointcount, CV_64F);
-
-	int index = 0;
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+	// word count of the new images
+	this->wordHistograms.resize(imageCount);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int i=matchedCount; i<imageCount; i++)
 	{
-		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
-		bool found = false;
-		for(unsigned int j=0; j<featureList->size(); j++)
+		std::vector<double>& h = this->wordHistograms[i];
+		h.assign(wordCount, 0.0);
+		for(unsigned int j=0; j<this->featurePointsList[i].size(); j++)
 		{
-			int objectID = (*featureList)[j].GetObjectID();
-			if(startIndex <= objectID && objectID < startIndex + n)
+			const double* descriptor = &this->featurePointsList[i][j].descriptor[0];
+			int minIndex = 0;
+			double minDistance = DBL_MAX;
+			for(int w=0; w<wordCount; w++)
 			{
-				windage::Vector4 point3D = this->reconstructionPoints[i].GetPoint();
-				point3D /= point3D.w;
-
-				cvmSet(pt3D, 0, index, point3D.x);
-				cvmSet(pt3D, 1, index, point3D.y);
-				cvmSet(pt3D, 2, index, point3D.z);
-				cvmSet(pt3D, 3, index, point3D.w);
-				found = true;
+				const double* word = &this->vocabulary[w].descriptor[0];
+				double distance = 0.0;
+				for(int k=0; k<dimension && distance < minDistance; k++)
+					distance += (descriptor[k] - word[k]) * (descriptor[k] - word[k]);
+				if(distance < minDistance)
+				{
+					minDistance = distance;
+					minIndex = w;
+				}
 			}
+			h[minIndex] += 1.0;
 		}
-
-		if(found)
-			index++;
 	}
 
-	// set 2d image points
-	pt2D = new CvMat*[n];
-	for(int i=0; i<n; i++)
+	// bag of words histogram of each image (tf-idf, unit length)
+	std::vector<double> histogram(imageCount * wordCount, 0.0);
+	for(int w=0; w<wordCount; w++)
+	{
+		int documentCount = 0;
+		for(int i=0; i<imageCount; i++)
+			if(this->wordHistograms[i][w] > 0.0) documentCount++;
+		double idf = log((double)imageCount / (double)MAX(1, documentCount));
+		for(int i=0; i<imageCount; i++)
+			histogram[i * wordCount + w] = this->wordHistograms[i][w] * idf;
+	}
+	for(int i=0; i<imageCount; i++)
 	{
-		pt2D[i] = cvCreateMat(3, pointcount, CV_64F);
+		double norm = 0.0;
+		for(int w=0; w<wordCount; w++)
+			norm += histogram[i * wordCount + w] * histogram[i * wordCount + w];
+		norm = norm > 0.0 ? 1.0 / sqrt(norm) : 0.0;
+		for(int w=0; w<wordCount; w++)
+			histogram[i * wordCount + w] *= norm;
+	}
 
-		for(int j=0; j<pointcount; j++)
+	// candidate pairs with a new image : one of them is in the most similar images of the other
+	int candidate = (this->candidateCount <= 0) ? imageCount - 1 : MIN(this->candidateCount, imageCount - 1);
+	std::vector<char> candidatePair(imageCount * imageCount, 0);
+	for(int i=0; i<imageCount; i++)
+	{
+		std::vector<std::pair<double, int>> similarity;
+		for(int j=0; j<imageCount; j++)
+		{
+			if(i == j)
+				continue;
+			double dot = 0.0;
+			for(int w=0; w<wordCount; w++)
+				dot += histogram[i * wordCount + w] * histogram[j * wordCount + w];
+			similarity.push_back(std::make_pair(-dot, j));
+		}
+		std::partial_sort(similarity.begin(), similarity.begin() + candidate, similarity.end());
+		for(int k=0; k<candidate; k++)
 		{
-			cvmSet(pt2D[i], 0, j, -1.0);
-			cvmSet(pt2D[i], 1, j, -1.0);
-			cvmSet(pt2D[i], 2, j, 1.0);
+			int j = similarity[k].second;
+			if(MAX(i, j) >= matchedCount)
+				candidatePair[MIN(i, j) * imageCount + MAX(i, j)] = 1;
 		}
 	}
 
-	index = 0;
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+	// grow the matrix
+	std::vector<int> matchingMatrix(imageCount * imageCount, 0);
+	for(int i=0; i<matchedCount; i++)
+		for(int j=0; j<matchedCount; j++)
+			matchingMatrix[i * imageCount + j] = this->matchingMatrix[i * matchedCount + j];
+	this->matchingMatrix.swap(matchingMatrix);
+
+	// match count of the candidate pairs, the index of each image is built once and queried by its own thread
+	this->imageMatchers.resize(imageCount, NULL);
+	double ratio = this->searchtree ? this->searchtree->GetRatio() : 0.7;
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int i=0; i<imageCount-1; i++)
 	{
-		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
-		bool found = false;
-		for(unsigned int j=0; j<featureList->size(); j++)
+		bool candidateFound = false;
+		for(int j=MAX(i+1, matchedCount); j<imageCount && !candidateFound; j++)
+			candidateFound = candidatePair[i * imageCount + j] != 0;
+		if(!candidateFound)
+			continue;
+
+		if(this->imageMatchers[i] == NULL)
 		{
-			int objectID = (*featureList)[j].GetObjectID();
-			if(startIndex <= objectID && objectID < startIndex + n)
+			windage::Algorithms::FLANNtree* tree = new windage::Algorithms::FLANNtree();
+			tree->SetRatio(ratio);
+			if(!tree->Training(&this->featurePointsList[i]))
 			{
-				int idx = objectID - startIndex;
-				windage::Vector3 imagePoint = (*featureList)[j].GetPoint();
-				
-				cvmSet(pt2D[idx], 0, index, imagePoint.x);
-				cvmSet(pt2D[idx], 1, index, imagePoint.y);
-				cvmSet(pt2D[idx], 2, index, imagePoint.z);
-				found = true;
+				delete tree;
+				continue;
 			}
+			this->imageMatchers[i] = tree;
 		}
 
-		if(found)
-			index++;
-	}
-
-	// RT
-	RT = new CvMat*[n];
-	for(int i=0; i<n; i++)
-	{
-		RT[i] = cvCreateMat(3, 4, CV_64F);
-
-		CvMat* extrinsic = this->GetCameraParameter(startIndex + i)->GetExtrinsicMatrix();
-		for(int y=0; y<3; y++)
+		for(int j=MAX(i+1, matchedCount); j<imageCount; j++)
 		{
-			for(int x=0; x<3; x++)
+			if(candidatePair[i * imageCount + j] == 0)
+				continue;
+
+			int count = 0;
+			for(unsigned int k=0; k<this->featurePointsList[j].size(); k++)
 			{
-				CV_MAT_ELEM((*RT[i]), double, y, x) = CV_MAT_ELEM((*extrinsic), double, y, x);
+				if(this->imageMatchers[i]->Matching(this->featurePointsList[j][k]) >= 0)
+					count++;
 			}
-			CV_MAT_ELEM((*RT[i]), double, y, 3) = CV_MAT_ELEM((*extrinsic), double, y, 3);
+			this->matchingMatrix[i * imageCount + j] = count;
+			this->matchingMatrix[j * imageCount + i] = count;
 		}
 	}
 
-	double error1 = this->CheckReprojectionError(RT, pt3D, pt2D, n);
-	bundler->SetParameters(this->initialCameraParameter->GetIntrinsicMatrix(),
-							pt3D, pt2D, RT, n, pointcount);
-	bundler->Run();
-	double error2 = this->CheckReprojectionError(RT, pt3D, pt2D, n);
+	return true;
+}
+
+bool IncrementalReconstruction::ArrangeImageOrder()
+{
+	int imageCount = this->attatchedCount;
+	if((int)this->matchingMatrix.size() != imageCount * imageCount)
+		return false;
+	if(this->caculatedCount > 0)
+		return false;
 
-	// update 3d points
-	index = 0;
-	for(unsigned int i=0; i<this->reconstructionPoints.size(); i++)
+	// seed pair : the pair with the most matches
+	int seed1 = 0, seed2 = 1;
+	for(int i=0; i<imageCount; i++)
 	{
-		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
-		bool found = false;
-		for(unsigned int j=0; j<featureList->size(); j++)
+		for(int j=i+1; j<imageCount; j++)
 		{
-			int objectID = (*featureList)[j].GetObjectID();
-			if(startIndex <= objectID && objectID < startIndex + n)
+			if(this->matchingMatrix[i * imageCount + j] > this->matchingMatrix[seed1 * imageCount + seed2])
 			{
-				windage::Vector4 point3D;
-				point3D.x = cvmGet(pt3D, 0, index);
-				point3D.y = cvmGet(pt3D, 1, index);
-				point3D.z = cvmGet(pt3D, 2, index);
-				point3D.w = cvmGet(pt3D, 3, index);
-				point3D /= point3D.w;
-
-				this->reconstructionPoints[i].SetPoint(point3D);
-				found = true;
+				seed1 = i;
+				seed2 = j;
 			}
 		}
-
-		if(found)
-			index++;
 	}
 
-	// update to calibration 
-	for(int i=0; i<n; i++)
+	// registration order : the image that matches best with one of the registered images
+	std::vector<int> order;
+	std::vector<char> registered(imageCount, 0);
+	order.push_back(seed1);		registered[seed1] = 1;
+	order.push_back(seed2);		registered[seed2] = 1;
+	while((int)order.size() < imageCount)
 	{
-		CvMat* extrinsic = this->GetCameraParameter(startIndex + i)->GetExtrinsicMatrix();
-		for(int y=0; y<3; y++)
+		int next = -1;
+		int maxCount = -1;
+		for(int j=0; j<imageCount; j++)
 		{
-			for(int x=0; x<3; x++)
+			if(registered[j])
+				continue;
+			for(unsigned int k=0; k<order.size(); k++)
 			{
-				CV_MAT_ELEM((*extrinsic), double, y, x) = CV_MAT_ELEM((*RT[i]), double, y, x);
+				if(this->matchingMatrix[order[k] * imageCount + j] > maxCount)
+				{
+					maxCount = this->matchingMatrix[order[k] * imageCount + j];
+					next = j;
+				}
 			}
-			CV_MAT_ELEM((*extrinsic), double, y, 3) = CV_MAT_ELEM((*RT[i]), double, y, 3);
 		}
+		order.push_back(next);
+		registered[next] = 1;
 	}
-	
-	// release storage
-	cvReleaseMat(&pt3D);
-	for(int i=0; i<n; i++)
+
+	// rearrange the attatched images
+	std::vector<std::vector<windage::FeaturePoint>> featurePointsList(imageCount);
+	std::vector<windage::Calibration*> cameraParameters(imageCount);
+	std::vector<int> matchingMatrix(imageCount * imageCount);
+	std::vector<int> imageOrder(imageCount);
+	std::vector<windage::Algorithms::SearchTree*> imageMatchers(imageCount, NULL);
+	std::vector<std::vector<double>> wordHistograms(imageCount);
+	for(int i=0; i<imageCount; i++)
 	{
-		cvReleaseMat(&pt2D[i]);
-		cvReleaseMat(&RT[i]);
+		featurePointsList[i].swap(this->featurePointsList[order[i]]);
+		if(order[i] < (int)this->imageMatchers.size()) imageMatchers[i] = this->imageMatchers[order[i]];
+		if(order[i] < (int)this->wordHistograms.size()) wordHistograms[i].swap(this->wordHistograms[order[i]]);
+		cameraParameters[i] = this->cameraParameters[order[i]];
+		imageOrder[i] = (int)this->imageOrder.size() == imageCount ? this->imageOrder[order[i]] : order[i];
+		for(int j=0; j<imageCount; j++)
+			matchingMatrix[i * imageCount + j] = this->matchingMatrix[order[i] * imageCount + order[j]];
+	}
+	this->featurePointsList.swap(featurePointsList);
+	this->cameraParameters.swap(cameraParameters);
+	this->matchingMatrix.swap(matchingMatrix);
+	this->imageOrder.swap(imageOrder);
+	this->imageMatchers.swap(imageMatchers);
+	this->wordHistograms.swap(wordHistograms);
+
+	if(this->verbose)
+	{
+		std::cout << std::endl;
+		std::cout << "seed image pair : " << seed1 << "-" << seed2 << " (" << this->matchingMatrix[1] << ")" << std::endl;
 	}
-	delete [] pt2D;
-	delete [] RT;
-	delete bundler;
 
 	return true;
 }
@@ -801,6 +1090,9 @@ void IncrementalReconstruction::AttatchFeaturePoint(std::vector<windage::Feature
 	this->attatchedCount++;
 	this->cameraParameters.resize(this->attatchedCount);
 	this->featurePointsList.resize(this->attatchedCount);
+	this->imageTracks.resize(this->attatchedCount);
+	if(this->imageOrder.size() > 0)
+		this->imageOrder.push_back(this->attatchedCount-1);
 
 	double fx = this->initialCameraParameter->GetParameters()[0];
 	double fy = this->initialCameraParameter->GetParameters()[1];
@@ -827,6 +1119,9 @@ bool IncrementalReconstruction::CalculateStep(int step)
 	if(this->initialCameraParameter == NULL)
 		return false;
 
+	// safe point : merge the finished background window before the registration reads the poses
+	this->MergeBundleAdjustment(false);
+
 	if(n == 2)
 	{
 		this->StereoReconstruction();
@@ -837,6 +1132,12 @@ bool IncrementalReconstruction::CalculateStep(int step)
 		this->caculatedCount = step-1;
 		this->IncrementReconstruction();
 //		this->BundleAdjustment(this->caculatedCount);
+
+		if(this->asynchronousBundle)
+		{
+			int STEP = MIN(n, BUNDLE_STEP);
+			this->BundleAdjustmentAsync(n-STEP, STEP);
+		}
 	}
 
 	return true;
@@ -849,6 +1150,10 @@ bool IncrementalReconstruction::CalculateAll()
 	if(this->initialCameraParameter == NULL)
 		return false;
 
+	// registration order : the best matching pair is the seed, each next image matches well with the registered ones
+	if(this->caculatedCount == 0 && this->CalculateMatchingMatrix())
+		this->ArrangeImageOrder();
+
 	this->StereoReconstruction();
 	this->BundleAdjustment();
 
@@ -872,14 +1177,15 @@ bool IncrementalReconstruction::UpdateColor()
 	int count = (unsigned)this->reconstructionPoints.size();
 	for(int i=0; i<count; i++)
 	{
-		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
-		int featureCount = featureList->size();
+		std::vector<windage::FeatureReference>* referenceList = this->reconstructionPoints[i].GetReferenceList();
+		int featureCount = referenceList->size();
 
 		CvScalar color = cvScalarAll(0);
 		for(int j=0; j<featureCount; j++)
 		{
+			windage::FeaturePoint* feature = &this->featurePointsList[(*referenceList)[j].imageID][(*referenceList)[j].featureID];
 			for(int k=0; k<3; k++)
-				color.val[k] += (*featureList)[j].GetColor().val[k];
+				color.val[k] += feature->GetColor().val[k];
 		}
 		for(int k=0; k<3; k++)
 			color.val[k] /= (double)featureCount;
@@ -890,6 +1196,53 @@ bool IncrementalReconstruction::UpdateColor()
 	return true;
 }
 
+bool IncrementalReconstruction::UpdateFeatureList()
+{
+	int count = (int)this->reconstructionPoints.size();
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int i=0; i<count; i++)
+	{
+		std::vector<windage::FeatureReference>* referenceList = this->reconstructionPoints[i].GetReferenceList();
+		std::vector<windage::FeaturePoint>* featureList = this->reconstructionPoints[i].GetFeatureList();
+		featureList->resize(referenceList->size());
+		for(unsigned int j=0; j<referenceList->size(); j++)
+		{
+			(*featureList)[j] = this->featurePointsList[(*referenceList)[j].imageID][(*referenceList)[j].featureID];
+			(*featureList)[j].SetObjectID((*referenceList)[j].imageID);
+			(*featureList)[j].SetRepositoryID((*referenceList)[j].featureID);
+		}
+	}
+
+	return true;
+}
+
+bool IncrementalReconstruction::UpdateMeanDescriptor()
+{
+	int count = (int)this->reconstructionPoints.size();
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int i=0; i<count; i++)
+	{
+		std::vector<windage::FeatureReference>* referenceList = this->reconstructionPoints[i].GetReferenceList();
+		std::vector<double>* descriptor = this->reconstructionPoints[i].GetMeanDescriptor();
+		descriptor->clear();
+		if(referenceList->size() == 0)
+			continue;
+
+		int dimension = this->featurePointsList[(*referenceList)[0].imageID][(*referenceList)[0].featureID].DESCRIPTOR_DIMENSION;
+		descriptor->assign(dimension, 0.0);
+		for(unsigned int j=0; j<referenceList->size(); j++)
+		{
+			windage::FeaturePoint* feature = &this->featurePointsList[(*referenceList)[j].imageID][(*referenceList)[j].featureID];
+			for(int k=0; k<dimension; k++)
+				(*descriptor)[k] += feature->descriptor[k];
+		}
+		for(int k=0; k<dimension; k++)
+			(*descriptor)[k] /= (double)referenceList->size();
+	}
+
+	return true;
+}
+
 bool IncrementalReconstruction::ResizeScale(double scale)
 {
 	windage::Vector4 center;
@@ -908,6 +1261,14 @@ bool IncrementalReconstruction::ResizeScale(double scale)
 	distance /= (double)count;
 	scale = scale / distance;
 
+	// the running window is merged in the resized coordinate
+	if(this->bundleTask)
+	{
+		for(int k=0; k<3; k++)
+			this->bundleTask->center[k] += center.v[k] / this->bundleTask->scale;
+		this->bundleTask->scale *= scale;
+	}
+
 	// points translation
 	for(int i=0; i<count; i++)
 	{
@@ -0,0 +1,877 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <stdio.h>
+#include <math.h>
+
+#include "Reconstruction/SparseBundleAdjuster.h"
+#include "Utilities/Profiler.h"
+using namespace windage;
+using namespace windage::Reconstruction;
+
+/* small dense block helpers (row-major) */
+
+/* C (r x c) += s * A^T (k x r) * B (k x c) */
+static inline void AddAtB(double* C, const double* A, const double* B, int k, int r, int c, double s)
+{
+	for(int i=0; i<r; i++)
+		for(int j=0; j<c; j++)
+		{
+			double sum = 0.0;
+			for(int l=0; l<k; l++)
+				sum += A[l*r + i] * B[l*c + j];
+			C[i*c + j] += s * sum;
+		}
+}
+
+/* C (r x c) -= A (r x k) * B^T (c x k) */
+static inline void SubABt(double* C, const double* A, const double* B, int r, int k, int c)
+{
+	for(int i=0; i<r; i++)
+		for(int j=0; j<c; j++)
+		{
+			double sum = 0.0;
+			for(int l=0; l<k; l++)
+				sum += A[i*k + l] * B[j*k + l];
+			C[i*c + j] -= sum;
+		}
+}
+
+/* inverse of the symmetric 3 x 3 matrix, returns false when it is singular */
+static inline bool Inverse3x3(const double* A, double* Ainv)
+{
+	double c00 = A[4]*A[8] - A[5]*A[7];
+	double c01 = A[5]*A[6] - A[3]*A[8];
+	double c02 = A[3]*A[7] - A[4]*A[6];
+	double det = A[0]*c00 + A[1]*c01 + A[2]*c02;
+	if(fabs(det) < 1.0e-300)
+		return false;
+
+	double idet = 1.0 / det;
+	Ainv[0] = c00 * idet;
+	Ainv[1] = (A[2]*A[7] - A[1]*A[8]) * idet;
+	Ainv[2] = (A[1]*A[5] - A[2]*A[4]) * idet;
+	Ainv[3] = c01 * idet;
+	Ainv[4] = (A[0]*A[8] - A[2]*A[6]) * idet;
+	Ainv[5] = (A[2]*A[3] - A[0]*A[5]) * idet;
+	Ainv[6] = c02 * idet;
+	Ainv[7] = (A[1]*A[6] - A[0]*A[7]) * idet;
+	Ainv[8] = (A[0]*A[4] - A[1]*A[3]) * idet;
+	return true;
+}
+
+/* in-place cholesky decomposition (lower triangle) of the n x n matrix, rows of each column are computed in parallel */
+static bool CholeskyDecomposition(double* A, int n)
+{
+	for(int j=0; j<n; j++)
+	{
+		double* Aj = A + j*n;
+		double d = Aj[j];
+		for(int k=0; k<j; k++)
+			d -= Aj[k] * Aj[k];
+		if(d <= 0.0)
+			return false;
+		d = sqrt(d);
+		Aj[j] = d;
+
+		double id = 1.0 / d;
+		#pragma omp parallel for schedule(static) if(n - j > 256)
+		for(int i=j+1; i<n; i++)
+		{
+			double* Ai = A + i*n;
+			double sum = Ai[j];
+			for(int k=0; k<j; k++)
+				sum -= Ai[k] * Aj[k];
+			Ai[j] = sum * id;
+		}
+	}
+	return true;
+}
+
+/* solves L L^T x = b with the decomposed matrix */
+static void CholeskySolve(const double* L, int n, const double* b, double* x)
+{
+	for(int i=0; i<n; i++)
+	{
+		double sum = b[i];
+		for(int k=0; k<i; k++)
+			sum -= L[i*n + k] * x[k];
+		x[i] = sum / L[i*n + i];
+	}
+	for(int i=n-1; i>=0; i--)
+	{
+		double sum = x[i];
+		for(int k=i+1; k<n; k++)
+			sum -= L[k*n + i] * x[k];
+		x[i] = sum / L[i*n + i];
+	}
+}
+
+/* in-place cholesky decomposition of the lower triangle stored by rows inside the envelope,
+   row i keeps the columns first[i]..i from offset[i] and the factor has no fill-in outside of the envelope */
+static bool EnvelopeCholeskyDecomposition(double* A, const int* first, const int* offset, int n)
+{
+	for(int j=0; j<n; j++)
+	{
+		double* Aj = A + offset[j] - first[j];
+		double d = Aj[j];
+		for(int k=first[j]; k<j; k++)
+			d -= Aj[k] * Aj[k];
+		if(d <= 0.0)
+			return false;
+		d = sqrt(d);
+		Aj[j] = d;
+
+		double id = 1.0 / d;
+		#pragma omp parallel for schedule(static) if(n - j > 256)
+		for(int i=j+1; i<n; i++)
+		{
+			if(first[i] > j)
+				continue;
+
+			double* Ai = A + offset[i] - first[i];
+			double sum = Ai[j];
+			for(int k=MAX(first[i], first[j]); k<j; k++)
+				sum -= Ai[k] * Aj[k];
+			Ai[j] = sum * id;
+		}
+	}
+	return true;
+}
+
+/* solves L L^T x = b with the decomposed envelope matrix */
+static void EnvelopeCholeskySolve(const double* L, const int* first, const int* offset, int n, const double* b, double* x)
+{
+	for(int i=0; i<n; i++)
+	{
+		const double* Li = L + offset[i] - first[i];
+		double sum = b[i];
+		for(int k=first[i]; k<i; k++)
+			sum -= Li[k] * x[k];
+		x[i] = sum / Li[i];
+	}
+	for(int i=n-1; i>=0; i--)
+	{
+		const double* Li = L + offset[i] - first[i];
+		x[i] /= Li[i];
+		for(int k=first[i]; k<i; k++)
+			x[k] -= Li[k] * x[i];
+	}
+}
+
+/* R = exp([w]x) (rodrigues formula) */
+static void Rodrigues(const double* w, double* R)
+{
+	double theta = sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+	double K[9] = {0.0, -w[2], w[1],  w[2], 0.0, -w[0],  -w[1], w[0], 0.0};
+	double a = 1.0;
+	double b = 0.5;
+	if(theta > 1.0e-12)
+	{
+		a = sin(theta) / theta;
+		b = (1.0 - cos(theta)) / (theta * theta);
+	}
+
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+		{
+			double K2 = K[i*3+0]*K[0*3+j] + K[i*3+1]*K[1*3+j] + K[i*3+2]*K[2*3+j];
+			R[i*3+j] = (i == j ? 1.0 : 0.0) + a*K[i*3+j] + b*K2;
+		}
+}
+
+void SparseBundleAdjuster::SetParameters(CvMat *intrinsic, CvMat *pt3D, BundleObservations* observations, CvMat **RT, int nImage, int nPTs)
+{
+	this->intrinsic[0] = cvmGet(intrinsic, 0, 0);
+	this->intrinsic[1] = cvmGet(intrinsic, 1, 1);
+	this->intrinsic[2] = cvmGet(intrinsic, 0, 1);
+	this->intrinsic[3] = cvmGet(intrinsic, 0, 2);
+	this->intrinsic[4] = cvmGet(intrinsic, 1, 2);
+
+	this->pt3D = pt3D;
+	this->observations = observations;
+	this->RT = RT;
+	this->cameraCount = nImage;
+	this->pointCount = nPTs;
+}
+
+double SparseBundleAdjuster::RobustWeight(double squaredError)
+{
+	double scale2 = this->lossScale * this->lossScale;
+	switch(this->lossFunction)
+	{
+	case LOSS_HUBER:
+		return (squaredError <= scale2) ? 1.0 : this->lossScale / sqrt(squaredError);
+	case LOSS_CAUCHY:
+		return 1.0 / (1.0 + squaredError / scale2);
+	default:
+		return 1.0;
+	}
+}
+
+double SparseBundleAdjuster::RobustCost(double squaredError)
+{
+	double scale2 = this->lossScale * this->lossScale;
+	switch(this->lossFunction)
+	{
+	case LOSS_HUBER:
+		return (squaredError <= scale2) ? squaredError : 2.0 * this->lossScale * sqrt(squaredError) - scale2;
+	case LOSS_CAUCHY:
+		return scale2 * log(1.0 + squaredError / scale2);
+	default:
+		return squaredError;
+	}
+}
+
+double SparseBundleAdjuster::EvaluateCost(std::vector<double>& cameras, std::vector<double>& points, double* meanError, int* behindCount)
+{
+	const double* K = this->intrinsic;
+	const int n = this->pointCount;
+	const double behindError = (double)BEHIND_CAMERA_ERROR;
+	const double behindCost = this->RobustCost(behindError * behindError);
+	double cost = 0.0;
+	double error = 0.0;
+	int behind = 0;
+
+	#pragma omp parallel for schedule(dynamic, 64) reduction(+:cost, error, behind)
+	for(int p=0; p<n; p++)
+	{
+		const double* X = &points[p*3];
+		for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+		{
+			const double* R = &cameras[this->observations->cameraIndex[k] * 12];
+			const double* t = R + 9;
+			double x = R[0]*X[0] + R[1]*X[1] + R[2]*X[2] + t[0];
+			double y = R[3]*X[0] + R[4]*X[1] + R[5]*X[2] + t[1];
+			double z = R[6]*X[0] + R[7]*X[1] + R[8]*X[2] + t[2];
+			if(z <= 1.0e-12)
+			{
+				// the observation keeps a fixed penalty instead of dropping out of the cost
+				cost += behindCost;
+				error += behindError;
+				behind++;
+				continue;
+			}
+
+			double iz = 1.0 / z;
+			double du = K[0]*x*iz + K[2]*y*iz + K[3] - this->observations->imagePoints[k*2+0];
+			double dv = K[1]*y*iz + K[4] - this->observations->imagePoints[k*2+1];
+			double e2 = du*du + dv*dv;
+			cost += this->RobustCost(e2);
+			error += sqrt(e2);
+		}
+	}
+
+	if(meanError)
+		*meanError = error / MAX(1, this->observations->GetObservationCount());
+	if(behindCount)
+		*behindCount = behind;
+	return cost;
+}
+
+void SparseBundleAdjuster::Linearize(std::vector<double>& cameras, std::vector<double>& points)
+{
+	const double* K = this->intrinsic;
+	const int m = this->cameraCount;
+	const int n = this->pointCount;
+
+	// per point : jacobians, V, W and point gradient (each point owns its observations)
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int p=0; p<n; p++)
+	{
+		const double* X = &points[p*3];
+		double* V = &this->blockV[p*9];
+		double* gp = &this->gradientPoint[p*3];
+		for(int i=0; i<9; i++) V[i] = 0.0;
+		for(int i=0; i<3; i++) gp[i] = 0.0;
+
+		for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+		{
+			const double* R = &cameras[this->observations->cameraIndex[k] * 12];
+			const double* t = R + 9;
+			double* Jc = &this->jacobianCamera[k*12];
+			double* Jp = &this->jacobianPoint[k*6];
+			double* r = &this->residual[k*2];
+			double* W = &this->blockW[k*18];
+			for(int i=0; i<12; i++) Jc[i] = 0.0;
+			for(int i=0; i<6; i++) Jp[i] = 0.0;
+			for(int i=0; i<18; i++) W[i] = 0.0;
+			r[0] = r[1] = 0.0;
+			this->weight[k] = 0.0;
+
+			// rotated point q = R X
+			double q[3];
+			q[0] = R[0]*X[0] + R[1]*X[1] + R[2]*X[2];
+			q[1] = R[3]*X[0] + R[4]*X[1] + R[5]*X[2];
+			q[2] = R[6]*X[0] + R[7]*X[1] + R[8]*X[2];
+			double x = q[0] + t[0];
+			double y = q[1] + t[1];
+			double z = q[2] + t[2];
+			if(z <= 1.0e-12)
+				continue;
+
+			double iz = 1.0 / z;
+			r[0] = K[0]*x*iz + K[2]*y*iz + K[3] - this->observations->imagePoints[k*2+0];
+			r[1] = K[1]*y*iz + K[4] - this->observations->imagePoints[k*2+1];
+			double w = this->RobustWeight(r[0]*r[0] + r[1]*r[1]);
+			this->weight[k] = w;
+
+			// derivatives of the projection with respect to the camera coordinate
+			double J[6] = {	K[0]*iz,	K[2]*iz,	-(K[0]*x + K[2]*y)*iz*iz,
+							0.0,		K[1]*iz,	-K[1]*y*iz*iz };
+
+			// left perturbation R <- exp([dw]x) R : d(RX)/d(dw) = -[q]x, d/dt = I, d/dX = R
+			double dq[9] = {	0.0,	q[2],	-q[1],
+								-q[2],	0.0,	q[0],
+								q[1],	-q[0],	0.0 };
+			for(int row=0; row<2; row++)
+			{
+				const double* Jr = J + row*3;
+				for(int c=0; c<3; c++)
+				{
+					Jc[row*6 + c] = Jr[0]*dq[0*3+c] + Jr[1]*dq[1*3+c] + Jr[2]*dq[2*3+c];
+					Jc[row*6 + 3 + c] = Jr[c];
+					Jp[row*3 + c] = Jr[0]*R[c] + Jr[1]*R[3+c] + Jr[2]*R[6+c];
+				}
+			}
+
+			AddAtB(V, Jp, Jp, 2, 3, 3, w);
+			AddAtB(W, Jc, Jp, 2, 6, 3, w);
+			for(int c=0; c<3; c++)
+				gp[c] -= w * (Jp[c]*r[0] + Jp[3+c]*r[1]);
+		}
+	}
+
+	// per camera : U and camera gradient
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(int c=0; c<m; c++)
+	{
+		double* U = &this->blockU[c*36];
+		double* gc = &this->gradientCamera[c*6];
+		for(int i=0; i<36; i++) U[i] = 0.0;
+		for(int i=0; i<6; i++) gc[i] = 0.0;
+
+		for(int l=this->cameraOffset[c]; l<this->cameraOffset[c+1]; l++)
+		{
+			int k = this->cameraObservation[l];
+			const double* Jc = &this->jacobianCamera[k*12];
+			const double* r = &this->residual[k*2];
+			double w = this->weight[k];
+
+			AddAtB(U, Jc, Jc, 2, 6, 6, w);
+			for(int i=0; i<6; i++)
+				gc[i] -= w * (Jc[i]*r[0] + Jc[6+i]*r[1]);
+		}
+	}
+}
+
+bool SparseBundleAdjuster::SolveCholesky(std::vector<double>& dampedU, std::vector<double>& b, int variableOffset, std::vector<double>& x)
+{
+	const int m = this->cameraCount;
+	const int nv = m - variableOffset;
+	const int N = nv * 6;
+
+	// envelope of the reduced camera system : block row a starts at the first camera sharing a point with camera a
+	std::vector<int> firstBlock(nv);
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(int a=0; a<nv; a++)
+	{
+		int ca = a + variableOffset;
+		int first = a;
+		for(int l=this->cameraOffset[ca]; l<this->cameraOffset[ca+1]; l++)
+		{
+			// the observations of a point are sorted by camera
+			int p = this->observationPoint[this->cameraObservation[l]];
+			for(int k2=this->observations->pointOffset[p]; k2<this->observations->pointOffset[p+1]; k2++)
+			{
+				int cb = this->observations->cameraIndex[k2];
+				if(cb >= variableOffset)
+				{
+					first = MIN(first, cb - variableOffset);
+					break;
+				}
+			}
+		}
+		firstBlock[a] = first;
+	}
+
+	std::vector<int> first(N), offset(N + 1, 0);
+	for(int i=0; i<N; i++)
+	{
+		first[i] = firstBlock[i/6] * 6;
+		offset[i+1] = offset[i] + (i - first[i] + 1);
+	}
+
+	// lower triangle of S = U - sum W V^-1 W^T inside the envelope, each thread fills its own block rows
+	std::vector<double> S(offset[N], 0.0);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int a=0; a<nv; a++)
+	{
+		int ca = a + variableOffset;
+		double block[36];
+		for(int i=0; i<6; i++)
+			for(int j=0; j<=i; j++)
+				S[offset[a*6 + i] + a*6 + j - first[a*6 + i]] = dampedU[ca*36 + i*6 + j];
+
+		for(int l=this->cameraOffset[ca]; l<this->cameraOffset[ca+1]; l++)
+		{
+			int k = this->cameraObservation[l];
+			int p = this->observationPoint[k];
+			const double* Y = &this->blockY[k*18];
+
+			for(int k2=this->observations->pointOffset[p]; k2<this->observations->pointOffset[p+1]; k2++)
+			{
+				int cb = this->observations->cameraIndex[k2];
+				if(cb < variableOffset || cb > ca)
+					continue;
+
+				int bIndex = cb - variableOffset;
+				for(int i=0; i<36; i++) block[i] = 0.0;
+				SubABt(block, Y, &this->blockW[k2*18], 6, 3, 6);
+				for(int i=0; i<6; i++)
+				{
+					double* row = &S[offset[a*6 + i] - first[a*6 + i]];
+					int jEnd = (bIndex == a) ? i : 5;
+					for(int j=0; j<=jEnd; j++)
+						row[bIndex*6 + j] += block[i*6 + j];
+				}
+			}
+		}
+	}
+
+	if(!EnvelopeCholeskyDecomposition(&S[0], &first[0], &offset[0], N))
+		return false;
+
+	x.resize(N);
+	EnvelopeCholeskySolve(&S[0], &first[0], &offset[0], N, &b[0], &x[0]);
+	return true;
+}
+
+bool SparseBundleAdjuster::SolvePCG(std::vector<double>& dampedU, std::vector<double>& b, int variableOffset, std::vector<double>& x)
+{
+	const int m = this->cameraCount;
+	const int n = this->pointCount;
+	const int nv = m - variableOffset;
+	const int N = nv * 6;
+
+	// block-Jacobi preconditioner : cholesky of the diagonal blocks of the reduced system
+	std::vector<double> precondition(nv * 36);
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(int a=0; a<nv; a++)
+	{
+		int ca = a + variableOffset;
+		double* P = &precondition[a*36];
+		for(int i=0; i<36; i++)
+			P[i] = dampedU[ca*36 + i];
+		for(int l=this->cameraOffset[ca]; l<this->cameraOffset[ca+1]; l++)
+		{
+			int k = this->cameraObservation[l];
+			SubABt(P, &this->blockY[k*18], &this->blockW[k*18], 6, 3, 6);
+		}
+		if(!CholeskyDecomposition(P, 6))
+		{
+			// fall back to the damped U block
+			for(int i=0; i<36; i++)
+				P[i] = dampedU[ca*36 + i];
+			CholeskyDecomposition(P, 6);
+		}
+	}
+
+	std::vector<double> r(b), z(N), d(N), q(N), tp(n * 3);
+	x.assign(N, 0.0);
+
+	// z = M^-1 r
+	#pragma omp parallel for
+	for(int a=0; a<nv; a++)
+		CholeskySolve(&precondition[a*36], 6, &r[a*6], &z[a*6]);
+	d = z;
+
+	double rz = 0.0, bb = 0.0;
+	for(int i=0; i<N; i++)
+	{
+		rz += r[i] * z[i];
+		bb += b[i] * b[i];
+	}
+	if(bb <= 0.0)
+		return true;
+
+	for(int it=0; it<this->maxPCGIteration; it++)
+	{
+		// q = S d (implicit) : tp = V^-1 sum W^T d per point, q = U d - sum W tp per camera
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(int p=0; p<n; p++)
+		{
+			double s[3] = {0.0, 0.0, 0.0};
+			for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+			{
+				int c = this->observations->cameraIndex[k];
+				if(c < variableOffset)
+					continue;
+				const double* W = &this->blockW[k*18];
+				const double* dc = &d[(c - variableOffset)*6];
+				for(int j=0; j<3; j++)
+					for(int i=0; i<6; i++)
+						s[j] += W[i*3 + j] * dc[i];
+			}
+			const double* Vinv = &this->blockVinv[p*9];
+			for(int j=0; j<3; j++)
+				tp[p*3 + j] = Vinv[j*3+0]*s[0] + Vinv[j*3+1]*s[1] + Vinv[j*3+2]*s[2];
+		}
+
+		#pragma omp parallel for schedule(dynamic, 4)
+		for(int a=0; a<nv; a++)
+		{
+			int ca = a + variableOffset;
+			const double* U = &dampedU[ca*36];
+			double* qa = &q[a*6];
+			for(int i=0; i<6; i++)
+			{
+				qa[i] = 0.0;
+				for(int j=0; j<6; j++)
+					qa[i] += U[i*6 + j] * d[a*6 + j];
+			}
+			for(int l=this->cameraOffset[ca]; l<this->cameraOffset[ca+1]; l++)
+			{
+				int k = this->cameraObservation[l];
+				const double* W = &this->blockW[k*18];
+				const double* t = &tp[this->observationPoint[k]*3];
+				for(int i=0; i<6; i++)
+					qa[i] -= W[i*3+0]*t[0] + W[i*3+1]*t[1] + W[i*3+2]*t[2];
+			}
+		}
+
+		double dq = 0.0;
+		for(int i=0; i<N; i++)
+			dq += d[i] * q[i];
+		if(dq <= 0.0)
+			break;
+
+		double alpha = rz / dq;
+		double rr = 0.0;
+		for(int i=0; i<N; i++)
+		{
+			x[i] += alpha * d[i];
+			r[i] -= alpha * q[i];
+			rr += r[i] * r[i];
+		}
+		if(rr <= this->pcgTolerance * this->pcgTolerance * bb)
+			break;
+
+		#pragma omp parallel for
+		for(int a=0; a<nv; a++)
+			CholeskySolve(&precondition[a*36], 6, &r[a*6], &z[a*6]);
+
+		double rzNew = 0.0;
+		for(int i=0; i<N; i++)
+			rzNew += r[i] * z[i];
+		double beta = rzNew / rz;
+		rz = rzNew;
+		for(int i=0; i<N; i++)
+			d[i] = z[i] + beta * d[i];
+	}
+
+	return true;
+}
+
+bool SparseBundleAdjuster::SolveStep(double lambda, int variableOffset, std::vector<double>& deltaCamera, std::vector<double>& deltaPoint)
+{
+	const int m = this->cameraCount;
+	const int n = this->pointCount;
+	const int nv = m - variableOffset;
+
+	// damped V^-1 and Y = W V^-1
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int p=0; p<n; p++)
+	{
+		double V[9];
+		for(int i=0; i<9; i++)
+			V[i] = this->blockV[p*9 + i];
+		for(int i=0; i<3; i++)
+			V[i*4] += lambda * V[i*4] + 1.0e-12;
+
+		double* Vinv = &this->blockVinv[p*9];
+		if(!Inverse3x3(V, Vinv))
+		{
+			for(int i=0; i<9; i++)
+				Vinv[i] = 0.0;
+		}
+
+		for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+		{
+			const double* W = &this->blockW[k*18];
+			double* Y = &this->blockY[k*18];
+			for(int i=0; i<6; i++)
+				for(int j=0; j<3; j++)
+					Y[i*3 + j] = W[i*3+0]*Vinv[0*3+j] + W[i*3+1]*Vinv[1*3+j] + W[i*3+2]*Vinv[2*3+j];
+		}
+	}
+
+	deltaCamera.assign(m * 6, 0.0);
+	deltaPoint.assign(n * 3, 0.0);
+
+	if(nv > 0)
+	{
+		// damped U and reduced gradient b = g_c - sum Y g_p
+		std::vector<double> dampedU(this->blockU);
+		std::vector<double> b(nv * 6);
+
+		#pragma omp parallel for schedule(dynamic, 4)
+		for(int c=0; c<m; c++)
+		{
+			for(int i=0; i<6; i++)
+				dampedU[c*36 + i*7] += lambda * this->blockU[c*36 + i*7] + 1.0e-12;
+
+			if(c < variableOffset)
+				continue;
+
+			double* bc = &b[(c - variableOffset)*6];
+			for(int i=0; i<6; i++)
+				bc[i] = this->gradientCamera[c*6 + i];
+			for(int l=this->cameraOffset[c]; l<this->cameraOffset[c+1]; l++)
+			{
+				int k = this->cameraObservation[l];
+				const double* Y = &this->blockY[k*18];
+				const double* gp = &this->gradientPoint[this->observationPoint[k]*3];
+				for(int i=0; i<6; i++)
+					bc[i] -= Y[i*3+0]*gp[0] + Y[i*3+1]*gp[1] + Y[i*3+2]*gp[2];
+			}
+		}
+
+		bool useCholesky = this->linearSolver == SOLVER_CHOLESKY ||
+						   (this->linearSolver == SOLVER_AUTO && nv <= this->choleskyCameraLimit);
+
+		std::vector<double> x;
+		bool solved = useCholesky ? this->SolveCholesky(dampedU, b, variableOffset, x) : this->SolvePCG(dampedU, b, variableOffset, x);
+		if(!solved)
+			return false;
+
+		for(int i=0; i<nv*6; i++)
+			deltaCamera[variableOffset*6 + i] = x[i];
+	}
+
+	// back substitution dX = V^-1 (g_p - sum W^T dc)
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int p=0; p<n; p++)
+	{
+		double s[3];
+		for(int j=0; j<3; j++)
+			s[j] = this->gradientPoint[p*3 + j];
+		for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+		{
+			const double* W = &this->blockW[k*18];
+			const double* dc = &deltaCamera[this->observations->cameraIndex[k]*6];
+			for(int j=0; j<3; j++)
+				for(int i=0; i<6; i++)
+					s[j] -= W[i*3 + j] * dc[i];
+		}
+
+		const double* Vinv = &this->blockVinv[p*9];
+		for(int j=0; j<3; j++)
+			deltaPoint[p*3 + j] = Vinv[j*3+0]*s[0] + Vinv[j*3+1]*s[1] + Vinv[j*3+2]*s[2];
+	}
+
+	return true;
+}
+
+bool SparseBundleAdjuster::Run()
+{
+	if(this->pt3D == NULL || this->RT == NULL || this->observations == NULL)
+		return false;
+	if(this->observations->GetPointCount() != this->pointCount || this->observations->GetObservationCount() == 0)
+		return false;
+
+	WINDAGE_PROFILE_SCOPE("SparseBundleAdjuster::run");
+
+	const int m = this->cameraCount;
+	const int n = this->pointCount;
+	const int nobs = this->observations->GetObservationCount();
+	const int variableOffset = MIN(this->fixedCameraCount, m);
+
+	// camera -> observation index
+	this->cameraOffset.assign(m + 1, 0);
+	this->cameraObservation.resize(nobs);
+	this->observationPoint.resize(nobs);
+	for(int p=0; p<n; p++)
+	{
+		for(int k=this->observations->pointOffset[p]; k<this->observations->pointOffset[p+1]; k++)
+		{
+			this->observationPoint[k] = p;
+			this->cameraOffset[this->observations->cameraIndex[k] + 1]++;
+		}
+	}
+	for(int c=0; c<m; c++)
+		this->cameraOffset[c+1] += this->cameraOffset[c];
+	std::vector<int> fill(this->cameraOffset.begin(), this->cameraOffset.end() - 1);
+	for(int k=0; k<nobs; k++)
+		this->cameraObservation[fill[this->observations->cameraIndex[k]]++] = k;
+
+	this->jacobianCamera.resize(nobs * 12);
+	this->jacobianPoint.resize(nobs * 6);
+	this->residual.resize(nobs * 2);
+	this->weight.resize(nobs);
+	this->blockW.resize(nobs * 18);
+	this->blockY.resize(nobs * 18);
+	this->blockU.resize(m * 36);
+	this->blockV.resize(n * 9);
+	this->blockVinv.resize(n * 9);
+	this->gradientCamera.resize(m * 6);
+	this->gradientPoint.resize(n * 3);
+
+	// parameters : R (9) t (3) per camera, X (3) per point
+	std::vector<double> cameras(m * 12), points(n * 3);
+	for(int c=0; c<m; c++)
+	{
+		for(int i=0; i<3; i++)
+		{
+			for(int j=0; j<3; j++)
+				cameras[c*12 + i*3 + j] = cvmGet(this->RT[c], i, j);
+			cameras[c*12 + 9 + i] = cvmGet(this->RT[c], i, 3);
+		}
+	}
+	for(int p=0; p<n; p++)
+	{
+		double w = cvmGet(this->pt3D, 3, p);
+		for(int i=0; i<3; i++)
+			points[p*3 + i] = cvmGet(this->pt3D, i, p) / w;
+	}
+
+	if(this->verbose)
+		printf("Native Sparse Bundle Adjustment (%d cameras, %d points, %d observations) ... \n", m, n, nobs);
+
+	int behindCount = 0;
+	double cost = this->EvaluateCost(cameras, points, &this->initialError, &behindCount);
+	this->initialCost = cost;
+	this->finalError = this->initialError;
+
+	std::vector<double> deltaCamera, deltaPoint;
+	std::vector<double> newCameras(m * 12), newPoints(n * 3);
+	double lambda = 1.0e-3;
+
+	for(this->iteration=0; this->iteration<this->maxIteration; this->iteration++)
+	{
+		// no step can decrease an exact fit, lambda would only grow until the limit
+		if(cost <= this->costTolerance)
+			break;
+
+		this->Linearize(cameras, points);
+
+		bool accepted = false;
+		double newCost = cost;
+		double newError = this->finalError;
+		int newBehindCount = behindCount;
+		while(!accepted && lambda < 1.0e16)
+		{
+			if(!this->SolveStep(lambda, variableOffset, deltaCamera, deltaPoint))
+			{
+				lambda *= 10.0;
+				continue;
+			}
+
+			#pragma omp parallel for
+			for(int c=0; c<m; c++)
+			{
+				double dR[9];
+				const double* R = &cameras[c*12];
+				double* Rn = &newCameras[c*12];
+				Rodrigues(&deltaCamera[c*6], dR);
+				for(int i=0; i<3; i++)
+				{
+					for(int j=0; j<3; j++)
+						Rn[i*3 + j] = dR[i*3+0]*R[0*3+j] + dR[i*3+1]*R[1*3+j] + dR[i*3+2]*R[2*3+j];
+					Rn[9 + i] = R[9 + i] + deltaCamera[c*6 + 3 + i];
+				}
+			}
+			for(int i=0; i<n*3; i++)
+				newPoints[i] = points[i] + deltaPoint[i];
+
+			// the step which moves more points behind the cameras is rejected (diverging step)
+			newCost = this->EvaluateCost(newCameras, newPoints, &newError, &newBehindCount);
+			if(newCost < cost && newBehindCount <= behindCount)
+			{
+				accepted = true;
+				lambda = MAX(lambda * 0.1, 1.0e-12);
+			}
+			else
+			{
+				lambda *= 10.0;
+			}
+		}
+
+		if(!accepted)
+			break;
+
+		double decrease = cost - newCost;
+		cameras.swap(newCameras);
+		points.swap(newPoints);
+		cost = newCost;
+		behindCount = newBehindCount;
+		this->finalError = newError;
+
+		if(this->verbose)
+			printf("\titeration %d : cost %lf, mean error %lf, lambda %g\n", this->iteration, cost, this->finalError, lambda);
+
+		if(decrease < this->functionTolerance * cost)
+		{
+			this->iteration++;
+			break;
+		}
+	}
+	this->finalCost = cost;
+
+	// write back
+	for(int c=0; c<m; c++)
+	{
+		for(int i=0; i<3; i++)
+		{
+			for(int j=0; j<3; j++)
+				cvmSet(this->RT[c], i, j, cameras[c*12 + i*3 + j]);
+			cvmSet(this->RT[c], i, 3, cameras[c*12 + 9 + i]);
+		}
+	}
+	for(int p=0; p<n; p++)
+	{
+		for(int i=0; i<3; i++)
+			cvmSet(this->pt3D, i, p, points[p*3 + i]);
+		cvmSet(this->pt3D, 3, p, 1.0);
+	}
+
+	return true;
+}
@@ -38,10 +38,13 @@
  * ======================================================================== */
 
 #include "Reconstruction/StereoReconstruction.h"
+#include "Utilities/Profiler.h"
 using namespace windage;
 using namespace windage::Reconstruction;
 
 #include <cv.h>
+#include <float.h>
+#include <vector>
 
 int ERANSACUpdateNumIters(double p, double ep, int model_points, int max_iters)
 {
@@ -61,6 +64,369 @@ int ERANSACUpdateNumIters(double p, double ep, int model_points, int max_iters)
 	return result;
 }
 
+/* five-point solver helpers (Nister, "An efficient solution to the five-point relative pose problem", 2004) */
+
+/* monomials of the constraint polynomials in x, y, z (Gauss-Jordan order of Nister) */
+static const int FIVE_POINT_MONOMIAL[20][3] = {
+	{3,0,0}, {0,3,0}, {2,1,0}, {1,2,0}, {2,0,1}, {2,0,0}, {0,2,1}, {0,2,0}, {1,1,1}, {1,1,0},
+	{1,0,2}, {1,0,1}, {1,0,0}, {0,1,2}, {0,1,1}, {0,1,0}, {0,0,3}, {0,0,2}, {0,0,1}, {0,0,0}
+};
+
+/* monomial index of x^ex y^ey z^ez at [ex*16 + ey*4 + ez] (-1 : degree over 3) */
+static const int FIVE_POINT_MONOMIAL_INDEX[64] = {
+	19, 18, 17, 16, 15, 14, 13, -1,  7,  6, -1, -1,  1, -1, -1, -1,
+	12, 11, 10, -1,  9,  8, -1, -1,  3, -1, -1, -1, -1, -1, -1, -1,
+	 5,  4, -1, -1,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+/* out += s * a * b (total degree is at most 3) */
+static void FivePointPolyMul(const double* a, const double* b, double* out, double s)
+{
+	for(int i=0; i<20; i++)
+	{
+		if(a[i] == 0.0)
+			continue;
+		for(int j=0; j<20; j++)
+		{
+			if(b[j] == 0.0)
+				continue;
+			int ex = FIVE_POINT_MONOMIAL[i][0] + FIVE_POINT_MONOMIAL[j][0];
+			int ey = FIVE_POINT_MONOMIAL[i][1] + FIVE_POINT_MONOMIAL[j][1];
+			int ez = FIVE_POINT_MONOMIAL[i][2] + FIVE_POINT_MONOMIAL[j][2];
+			if(ex + ey + ez <= 3)
+				out[FIVE_POINT_MONOMIAL_INDEX[ex*16 + ey*4 + ez]] += s * a[i] * b[j];
+		}
+	}
+}
+
+/* ascending coefficients : out(na+nb) = a(na) * b(nb) */
+static void PolyMul1D(const double* a, int na, const double* b, int nb, double* out)
+{
+	for(int i=0; i<=na+nb; i++)
+		out[i] = 0.0;
+	for(int i=0; i<=na; i++)
+		for(int j=0; j<=nb; j++)
+			out[i+j] += a[i] * b[j];
+}
+
+static double PolyEval1D(const double* c, int n, double x)
+{
+	double v = c[n];
+	for(int i=n-1; i>=0; i--)
+		v = v*x + c[i];
+	return v;
+}
+
+/* real roots of the polynomial (ascending coefficients), isolated between the roots of its derivative */
+static int PolyRealRoots(const double* coeff, int n, double* roots)
+{
+	double maxCoeff = 0.0;
+	for(int i=0; i<=n; i++)
+		maxCoeff = MAX(maxCoeff, fabs(coeff[i]));
+	while(n > 0 && fabs(coeff[n]) <= 1.0e-14 * maxCoeff)
+		n--;
+	if(n <= 0)
+		return 0;
+	if(n == 1)
+	{
+		roots[0] = -coeff[0] / coeff[1];
+		return 1;
+	}
+
+	double bound = 0.0;
+	for(int i=0; i<n; i++)
+		bound = MAX(bound, fabs(coeff[i] / coeff[n]));
+	bound += 1.0;
+
+	double derivative[20];
+	double critical[20];
+	for(int i=0; i<n; i++)
+		derivative[i] = (i+1) * coeff[i+1];
+	int criticalCount = PolyRealRoots(derivative, n-1, critical);
+
+	double edge[22];
+	int edgeCount = 0;
+	edge[edgeCount++] = -bound;
+	for(int i=0; i<criticalCount; i++)
+		if(-bound < critical[i] && critical[i] < bound)
+			edge[edgeCount++] = critical[i];
+	edge[edgeCount++] = bound;
+
+	int count = 0;
+	for(int i=0; i<edgeCount-1; i++)
+	{
+		double a = edge[i], b = edge[i+1];
+		double fa = PolyEval1D(coeff, n, a);
+		double fb = PolyEval1D(coeff, n, b);
+		if(fa == 0.0)
+		{
+			if(count == 0 || roots[count-1] != a)
+				roots[count++] = a;
+			continue;
+		}
+		if(fa * fb > 0.0)
+			continue;
+
+		for(int k=0; k<100 && b - a > 1.0e-14 * MAX(1.0, fabs(a)); k++)
+		{
+			double m = 0.5 * (a + b);
+			double fm = PolyEval1D(coeff, n, m);
+			if(fa * fm <= 0.0)
+			{
+				b = m;
+			}
+			else
+			{
+				a = m;
+				fa = fm;
+			}
+		}
+		roots[count++] = 0.5 * (a + b);
+	}
+	return count;
+}
+
+/* essential matrices (x2^T E x1 = 0) of 5 normalized correspondences, returns the solution count (at most 10) */
+static int SolveFivePoints(const double* x1, const double* x2, double* E)
+{
+	// null space of the 5 x 9 epipolar constraint by gauss-jordan elimination
+	double Q[5][9];
+	for(int i=0; i<5; i++)
+	{
+		const double* p1 = x1 + i*3;
+		const double* p2 = x2 + i*3;
+		for(int r=0; r<3; r++)
+			for(int c=0; c<3; c++)
+				Q[i][r*3 + c] = p2[r] * p1[c];
+	}
+
+	int pivotColumn[5];
+	int row = 0;
+	bool isPivot[9] = {false, false, false, false, false, false, false, false, false};
+	for(int c=0; c<9 && row<5; c++)
+	{
+		int best = row;
+		for(int r=row+1; r<5; r++)
+			if(fabs(Q[r][c]) > fabs(Q[best][c])) best = r;
+		if(fabs(Q[best][c]) < 1.0e-12)
+			continue;
+		for(int k=0; k<9; k++) { double t = Q[row][k]; Q[row][k] = Q[best][k]; Q[best][k] = t; }
+		double inv = 1.0 / Q[row][c];
+		for(int k=0; k<9; k++) Q[row][k] *= inv;
+		for(int r=0; r<5; r++)
+		{
+			if(r == row || Q[r][c] == 0.0)
+				continue;
+			double f = Q[r][c];
+			for(int k=0; k<9; k++) Q[r][k] -= f * Q[row][k];
+		}
+		pivotColumn[row] = c;
+		isPivot[c] = true;
+		row++;
+	}
+	if(row < 5)
+		return 0;
+
+	double basis[4][9];
+	int freeCount = 0;
+	for(int c=0; c<9; c++)
+	{
+		if(isPivot[c])
+			continue;
+		for(int k=0; k<9; k++) basis[freeCount][k] = 0.0;
+		basis[freeCount][c] = 1.0;
+		for(int r=0; r<5; r++)
+			basis[freeCount][pivotColumn[r]] = -Q[r][c];
+		freeCount++;
+	}
+
+	// orthonormal basis for the conditioning of the polynomial system
+	for(int i=0; i<4; i++)
+	{
+		for(int j=0; j<i; j++)
+		{
+			double dot = 0.0;
+			for(int k=0; k<9; k++) dot += basis[i][k] * basis[j][k];
+			for(int k=0; k<9; k++) basis[i][k] -= dot * basis[j][k];
+		}
+		double norm = 0.0;
+		for(int k=0; k<9; k++) norm += basis[i][k] * basis[i][k];
+		norm = 1.0 / sqrt(norm);
+		for(int k=0; k<9; k++) basis[i][k] *= norm;
+	}
+
+	// E = x X + y Y + z Z + W with polynomial entries
+	const int X = 12, Y = 15, Z = 18, W = 19;
+	double e[9][20];
+	for(int k=0; k<9; k++)
+	{
+		for(int m=0; m<20; m++) e[k][m] = 0.0;
+		e[k][X] = basis[0][k];
+		e[k][Y] = basis[1][k];
+		e[k][Z] = basis[2][k];
+		e[k][W] = basis[3][k];
+	}
+
+	double M[10][20];
+	for(int i=0; i<10; i++)
+		for(int m=0; m<20; m++) M[i][m] = 0.0;
+
+	// det(E) = 0
+	double minor[20];
+	for(int m=0; m<20; m++) minor[m] = 0.0;
+	FivePointPolyMul(e[4], e[8], minor, 1.0);	FivePointPolyMul(e[5], e[7], minor, -1.0);
+	FivePointPolyMul(e[0], minor, M[0], 1.0);
+	for(int m=0; m<20; m++) minor[m] = 0.0;
+	FivePointPolyMul(e[3], e[8], minor, 1.0);	FivePointPolyMul(e[5], e[6], minor, -1.0);
+	FivePointPolyMul(e[1], minor, M[0], -1.0);
+	for(int m=0; m<20; m++) minor[m] = 0.0;
+	FivePointPolyMul(e[3], e[7], minor, 1.0);	FivePointPolyMul(e[4], e[6], minor, -1.0);
+	FivePointPolyMul(e[2], minor, M[0], 1.0);
+
+	// 2 E E^T E - trace(E E^T) E = 0
+	double EEt[9][20];
+	double trace[20];
+	for(int m=0; m<20; m++) trace[m] = 0.0;
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+		{
+			for(int m=0; m<20; m++) EEt[i*3+j][m] = 0.0;
+			for(int k=0; k<3; k++)
+				FivePointPolyMul(e[i*3+k], e[j*3+k], EEt[i*3+j], 1.0);
+		}
+	for(int i=0; i<3; i++)
+		for(int m=0; m<20; m++) trace[m] += EEt[i*3+i][m];
+
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+		{
+			double* eq = M[1 + i*3 + j];
+			for(int k=0; k<3; k++)
+				FivePointPolyMul(EEt[i*3+k], e[k*3+j], eq, 2.0);
+			FivePointPolyMul(trace, e[i*3+j], eq, -1.0);
+		}
+
+	// gauss-jordan elimination of the first 10 monomials
+	for(int c=0; c<10; c++)
+	{
+		int best = c;
+		for(int r=c+1; r<10; r++)
+			if(fabs(M[r][c]) > fabs(M[best][c])) best = r;
+		if(fabs(M[best][c]) < 1.0e-15)
+			return 0;
+		for(int k=0; k<20; k++) { double t = M[c][k]; M[c][k] = M[best][k]; M[best][k] = t; }
+		double inv = 1.0 / M[c][c];
+		for(int k=0; k<20; k++) M[c][k] *= inv;
+		for(int r=0; r<10; r++)
+		{
+			if(r == c || M[r][c] == 0.0)
+				continue;
+			double f = M[r][c];
+			for(int k=c; k<20; k++) M[r][k] -= f * M[c][k];
+		}
+	}
+
+	// <k> = <e> - z<f>, <l> = <g> - z<h>, <m> = <i> - z<j> : polynomials in x, y, 1 with coefficients in z
+	double B[3][3][5];
+	for(int p=0; p<3; p++)
+	{
+		const double* a = M[4 + p*2];
+		const double* b = M[5 + p*2];
+		for(int v=0; v<2; v++)
+		{
+			int o = 10 + v*3;	// xz^2, xz, x (yz^2, yz, y)
+			B[p][v][0] = a[o+2];
+			B[p][v][1] = a[o+1] - b[o+2];
+			B[p][v][2] = a[o] - b[o+1];
+			B[p][v][3] = -b[o];
+			B[p][v][4] = 0.0;
+		}
+		B[p][2][0] = a[19];
+		B[p][2][1] = a[18] - b[19];
+		B[p][2][2] = a[17] - b[18];
+		B[p][2][3] = a[16] - b[17];
+		B[p][2][4] = -b[16];
+	}
+
+	// det(B) : 10th degree polynomial in z
+	double n[11];
+	for(int i=0; i<11; i++) n[i] = 0.0;
+	double t1[9], t2[9], t3[13];
+	for(int c=0; c<3; c++)
+	{
+		int c1 = (c+1) % 3, c2 = (c+2) % 3;
+		// cofactor of B[0][c] : B[1][c1] B[2][c2] - B[1][c2] B[2][c1]
+		PolyMul1D(B[1][c1], 4, B[2][c2], 4, t1);
+		PolyMul1D(B[1][c2], 4, B[2][c1], 4, t2);
+		for(int i=0; i<9; i++) t1[i] -= t2[i];
+		PolyMul1D(B[0][c], 4, t1, 8, t3);
+		for(int i=0; i<=10; i++) n[i] += t3[i];
+	}
+
+	double roots[10];
+	int rootCount = PolyRealRoots(n, 10, roots);
+
+	int count = 0;
+	for(int r=0; r<rootCount; r++)
+	{
+		double z = roots[r];
+		double b[3][3];
+		for(int p=0; p<3; p++)
+			for(int v=0; v<3; v++)
+				b[p][v] = PolyEval1D(B[p][v], 4, z);
+
+		// (x, y, 1) is the null vector of B(z)
+		double s[3];
+		s[0] = b[0][1]*b[1][2] - b[0][2]*b[1][1];
+		s[1] = b[0][2]*b[1][0] - b[0][0]*b[1][2];
+		s[2] = b[0][0]*b[1][1] - b[0][1]*b[1][0];
+		if(fabs(s[2]) < 1.0e-12)
+			continue;
+		double x = s[0] / s[2];
+		double y = s[1] / s[2];
+
+		double* Ei = E + count*9;
+		double norm = 0.0;
+		for(int k=0; k<9; k++)
+		{
+			Ei[k] = x*basis[0][k] + y*basis[1][k] + z*basis[2][k] + basis[3][k];
+			norm += Ei[k] * Ei[k];
+		}
+		norm = 1.0 / sqrt(norm);
+		for(int k=0; k<9; k++)
+			Ei[k] *= norm;
+		count++;
+	}
+
+	return count;
+}
+
+/* sampson distance of all correspondences (x2^T E x1 = 0), returns the inlier count */
+static int SampsonInliers(const double* E, const double* x1, const double* y1, const double* x2, const double* y2, int n, double threshold2, double* error)
+{
+	int inliers = 0;
+	double sum = 0.0;
+	for(int i=0; i<n; i++)
+	{
+		double Ex0 = E[0]*x1[i] + E[1]*y1[i] + E[2];
+		double Ex1 = E[3]*x1[i] + E[4]*y1[i] + E[5];
+		double Ex2 = E[6]*x1[i] + E[7]*y1[i] + E[8];
+		double Etx0 = E[0]*x2[i] + E[3]*y2[i] + E[6];
+		double Etx1 = E[1]*x2[i] + E[4]*y2[i] + E[7];
+		double r = x2[i]*Ex0 + y2[i]*Ex1 + Ex2;
+		double d = r*r / (Ex0*Ex0 + Ex1*Ex1 + Etx0*Etx0 + Etx1*Etx1 + DBL_MIN);
+		if(d < threshold2)
+		{
+			inliers++;
+			sum += d;
+		}
+	}
+	if(error)
+		*error = sum;
+	return inliers;
+}
+
 void StereoReconstruction::CalculateNormalizedPoint()
 {
 	windage::Matrix3 intrinsic;
@@ -169,7 +535,7 @@ bool StereoReconstruction::CalibratedTriangulation(CvMat *matR, CvMat *matT, CvM
 	return true;
 }
 
-bool StereoReconstruction::DecomposeEMatrix(CvMat *EMat)
+bool StereoReconstruction::DecomposeEMatrix(CvMat *EMat, int testIndex1, int testIndex2)
 {
 	bool _failed = false;
 	
@@ -233,8 +599,8 @@ bool StereoReconstruction::DecomposeEMatrix(CvMat *EMat)
 	CvMat *test2DPt= cvCreateMat(3, 1, CV_64F);
 	for(int i=0; i<3; i++) 
 	{
-		cvmSet(testLPt, i, 0, this->normalizedMatchedPoint1[0].v[i]);
-		cvmSet(testRPt, i, 0, this->normalizedMatchedPoint2[0].v[i]);
+		cvmSet(testLPt, i, 0, this->normalizedMatchedPoint1[testIndex1].v[i]);
+		cvmSet(testRPt, i, 0, this->normalizedMatchedPoint2[testIndex1].v[i]);
 	}
 
 	int ir = -1, it = -1; 
@@ -267,8 +633,8 @@ bool StereoReconstruction::DecomposeEMatrix(CvMat *EMat)
 			{
 				for(int p=0; p<3; p++) 
 				{
-					cvmSet(testLPt, p, 0, this->normalizedMatchedPoint1[1].v[p]);
-					cvmSet(testRPt, p, 0, this->normalizedMatchedPoint2[1].v[p]);
+					cvmSet(testLPt, p, 0, this->normalizedMatchedPoint1[testIndex2].v[p]);
+					cvmSet(testRPt, p, 0, this->normalizedMatchedPoint2[testIndex2].v[p]);
 				}
 				
 				CalibratedTriangulation(_R[i], _t[j], testLPt, testRPt, testPt);
@@ -492,8 +858,188 @@ bool StereoReconstruction::ComputeEssentialMatrix8Points(CvMat *pt1, CvMat *pt2,
 	return true;
 }
 
+int StereoReconstruction::ComputeEssentialMatrix5Points(CvMat *pt1, CvMat *pt2, CvMat *EMats)
+{
+	double x1[15], x2[15];
+	for(int i=0; i<5; i++)
+	{
+		for(int k=0; k<3; k++)
+		{
+			x1[i*3 + k] = cvmGet(pt1, k, i);
+			x2[i*3 + k] = cvmGet(pt2, k, i);
+		}
+	}
+
+	double E[90];
+	int count = SolveFivePoints(x1, x2, E);
+	for(int i=0; i<count && i<EMats->rows; i++)
+		for(int k=0; k<9; k++)
+			cvmSet(EMats, i, k, E[i*9 + k]);
+
+	return MIN(count, EMats->rows);
+}
+
+bool StereoReconstruction::ComputeEssentialMatrixRANSAC5Points(double* error)
+{
+	// preparation
+	int n = (int)this->normalizedMatchedPoint1.size();
+	const int SAMPLE_SIZE = 5;
+	const int BATCH_SIZE = 64;
+	if(n < SAMPLE_SIZE)
+	{
+		(*error) = -1.0;
+		return false;
+	}
+
+	// structure of arrays for the sampson scoring
+	std::vector<double> x1(n), y1(n), x2(n), y2(n);
+	for(int i=0; i<n; i++)
+	{
+		x1[i] = this->normalizedMatchedPoint1[i].x / this->normalizedMatchedPoint1[i].z;
+		y1[i] = this->normalizedMatchedPoint1[i].y / this->normalizedMatchedPoint1[i].z;
+		x2[i] = this->normalizedMatchedPoint2[i].x / this->normalizedMatchedPoint2[i].z;
+		y2[i] = this->normalizedMatchedPoint2[i].y / this->normalizedMatchedPoint2[i].z;
+	}
+
+	// the threshold in pixel is converted to the normalized coordinate (sum of the both image errors)
+	double focal = this->initialCameraParameter->GetParameters()[0];
+	double threshold = this->reprojectionError / focal;
+	double threshold2 = 2.0 * threshold * threshold;
+
+	int max_iter = this->maxIteration;
+	int max_random_iters = 20;
+	int ci = 0;
+
+	int bestInlier = -1;
+	double bestError = DBL_MAX;
+	double bestE[9];
+
+	std::vector<int> samples(BATCH_SIZE * SAMPLE_SIZE);
+	std::vector<int> batchInlier(BATCH_SIZE);
+	std::vector<double> batchError(BATCH_SIZE);
+	std::vector<double> batchE(BATCH_SIZE * 9);
+	while(ci < max_iter)
+	{
+		/** select random samples of the batch */
+		int batch = MIN(BATCH_SIZE, max_iter - ci);
+		for(int b=0; b<batch; b++)
+		{
+			int* idx = &samples[b * SAMPLE_SIZE];
+			int snum = 0;
+			for(int i=0; i<SAMPLE_SIZE; i++)
+			{
+				for(int k=0; k<max_random_iters; k++)
+				{
+					idx[i] = cvRandInt(&this->rng) % n;
+
+					bool bIn = false;
+					for(int j=0; j<snum; j++)
+					{
+						if(idx[j] == idx[i])
+						{
+							bIn = true;
+							break;
+						}
+					}
+
+					if(!bIn)
+					{
+						snum++;
+						break;
+					}
+				}
+			}
+		}
+
+		/** hypotheses are solved and scored in parallel */
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int b=0; b<batch; b++)
+		{
+			const int* idx = &samples[b * SAMPLE_SIZE];
+			double p1[15], p2[15];
+			for(int i=0; i<SAMPLE_SIZE; i++)
+			{
+				p1[i*3 + 0] = x1[idx[i]];	p1[i*3 + 1] = y1[idx[i]];	p1[i*3 + 2] = 1.0;
+				p2[i*3 + 0] = x2[idx[i]];	p2[i*3 + 1] = y2[idx[i]];	p2[i*3 + 2] = 1.0;
+			}
+
+			double E[90];
+			int count = SolveFivePoints(p1, p2, E);
+
+			batchInlier[b] = -1;
+			batchError[b] = DBL_MAX;
+			for(int s=0; s<count; s++)
+			{
+				double err = 0.0;
+				int inlier = SampsonInliers(E + s*9, &x1[0], &y1[0], &x2[0], &y2[0], n, threshold2, &err);
+				if(inlier > batchInlier[b] || (inlier == batchInlier[b] && err < batchError[b]))
+				{
+					batchInlier[b] = inlier;
+					batchError[b] = err;
+					for(int k=0; k<9; k++)
+						batchE[b*9 + k] = E[s*9 + k];
+				}
+			}
+		}
+
+		for(int b=0; b<batch; b++)
+		{
+			if(batchInlier[b] > bestInlier || (batchInlier[b] == bestInlier && batchError[b] < bestError))
+			{
+				bestInlier = batchInlier[b];
+				bestError = batchError[b];
+				for(int k=0; k<9; k++)
+					bestE[k] = batchE[b*9 + k];
+
+				if(this->confidence > 0)
+					max_iter = ERANSACUpdateNumIters(this->confidence, (double)(n - bestInlier)/(double)n, SAMPLE_SIZE, max_iter);
+			}
+		}
+		ci += batch;
+	}
+
+	if(bestInlier < SAMPLE_SIZE)
+	{
+		(*error) = -1.0;
+		return false;
+	}
+
+	/** decompose only the winning model, the cheirality is tested with its inliers */
+	int testIndex[2] = {0, 1};
+	for(int i=0, found=0; i<n && found<2; i++)
+	{
+		double e = 0.0;
+		if(SampsonInliers(bestE, &x1[i], &y1[i], &x2[i], &y2[i], 1, threshold2, &e) > 0)
+			testIndex[found++] = i;
+	}
+
+	for(int k=0; k<9; k++)
+		this->essentialMatrix->data.db[k] = bestE[k];
+
+	double err = 0.0;
+	if(!DecomposeEMatrix(this->essentialMatrix, testIndex[0], testIndex[1]))
+	{
+		(*error) = -1.0;
+		return false;
+	}
+	ReconstructAll(this->essentialMatrix);
+	this->inlierCount = CountInliers(this->reprojectionError, &err);
+	(*error) = err;
+
+	if(this->inlierCount == 0 || err > 5.0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
 bool StereoReconstruction::ComputeEssentialMatrixRANSAC(double* error)
 {
+	WINDAGE_PROFILE_SCOPE("StereoReconstruction::essential");
+	if(this->fivePoints)
+		return this->ComputeEssentialMatrixRANSAC5Points(error);
+
 	// preparation
 	int n = (int)this->normalizedMatchedPoint1.size();
 	const int SAMPLE_SIZE = 8;
@@ -512,7 +1058,6 @@ bool StereoReconstruction::ComputeEssentialMatrixRANSAC(double* error)
 	pt1   = cvCreateMat(3, SAMPLE_SIZE, CV_64F);
 	pt2   = cvCreateMat(3, SAMPLE_SIZE, CV_64F);
 
-	CvRNG rng = cvRNG(cvGetTickCount());
 	int pre_inlier = -1, num_inlier;
 	double pre_error = 10000, small_err = 0.0;
 		
@@ -530,7 +1075,7 @@ bool StereoReconstruction::ComputeEssentialMatrixRANSAC(double* error)
 			for(int k = 0; k <max_random_iters; k++ )
 			{
 				/** randomly select one */
-				idx[i] = cvRandInt(&rng) % total_num;
+				idx[i] = cvRandInt(&this->rng) % total_num;
 
 				bIn = false;
 				/** is the picked one already chosen? */
@@ -38,11 +38,37 @@
  * ======================================================================== */
 
 #include <time.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "Reconstruction/Utilities/Exportor.h"
 using namespace windage;
 using namespace Reconstruction;
 
+static const char PADDING[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+static unsigned long long AlignSection(unsigned long long size)
+{
+	return (size + 7) & ~(unsigned long long)7;
+}
+
+static void AddSection(std::vector<ReconstructionFileSection>& sections, int type, unsigned int stride, unsigned long long count, unsigned long long size)
+{
+	ReconstructionFileSection section;
+	section.type = type;
+	section.stride = stride;
+	section.count = count;
+	section.offset = 0;
+	section.size = size;
+	sections.push_back(section);
+}
+
+static bool PadSection(FILE* output, unsigned long long size)
+{
+	size_t padding = (size_t)(AlignSection(size) - size);
+	return padding == 0 || fwrite(PADDING, 1, padding, output) == padding;
+}
+
 bool Exportor::DoExport()
 {
 	if(reconstructionPoints == NULL)
@@ -174,4 +200,178 @@ bool Exportor::DoExport()
 	}
 
 	return true;
+}
+
+bool Exportor::DoExportBinary(const char* filename)
+{
+	if(reconstructionPoints == NULL)
+		return false;
+	if(calibrationList.size() <= 0)
+		return false;
+	if(calibrationList.size() != imageFileList.size())
+		return false;
+
+	int cameraCount = (int)this->calibrationList.size();
+	int pointCount = (int)this->reconstructionPoints->size();
+
+	// count variable length datas
+	unsigned long long pathLength = 0;
+	for(int i=0; i<cameraCount; i++)
+		pathLength += this->imageFileList[i].size() + 1;
+
+	unsigned long long featureCount = 0;
+	unsigned long long descriptorCount = 0;
+	unsigned long long referenceCount = 0;
+	for(int i=0; i<pointCount; i++)
+	{
+		std::vector<windage::FeaturePoint>* featurePoints = (*reconstructionPoints)[i].GetFeatureList();
+		featureCount += featurePoints->size();
+		for(unsigned int j=0; j<featurePoints->size(); j++)
+			descriptorCount += (*featurePoints)[j].descriptor.size();
+		referenceCount += (*reconstructionPoints)[i].GetReferenceCount();
+	}
+
+	// section table
+	const unsigned long long INDEX_SIZE = sizeof(unsigned long long);
+	std::vector<ReconstructionFileSection> sections;
+	AddSection(sections, RECONSTRUCTION_SECTION_CAMERA, sizeof(CameraRecord), cameraCount, cameraCount * sizeof(CameraRecord));
+	AddSection(sections, RECONSTRUCTION_SECTION_IMAGE_PATH, 0, cameraCount, (cameraCount + 1) * INDEX_SIZE + pathLength);
+	AddSection(sections, RECONSTRUCTION_SECTION_POINT, 4 * sizeof(double), pointCount, pointCount * 4 * sizeof(double));
+	AddSection(sections, RECONSTRUCTION_SECTION_COLOR, 4 * sizeof(double), pointCount, pointCount * 4 * sizeof(double));
+	AddSection(sections, RECONSTRUCTION_SECTION_OBJECT_ID, sizeof(int), pointCount, pointCount * sizeof(int));
+	AddSection(sections, RECONSTRUCTION_SECTION_FEATURE_INDEX, (unsigned int)INDEX_SIZE, pointCount + 1, (pointCount + 1) * INDEX_SIZE);
+	AddSection(sections, RECONSTRUCTION_SECTION_FEATURE, sizeof(FeatureRecord), featureCount, featureCount * sizeof(FeatureRecord));
+	AddSection(sections, RECONSTRUCTION_SECTION_DESCRIPTOR, sizeof(double), descriptorCount, descriptorCount * sizeof(double));
+	AddSection(sections, RECONSTRUCTION_SECTION_REFERENCE_INDEX, (unsigned int)INDEX_SIZE, pointCount + 1, (pointCount + 1) * INDEX_SIZE);
+	AddSection(sections, RECONSTRUCTION_SECTION_REFERENCE, sizeof(windage::FeatureReference), referenceCount, referenceCount * sizeof(windage::FeatureReference));
+
+	unsigned long long offset = sizeof(ReconstructionFileHeader) + sections.size() * sizeof(ReconstructionFileSection);
+	for(unsigned int i=0; i<sections.size(); i++)
+	{
+		sections[i].offset = offset;
+		offset += AlignSection(sections[i].size);
+	}
+
+	ReconstructionFileHeader header;
+	memcpy(header.magic, RECONSTRUCTION_FILE_MAGIC, 8);
+	header.version = RECONSTRUCTION_FILE_VERSION;
+	header.sectionCount = (unsigned int)sections.size();
+	header.fileSize = offset;
+
+	FILE* output = fopen(filename, "wb");
+	if(output == NULL)
+		return false;
+
+	bool result = true;
+	result = result && fwrite(&header, sizeof(header), 1, output) == 1;
+	result = result && fwrite(&sections[0], sizeof(ReconstructionFileSection), sections.size(), output) == sections.size();
+
+	// cameras
+	for(int i=0; i<cameraCount && result; i++)
+	{
+		CameraRecord camera;
+		for(int y=0; y<3; y++)
+			for(int x=0; x<3; x++)
+				camera.intrinsic[y*3 + x] = cvGetReal2D(this->calibrationList[i]->GetIntrinsicMatrix(), y, x);
+		for(int y=0; y<4; y++)
+			for(int x=0; x<4; x++)
+				camera.extrinsic[y*4 + x] = cvGetReal2D(this->calibrationList[i]->GetExtrinsicMatrix(), y, x);
+		result = fwrite(&camera, sizeof(camera), 1, output) == 1;
+	}
+
+	// image paths
+	unsigned long long index = 0;
+	for(int i=0; i<=cameraCount && result; i++)
+	{
+		result = fwrite(&index, sizeof(index), 1, output) == 1;
+		if(i < cameraCount)
+			index += this->imageFileList[i].size() + 1;
+	}
+	for(int i=0; i<cameraCount && result; i++)
+		result = fwrite(this->imageFileList[i].c_str(), 1, this->imageFileList[i].size() + 1, output) == this->imageFileList[i].size() + 1;
+	result = result && PadSection(output, sections[1].size);
+
+	// points, colors and object ids
+	for(int i=0; i<pointCount && result; i++)
+	{
+		windage::Vector4 point = (*reconstructionPoints)[i].GetPoint();
+		double data[4] = {point.x, point.y, point.z, point.w};
+		result = fwrite(data, sizeof(double), 4, output) == 4;
+	}
+	for(int i=0; i<pointCount && result; i++)
+	{
+		CvScalar color = (*reconstructionPoints)[i].GetColor();
+		result = fwrite(color.val, sizeof(double), 4, output) == 4;
+	}
+	for(int i=0; i<pointCount && result; i++)
+	{
+		int objectID = (*reconstructionPoints)[i].GetObjectID();
+		result = fwrite(&objectID, sizeof(int), 1, output) == 1;
+	}
+	result = result && PadSection(output, sections[4].size);
+
+	// features
+	index = 0;
+	for(int i=0; i<=pointCount && result; i++)
+	{
+		result = fwrite(&index, sizeof(index), 1, output) == 1;
+		if(i < pointCount)
+			index += (*reconstructionPoints)[i].GetFeatureList()->size();
+	}
+	unsigned long long descriptorOffset = 0;
+	for(int i=0; i<pointCount && result; i++)
+	{
+		std::vector<windage::FeaturePoint>* featurePoints = (*reconstructionPoints)[i].GetFeatureList();
+		for(unsigned int j=0; j<featurePoints->size() && result; j++)
+		{
+			windage::FeaturePoint* feature = &(*featurePoints)[j];
+			windage::Vector3 point = feature->GetPoint();
+			CvScalar color = feature->GetColor();
+
+			FeatureRecord record;
+			record.point[0] = point.x;
+			record.point[1] = point.y;
+			record.point[2] = point.z;
+			for(int k=0; k<4; k++)
+				record.color[k] = color.val[k];
+			record.dir = feature->GetDir();
+			record.distance = feature->GetDistance();
+			record.objectID = feature->GetObjectID();
+			record.size = feature->GetSize();
+			record.descriptorOffset = descriptorOffset;
+			record.descriptorDimension = (int)feature->descriptor.size();
+			record.reserved = 0;
+
+			result = fwrite(&record, sizeof(record), 1, output) == 1;
+			descriptorOffset += record.descriptorDimension;
+		}
+	}
+	for(int i=0; i<pointCount && result; i++)
+	{
+		std::vector<windage::FeaturePoint>* featurePoints = (*reconstructionPoints)[i].GetFeatureList();
+		for(unsigned int j=0; j<featurePoints->size() && result; j++)
+		{
+			std::vector<double>* descriptor = &(*featurePoints)[j].descriptor;
+			if(descriptor->size() > 0)
+				result = fwrite(&(*descriptor)[0], sizeof(double), descriptor->size(), output) == descriptor->size();
+		}
+	}
+
+	// references
+	index = 0;
+	for(int i=0; i<=pointCount && result; i++)
+	{
+		result = fwrite(&index, sizeof(index), 1, output) == 1;
+		if(i < pointCount)
+			index += (*reconstructionPoints)[i].GetReferenceCount();
+	}
+	for(int i=0; i<pointCount && result; i++)
+	{
+		std::vector<windage::FeatureReference>* references = (*reconstructionPoints)[i].GetReferenceList();
+		if(references->size() > 0)
+			result = fwrite(&(*references)[0], sizeof(windage::FeatureReference), references->size(), output) == references->size();
+	}
+
+	fclose(output);
+	return result;
 }
\ No newline at end of file
@@ -38,11 +38,18 @@
  * ======================================================================== */
 
 #include <fstream>
+#include <limits>
+#include <string.h>
 
 #include "Reconstruction/Utilities/Loader.h"
 using namespace windage;
 using namespace Reconstruction;
 
+static void SkipLine(std::ifstream& input)
+{
+	input.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+}
+
 bool Loader::DoLoad(const char* filename)
 {
 	if(calibrationList == NULL)
@@ -52,30 +59,116 @@ bool Loader::DoLoad(const char* filename)
 	if(reconstructionPoints == NULL)
 		return false;
 
+	if(MappedReconstruction::IsReconstructionFile(filename))
+		return this->DoLoadBinary(filename);
+	return this->DoLoadText(filename);
+}
+
+bool Loader::DoLoadBinary(const char* filename)
+{
+	MappedReconstruction file;
+	if(!file.Open(filename))
+		return false;
+
+	// calibration
+	int calibrationCount = file.GetCameraCount();
+	const CameraRecord* cameras = file.GetCameras();
+
+	this->calibrationList->resize(calibrationCount);
+	this->filenameList->resize(calibrationCount);
+	for(int i=0; i<calibrationCount; i++)
+	{
+		const double* intrinsic = cameras[i].intrinsic;
+		double extrinsic[16];
+		memcpy(extrinsic, cameras[i].extrinsic, sizeof(extrinsic));
+
+		(*calibrationList)[i] = new windage::Calibration();
+		(*calibrationList)[i]->Initialize(intrinsic[0], intrinsic[4], intrinsic[2], intrinsic[5]);
+		(*calibrationList)[i]->SetExtrinsicMatrix(extrinsic);
+
+		const char* path = file.GetImagePath(i);
+		(*filenameList)[i] = std::string(path ? path : "");
+	}
+
+	// reconstruction points
+	int reconstructionCount = file.GetPointCount();
+	const double* points = file.GetPoints();
+	const double* colors = file.GetColors();
+	const int* objectIDs = file.GetObjectIDs();
+	const unsigned long long* featureIndex = file.GetFeatureIndex();
+	const FeatureRecord* features = file.GetFeatures();
+	const double* descriptors = file.GetDescriptors();
+	const unsigned long long* referenceIndex = file.GetReferenceIndex();
+	const windage::FeatureReference* references = file.GetReferences();
+
+	this->reconstructionPoints->resize(reconstructionCount);
+	for(int i=0; i<reconstructionCount; i++)
+	{
+		windage::ReconstructionPoint* reconstructionPoint = &(*this->reconstructionPoints)[i];
+		reconstructionPoint->SetPoint(windage::Vector4(points[i*4 + 0], points[i*4 + 1], points[i*4 + 2], points[i*4 + 3]));
+		if(colors)
+			reconstructionPoint->SetColor(cvScalar(colors[i*4 + 0], colors[i*4 + 1], colors[i*4 + 2], colors[i*4 + 3]));
+		if(objectIDs)
+			reconstructionPoint->SetObjectID(objectIDs[i]);
+
+		if(featureIndex)
+		{
+			reconstructionPoint->GetFeatureList()->reserve((size_t)(featureIndex[i+1] - featureIndex[i]));
+			for(unsigned long long j=featureIndex[i]; j<featureIndex[i+1]; j++)
+			{
+				const FeatureRecord* record = &features[j];
+
+				windage::FeaturePoint featurePoint;
+				featurePoint.SetPoint(windage::Vector3(record->point[0], record->point[1], record->point[2]));
+				featurePoint.SetObjectID(record->objectID);
+				featurePoint.SetColor(cvScalar(record->color[0], record->color[1], record->color[2], record->color[3]));
+				featurePoint.SetSize(record->size);
+				featurePoint.SetDir(record->dir);
+				featurePoint.SetDistance(record->distance);
+
+				featurePoint.DESCRIPTOR_DIMENSION = record->descriptorDimension;
+				featurePoint.descriptor.assign(descriptors + record->descriptorOffset, descriptors + record->descriptorOffset + record->descriptorDimension);
+
+				reconstructionPoint->AddFeaturePoint(featurePoint);
+			}
+		}
+
+		if(referenceIndex)
+		{
+			for(unsigned long long j=referenceIndex[i]; j<referenceIndex[i+1]; j++)
+				reconstructionPoint->AddFeatureReference(references[j].imageID, references[j].featureID);
+		}
+	}
+	std::cout << "load reconstruction all point count : " << reconstructionCount << std::endl;
+
+	file.Close();
+
+	return true;
+}
+
+bool Loader::DoLoadText(const char* filename)
+{
 	std::ifstream input;
 	input.open(filename);
 	if(!input.is_open())
 		return false;
 
-	const int BUFFER_SIZE = 1024;
-	char BUFFER[BUFFER_SIZE];
-
 	// dummay
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); // # w
-	input.getline(BUFFER, BUFFER_SIZE); // # 
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); //
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); // # C
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); //
+	SkipLine(input); // ##
+	SkipLine(input); // # w
+	SkipLine(input); // # 
+	SkipLine(input); // ##
+	SkipLine(input); //
+	SkipLine(input); // ##
+	SkipLine(input); // # C
+	SkipLine(input); // ##
+	SkipLine(input); //
 
 	// calibration
 	int calibrationCount = 0;
 	input >> calibrationCount;
-	input.getline(BUFFER, BUFFER_SIZE); //
-	input.getline(BUFFER, BUFFER_SIZE); // 
+	SkipLine(input); //
+	SkipLine(input); // 
 
 	windage::Matrix3 intrinsic;
 	windage::Matrix4 extrinsic;
@@ -84,8 +177,8 @@ bool Loader::DoLoad(const char* filename)
 	this->filenameList->resize(calibrationCount);
 	for(int i=0; i<calibrationCount; i++)
 	{
-		input.getline(BUFFER, BUFFER_SIZE); // # camera
-		input.getline(BUFFER, BUFFER_SIZE); // # intrinsic
+		SkipLine(input); // # camera
+		SkipLine(input); // # intrinsic
 		for(int y=0; y<3; y++)
 		{
 			for(int x=0; x<3; x++)
@@ -94,9 +187,9 @@ bool Loader::DoLoad(const char* filename)
 			}
 		}
 
-		input.getline(BUFFER, BUFFER_SIZE); // 
-		input.getline(BUFFER, BUFFER_SIZE); // 
-		input.getline(BUFFER, BUFFER_SIZE); // # extrinsic
+		SkipLine(input); // 
+		SkipLine(input); // 
+		SkipLine(input); // # extrinsic
 		for(int y=0; y<4; y++)
 		{
 			for(int x=0; x<4; x++)
@@ -105,31 +198,30 @@ bool Loader::DoLoad(const char* filename)
 			}
 		}
 
-		input.getline(BUFFER, BUFFER_SIZE); // 
-		input.getline(BUFFER, BUFFER_SIZE); // 
+		SkipLine(input); // 
+		SkipLine(input); // 
 		
 		(*calibrationList)[i] = new windage::Calibration();
 		(*calibrationList)[i]->Initialize(intrinsic._11, intrinsic._22, intrinsic._13, intrinsic._23);
 		(*calibrationList)[i]->SetExtrinsicMatrix(extrinsic.m1);
 
-		input.getline(BUFFER, BUFFER_SIZE); // # image file
-		input.getline(BUFFER, BUFFER_SIZE); // data
-		(*filenameList)[i] = std::string(BUFFER);
+		SkipLine(input); // # image file
+		std::getline(input, (*filenameList)[i]); // data
 		
-		input.getline(BUFFER, BUFFER_SIZE); // 
+		SkipLine(input); // 
 	}
 
 
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); // # R
-	input.getline(BUFFER, BUFFER_SIZE); // ##
-	input.getline(BUFFER, BUFFER_SIZE); //
+	SkipLine(input); // ##
+	SkipLine(input); // # R
+	SkipLine(input); // ##
+	SkipLine(input); //
 	
 	// reconstruction points
 	int reconstructionCount = 0;
 	input >> reconstructionCount;
-	input.getline(BUFFER, BUFFER_SIZE); //
-	input.getline(BUFFER, BUFFER_SIZE); //
+	SkipLine(input); //
+	SkipLine(input); //
 
 	this->reconstructionPoints->resize(reconstructionCount);
 	windage::Vector4 point;
@@ -142,29 +234,29 @@ bool Loader::DoLoad(const char* filename)
 			std::cout << "load reconstruction point : " << i << std::endl;
 		windage::ReconstructionPoint reconstructionPoint;
 
-		input.getline(BUFFER, BUFFER_SIZE); // 
-		input.getline(BUFFER, BUFFER_SIZE); // # reconstruction
-		input.getline(BUFFER, BUFFER_SIZE); //
+		SkipLine(input); // 
+		SkipLine(input); // # reconstruction
+		SkipLine(input); //
 
 		// point
 		input >> point.x >> point.y >> point.z >> point.w;
-		input.getline(BUFFER, BUFFER_SIZE); //
+		SkipLine(input); //
 		reconstructionPoint.SetPoint(point);
 
 		input >> objectID;
-		input.getline(BUFFER, BUFFER_SIZE); //
+		SkipLine(input); //
 		reconstructionPoint.SetObjectID(objectID);
 
 		input >> color.val[0] >> color.val[1] >> color.val[2] >> color.val[3];
-		input.getline(BUFFER, BUFFER_SIZE); //
+		SkipLine(input); //
 		reconstructionPoint.SetColor(color);
 
-		input.getline(BUFFER, BUFFER_SIZE); // 
-		input.getline(BUFFER, BUFFER_SIZE); // # feature point datas
+		SkipLine(input); // 
+		SkipLine(input); // # feature point datas
 
 		int featureCount = 0;
 		input >> featureCount;
-		input.getline(BUFFER, BUFFER_SIZE); // 
+		SkipLine(input); // 
 
 		for(int j=0; j<featureCount; j++)
 		{
@@ -174,36 +266,36 @@ bool Loader::DoLoad(const char* filename)
 			double dir;
 			double distance;
 
-			input.getline(BUFFER, BUFFER_SIZE); // # feature point
+			SkipLine(input); // # feature point
 
 			input >> featurePosition.x >> featurePosition.y >> featurePosition.z;
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetPoint(featurePosition);
 
 			input >> objectID;
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetObjectID(objectID);
 
 			input >> color.val[0] >> color.val[1] >> color.val[2] >> color.val[3];
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetColor(color);
 
 			input >> size;
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetSize(size);
 
 			input >> dir;
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetDir(dir);
 
 			input >> distance;
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 			featurePoint.SetDistance(distance);
 
-			input.getline(BUFFER, BUFFER_SIZE); // # descriptor datas
+			SkipLine(input); // # descriptor datas
 			int descriptorDimension = 0;
 			input >> descriptorDimension;
-			input.getline(BUFFER, BUFFER_SIZE); //
+			SkipLine(input); //
 
 			featurePoint.DESCRIPTOR_DIMENSION = descriptorDimension;
 			featurePoint.descriptor.resize(descriptorDimension);
@@ -211,12 +303,12 @@ bool Loader::DoLoad(const char* filename)
 			{
 				input >> featurePoint.descriptor[k];
 			}
-			input.getline(BUFFER, BUFFER_SIZE);
+			SkipLine(input);
 
 			// add feature point information
 			reconstructionPoint.AddFeaturePoint(featurePoint);
 		}
-		input.getline(BUFFER, BUFFER_SIZE);
+		SkipLine(input);
 
 		(*this->reconstructionPoints)[i] = reconstructionPoint;
 	}
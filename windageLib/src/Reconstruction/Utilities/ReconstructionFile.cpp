@@ -0,0 +1,299 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <string.h>
+
+#include "Reconstruction/Utilities/ReconstructionFile.h"
+using namespace windage;
+using namespace Reconstruction;
+
+bool MappedReconstruction::IsReconstructionFile(const char* filename)
+{
+	return windage::MappedFile::HasMagic(filename, RECONSTRUCTION_FILE_MAGIC, 8);
+}
+
+bool MappedReconstruction::Open(const char* filename)
+{
+	this->Close();
+
+	if(!this->file.Open(filename))
+		return false;
+	if(this->file.GetSize() < sizeof(ReconstructionFileHeader))
+	{
+		this->Close();
+		return false;
+	}
+	this->data = this->file.GetData();
+	this->dataSize = this->file.GetSize();
+
+	// validate header
+	const ReconstructionFileHeader* header = (const ReconstructionFileHeader*)this->data;
+	if(memcmp(header->magic, RECONSTRUCTION_FILE_MAGIC, 8) != 0 || header->version != RECONSTRUCTION_FILE_VERSION || header->fileSize != this->dataSize)
+	{
+		this->Close();
+		return false;
+	}
+	unsigned long long tableEnd = sizeof(ReconstructionFileHeader) + (unsigned long long)header->sectionCount * sizeof(ReconstructionFileSection);
+	if(tableEnd > this->dataSize)
+	{
+		this->Close();
+		return false;
+	}
+
+	// validate section table
+	this->sections = (const ReconstructionFileSection*)(this->data + sizeof(ReconstructionFileHeader));
+	this->sectionCount = header->sectionCount;
+	for(unsigned int i=0; i<this->sectionCount; i++)
+	{
+		const ReconstructionFileSection* section = &this->sections[i];
+		if(section->offset % 8 != 0 || section->offset < tableEnd || section->size > this->dataSize - section->offset ||
+			(section->stride > 0 && section->count > section->size / section->stride))
+		{
+			this->Close();
+			return false;
+		}
+	}
+
+	// validate record sizes
+	unsigned int strides[][2] = {	{RECONSTRUCTION_SECTION_CAMERA, sizeof(CameraRecord)},
+									{RECONSTRUCTION_SECTION_POINT, 4 * sizeof(double)},
+									{RECONSTRUCTION_SECTION_COLOR, 4 * sizeof(double)},
+									{RECONSTRUCTION_SECTION_OBJECT_ID, sizeof(int)},
+									{RECONSTRUCTION_SECTION_FEATURE_INDEX, sizeof(unsigned long long)},
+									{RECONSTRUCTION_SECTION_FEATURE, sizeof(FeatureRecord)},
+									{RECONSTRUCTION_SECTION_DESCRIPTOR, sizeof(double)},
+									{RECONSTRUCTION_SECTION_REFERENCE_INDEX, sizeof(unsigned long long)},
+									{RECONSTRUCTION_SECTION_REFERENCE, sizeof(windage::FeatureReference)}	};
+	for(unsigned int i=0; i<this->sectionCount; i++)
+	{
+		for(unsigned int j=0; j<sizeof(strides)/sizeof(strides[0]); j++)
+		{
+			if(this->sections[i].type == strides[j][0] && this->sections[i].stride != strides[j][1])
+			{
+				this->Close();
+				return false;
+			}
+		}
+	}
+
+	// validate per point sections
+	unsigned long long pointCount = this->GetPointCount();
+	int pointTypes[2] = {RECONSTRUCTION_SECTION_COLOR, RECONSTRUCTION_SECTION_OBJECT_ID};
+	for(int i=0; i<2; i++)
+	{
+		unsigned long long count = 0;
+		if(this->GetSection(pointTypes[i], &count) != NULL && count != pointCount)
+		{
+			this->Close();
+			return false;
+		}
+	}
+
+	// validate variable length indices
+	int indexTypes[3][2] = {	{RECONSTRUCTION_SECTION_FEATURE_INDEX, RECONSTRUCTION_SECTION_FEATURE},
+								{RECONSTRUCTION_SECTION_REFERENCE_INDEX, RECONSTRUCTION_SECTION_REFERENCE},
+								{RECONSTRUCTION_SECTION_IMAGE_PATH, -1}	};
+	for(int i=0; i<3; i++)
+	{
+		unsigned long long count = 0;
+		const unsigned long long* index = (const unsigned long long*)this->GetSection(indexTypes[i][0], &count);
+		if(index == NULL)
+			continue;
+
+		unsigned long long elementCount = 0;
+		if(indexTypes[i][1] < 0)
+		{
+			// image path : offsets are followed by the string table
+			unsigned long long pathCount = count;
+			const ReconstructionFileSection* section = NULL;
+			for(unsigned int j=0; j<this->sectionCount; j++)
+				if(this->sections[j].type == RECONSTRUCTION_SECTION_IMAGE_PATH)
+					section = &this->sections[j];
+			if((pathCount + 1) * sizeof(unsigned long long) > section->size)
+			{
+				this->Close();
+				return false;
+			}
+			elementCount = section->size - (pathCount + 1) * sizeof(unsigned long long);
+			count = pathCount;
+			const char* strings = (const char*)(index + pathCount + 1);
+			if(index[count] > elementCount || (index[count] > 0 && strings[index[count] - 1] != '\0'))
+			{
+				this->Close();
+				return false;
+			}
+		}
+		else
+		{
+			if(count != pointCount + 1)
+			{
+				this->Close();
+				return false;
+			}
+			count = pointCount;
+			this->GetSection(indexTypes[i][1], &elementCount);
+		}
+
+		for(unsigned long long j=0; j<count; j++)
+		{
+			if(index[j] > index[j+1] || index[j+1] > elementCount)
+			{
+				this->Close();
+				return false;
+			}
+		}
+	}
+
+	// validate descriptor ranges
+	unsigned long long featureCount = 0;
+	unsigned long long descriptorCount = 0;
+	const FeatureRecord* features = (const FeatureRecord*)this->GetSection(RECONSTRUCTION_SECTION_FEATURE, &featureCount);
+	this->GetSection(RECONSTRUCTION_SECTION_DESCRIPTOR, &descriptorCount);
+	for(unsigned long long i=0; i<featureCount; i++)
+	{
+		if(features[i].descriptorDimension < 0 || features[i].descriptorOffset > descriptorCount ||
+			(unsigned long long)features[i].descriptorDimension > descriptorCount - features[i].descriptorOffset)
+		{
+			this->Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MappedReconstruction::Close()
+{
+	this->file.Close();
+
+	this->data = NULL;
+	this->dataSize = 0;
+	this->sections = NULL;
+	this->sectionCount = 0;
+}
+
+const void* MappedReconstruction::GetSection(int type, unsigned long long* count)
+{
+	if(count)
+		*count = 0;
+	if(this->data == NULL)
+		return NULL;
+
+	for(unsigned int i=0; i<this->sectionCount; i++)
+	{
+		if(this->sections[i].type == (unsigned int)type)
+		{
+			if(count)
+				*count = this->sections[i].count;
+			return this->data + this->sections[i].offset;
+		}
+	}
+	return NULL;
+}
+
+int MappedReconstruction::GetCameraCount()
+{
+	unsigned long long count = 0;
+	this->GetSection(RECONSTRUCTION_SECTION_CAMERA, &count);
+	return (int)count;
+}
+
+const CameraRecord* MappedReconstruction::GetCameras()
+{
+	return (const CameraRecord*)this->GetSection(RECONSTRUCTION_SECTION_CAMERA);
+}
+
+const char* MappedReconstruction::GetImagePath(int index)
+{
+	unsigned long long count = 0;
+	const unsigned long long* offsets = (const unsigned long long*)this->GetSection(RECONSTRUCTION_SECTION_IMAGE_PATH, &count);
+	if(offsets == NULL || index < 0 || (unsigned long long)index >= count)
+		return NULL;
+
+	const char* strings = (const char*)(offsets + count + 1);
+	return strings + offsets[index];
+}
+
+int MappedReconstruction::GetPointCount()
+{
+	unsigned long long count = 0;
+	this->GetSection(RECONSTRUCTION_SECTION_POINT, &count);
+	return (int)count;
+}
+
+const double* MappedReconstruction::GetPoints()
+{
+	return (const double*)this->GetSection(RECONSTRUCTION_SECTION_POINT);
+}
+
+const double* MappedReconstruction::GetColors()
+{
+	return (const double*)this->GetSection(RECONSTRUCTION_SECTION_COLOR);
+}
+
+const int* MappedReconstruction::GetObjectIDs()
+{
+	return (const int*)this->GetSection(RECONSTRUCTION_SECTION_OBJECT_ID);
+}
+
+const unsigned long long* MappedReconstruction::GetFeatureIndex()
+{
+	return (const unsigned long long*)this->GetSection(RECONSTRUCTION_SECTION_FEATURE_INDEX);
+}
+
+const FeatureRecord* MappedReconstruction::GetFeatures()
+{
+	return (const FeatureRecord*)this->GetSection(RECONSTRUCTION_SECTION_FEATURE);
+}
+
+const double* MappedReconstruction::GetDescriptors()
+{
+	return (const double*)this->GetSection(RECONSTRUCTION_SECTION_DESCRIPTOR);
+}
+
+const unsigned long long* MappedReconstruction::GetReferenceIndex()
+{
+	return (const unsigned long long*)this->GetSection(RECONSTRUCTION_SECTION_REFERENCE_INDEX);
+}
+
+const FeatureReference* MappedReconstruction::GetReferences()
+{
+	return (const FeatureReference*)this->GetSection(RECONSTRUCTION_SECTION_REFERENCE);
+}
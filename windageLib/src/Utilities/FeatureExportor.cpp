@@ -99,4 +99,24 @@ bool FeatureExportor::DoExport()
 	}	
 
 	return true;
+}
+
+bool FeatureExportor::DoExportBinary(const char* filename, bool quantization, double minimum, double maximum)
+{
+	if(featurePoints == NULL)
+		return false;
+
+	int count = (int)this->featurePoints->size();
+	int dimension = count > 0 ? (*featurePoints)[0].DESCRIPTOR_DIMENSION : 0;
+
+	windage::FeatureFileWriter writer;
+	if(!writer.Open(filename, count, dimension, quantization, minimum, maximum))
+		return false;
+	if(!writer.Write(this->featurePoints))
+	{
+		writer.Close();
+		return false;
+	}
+
+	return writer.Close();
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <string.h>
+
+#include "Utilities/FeatureFile.h"
+using namespace windage;
+
+static unsigned long long AlignArray(unsigned long long size)
+{
+	return (size + 7) & ~(unsigned long long)7;
+}
+
+static int GetArrayStride(int type, unsigned int dimension, bool quantization)
+{
+	switch(type)
+	{
+	case FEATURE_ARRAY_POSITION:
+		return 3 * sizeof(float);
+	case FEATURE_ARRAY_SIZE:
+	case FEATURE_ARRAY_OBJECT_ID:
+		return sizeof(int);
+	case FEATURE_ARRAY_DIR:
+	case FEATURE_ARRAY_DISTANCE:
+		return sizeof(float);
+	case FEATURE_ARRAY_COLOR:
+		return 4 * sizeof(unsigned char);
+	case FEATURE_ARRAY_DESCRIPTOR:
+		return dimension * (quantization ? sizeof(unsigned char) : sizeof(float));
+	}
+	return 0;
+}
+
+bool FeatureFileWriter::Open(const char* filename, int count, int dimension, bool quantization, double minimum, double maximum)
+{
+	this->Close();
+	if(count < 0 || dimension < 0 || (quantization && maximum <= minimum))
+		return false;
+
+	memset(&this->header, 0, sizeof(this->header));
+	memcpy(this->header.magic, FEATURE_FILE_MAGIC, 8);
+	this->header.version = FEATURE_FILE_VERSION;
+	this->header.flags = quantization ? FEATURE_FILE_QUANTIZED : 0;
+	this->header.count = count;
+	this->header.dimension = dimension;
+	this->header.quantizationMinimum = minimum;
+	this->header.quantizationScale = quantization ? (maximum - minimum) / 255.0 : 1.0;
+
+	unsigned long long offset = sizeof(FeatureFileHeader);
+	for(int i=0; i<FEATURE_ARRAY_COUNT; i++)
+	{
+		this->header.offset[i] = offset;
+		offset += AlignArray((unsigned long long)count * GetArrayStride(i, dimension, quantization));
+	}
+	this->header.fileSize = offset;
+
+	this->output = fopen(filename, "wb");
+	if(this->output == NULL)
+		return false;
+	this->written = 0;
+
+	// reserve the whole file so that each block can be placed by seek
+	bool result = fwrite(&this->header, sizeof(this->header), 1, this->output) == 1;
+	if(result && offset > sizeof(FeatureFileHeader))
+	{
+		const char zero = 0;
+		result = _fseeki64(this->output, (long long)offset - 1, SEEK_SET) == 0 && fwrite(&zero, 1, 1, this->output) == 1;
+	}
+	if(!result)
+	{
+		fclose(this->output);
+		this->output = NULL;
+	}
+
+	return result;
+}
+
+bool FeatureFileWriter::WriteArray(int type, int stride, unsigned long long count, const void* data)
+{
+	if(count == 0)
+		return true;
+	if(_fseeki64(this->output, (long long)(this->header.offset[type] + this->written * stride), SEEK_SET) != 0)
+		return false;
+	return fwrite(data, stride, (size_t)count, this->output) == count;
+}
+
+bool FeatureFileWriter::Write(std::vector<windage::FeaturePoint>* featurePoints)
+{
+	if(this->output == NULL || featurePoints == NULL)
+		return false;
+
+	int count = (int)featurePoints->size();
+	if(this->written + count > this->header.count)
+		return false;
+
+	int dimension = (int)this->header.dimension;
+	bool quantization = (this->header.flags & FEATURE_FILE_QUANTIZED) != 0;
+
+	std::vector<float> positions(count * 3);
+	std::vector<int> sizes(count);
+	std::vector<float> dirs(count);
+	std::vector<float> distances(count);
+	std::vector<int> objectIDs(count);
+	std::vector<unsigned char> colors(count * 4);
+	std::vector<float> descriptors(quantization ? 0 : count * dimension);
+	std::vector<unsigned char> quantizedDescriptors(quantization ? count * dimension : 0);
+
+	for(int i=0; i<count; i++)
+	{
+		windage::FeaturePoint* feature = &(*featurePoints)[i];
+		if((int)feature->descriptor.size() < dimension)
+			return false;
+
+		windage::Vector3 point = feature->GetPoint();
+		positions[i*3 + 0] = (float)point.x;
+		positions[i*3 + 1] = (float)point.y;
+		positions[i*3 + 2] = (float)point.z;
+		sizes[i] = feature->GetSize();
+		dirs[i] = (float)feature->GetDir();
+		distances[i] = (float)feature->GetDistance();
+		objectIDs[i] = feature->GetObjectID();
+
+		CvScalar color = feature->GetColor();
+		for(int k=0; k<4; k++)
+			colors[i*4 + k] = (unsigned char)MIN(MAX(cvRound(color.val[k]), 0), 255);
+
+		if(quantization)
+		{
+			for(int k=0; k<dimension; k++)
+			{
+				int value = cvRound((feature->descriptor[k] - this->header.quantizationMinimum) / this->header.quantizationScale);
+				quantizedDescriptors[i*dimension + k] = (unsigned char)MIN(MAX(value, 0), 255);
+			}
+		}
+		else
+		{
+			for(int k=0; k<dimension; k++)
+				descriptors[i*dimension + k] = (float)feature->descriptor[k];
+		}
+	}
+
+	bool result = count == 0 ||
+		(WriteArray(FEATURE_ARRAY_POSITION, 3 * sizeof(float), count, &positions[0]) &&
+		WriteArray(FEATURE_ARRAY_SIZE, sizeof(int), count, &sizes[0]) &&
+		WriteArray(FEATURE_ARRAY_DIR, sizeof(float), count, &dirs[0]) &&
+		WriteArray(FEATURE_ARRAY_DISTANCE, sizeof(float), count, &distances[0]) &&
+		WriteArray(FEATURE_ARRAY_OBJECT_ID, sizeof(int), count, &objectIDs[0]) &&
+		WriteArray(FEATURE_ARRAY_COLOR, 4 * sizeof(unsigned char), count, &colors[0]));
+	if(result && count > 0 && dimension > 0)
+	{
+		if(quantization)
+			result = WriteArray(FEATURE_ARRAY_DESCRIPTOR, dimension * sizeof(unsigned char), count, &quantizedDescriptors[0]);
+		else
+			result = WriteArray(FEATURE_ARRAY_DESCRIPTOR, dimension * sizeof(float), count, &descriptors[0]);
+	}
+
+	if(result)
+		this->written += count;
+	return result;
+}
+
+bool FeatureFileWriter::Close()
+{
+	if(this->output == NULL)
+		return false;
+
+	fclose(this->output);
+	this->output = NULL;
+
+	return this->written == this->header.count;
+}
+
+bool MappedFeatureFile::IsFeatureFile(const char* filename)
+{
+	return windage::MappedFile::HasMagic(filename, FEATURE_FILE_MAGIC, 8);
+}
+
+bool MappedFeatureFile::Open(const char* filename)
+{
+	this->Close();
+
+	if(!this->file.Open(filename))
+		return false;
+	if(this->file.GetSize() < sizeof(FeatureFileHeader))
+	{
+		this->Close();
+		return false;
+	}
+
+	const FeatureFileHeader* fileHeader = (const FeatureFileHeader*)this->file.GetData();
+	if(memcmp(fileHeader->magic, FEATURE_FILE_MAGIC, 8) != 0 || fileHeader->version != FEATURE_FILE_VERSION || fileHeader->fileSize != this->file.GetSize())
+	{
+		this->Close();
+		return false;
+	}
+
+	// validate array ranges
+	bool quantization = (fileHeader->flags & FEATURE_FILE_QUANTIZED) != 0;
+	for(int i=0; i<FEATURE_ARRAY_COUNT; i++)
+	{
+		unsigned long long stride = GetArrayStride(i, fileHeader->dimension, quantization);
+		unsigned long long offset = fileHeader->offset[i];
+		if(offset % 8 != 0 || offset < sizeof(FeatureFileHeader) || offset > fileHeader->fileSize ||
+			(stride > 0 && fileHeader->count > (fileHeader->fileSize - offset) / stride))
+		{
+			this->Close();
+			return false;
+		}
+	}
+
+	this->header = fileHeader;
+	return true;
+}
+
+void MappedFeatureFile::Close()
+{
+	this->header = NULL;
+	this->file.Close();
+	std::vector<float>().swap(this->dequantizedDescriptors);
+}
+
+bool MappedFeatureFile::GetFeature(int index, windage::FeaturePoint* featurePoint)
+{
+	if(this->header == NULL || featurePoint == NULL || index < 0 || index >= this->GetCount())
+		return false;
+
+	const float* position = this->GetPositions() + index*3;
+	const unsigned char* color = this->GetColors() + index*4;
+
+	featurePoint->SetPoint(windage::Vector3(position[0], position[1], position[2]));
+	featurePoint->SetSize(this->GetSizes()[index]);
+	featurePoint->SetDir(this->GetDirs()[index]);
+	featurePoint->SetDistance(this->GetDistances()[index]);
+	featurePoint->SetObjectID(this->GetObjectIDs()[index]);
+	featurePoint->SetColor(cvScalar(color[0], color[1], color[2], color[3]));
+
+	int dimension = this->GetDimension();
+	featurePoint->DESCRIPTOR_DIMENSION = dimension;
+	featurePoint->descriptor.resize(dimension);
+	if(this->IsQuantized())
+	{
+		const unsigned char* descriptor = this->GetQuantizedDescriptors() + index*dimension;
+		for(int k=0; k<dimension; k++)
+			featurePoint->descriptor[k] = this->header->quantizationMinimum + descriptor[k] * this->header->quantizationScale;
+	}
+	else
+	{
+		const float* descriptor = this->GetDescriptors() + index*dimension;
+		for(int k=0; k<dimension; k++)
+			featurePoint->descriptor[k] = descriptor[k];
+	}
+
+	return true;
+}
+
+bool MappedFeatureFile::Training(windage::Algorithms::SearchTree* searchTree)
+{
+	if(this->header == NULL || searchTree == NULL)
+		return false;
+
+	int count = this->GetCount();
+	int dimension = this->GetDimension();
+	if(!this->IsQuantized())
+		return searchTree->TrainingDescriptors(this->GetDescriptors(), count, dimension);
+
+	const unsigned char* quantized = this->GetQuantizedDescriptors();
+	this->dequantizedDescriptors.resize((size_t)count * dimension);
+	float minimum = (float)this->header->quantizationMinimum;
+	float scale = (float)this->header->quantizationScale;
+	for(int i=0; i<count*dimension; i++)
+		this->dequantizedDescriptors[i] = minimum + quantized[i] * scale;
+
+	return searchTree->TrainingDescriptors(count > 0 ? &this->dequantizedDescriptors[0] : NULL, count, dimension);
+}
@@ -40,6 +40,7 @@
 #include <fstream>
 
 #include "Utilities/FeatureLoader.h"
+#include "Utilities/FeatureFile.h"
 using namespace windage;
 
 bool FeatureLoader::DoLoad(const char* filename)
@@ -47,6 +48,22 @@ bool FeatureLoader::DoLoad(const char* filename)
 	if(featurePoints == NULL)
 		return false;
 
+	if(windage::MappedFeatureFile::IsFeatureFile(filename))
+	{
+		windage::MappedFeatureFile file;
+		if(!file.Open(filename))
+			return false;
+
+		int count = file.GetCount();
+		int offset = (int)featurePoints->size();
+		featurePoints->resize(offset + count);
+		for(int i=0; i<count; i++)
+			file.GetFeature(i, &(*featurePoints)[offset + i]);
+
+		file.Close();
+		return true;
+	}
+
 	std::ifstream input;
 	input.open(filename);
 	if(!input.is_open())
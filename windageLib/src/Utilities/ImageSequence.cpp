@@ -0,0 +1,176 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include <string.h>
+
+#include "Utilities/ImageSequence.h"
+using namespace windage;
+
+bool ImageSequence::IsNumberedPattern(const char* filename)
+{
+	// the formatted number is shorter than 100 characters (width of 2 digits at most)
+	if(filename == NULL || strlen(filename) + 100 > MAX_FILENAME_LENGTH)
+		return false;
+
+	int conversionCount = 0;
+	for(const char* c = filename; *c; c++)
+	{
+		if(*c != '%')
+			continue;
+		c++;
+		if(*c == '%')
+			continue;
+
+		while(*c && strchr("-+ #0", *c))
+			c++;
+		for(int digit=0; *c >= '0' && *c <= '9'; digit++, c++)
+			if(digit >= 2)
+				return false;
+		if(*c == '\0' || strchr("diuoxX", *c) == NULL)
+			return false;
+		conversionCount++;
+	}
+	return conversionCount == 1;
+}
+
+void ImageSequence::Release()
+{
+	if(capture) cvReleaseCapture(&capture);
+	capture = NULL;
+	if(colorImage) cvReleaseImage(&colorImage);
+	colorImage = NULL;
+	if(grayImage) cvReleaseImage(&grayImage);
+	grayImage = NULL;
+
+	this->index = -1;
+}
+
+bool ImageSequence::Open(const char* filename, int startIndex)
+{
+	this->Release();
+	if(filename == NULL)
+		return false;
+
+	this->filename = filename;
+	this->startIndex = startIndex;
+	this->numbered = IsNumberedPattern(filename);
+
+	if(this->numbered)
+	{
+		char message[MAX_FILENAME_LENGTH];
+		sprintf_s(message, this->filename.c_str(), this->startIndex);
+		IplImage* frame = cvLoadImage(message);
+		if(frame == NULL)
+			return false;
+		cvReleaseImage(&frame);
+	}
+	else
+	{
+		this->capture = cvCreateFileCapture(this->filename.c_str());
+		if(this->capture == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+bool ImageSequence::SetFrame(IplImage* frame)
+{
+	if(frame == NULL)
+		return false;
+
+	CvSize size = cvGetSize(frame);
+	if(this->width > 0 && this->height > 0)
+		size = cvSize(this->width, this->height);
+
+	if(this->colorImage == NULL || this->colorImage->width != size.width || this->colorImage->height != size.height)
+	{
+		if(colorImage) cvReleaseImage(&colorImage);
+		if(grayImage) cvReleaseImage(&grayImage);
+		colorImage = cvCreateImage(size, IPL_DEPTH_8U, 3);
+		grayImage = cvCreateImage(size, IPL_DEPTH_8U, 1);
+	}
+
+	IplImage* colorFrame = frame;
+	if(frame->nChannels == 1)
+	{
+		colorFrame = cvCreateImage(cvGetSize(frame), IPL_DEPTH_8U, 3);
+		cvCvtColor(frame, colorFrame, CV_GRAY2BGR);
+	}
+
+	if(colorFrame->width == size.width && colorFrame->height == size.height)
+		cvCopy(colorFrame, this->colorImage);
+	else
+		cvResize(colorFrame, this->colorImage, CV_INTER_LINEAR);
+	// video frame is bottom-left origin at some codecs
+	if(colorFrame->origin != this->colorImage->origin)
+		cvFlip(this->colorImage, this->colorImage, 0);
+	cvCvtColor(this->colorImage, this->grayImage, CV_BGR2GRAY);
+
+	if(colorFrame != frame)
+		cvReleaseImage(&colorFrame);
+	return true;
+}
+
+bool ImageSequence::Next()
+{
+	if(this->frameCount > 0 && this->index + 1 >= this->frameCount)
+		return false;
+
+	bool updated = false;
+	if(this->numbered)
+	{
+		char message[MAX_FILENAME_LENGTH];
+		sprintf_s(message, this->filename.c_str(), this->startIndex + this->index + 1);
+		IplImage* frame = cvLoadImage(message);
+		updated = this->SetFrame(frame);
+		if(frame) cvReleaseImage(&frame);
+	}
+	else if(this->capture)
+	{
+		// the captured frame is owned by the capture
+		updated = this->SetFrame(cvQueryFrame(this->capture));
+	}
+
+	if(updated == false)
+		return false;
+
+	this->index++;
+	return true;
+}
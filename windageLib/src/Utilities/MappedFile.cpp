@@ -0,0 +1,108 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+
+#include "Utilities/MappedFile.h"
+using namespace windage;
+
+bool MappedFile::Open(const char* filename)
+{
+	this->Close();
+
+	HANDLE fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	this->file = fileHandle;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(this->mapping == NULL)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->data = (const char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+	if(this->data == NULL)
+	{
+		this->Close();
+		return false;
+	}
+	this->size = (unsigned long long)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(this->data)
+		UnmapViewOfFile(this->data);
+	if(this->mapping)
+		CloseHandle(this->mapping);
+	if(this->file)
+		CloseHandle(this->file);
+
+	this->file = NULL;
+	this->mapping = NULL;
+	this->data = NULL;
+	this->size = 0;
+}
+
+bool MappedFile::HasMagic(const char* filename, const char* magic, int length)
+{
+	FILE* input = fopen(filename, "rb");
+	if(input == NULL)
+		return false;
+
+	char buffer[16];
+	bool result = length <= 16 && (int)fread(buffer, 1, length, input) == length && memcmp(buffer, magic, length) == 0;
+	fclose(input);
+
+	return result;
+}
@@ -0,0 +1,639 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+#include <process.h>
+
+#include "Utilities/Profiler.h"
+#include "Utilities/Utils.h"
+using namespace windage;
+
+int LatencyHistogram::GetIndex(unsigned long long value)
+{
+	if(value >= (1ULL << VALUE_BITS))
+		value = (1ULL << VALUE_BITS) - 1;
+	if(value < SUB_BUCKET_COUNT)
+		return (int)value;
+
+	// the highest bit selects the bucket and the next (SUB_BUCKET_BITS-1) bits select the sub-bucket
+	int highest = 0;
+	while((value >> (highest+1)) != 0)
+		highest++;
+	int shift = highest - SUB_BUCKET_BITS + 1;
+	return shift * HALF_SUB_BUCKET_COUNT + (int)(value >> shift);
+}
+
+unsigned long long LatencyHistogram::GetUpperBound(int index)
+{
+	if(index < SUB_BUCKET_COUNT)
+		return (unsigned long long)index;
+
+	int shift = index / HALF_SUB_BUCKET_COUNT - 1;
+	unsigned long long subBucket = (unsigned long long)(index - shift * HALF_SUB_BUCKET_COUNT);
+	return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Reset()
+{
+	memset(this->counts, 0, sizeof(this->counts));
+	this->count = 0;
+	this->minimum = 0;
+	this->maximum = 0;
+	this->sum = 0.0;
+}
+
+void LatencyHistogram::Record(unsigned long long nanoseconds)
+{
+	this->counts[GetIndex(nanoseconds)]++;
+	if(this->count == 0 || nanoseconds < this->minimum)
+		this->minimum = nanoseconds;
+	if(nanoseconds > this->maximum)
+		this->maximum = nanoseconds;
+	this->sum += (double)nanoseconds;
+	this->count++;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& histogram)
+{
+	if(histogram.count == 0)
+		return;
+
+	for(int i=0; i<INDEX_COUNT; i++)
+		this->counts[i] += histogram.counts[i];
+	if(this->count == 0 || histogram.minimum < this->minimum)
+		this->minimum = histogram.minimum;
+	if(histogram.maximum > this->maximum)
+		this->maximum = histogram.maximum;
+	this->sum += histogram.sum;
+	this->count += histogram.count;
+}
+
+unsigned long long LatencyHistogram::GetPercentile(double percentile) const
+{
+	if(this->count == 0)
+		return 0;
+
+	double target = percentile / 100.0 * this->count;
+	if(target < 1.0)
+		target = 1.0;
+
+	unsigned int accumulated = 0;
+	for(int i=0; i<INDEX_COUNT; i++)
+	{
+		accumulated += this->counts[i];
+		if(accumulated >= target)
+		{
+			unsigned long long value = GetUpperBound(i);
+			return value < this->maximum ? value : this->maximum;
+		}
+	}
+	return this->maximum;
+}
+
+namespace windage
+{
+	namespace ProfilerInternal
+	{
+		struct ProfileRecord
+		{
+			int stageID;
+			int frameID;
+			int objectID;
+			int64 startTick;
+			int64 endTick;
+		};
+
+		/**
+		 * @brief
+		 *		single producer (owner thread) / single consumer (Collect) ring buffer
+		 * @remark
+		 *		the producer publishes a record by writeIndex and the consumer releases it by readIndex,
+		 *		both are written by interlocked exchange so the record is visible before the index
+		 */
+		struct ThreadRing
+		{
+			ProfileRecord records[Profiler::RING_SIZE];
+			volatile LONG writeIndex;
+			volatile LONG readIndex;
+			volatile LONG dropped;
+
+			bool used;
+			DWORD threadID;
+			HANDLE thread;
+			char name[32];
+			bool nameWritten;				///< thread name is written to the trace
+		};
+
+		struct ProfilerState
+		{
+			CRITICAL_SECTION lock;
+			DWORD tlsIndex;
+			volatile LONG enabled;
+			volatile LONG dropped;			///< records of the threads without ring buffer
+
+			int stageCount;
+			char stageNames[Profiler::MAX_STAGE_COUNT][64];
+			LatencyHistogram histograms[Profiler::MAX_STAGE_COUNT];
+
+			ThreadRing* rings[Profiler::MAX_THREAD_COUNT];
+			double tickToNanosecond;
+			double tickFrequency;			///< ticks per microsecond
+			volatile LONG frameID;
+
+			// trace
+			FILE* traceFile;
+			bool traceFirstEvent;
+			int64 traceStartTick;
+			DWORD processID;
+			HANDLE flusher;
+			volatile LONG flushing;
+			int flushInterval;
+
+			ProfilerState()
+			{
+				InitializeCriticalSection(&lock);
+				tlsIndex = TlsAlloc();
+				enabled = 0;
+				dropped = 0;
+				stageCount = 0;
+				for(int i=0; i<Profiler::MAX_THREAD_COUNT; i++)
+					rings[i] = NULL;
+				tickFrequency = cvGetTickFrequency();
+				tickToNanosecond = 1000.0 / tickFrequency;
+				frameID = -1;
+
+				traceFile = NULL;
+				traceFirstEvent = true;
+				traceStartTick = 0;
+				processID = GetCurrentProcessId();
+				flusher = NULL;
+				flushing = 0;
+				flushInterval = 100;
+			}
+		};
+
+		/** the state is created at the first use so that stages can be registered from static initializers */
+		static ProfilerState* GetState()
+		{
+			static ProfilerState* volatile state = NULL;
+			static volatile LONG creating = 0;
+
+			if(state == NULL)
+			{
+				while(InterlockedCompareExchange(&creating, 1, 0) != 0)
+					Sleep(0);
+				if(state == NULL)
+					state = new ProfilerState();
+				InterlockedExchange(&creating, 0);
+			}
+			return state;
+		}
+
+		/** marker of the thread which could not get a ring buffer */
+		static ThreadRing noRing;
+
+		static ThreadRing* AcquireRing(ProfilerState* state)
+		{
+			ThreadRing* ring = NULL;
+
+			EnterCriticalSection(&state->lock);
+			for(int i=0; i<Profiler::MAX_THREAD_COUNT && ring == NULL; i++)
+			{
+				if(state->rings[i] == NULL)
+				{
+					state->rings[i] = new ThreadRing();
+					state->rings[i]->used = false;
+				}
+				if(state->rings[i]->used == false)
+				{
+					ring = state->rings[i];
+					ring->writeIndex = 0;
+					ring->readIndex = 0;
+					ring->dropped = 0;
+					ring->used = true;
+					ring->threadID = GetCurrentThreadId();
+					ring->thread = OpenThread(SYNCHRONIZE, FALSE, ring->threadID);
+					ring->name[0] = '\0';
+					ring->nameWritten = false;
+				}
+			}
+			LeaveCriticalSection(&state->lock);
+
+			return ring != NULL ? ring : &noRing;
+		}
+
+		static ThreadRing* GetRing(ProfilerState* state)
+		{
+			ThreadRing* ring = (ThreadRing*)TlsGetValue(state->tlsIndex);
+			if(ring == NULL)
+			{
+				ring = AcquireRing(state);
+				TlsSetValue(state->tlsIndex, ring);
+			}
+			return ring;
+		}
+
+		/** separator before each trace event after the first, called in the lock */
+		static void BeginTraceEvent(ProfilerState* state)
+		{
+			if(state->traceFirstEvent == false)
+				fputs(",\n", state->traceFile);
+			state->traceFirstEvent = false;
+		}
+
+		/** thread name metadata event, called in the lock */
+		static void WriteTraceThreadName(ProfilerState* state, ThreadRing* ring)
+		{
+			if(state->traceFile == NULL || ring->nameWritten || ring->name[0] == '\0')
+				return;
+
+			BeginTraceEvent(state);
+			fprintf(state->traceFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":", (unsigned long)state->processID, (unsigned long)ring->threadID);
+			Utils::WriteJSONString(state->traceFile, ring->name);
+			fputs("}}", state->traceFile);
+			ring->nameWritten = true;
+		}
+
+		/** complete event (begin and duration), called in the lock */
+		static void WriteTraceEvent(ProfilerState* state, ThreadRing* ring, const ProfileRecord& record)
+		{
+			if(record.startTick < state->traceStartTick)
+				return;
+
+			double timestamp = (double)(record.startTick - state->traceStartTick) / state->tickFrequency;
+			double duration = (double)(record.endTick - record.startTick) / state->tickFrequency;
+
+			BeginTraceEvent(state);
+			fputs("{\"name\":", state->traceFile);
+			Utils::WriteJSONString(state->traceFile, state->stageNames[record.stageID]);
+			fprintf(state->traceFile, ",\"cat\":\"windage\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu,\"args\":{",
+				timestamp, duration > 0.0 ? duration : 0.0, (unsigned long)state->processID, (unsigned long)ring->threadID);
+			if(record.frameID >= 0)
+				fprintf(state->traceFile, "\"frame\":%d", record.frameID);
+			if(record.objectID >= 0)
+				fprintf(state->traceFile, "%s\"object\":%d", record.frameID >= 0 ? "," : "", record.objectID);
+			fputs("}}", state->traceFile);
+		}
+
+		/** consumer side, called in the lock */
+		static void DrainRing(ProfilerState* state, ThreadRing* ring)
+		{
+			WriteTraceThreadName(state, ring);
+
+			LONG writeIndex = InterlockedCompareExchange(&ring->writeIndex, 0, 0);
+			LONG readIndex = ring->readIndex;
+			for(; readIndex != writeIndex; readIndex++)
+			{
+				const ProfileRecord& record = ring->records[readIndex & (Profiler::RING_SIZE-1)];
+				if(0 <= record.stageID && record.stageID < state->stageCount)
+				{
+					int64 duration = record.endTick - record.startTick;
+					state->histograms[record.stageID].Record(duration > 0 ? (unsigned long long)(duration * state->tickToNanosecond) : 0);
+					if(state->traceFile)
+						WriteTraceEvent(state, ring, record);
+				}
+			}
+			InterlockedExchange(&ring->readIndex, readIndex);
+		}
+
+		static unsigned int WINAPI TraceFlushThread(void* pArg)
+		{
+			ProfilerState* state = (ProfilerState*)pArg;
+			while(state->flushing)
+			{
+				Sleep(state->flushInterval);
+
+				Profiler::Collect();
+
+				EnterCriticalSection(&state->lock);
+				if(state->traceFile)
+					fflush(state->traceFile);
+				LeaveCriticalSection(&state->lock);
+			}
+			return 0;
+		}
+	}
+}
+using namespace windage::ProfilerInternal;
+
+void Profiler::SetEnabled(bool enabled)
+{
+	InterlockedExchange(&GetState()->enabled, enabled ? 1 : 0);
+}
+
+bool Profiler::IsEnabled()
+{
+	return GetState()->enabled != 0;
+}
+
+int Profiler::RegisterStage(const char* name)
+{
+	if(name == NULL)
+		return -1;
+
+	ProfilerState* state = GetState();
+	int stageID = -1;
+
+	EnterCriticalSection(&state->lock);
+	for(int i=0; i<state->stageCount && stageID < 0; i++)
+	{
+		if(strcmp(state->stageNames[i], name) == 0)
+			stageID = i;
+	}
+	if(stageID < 0 && state->stageCount < MAX_STAGE_COUNT)
+	{
+		stageID = state->stageCount;
+		strncpy_s(state->stageNames[stageID], sizeof(state->stageNames[stageID]), name, _TRUNCATE);
+		state->histograms[stageID].Reset();
+		state->stageCount++;
+	}
+	LeaveCriticalSection(&state->lock);
+
+	return stageID;
+}
+
+int Profiler::RegisterStage(volatile long* stageID, const char* name)
+{
+	LONG cachedID = *stageID;
+	if(cachedID >= 0)
+		return (int)cachedID;
+
+	// racing threads get the same ID for the same name, the first one publishes it
+	int registeredID = RegisterStage(name);
+	if(registeredID >= 0)
+		InterlockedCompareExchange(stageID, registeredID, -1);
+	return registeredID;
+}
+
+int Profiler::GetStageCount()
+{
+	return GetState()->stageCount;
+}
+
+const char* Profiler::GetStageName(int stageID)
+{
+	ProfilerState* state = GetState();
+	if(stageID < 0 || stageID >= state->stageCount)
+		return NULL;
+	return state->stageNames[stageID];
+}
+
+int Profiler::BeginFrame()
+{
+	return (int)InterlockedIncrement(&GetState()->frameID);
+}
+
+int Profiler::GetFrameID()
+{
+	return (int)GetState()->frameID;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	if(name == NULL)
+		return;
+
+	ProfilerState* state = GetState();
+	ThreadRing* ring = GetRing(state);
+	if(ring == &noRing)
+		return;
+
+	EnterCriticalSection(&state->lock);
+	strncpy_s(ring->name, sizeof(ring->name), name, _TRUNCATE);
+	ring->nameWritten = false;
+	LeaveCriticalSection(&state->lock);
+}
+
+void Profiler::Record(int stageID, int64 startTick, int64 endTick, int frameID, int objectID)
+{
+	ProfilerState* state = GetState();
+
+	ThreadRing* ring = GetRing(state);
+	if(ring == &noRing)
+	{
+		InterlockedIncrement(&state->dropped);
+		return;
+	}
+
+	LONG writeIndex = ring->writeIndex;
+	if((unsigned long)(writeIndex - ring->readIndex) >= (unsigned long)RING_SIZE)
+	{
+		InterlockedIncrement(&ring->dropped);
+		return;
+	}
+
+	ProfileRecord& record = ring->records[writeIndex & (RING_SIZE-1)];
+	record.stageID = stageID;
+	record.frameID = frameID;
+	record.objectID = objectID;
+	record.startTick = startTick;
+	record.endTick = endTick;
+	InterlockedExchange(&ring->writeIndex, writeIndex + 1);
+}
+
+void Profiler::Collect()
+{
+	ProfilerState* state = GetState();
+
+	EnterCriticalSection(&state->lock);
+	for(int i=0; i<MAX_THREAD_COUNT; i++)
+	{
+		ThreadRing* ring = state->rings[i];
+		if(ring == NULL || ring->used == false)
+			continue;
+
+		DrainRing(state, ring);
+
+		// release the ring buffer of the finished thread
+		if(ring->thread != NULL && WaitForSingleObject(ring->thread, 0) == WAIT_OBJECT_0)
+		{
+			DrainRing(state, ring);
+			InterlockedExchangeAdd(&state->dropped, ring->dropped);
+			CloseHandle(ring->thread);
+			ring->thread = NULL;
+			ring->used = false;
+		}
+	}
+	LeaveCriticalSection(&state->lock);
+}
+
+void Profiler::Reset()
+{
+	ProfilerState* state = GetState();
+
+	Collect();
+
+	EnterCriticalSection(&state->lock);
+	for(int i=0; i<state->stageCount; i++)
+		state->histograms[i].Reset();
+	state->dropped = 0;
+	for(int i=0; i<MAX_THREAD_COUNT; i++)
+		if(state->rings[i])
+			state->rings[i]->dropped = 0;
+	LeaveCriticalSection(&state->lock);
+}
+
+LatencyHistogram Profiler::GetHistogram(int stageID)
+{
+	ProfilerState* state = GetState();
+	LatencyHistogram histogram;
+
+	EnterCriticalSection(&state->lock);
+	if(0 <= stageID && stageID < state->stageCount)
+		histogram = state->histograms[stageID];
+	LeaveCriticalSection(&state->lock);
+
+	return histogram;
+}
+
+unsigned int Profiler::GetDroppedCount()
+{
+	ProfilerState* state = GetState();
+	unsigned int dropped = (unsigned int)state->dropped;
+	for(int i=0; i<MAX_THREAD_COUNT; i++)
+		if(state->rings[i] && state->rings[i]->used)
+			dropped += (unsigned int)state->rings[i]->dropped;
+	return dropped;
+}
+
+void Profiler::Dump(windage::Logger* logger)
+{
+	if(logger == NULL)
+		return;
+
+	Collect();
+
+	int stageCount = GetStageCount();
+	for(int i=0; i<stageCount; i++)
+	{
+		LatencyHistogram histogram = GetHistogram(i);
+		if(histogram.GetCount() == 0)
+			continue;
+
+		logger->log("stage", (char*)GetStageName(i));
+		logger->log("count", (int)histogram.GetCount());
+		logger->log("mean", histogram.GetMean() / 1000000.0);
+		logger->log("p50", (double)histogram.GetPercentile(50.0) / 1000000.0);
+		logger->log("p95", (double)histogram.GetPercentile(95.0) / 1000000.0);
+		logger->log("p99", (double)histogram.GetPercentile(99.0) / 1000000.0);
+		logger->log("max", (double)histogram.GetMax() / 1000000.0);
+		logger->logNewLine();
+	}
+
+	unsigned int dropped = GetDroppedCount();
+	if(dropped > 0)
+	{
+		logger->log("dropped", (int)dropped);
+		logger->logNewLine();
+	}
+}
+
+bool Profiler::StartTrace(const char* filename, int flushInterval)
+{
+	if(filename == NULL)
+		return false;
+
+	ProfilerState* state = GetState();
+
+	// records before the trace are kept only in the histograms
+	Collect();
+
+	EnterCriticalSection(&state->lock);
+	if(state->traceFile != NULL)
+	{
+		LeaveCriticalSection(&state->lock);
+		return false;
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if(file == NULL)
+	{
+		LeaveCriticalSection(&state->lock);
+		return false;
+	}
+
+	fputs("{\"traceEvents\":[\n", file);
+	state->traceFile = file;
+	state->traceFirstEvent = true;
+	state->traceStartTick = cvGetTickCount();
+	state->flushInterval = flushInterval > 0 ? flushInterval : 1;
+	for(int i=0; i<MAX_THREAD_COUNT; i++)
+		if(state->rings[i])
+			state->rings[i]->nameWritten = false;
+	LeaveCriticalSection(&state->lock);
+
+	SetEnabled(true);
+
+	InterlockedExchange(&state->flushing, 1);
+	state->flusher = (HANDLE)_beginthreadex(NULL, 0, TraceFlushThread, (void*)state, 0, NULL);
+
+	return true;
+}
+
+void Profiler::StopTrace()
+{
+	ProfilerState* state = GetState();
+
+	InterlockedExchange(&state->flushing, 0);
+	if(state->flusher)
+	{
+		WaitForSingleObject(state->flusher, INFINITE);
+		CloseHandle(state->flusher);
+		state->flusher = NULL;
+	}
+
+	Collect();
+
+	EnterCriticalSection(&state->lock);
+	if(state->traceFile)
+	{
+		fputs("\n],\"displayTimeUnit\":\"ms\"}\n", state->traceFile);
+		fclose(state->traceFile);
+		state->traceFile = NULL;
+	}
+	LeaveCriticalSection(&state->lock);
+}
+
+bool Profiler::IsTracing()
+{
+	return GetState()->traceFile != NULL;
+}
@@ -0,0 +1,345 @@
+/* ========================================================================
+ * PROJECT: windage Library
+ * ========================================================================
+ * This work is based on the original windage Library developed by
+ *   Woonhyuk Baek (wbaek@gist.ac.kr / windage@live.com)
+ *   Woontack Woo (wwoo@gist.ac.kr)
+ *   U-VR Lab, GIST of Gwangju in Korea.
+ *   http://windage.googlecode.com/
+ *   http://uvr.gist.ac.kr/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2009 GIST U-VR Lab.
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Woonhyuk Baek
+ *   <windage@live.com>
+ *   GIST U-VR Lab.
+ *   Department of Information and Communication
+ *   Gwangju Institute of Science and Technology
+ *   1, Oryong-dong, Buk-gu, Gwangju
+ *   South Korea
+ * ========================================================================
+ ** @author   Woonhyuk Baek
+ * ======================================================================== */
+
+#include "Utilities/SyntheticSequence.h"
+using namespace windage;
+
+static windage::Matrix3 GetRotation(windage::Calibration* calibration)
+{
+	CvMat* extrinsic = calibration->GetExtrinsicMatrix();
+	windage::Matrix3 rotation;
+	for(int y=0; y<3; y++)
+		for(int x=0; x<3; x++)
+			rotation.m[y][x] = CV_MAT_ELEM((*extrinsic), double, y, x);
+	return rotation;
+}
+
+static windage::Vector2 ProjectPoint(windage::Calibration* calibration, double x, double y, double z)
+{
+	CvMat* intrinsic = calibration->GetIntrinsicMatrix();
+	CvMat* extrinsic = calibration->GetExtrinsicMatrix();
+
+	double camera[3];
+	for(int i=0; i<3; i++)
+	{
+		camera[i] =	CV_MAT_ELEM((*extrinsic), double, i, 0) * x +
+					CV_MAT_ELEM((*extrinsic), double, i, 1) * y +
+					CV_MAT_ELEM((*extrinsic), double, i, 2) * z +
+					CV_MAT_ELEM((*extrinsic), double, i, 3);
+	}
+
+	windage::Vector2 point;
+	point.x = CV_MAT_ELEM((*intrinsic), double, 0, 0) * camera[0] / camera[2] + CV_MAT_ELEM((*intrinsic), double, 0, 2);
+	point.y = CV_MAT_ELEM((*intrinsic), double, 1, 1) * camera[1] / camera[2] + CV_MAT_ELEM((*intrinsic), double, 1, 2);
+	return point;
+}
+
+void SyntheticSequence::Release()
+{
+	if(referenceMask) cvReleaseImage(&referenceMask);
+	if(backgroundImage) cvReleaseImage(&backgroundImage);
+	if(warpImage) cvReleaseImage(&warpImage);
+	if(maskImage) cvReleaseImage(&maskImage);
+	if(floatImage) cvReleaseImage(&floatImage);
+	if(noiseImage) cvReleaseImage(&noiseImage);
+	if(frameImage) cvReleaseImage(&frameImage);
+
+	referenceMask = NULL;
+	backgroundImage = NULL;
+	warpImage = NULL;
+	maskImage = NULL;
+	floatImage = NULL;
+	noiseImage = NULL;
+	frameImage = NULL;
+
+	this->initialize = false;
+}
+
+bool SyntheticSequence::AttatchReferenceImage(IplImage* grayImage)
+{
+	if(grayImage == NULL || grayImage->nChannels != 1)
+		return false;
+
+	if(this->referenceImage) cvReleaseImage(&this->referenceImage);
+	this->referenceImage = NULL;
+	this->referenceImage = cvCloneImage(grayImage);
+
+	this->initialize = false;
+	return true;
+}
+
+bool SyntheticSequence::Initialize(int width, int height, double realWidth, double realHeight)
+{
+	if(this->cameraParameter == NULL || this->referenceImage == NULL)
+		return false;
+	if(width <= 0 || height <= 0 || this->frameCount <= 0)
+		return false;
+
+	this->Release();
+
+	this->width = width;
+	this->height = height;
+	this->realWidth = realWidth;
+	this->realHeight = realHeight;
+
+	this->referenceMask = cvCreateImage(cvGetSize(this->referenceImage), IPL_DEPTH_8U, 1);
+	this->backgroundImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+	this->warpImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+	this->maskImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+	this->floatImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 1);
+	this->noiseImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_32F, 1);
+	this->frameImage = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 1);
+	cvSet(this->referenceMask, cvScalar(255));
+
+	double* parameter = this->cameraParameter->GetParameters();
+	this->groundTruth->Initialize(parameter[0], parameter[1], parameter[2], parameter[3], parameter[4], parameter[5], parameter[6], parameter[7]);
+
+	// the reference covers about 70% of the frame width at the frontal pose
+	if(this->distance <= 0.0)
+		this->distance = parameter[0] * this->realWidth / (0.7 * (double)width);
+
+	this->RenderBackground();
+
+	this->index = -1;
+	this->initialize = true;
+	return true;
+}
+
+void SyntheticSequence::RenderBackground()
+{
+	CvRNG rng = cvRNG((int64)this->seed * 100003 + 7);
+
+	// low contrast clutter, so the keypoints of the background become outliers
+	cvSet(this->backgroundImage, cvScalar(96));
+	for(int i=0; i<this->width*this->height/2000; i++)
+	{
+		CvPoint center = cvPoint(cvRandInt(&rng) % this->width, cvRandInt(&rng) % this->height);
+		int size = 5 + cvRandInt(&rng) % 40;
+		CvScalar color = cvScalar(48 + cvRandInt(&rng) % 96);
+		if(cvRandInt(&rng) % 2)
+			cvCircle(this->backgroundImage, center, size, color, CV_FILLED);
+		else
+			cvRectangle(this->backgroundImage, center, cvPoint(center.x + size, center.y + size/2), color, CV_FILLED);
+	}
+	cvSmooth(this->backgroundImage, this->backgroundImage, CV_GAUSSIAN, 5);
+}
+
+void SyntheticSequence::CalculatePose(int index, CvRNG* rng, double* extrinsic)
+{
+	double phase = 2.0 * CV_PI * (double)index / (double)this->frameCount;
+	double toRadian = CV_PI / 180.0;
+
+	double jitterValue[3] = {0.0, 0.0, 0.0};
+	if(this->jitter > 0.0)
+	{
+		CvMat jitterMat = cvMat(1, 3, CV_64FC1, jitterValue);
+		cvRandArr(rng, &jitterMat, CV_RAND_NORMAL, cvScalar(0.0), cvScalar(this->jitter));
+	}
+
+	double tilt = (this->rotationRange * sin(phase) + jitterValue[0]) * toRadian;
+	double pan = (this->rotationRange * sin(2.0*phase + CV_PI/3.0) + jitterValue[1]) * toRadian;
+	double roll = (this->rotationRange * sin(phase + CV_PI/2.0) + jitterValue[2]) * toRadian;
+	double distance = this->distance * (1.0 + this->distanceRange * sin(3.0*phase));
+
+	// frontal camera (x-right, y-down, z-forward) to the object plane (y-up) and the perturbation
+	windage::Matrix3 frontal(1.0, 0.0, 0.0, 0.0, -1.0, 0.0, 0.0, 0.0, -1.0);
+	windage::Matrix3 rotationX(1.0, 0.0, 0.0, 0.0, cos(tilt), -sin(tilt), 0.0, sin(tilt), cos(tilt));
+	windage::Matrix3 rotationY(cos(pan), 0.0, sin(pan), 0.0, 1.0, 0.0, -sin(pan), 0.0, cos(pan));
+	windage::Matrix3 rotationZ(cos(roll), -sin(roll), 0.0, sin(roll), cos(roll), 0.0, 0.0, 0.0, 1.0);
+	windage::Matrix3 R = rotationZ * rotationX * rotationY * frontal;
+
+	// the camera looks at the target point of the reference plane
+	windage::Vector3 target(this->translationRange * this->realWidth * sin(phase + CV_PI/4.0),
+							this->translationRange * this->realHeight * cos(2.0*phase),
+							0.0);
+	windage::Vector3 axis(R.m[2][0], R.m[2][1], R.m[2][2]);
+	windage::Vector3 position = target - axis * distance;
+	windage::Vector3 t = -(R * position);
+
+	for(int y=0; y<3; y++)
+	{
+		for(int x=0; x<3; x++)
+			extrinsic[y*4+x] = R.m[y][x];
+	}
+	extrinsic[3] = t.x; extrinsic[7] = t.y; extrinsic[11] = t.z;
+	extrinsic[12] = extrinsic[13] = extrinsic[14] = 0.0; extrinsic[15] = 1.0;
+}
+
+bool SyntheticSequence::Generate(int index)
+{
+	if(this->initialize == false)
+		return false;
+	if(index < 0 || index >= this->frameCount)
+		return false;
+
+	this->index = index;
+	CvRNG rng = cvRNG((int64)this->seed * 100003 + index + 11);
+
+	// ground truth pose
+	double extrinsic[16];
+	this->CalculatePose(index, &rng, extrinsic);
+	this->groundTruth->SetExtrinsicMatrix(extrinsic);
+
+	// H = K [r1 r2 t] * (reference pixel to object coordinate)
+	double* parameter = this->cameraParameter->GetParameters();
+	windage::Matrix3 K(parameter[0], 0.0, parameter[2], 0.0, parameter[1], parameter[3], 0.0, 0.0, 1.0);
+	windage::Matrix3 Rt(extrinsic[0], extrinsic[1], extrinsic[3], extrinsic[4], extrinsic[5], extrinsic[7], extrinsic[8], extrinsic[9], extrinsic[11]);
+	double xScaleFactor = this->realWidth / (double)this->referenceImage->width;
+	double yScaleFactor = this->realHeight / (double)this->referenceImage->height;
+	windage::Matrix3 referenceToObject(	xScaleFactor, 0.0, -this->realWidth/2.0,
+										0.0, -yScaleFactor, this->realHeight/2.0 + 1.0,
+										0.0, 0.0, 1.0);
+	this->homography = K * Rt * referenceToObject;
+	double scale = this->homography.m[2][2];
+	for(int i=0; i<9; i++)
+		this->homography.m1[i] /= scale;
+
+	// render
+	double warpValue[9];
+	for(int i=0; i<9; i++)
+		warpValue[i] = this->homography.m1[i];
+	CvMat warp = cvMat(3, 3, CV_64FC1, warpValue);
+	cvWarpPerspective(this->referenceImage, this->warpImage, &warp, CV_INTER_LINEAR+CV_WARP_FILL_OUTLIERS, cvScalarAll(0));
+	cvWarpPerspective(this->referenceMask, this->maskImage, &warp, CV_INTER_NN+CV_WARP_FILL_OUTLIERS, cvScalarAll(0));
+	cvCopy(this->backgroundImage, this->frameImage);
+	cvCopy(this->warpImage, this->frameImage, this->maskImage);
+
+	// occlusion in the bounding box of the projected reference
+	if(this->occluderCount > 0)
+	{
+		double minX = this->width, minY = this->height, maxX = 0.0, maxY = 0.0;
+		for(int i=0; i<4; i++)
+		{
+			double x = (i == 0 || i == 3) ? 0.0 : (double)this->referenceImage->width;
+			double y = (i < 2) ? 0.0 : (double)this->referenceImage->height;
+			windage::Vector3 point = this->homography * windage::Vector3(x, y, 1.0);
+			point /= point.z;
+			minX = MIN(minX, point.x); maxX = MAX(maxX, point.x);
+			minY = MIN(minY, point.y); maxY = MAX(maxY, point.y);
+		}
+		minX = MAX(minX, 0.0); maxX = MIN(maxX, (double)this->width);
+		minY = MAX(minY, 0.0); maxY = MIN(maxY, (double)this->height);
+
+		int sizeX = cvRound((maxX - minX) * this->occluderSize);
+		int sizeY = cvRound((maxY - minY) * this->occluderSize);
+		int rangeX = cvRound(maxX - minX) - sizeX;
+		int rangeY = cvRound(maxY - minY) - sizeY;
+		if(sizeX > 0 && sizeY > 0 && rangeX > 0 && rangeY > 0)
+		{
+			for(int i=0; i<this->occluderCount; i++)
+			{
+				CvPoint start = cvPoint(cvRound(minX) + cvRandInt(&rng) % rangeX, cvRound(minY) + cvRandInt(&rng) % rangeY);
+				CvPoint end = cvPoint(start.x + sizeX, start.y + sizeY);
+				cvRectangle(this->frameImage, start, end, cvScalar(cvRandInt(&rng) % 256), CV_FILLED);
+			}
+		}
+	}
+
+	// lighting (smooth change of the exposure)
+	if(this->gainRange > 0.0 || this->biasRange > 0.0)
+	{
+		double phase = 2.0 * CV_PI * (double)index / (double)this->frameCount;
+		double gain = 1.0 + this->gainRange * sin(2.0*phase + 1.0);
+		double bias = this->biasRange * cos(3.0*phase);
+		cvConvertScale(this->frameImage, this->frameImage, gain, bias);
+	}
+
+	if(this->blur > 0.0)
+		cvSmooth(this->frameImage, this->frameImage, CV_GAUSSIAN, 0, 0, this->blur);
+
+	// sensor noise
+	if(this->noise > 0.0)
+	{
+		cvRandArr(&rng, this->noiseImage, CV_RAND_NORMAL, cvScalar(0.0), cvScalar(this->noise));
+		cvConvert(this->frameImage, this->floatImage);
+		cvAdd(this->floatImage, this->noiseImage, this->floatImage);
+		cvConvert(this->floatImage, this->frameImage);
+	}
+
+	return true;
+}
+
+bool SyntheticSequence::Next()
+{
+	if(this->index + 1 >= this->frameCount)
+		return false;
+	return this->Generate(this->index + 1);
+}
+
+double SyntheticSequence::CalculateRotationError(windage::Calibration* estimated)
+{
+	if(estimated == NULL || this->index < 0)
+		return -1.0;
+
+	// angle of R_estimated^T * R_groundtruth
+	windage::Matrix3 relative = GetRotation(estimated).Transpose() * GetRotation(this->groundTruth);
+	double cosine = (relative.m[0][0] + relative.m[1][1] + relative.m[2][2] - 1.0) / 2.0;
+	cosine = MAX(-1.0, MIN(1.0, cosine));
+	return acos(cosine) * 180.0 / CV_PI;
+}
+
+double SyntheticSequence::CalculateTranslationError(windage::Calibration* estimated)
+{
+	if(estimated == NULL || this->index < 0)
+		return -1.0;
+
+	CvScalar position1 = estimated->GetCameraPosition();
+	CvScalar position2 = this->groundTruth->GetCameraPosition();
+	double dx = position1.val[0] - position2.val[0];
+	double dy = position1.val[1] - position2.val[1];
+	double dz = position1.val[2] - position2.val[2];
+	return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+double SyntheticSequence::CalculateReprojectionError(windage::Calibration* estimated)
+{
+	if(estimated == NULL || this->index < 0)
+		return -1.0;
+
+	double error = 0.0;
+	for(int i=0; i<4; i++)
+	{
+		double x = (i == 0 || i == 3) ? -this->realWidth/2.0 : this->realWidth/2.0;
+		double y = (i < 2) ? -this->realHeight/2.0 : this->realHeight/2.0;
+		windage::Vector2 point1 = ProjectPoint(estimated, x, y, 0.0);
+		windage::Vector2 point2 = ProjectPoint(this->groundTruth, x, y, 0.0);
+		error += sqrt((point1.x - point2.x)*(point1.x - point2.x) + (point1.y - point2.y)*(point1.y - point2.y));
+	}
+	return error / 4.0;
+}
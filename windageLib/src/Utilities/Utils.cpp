@@ -38,6 +38,7 @@
  * ======================================================================== */
 
 #include <stdio.h>
+#include <algorithm>
 
 #include "Utilities/Utils.h"
 using namespace windage;
@@ -51,3 +52,36 @@ void Utils::DrawTextToImage(IplImage* colorImage, CvPoint position, double scale
 	cvPutText(colorImage, message, position, &outLineFont, CV_RGB(0, 0, 0));
 	cvPutText(colorImage, message, position, &font, CV_RGB(255, 255, 255));
 }
+
+double Utils::GetPercentile(std::vector<double> values, double ratio)
+{
+	if(values.size() == 0)
+		return -1.0;
+
+	std::sort(values.begin(), values.end());
+	int index = (int)(ratio * (double)(values.size() - 1) + 0.5);
+	return values[MIN(MAX(index, 0), (int)values.size() - 1)];
+}
+
+void Utils::WriteJSONString(FILE* file, const char* text)
+{
+	fputc('"', file);
+	for(; text && *text; text++)
+	{
+		unsigned char character = (unsigned char)*text;
+		if(character == '"' || character == '\\')
+		{
+			fputc('\\', file);
+			fputc(character, file);
+		}
+		else if(character < 0x20)
+		{
+			fprintf(file, "\\u%04x", character);
+		}
+		else
+		{
+			fputc(character, file);
+		}
+	}
+	fputc('"', file);
+}